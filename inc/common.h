@@ -2,18 +2,105 @@
 #define TYDF_COMMON_H
 
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <iterator>
 #include <array>
 #include <string>
 #include <vector>
+#include <thread>
+#include <algorithm>
 #include <exception>
 #include <stdexcept>
+#include <new>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <iosfwd>
+#include <ostream>
+
+/// Bounds checking of the hot-path accessors, e.g. "Array1D::unchecked".
+/// Dropped by default, define "TYDF_CHECKED_ACCESS" for diagnostics.
+
+/// Stage-level instrumentation, see "COMMON::PROFILER".
+/// Timers and counters are recorded only when "TYDF_ENABLE_PROFILE" is defined,
+/// otherwise they expand to nothing.
+#ifdef TYDF_ENABLE_PROFILE
+#define TYDF_PROFILE_JOIN_(a, b) a##b
+#define TYDF_PROFILE_JOIN(a, b) TYDF_PROFILE_JOIN_(a, b)
+#define TYDF_PROFILE_SCOPE(name) const GridTool::COMMON::SCOPED_TIMER TYDF_PROFILE_JOIN(tydf_profile_, __LINE__)(name)
+#define TYDF_PROFILE_COUNT(name, val) GridTool::COMMON::profiler().count(name, static_cast<long long>(val))
+#else
+#define TYDF_PROFILE_SCOPE(name) ((void)0)
+#define TYDF_PROFILE_COUNT(name, val) ((void)0)
+#endif
 
 namespace GridTool::COMMON
 {
     typedef double Scalar;
 
+    /// 0-based access to random-access containers in hot loops,
+    /// unlike the 1-based "Array1D::unchecked".
+    /// Same as "c.at(i)" when "TYDF_CHECKED_ACCESS" is defined, otherwise same as "c[i]".
+    template<typename C>
+    auto at_unchecked(C &c, size_t i) -> decltype(c[i])
+    {
+#ifdef TYDF_CHECKED_ACCESS
+        return c.at(i);
+#else
+        return c[i];
+#endif
+    }
+
     Scalar relaxation(Scalar a, Scalar b, Scalar x);
 
+    /// Num of threads used by multi-threaded routines.
+    /// Defaults to the num of hardware threads, set to 1 to run serially.
+    size_t &num_of_thread();
+
+    /// Split [0, n) into contiguous ranges and process them concurrently.
+    /// "f(first, last)" is invoked once for each range [first, last),
+    /// and no range is smaller than "grain" unless "n" itself is.
+    /// The first exception thrown by any worker is re-thrown after all workers have joined.
+    template<typename F>
+    void parallel_for(size_t n, const F &f, size_t grain = 1)
+    {
+        const size_t nWorker = std::min(num_of_thread(), (n + grain - 1) / std::max<size_t>(grain, 1));
+        if (nWorker <= 1)
+        {
+            if (n > 0)
+                f(size_t(0), n);
+            return;
+        }
+
+        std::vector<std::exception_ptr> err(nWorker);
+        std::vector<std::thread> worker;
+        worker.reserve(nWorker);
+        for (size_t t = 0; t < nWorker; ++t)
+        {
+            const size_t first = n * t / nWorker;
+            const size_t last = n * (t + 1) / nWorker;
+            worker.emplace_back([&f, &err, t, first, last]()
+            {
+                try
+                {
+                    f(first, last);
+                }
+                catch (...)
+                {
+                    err[t] = std::current_exception();
+                }
+            });
+        }
+        for (auto &e : worker)
+            e.join();
+        for (const auto &e : err)
+            if (e)
+                std::rethrow_exception(e);
+    }
+
     struct wrong_index : public std::logic_error
     {
         wrong_index(long long idx, const std::string &reason) :
@@ -157,6 +244,334 @@ namespace GridTool::COMMON
     /// dst_RL: Unit normal vector from "rightCell" to "leftCell".
     void quadrilateral_normal(const Vector &n1, const Vector &n2, const Vector &n3, const Vector &n4, Vector &dst_LR, Vector &dst_RL);
 
+    /// Instruction sets available to batched geometry kernels.
+    enum SIMD_ISA
+    {
+        SCALAR_ISA = 0,
+        AVX2_ISA = 1,
+        AVX512_ISA = 2
+    };
+
+    /// The widest instruction set supported by both the compiler and the running CPU.
+    SIMD_ISA simd_supported();
+
+    /// The instruction set adopted by batched kernels, "simd_supported()" by default.
+    /// It may be lowered manually, values beyond "simd_supported()" are ignored.
+    SIMD_ISA &simd_isa();
+
+    /// Batched version of "triangle_area", "triangle_center" and "triangle_normal".
+    /// Nodal coordinates are given in planar form, "coord[k]" is the "k"-th component.
+    /// 0-based node index of the "i"-th triangle are "node[3*i]", "node[3*i+1]" and "node[3*i+2]".
+    /// Results of the "i"-th triangle are stored at "area[i]", "center[k][i]" and "normal[k][i]",
+    /// where the unit normal vector points from "leftCell" to "rightCell".
+    /// Results are bitwise identical to the non-batched ones, whatever the instruction set.
+    void triangle_geometry(size_t n, const Scalar *const coord[3], const size_t *node, Scalar *area, Scalar *const center[3], Scalar *const normal[3]);
+
+    /// Batched version of "quadrilateral_area", "quadrilateral_center" and "quadrilateral_normal".
+    /// 0-based node index of the "i"-th quadrilateral are "node[4*i]" to "node[4*i+3]".
+    /// Conventions are the same as "triangle_geometry".
+    void quadrilateral_geometry(size_t n, const Scalar *const coord[3], const size_t *node, Scalar *area, Scalar *const center[3], Scalar *const normal[3]);
+
+    /// Array of non-negative integers, whose width is chosen at allocation.
+    /// 32-bit storage is adopted whenever the largest value allows.
+    class IndexArray
+    {
+    private:
+        bool m_wide;
+        std::vector<uint32_t> m_narrow;
+        std::vector<uint64_t> m_broad;
+
+    public:
+        IndexArray();
+
+        IndexArray(size_t n, size_t maxVal);
+
+        IndexArray(const IndexArray &rhs) = default;
+
+        IndexArray(IndexArray &&rhs) noexcept = default;
+
+        IndexArray &operator=(const IndexArray &rhs) = default;
+
+        IndexArray &operator=(IndexArray &&rhs) noexcept = default;
+
+        ~IndexArray() = default;
+
+        /// Initialize "n" zeros, "maxVal" is the largest value to be stored.
+        void allocate(size_t n, size_t maxVal);
+
+        void clear();
+
+        size_t size() const
+        {
+            return m_wide ? m_broad.size() : m_narrow.size();
+        }
+
+        /// 64-bit storage or not.
+        bool wide() const;
+
+        /// Memory occupied by the stored values, in bytes.
+        size_t bytes() const;
+
+        /// 0-based, NO bound check.
+        size_t operator[](size_t i) const
+        {
+            return m_wide ? static_cast<size_t>(m_broad[i]) : static_cast<size_t>(m_narrow[i]);
+        }
+
+        void set(size_t i, size_t val)
+        {
+            if (m_wide)
+                m_broad[i] = val;
+            else
+                m_narrow[i] = static_cast<uint32_t>(val);
+        }
+    };
+
+    /// Compressed-Sparse-Row storage of variable-length index lists.
+    class CSR
+    {
+    public:
+        /// Read-only view of consecutive entries.
+        class ROW
+        {
+        public:
+            class const_iterator
+            {
+            private:
+                const IndexArray *m_data;
+                size_t m_pos;
+
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef size_t value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const size_t *pointer;
+                typedef size_t reference;
+
+                const_iterator(const IndexArray *data, size_t pos) : m_data(data), m_pos(pos) {}
+
+                size_t operator*() const
+                {
+                    return (*m_data)[m_pos];
+                }
+
+                const_iterator &operator++()
+                {
+                    ++m_pos;
+                    return *this;
+                }
+
+                const_iterator operator++(int)
+                {
+                    const_iterator ret(*this);
+                    ++m_pos;
+                    return ret;
+                }
+
+                bool operator==(const const_iterator &rhs) const
+                {
+                    return m_pos == rhs.m_pos && m_data == rhs.m_data;
+                }
+
+                bool operator!=(const const_iterator &rhs) const
+                {
+                    return !(*this == rhs);
+                }
+            };
+
+        private:
+            const IndexArray *m_data;
+            size_t m_first, m_last;
+
+        public:
+            ROW(const IndexArray &data, size_t first, size_t last) : m_data(&data), m_first(first), m_last(last) {}
+
+            ROW(const ROW &rhs) = default;
+
+            ~ROW() = default;
+
+            size_t size() const
+            {
+                return m_last - m_first;
+            }
+
+            bool empty() const
+            {
+                return m_first == m_last;
+            }
+
+            /// 0-based indexing, NO bound check.
+            size_t operator[](size_t k) const
+            {
+                return (*m_data)[m_first + k];
+            }
+
+            /// 0-based indexing
+            size_t at(size_t k) const
+            {
+                if (k >= size())
+                    throw std::out_of_range("Index " + std::to_string(k) + " is out of range of the row.");
+                return (*m_data)[m_first + k];
+            }
+
+            /// 1-based indexing
+            size_t operator()(int k) const
+            {
+                if (k >= 1)
+                    return at(k - 1);
+                else if (k <= -1)
+                    return at(size() + k);
+                else
+                    throw wrong_index(0, "is invalid when using 1-based index");
+            }
+
+            const_iterator begin() const
+            {
+                return const_iterator(m_data, m_first);
+            }
+
+            const_iterator end() const
+            {
+                return const_iterator(m_data, m_last);
+            }
+
+            /// Check inclusion
+            bool contains(size_t x) const;
+
+            bool contains(size_t a, size_t b) const;
+        };
+
+    private:
+        IndexArray m_offset;
+        IndexArray m_index;
+
+    public:
+        CSR() = default;
+
+        CSR(const CSR &rhs) = default;
+
+        CSR(CSR &&rhs) noexcept = default;
+
+        CSR &operator=(const CSR &rhs) = default;
+
+        CSR &operator=(CSR &&rhs) noexcept = default;
+
+        ~CSR() = default;
+
+        /// Allocate storage of zeros given num of entries within each row,
+        /// "maxVal" is the largest value to be stored.
+        void allocate(const std::vector<size_t> &cnt, size_t maxVal);
+
+        /// Allocate storage of zeros with "n" rows of "len" entries each.
+        void allocate(size_t n, size_t len, size_t maxVal);
+
+        void clear();
+
+        /// Num of rows.
+        size_t size() const
+        {
+            return m_offset.size() > 0 ? m_offset.size() - 1 : 0;
+        }
+
+        /// Num of entries of all rows.
+        size_t nnz() const
+        {
+            return m_index.size();
+        }
+
+        /// Memory occupied, in bytes.
+        size_t bytes() const;
+
+        /// Position of the first entry of the 0-based "i"-th row.
+        size_t offset(size_t i) const
+        {
+            return m_offset[i];
+        }
+
+        size_t length(size_t i) const
+        {
+            return m_offset[i + 1] - m_offset[i];
+        }
+
+        /// Value of the "k"-th (0-based) entry within the 0-based "i"-th row.
+        size_t at(size_t i, size_t k) const
+        {
+            return m_index[m_offset[i] + k];
+        }
+
+        void set(size_t i, size_t k, size_t val)
+        {
+            m_index.set(m_offset[i] + k, val);
+        }
+
+        ROW row(size_t i) const
+        {
+            return ROW(m_index, m_offset[i], m_offset[i + 1]);
+        }
+
+        /// Raw entries of all rows.
+        const IndexArray &entry() const;
+
+        /// Raw offsets of all rows, with one more than num of rows.
+        const IndexArray &row_offset() const;
+
+        /// Adopt "offset" and "index" built elsewhere, see "row_offset" and "entry".
+        void assign(IndexArray &&offset, IndexArray &&index);
+    };
+
+    /// Planar storage of vectors, components are kept in separate contiguous arrays.
+    class VectorArray
+    {
+    private:
+        std::array<std::vector<Scalar>, 3> m_comp;
+
+    public:
+        VectorArray() = default;
+
+        explicit VectorArray(size_t n);
+
+        VectorArray(const VectorArray &rhs) = default;
+
+        VectorArray(VectorArray &&rhs) noexcept = default;
+
+        VectorArray &operator=(const VectorArray &rhs) = default;
+
+        VectorArray &operator=(VectorArray &&rhs) noexcept = default;
+
+        ~VectorArray() = default;
+
+        /// All components are reset to 0.
+        void assign(size_t n);
+
+        void clear();
+
+        size_t size() const
+        {
+            return m_comp[0].size();
+        }
+
+        /// Memory occupied, in bytes.
+        size_t bytes() const;
+
+        /// 0-based
+        Vector at(size_t i) const
+        {
+            return Vector(m_comp[0][i], m_comp[1][i], m_comp[2][i]);
+        }
+
+        void set(size_t i, const Vector &v)
+        {
+            m_comp[0][i] = v.x();
+            m_comp[1][i] = v.y();
+            m_comp[2][i] = v.z();
+        }
+
+        /// Contiguous storage of the "k"-th (0-based) component.
+        const Scalar *plane(int k) const;
+
+        Scalar *plane(int k);
+    };
+
     template <typename T>
     class Array1D : public std::vector<T>
     {
@@ -179,6 +594,12 @@ namespace GridTool::COMMON
 
         Array1D(const Array1D &obj) = default;
 
+        Array1D(Array1D &&obj) noexcept = default;
+
+        Array1D &operator=(const Array1D &obj) = default;
+
+        Array1D &operator=(Array1D &&obj) noexcept = default;
+
         ~Array1D() = default;
 
         /// 1-based indexing
@@ -202,6 +623,31 @@ namespace GridTool::COMMON
                 throw index_is_zero();
         }
 
+        /// 1-based indexing without the negative-index support of "operator()",
+        /// unlike the 0-based "COMMON::at_unchecked".
+        /// Bounds are checked only when "TYDF_CHECKED_ACCESS" is defined.
+        const T &unchecked(size_t i) const
+        {
+#ifdef TYDF_CHECKED_ACCESS
+            if (i == 0)
+                throw index_is_zero();
+            return std::vector<T>::at(i - 1);
+#else
+            return std::vector<T>::operator[](i - 1);
+#endif
+        }
+
+        T &unchecked(size_t i)
+        {
+#ifdef TYDF_CHECKED_ACCESS
+            if (i == 0)
+                throw index_is_zero();
+            return std::vector<T>::at(i - 1);
+#else
+            return std::vector<T>::operator[](i - 1);
+#endif
+        }
+
         /// Check inclusion
         bool contains(const T &x) const
         {
@@ -232,8 +678,59 @@ namespace GridTool::COMMON
         }
     };
 
+    /// Allocator of storage aligned to "Align" bytes, for vectorized loops.
+    template<typename T, size_t Align = 64>
+    struct ALIGNED_ALLOCATOR
+    {
+        typedef T value_type;
+
+        template<typename U>
+        struct rebind
+        {
+            typedef ALIGNED_ALLOCATOR<U, Align> other;
+        };
+
+        ALIGNED_ALLOCATOR() = default;
+
+        template<typename U>
+        ALIGNED_ALLOCATOR(const ALIGNED_ALLOCATOR<U, Align> &) {}
+
+        T *allocate(size_t n)
+        {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+        }
+
+        void deallocate(T *p, size_t)
+        {
+            ::operator delete(p, std::align_val_t(Align));
+        }
+
+        template<typename U>
+        bool operator==(const ALIGNED_ALLOCATOR<U, Align> &) const
+        {
+            return true;
+        }
+
+        template<typename U>
+        bool operator!=(const ALIGNED_ALLOCATOR<U, Align> &) const
+        {
+            return false;
+        }
+    };
+
+    /// Storage policies of "ArrayND".
+    /// INTERLEAVED: elements are stored one after another.
+    /// PLANAR: for elements of fixed-size arrays (e.g. "Vector"), each component
+    ///         resides in its own contiguous and aligned plane.
+    struct INTERLEAVED {};
+
+    struct PLANAR {};
+
+    template<typename T, typename Layout = INTERLEAVED>
+    class ArrayND;
+
     template<typename T>
-    class ArrayND
+    class ArrayND<T, INTERLEAVED>
     {
     protected:
         size_t m_Nx, m_Ny, m_Nz;
@@ -297,6 +794,12 @@ namespace GridTool::COMMON
                 throw wrong_index(0, "in K-dim");
         }
 
+        ArrayND(ArrayND &&rhs) noexcept = default;
+
+        ArrayND &operator=(const ArrayND &rhs) = default;
+
+        ArrayND &operator=(ArrayND &&rhs) noexcept = default;
+
         virtual ~ArrayND() = default;
 
         size_t nI() const
@@ -377,6 +880,493 @@ namespace GridTool::COMMON
             return at(i - 1, j - 1, k - 1);
         }
     };
+
+    template<typename T>
+    class ArrayND<T, PLANAR>
+    {
+    public:
+        typedef typename T::value_type value_type;
+
+        /// Num of components of each element.
+        static constexpr size_t NumOfComp = sizeof(T) / sizeof(value_type);
+
+        /// Planes start at multiples of "Align" bytes.
+        static constexpr size_t Align = 64;
+
+        /// Reference to an element scattered over planes.
+        /// Converts to "T", and exposes each component through "operator[]".
+        class REFERENCE
+        {
+        private:
+            value_type *m_p;
+            size_t m_stride;
+
+        public:
+            REFERENCE(value_type *p, size_t stride) :
+                m_p(p),
+                m_stride(stride)
+            {
+                /// Empty body.
+            }
+
+            REFERENCE(const REFERENCE &rhs) = default;
+
+            ~REFERENCE() = default;
+
+            operator T() const
+            {
+                T ret;
+                for (size_t c = 0; c < NumOfComp; ++c)
+                    ret[c] = m_p[c * m_stride];
+                return ret;
+            }
+
+            REFERENCE &operator=(const T &rhs)
+            {
+                for (size_t c = 0; c < NumOfComp; ++c)
+                    m_p[c * m_stride] = rhs[c];
+                return *this;
+            }
+
+            REFERENCE &operator=(const REFERENCE &rhs)
+            {
+                return *this = static_cast<T>(rhs);
+            }
+
+            /// 0-based indexing of components
+            value_type &operator[](size_t c) const
+            {
+                return m_p[c * m_stride];
+            }
+
+            value_type &x() const
+            {
+                return m_p[0];
+            }
+
+            value_type &y() const
+            {
+                return m_p[m_stride];
+            }
+
+            value_type &z() const
+            {
+                return m_p[2 * m_stride];
+            }
+        };
+
+    protected:
+        size_t m_Nx, m_Ny, m_Nz;
+        size_t m_NXY;
+
+        /// Distance between planes, in num of components.
+        size_t m_stride;
+
+        std::vector<value_type, ALIGNED_ALLOCATOR<value_type, Align>> m_data;
+
+    public:
+        ArrayND() = delete;
+
+        ArrayND(size_t nx, const T &val) :
+            ArrayND(nx, 1, 1, val)
+        {
+            /// Empty body.
+        }
+
+        ArrayND(size_t nx, size_t ny, const T &val) :
+            ArrayND(nx, ny, 1, val)
+        {
+            /// Empty body.
+        }
+
+        ArrayND(size_t nx, size_t ny, size_t nz, const T &val) :
+            m_Nx(nx),
+            m_Ny(ny),
+            m_Nz(nz),
+            m_NXY(nx*ny),
+            m_stride(padded(nx*ny*nz)),
+            m_data(NumOfComp * m_stride)
+        {
+            if (nI() == 0)
+                throw wrong_index(0, "in I-dim");
+            if (nJ() == 0)
+                throw wrong_index(0, "in J-dim");
+            if (nK() == 0)
+                throw wrong_index(0, "in K-dim");
+
+            for (size_t c = 0; c < NumOfComp; ++c)
+                std::fill(plane(c), plane(c) + size(), val[c]);
+        }
+
+        ArrayND(const ArrayND &rhs) = default;
+
+        ArrayND(ArrayND &&rhs) noexcept = default;
+
+        ArrayND &operator=(const ArrayND &rhs) = default;
+
+        ArrayND &operator=(ArrayND &&rhs) noexcept = default;
+
+        virtual ~ArrayND() = default;
+
+        size_t nI() const
+        {
+            return m_Nx;
+        }
+
+        size_t nJ() const
+        {
+            return m_Ny;
+        }
+
+        size_t nK() const
+        {
+            return m_Nz;
+        }
+
+        /// Num of elements, i.e. length of each plane.
+        size_t size() const
+        {
+            return m_Nx * m_Ny * m_Nz;
+        }
+
+        /// Contiguous storage of the "c"-th (0-based) component,
+        /// elements are ordered with "i" varying fastest.
+        const value_type *plane(size_t c) const
+        {
+            return m_data.data() + c * m_stride;
+        }
+
+        value_type *plane(size_t c)
+        {
+            return m_data.data() + c * m_stride;
+        }
+
+    private:
+        static size_t padded(size_t n)
+        {
+            const size_t m = Align / sizeof(value_type);
+            return (n + m - 1) / m * m;
+        }
+
+        /// Calculate 0-based internal index
+        size_t idx(size_t i, size_t j) const
+        {
+            return i + m_Nx * j;
+        }
+
+        size_t idx(size_t i, size_t j, size_t k) const
+        {
+            return i + m_Nx * j + m_NXY * k;
+        }
+
+        T element(size_t n) const
+        {
+            T ret;
+            for (size_t c = 0; c < NumOfComp; ++c)
+                ret[c] = m_data[n + c * m_stride];
+            return ret;
+        }
+
+    public:
+        /// 2D
+        /// 0-based indexing
+        T at(size_t i, size_t j) const
+        {
+            return element(idx(i, j));
+        }
+
+        REFERENCE at(size_t i, size_t j)
+        {
+            return REFERENCE(m_data.data() + idx(i, j), m_stride);
+        }
+
+        /// 1-based indexing
+        T operator()(size_t i, size_t j) const
+        {
+            return at(i - 1, j - 1);
+        }
+
+        REFERENCE operator()(size_t i, size_t j)
+        {
+            return at(i - 1, j - 1);
+        }
+
+        /// 3D
+        /// 0-based indexing
+        T at(size_t i, size_t j, size_t k) const
+        {
+            return element(idx(i, j, k));
+        }
+
+        REFERENCE at(size_t i, size_t j, size_t k)
+        {
+            return REFERENCE(m_data.data() + idx(i, j, k), m_stride);
+        }
+
+        /// 1-based indexing
+        T operator()(size_t i, size_t j, size_t k) const
+        {
+            return at(i - 1, j - 1, k - 1);
+        }
+
+        REFERENCE operator()(size_t i, size_t j, size_t k)
+        {
+            return at(i - 1, j - 1, k - 1);
+        }
+    };
+
+    /// Disjoint sets over dense 0-based ids, merged by size with path compression.
+    /// Each element also carries a parity relative to the root of its set,
+    /// so that relations like "runs opposite to" are merged along with equivalence.
+    class DISJOINT_SET
+    {
+    private:
+        std::vector<size_t> m_parent;
+        std::vector<size_t> m_size;
+
+        /// Parity relative to the parent.
+        std::vector<unsigned char> m_parity;
+
+    public:
+        explicit DISJOINT_SET(size_t n = 0);
+
+        DISJOINT_SET(const DISJOINT_SET &rhs) = default;
+
+        DISJOINT_SET(DISJOINT_SET &&rhs) noexcept = default;
+
+        DISJOINT_SET &operator=(const DISJOINT_SET &rhs) = default;
+
+        DISJOINT_SET &operator=(DISJOINT_SET &&rhs) noexcept = default;
+
+        ~DISJOINT_SET() = default;
+
+        /// Re-initialize with "n" singleton sets.
+        void reset(size_t n);
+
+        size_t size() const;
+
+        /// Representative of the set containing "x".
+        size_t find(size_t x);
+
+        /// Parity of "x" relative to the representative of its set.
+        bool parity(size_t x);
+
+        /// Merge sets of "a" and "b", where "b" has parity "p" relative to "a".
+        /// "false" is returned if that contradicts previous merges.
+        bool unite(size_t a, size_t b, bool p = false);
+    };
+
+    /// Read-only view of the whole content of a file.
+    /// The file is memory-mapped where possible, otherwise it is loaded at once.
+    class MAPPED_FILE
+    {
+    private:
+        const char *m_data;
+        size_t m_size;
+        bool m_mapped;
+        std::string m_buf;
+
+    public:
+        MAPPED_FILE() = delete;
+
+        explicit MAPPED_FILE(const std::string &src);
+
+        MAPPED_FILE(const MAPPED_FILE &rhs) = delete;
+
+        ~MAPPED_FILE();
+
+        const char *begin() const
+        {
+            return m_data;
+        }
+
+        const char *end() const
+        {
+            return m_data + m_size;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+    };
+
+    /// Buffers are written to "out" by a dedicated thread in the order they are pushed,
+    /// so that the caller can format the next one while the previous is being written.
+    /// At most "depth" buffers are pending, "push" blocks until there is a free slot.
+    /// Failures of writing are re-thrown by "push" or "finish".
+    class ASYNC_WRITER
+    {
+    private:
+        std::ostream &m_out;
+        const size_t m_depth;
+        std::deque<std::string> m_queue;
+        bool m_done;
+        std::exception_ptr m_err;
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+        std::thread m_worker;
+
+        void run();
+
+    public:
+        ASYNC_WRITER() = delete;
+
+        explicit ASYNC_WRITER(std::ostream &out, size_t depth = 2);
+
+        ASYNC_WRITER(const ASYNC_WRITER &rhs) = delete;
+
+        /// Pending buffers are still written, but failures are dropped, call "finish" to see them.
+        ~ASYNC_WRITER();
+
+        void push(std::string &&buf);
+
+        /// Wait until all pushed buffers are written.
+        void finish();
+    };
+
+    /// Records [0, n) of a text body are formatted in chunks by "fmt(first, last, buf)",
+    /// which appends text of records [first, last) to "buf". Chunks are formatted concurrently,
+    /// while the previous ones are being written by "ASYNC_WRITER".
+    template<typename F>
+    void write_records(std::ostream &out, size_t n, const F &fmt)
+    {
+        static const size_t NumPerChunk = 1 << 15;
+
+        const size_t nChunk = (n + NumPerChunk - 1) / NumPerChunk;
+        if (nChunk <= 1)
+        {
+            std::string buf;
+            fmt(size_t(0), n, buf);
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            return;
+        }
+
+        /// One batch of chunks per round, two rounds in flight.
+        const size_t nBatch = std::max<size_t>(num_of_thread(), 1);
+        std::vector<std::string> buf(nBatch);
+        ASYNC_WRITER writer(out, 2 * nBatch);
+        for (size_t c0 = 0; c0 < nChunk; c0 += nBatch)
+        {
+            const size_t nCur = std::min(nBatch, nChunk - c0);
+            parallel_for(nCur, [&](size_t first, size_t last)
+            {
+                for (size_t c = first; c < last; ++c)
+                {
+                    const size_t lo = (c0 + c) * NumPerChunk;
+                    buf[c].clear();
+                    fmt(lo, std::min(lo + NumPerChunk, n), buf[c]);
+                }
+            });
+            for (size_t c = 0; c < nCur; ++c)
+                writer.push(std::move(buf[c]));
+        }
+        writer.finish();
+    }
+
+    /// Format by "put(i, p)" at most "width" chars for each of records [first, last) at the end of "buf",
+    /// where "put" returns the end of text of record "i" starting at "p".
+    template<typename F>
+    void append_records(std::string &buf, size_t first, size_t last, size_t width, const F &put)
+    {
+        const size_t pos = buf.size();
+        buf.resize(pos + (last - first) * width);
+        char *p = &buf[pos];
+        for (size_t i = first; i < last; ++i)
+            p = put(i, p);
+        buf.resize(p - buf.data());
+    }
+
+    /// Peak resident set size of this process in KB, 0 if unknown.
+    size_t peak_rss();
+
+    /// Restart tracking of "peak_rss" from current usage.
+    /// Only effective on Linux, elsewhere the peak is kept since the process started.
+    void reset_peak_rss();
+
+    /// Timed events and accumulated counters of all threads.
+    /// Filled through "TYDF_PROFILE_SCOPE" and "TYDF_PROFILE_COUNT",
+    /// thus it stays empty unless "TYDF_ENABLE_PROFILE" is defined.
+    class PROFILER
+    {
+    public:
+        struct EVENT
+        {
+            std::string name;
+            double start;    /// Microseconds since the last "reset".
+            double duration; /// Microseconds.
+            size_t thread;   /// 0-based, in the order of first recording.
+            size_t peak_rss; /// KB, when the event is finished.
+        };
+
+        /// Value of a counter after being increased at "time".
+        struct SAMPLE
+        {
+            std::string name;
+            double time;
+            long long value;
+        };
+
+    private:
+        mutable std::mutex m_mutex;
+        std::chrono::steady_clock::time_point m_origin;
+        std::vector<std::thread::id> m_thread;
+        std::vector<EVENT> m_event;
+        std::vector<SAMPLE> m_sample;
+        std::map<std::string, long long> m_counter;
+
+    public:
+        PROFILER();
+
+        PROFILER(const PROFILER &rhs) = delete;
+
+        ~PROFILER() = default;
+
+        /// Drop all records and restart the clock.
+        /// Not to be called while other threads are recording.
+        void reset();
+
+        /// Microseconds since the last "reset".
+        double now() const;
+
+        void record(const std::string &name, double start, double finish);
+
+        void count(const std::string &name, long long val);
+
+        /// Snapshots, safe to be taken while other threads are recording.
+        std::vector<EVENT> events() const;
+
+        std::map<std::string, long long> counters() const;
+
+        /// 0 if never counted.
+        long long counter(const std::string &name) const;
+
+        /// Events, with total duration of each name, and counters.
+        void dump_json(std::ostream &out) const;
+
+        /// Chrome trace format, to be loaded by "chrome://tracing" or Perfetto.
+        void dump_trace(std::ostream &out) const;
+
+    private:
+        size_t thread_index();
+    };
+
+    PROFILER &profiler();
+
+    /// Record the lifetime of an object as an event named "name".
+    class SCOPED_TIMER
+    {
+    private:
+        const char *m_name;
+        double m_start;
+
+    public:
+        explicit SCOPED_TIMER(const char *name);
+
+        SCOPED_TIMER(const SCOPED_TIMER &rhs) = delete;
+
+        ~SCOPED_TIMER();
+    };
 }
 
 #endif
@@ -10,7 +10,6 @@
 #include <cstddef>
 #include <vector>
 #include <utility>
-#include <regex>
 #include "common.h"
 
 #define BC_ENUM { UNPROCESSED, ONE_TO_ONE, SYM, WALL, INFLOW, OUTFLOW, FAR }
@@ -42,6 +41,9 @@ namespace GridTool::NMF
         ~BC() = default;
     };
 
+    /// Common part of cells.
+    /// No virtual functions, so that cells of a block can be
+    /// stored by value in a contiguous array.
     class CELL
     {
     protected:
@@ -53,21 +55,11 @@ namespace GridTool::NMF
 
         CELL(const CELL &rhs) = default;
 
-        virtual ~CELL() = default;
+        ~CELL() = default;
 
         size_t CellSeq() const;
 
         size_t &CellSeq();
-
-        /// 1-based indexing of node
-        virtual size_t NodeSeq(size_t n) const = 0;
-
-        virtual size_t &NodeSeq(size_t n) = 0;
-
-        /// 1-based indexing of face
-        virtual size_t FaceSeq(size_t n) const = 0;
-
-        virtual size_t &FaceSeq(size_t n) = 0;
     };
 
     class QUAD_CELL : public CELL
@@ -226,7 +218,8 @@ namespace GridTool::NMF
         };
 
     private:
-        Array1D<QUAD_CELL*> m_cell;
+        /// Stored by value, in the same (i, j) order as "cell".
+        Array1D<QUAD_CELL> m_cell;
         Array1D<FRAME> m_frame;
         Array1D<VERTEX> m_vertex;
 
@@ -325,11 +318,24 @@ namespace GridTool::NMF
         };
 
     private:
-        Array1D<HEX_CELL*> m_cell;
+        /// Stored by value, in the same (i, j, k) order as "cell".
+        /// Empty unless "allocate_cell_storage" is called.
+        Array1D<HEX_CELL> m_cell;
         Array1D<VERTEX> m_vertex;
         Array1D<FRAME> m_frame;
         Array1D<SURF> m_surf;
 
+        /// Global 1-based index of nodes and faces on each surface,
+        /// see "surface_node_index" and "surface_face_index" for the layout.
+        Array1D<std::vector<size_t>> m_surfNode;
+        Array1D<std::vector<size_t>> m_surfFace;
+
+        /// Num of block-interior nodes, block-internal faces and cells
+        /// numbered ahead of this block.
+        size_t m_nodeOffset;
+        size_t m_faceOffset;
+        size_t m_cellOffset;
+
     public:
         Block3D() = delete;
 
@@ -390,32 +396,68 @@ namespace GridTool::NMF
 
         size_t surface_face_num(short idx) const;
 
+        /// Num of nodes in primary and secondary direction of surface "f".
+        void surface_size(short f, size_t &n_pri, size_t &n_sec) const;
+
         size_t shell_face_num() const;
 
+        /// Storage of global indices of nodes and faces on the 6 surfaces.
+        /// Allocated by "Mapping3D::numbering", whether cell storage is adopted or not.
+        void release_shell_storage();
+
+        void allocate_shell_storage();
+
+        bool has_shell_storage() const;
+
+        /// Global 1-based index of the face on surface "f".
+        /// "pri" and "sec" are 1-based local index of the lower-left node of the face,
+        /// see "surface_node_coordinate" for their meaning.
         size_t &surface_face_index(short f, size_t pri, size_t sec);
 
-        size_t &vertex_node_index(short v);
+        size_t surface_face_index(short f, size_t pri, size_t sec) const;
 
-        void interior_node_occurance(size_t i, size_t j, size_t k, std::vector<size_t*> &oc);
+        /// Global 1-based index of the node on surface "f".
+        /// Nodes on frames appear on more than 1 surface, use "assign_node_index" to modify.
+        size_t &surface_node_index(short f, size_t pri, size_t sec);
 
-        void surface_node_coordinate(short f, size_t pri_seq, size_t sec_seq, size_t &i, size_t &j, size_t &k);
+        size_t surface_node_index(short f, size_t pri, size_t sec) const;
 
-        void surface_internal_node_occurance(short f, size_t pri, size_t sec, std::vector<size_t*> &oc);
+        void vertex_node_coordinate(short v, size_t &i, size_t &j, size_t &k) const;
 
-        void frame_internal_node_occurace(short f, size_t idx, std::vector<size_t*> &oc);
+        void surface_node_coordinate(short f, size_t pri_seq, size_t sec_seq, size_t &i, size_t &j, size_t &k) const;
 
-        size_t node_index(size_t i, size_t j, size_t k);
+        void frame_node_coordinate(short f, size_t idx, size_t &i, size_t &j, size_t &k) const;
 
-    private:
-        void setup_dependence();
+        /// Assign global index to the node on block surfaces, all occurrences are updated.
+        void assign_node_index(size_t i, size_t j, size_t k, size_t val);
 
-        void establish_connections();
+        /// Global 1-based index of node (i, j, k), available after numbering.
+        /// Nodes on surfaces are looked up, while block-interior nodes are computed.
+        size_t node_index(size_t i, size_t j, size_t k) const;
+
+        /// Global 1-based index of cell (i, j, k), available after numbering.
+        size_t cell_index(size_t i, size_t j, size_t k) const;
+
+        /// Global 1-based index of the "f"-th face (see "HEX_CELL::FaceSeq") of cell (i, j, k),
+        /// available after numbering.
+        size_t face_index(size_t i, size_t j, size_t k, short f) const;
+
+        size_t node_offset() const;
 
-        short isVertexNode(size_t i, size_t j, size_t k) const;
+        size_t &node_offset();
 
-        void isFrameInternalNode(size_t i, size_t j, size_t k, short &f, size_t &idx) const;
+        size_t face_offset() const;
+
+        size_t &face_offset();
+
+        size_t cell_offset() const;
+
+        size_t &cell_offset();
+
+    private:
+        void setup_dependence();
 
-        void isSurfaceInternalNode(size_t i, size_t j, size_t k, short &s, size_t &pri, size_t &sec) const;
+        void establish_connections();
     };
 
     class Mapping2D
@@ -634,6 +676,41 @@ namespace GridTool::NMF
         Array1D<Array1D<Block3D::FRAME*>> m_frame;
         Array1D<Array1D<Block3D::SURF*>> m_surf;
 
+        /// Equivalence classes of vertices, frames and surfaces of all blocks over dense ids,
+        /// see "vertex_id", "frame_id" and "surface_id".
+        /// Parity of a frame tells whether it runs opposite to the representative of its class.
+        COMMON::DISJOINT_SET m_vertexSet;
+        COMMON::DISJOINT_SET m_frameSet;
+        COMMON::DISJOINT_SET m_surfSet;
+
+        /// Entries covering a block surface, for point queries in O(log n).
+        /// Node indices bounding all ranges on the surface are sorted and made distinct
+        /// in each direction, and each rectangle between consecutive ones refers to the
+        /// entry covering it, with "pri" varying fastest.
+        struct SURFACE_INDEX
+        {
+            std::vector<size_t> pri, sec;
+            std::vector<size_t> entry; /// 1-based index of the covering entry, 0 if not covered.
+            std::vector<short> side; /// Which range of the entry lies on the surface, 1 or 2.
+            size_t interface_face_num = 0; /// Num of faces covered by 1-to-1 entries.
+        };
+
+        /// Surface "f" of block "b" goes to "Block3D::NumOfSurf * (b - 1) + (f - 1)".
+        std::vector<SURFACE_INDEX> m_surfIndex;
+
+        /// Set if some 1-to-1 entry covers a block surface only partially,
+        /// e.g. a surface split into several patches connected to different blocks.
+        /// Such entries are not reflected by "Block3D::SURF::neighbourSurf", and nodes
+        /// on block surfaces are then merged by "merge_shell_node" instead of frames and vertices.
+        bool m_partial = false;
+
+        /// Entries of surface node tables of all blocks, the (pri, sec) node on surface "f"
+        /// of block "b" is given "m_shellOffset[Block3D::NumOfSurf * (b - 1) + (f - 1)] + (pri - 1) + (sec - 1) * n_pri".
+        /// Only used when "m_partial" is set.
+        std::vector<size_t> m_shellOffset;
+        COMMON::DISJOINT_SET m_shellNodeSet;
+        size_t m_shellNodeNum = 0;
+
     public:
         Mapping3D() = default;
 
@@ -649,7 +726,10 @@ namespace GridTool::NMF
         {
             // Copy blocks
             for (size_t i = 0; i < m_blk.size(); ++i)
+            {
                 m_blk[i] = new Block3D(*rhs.m_blk[i]);
+                m_blk[i]->index() = rhs.m_blk[i]->index();
+            }
 
             // Copy entries
             for (size_t i = 0; i < m_entry.size(); ++i)
@@ -665,15 +745,52 @@ namespace GridTool::NMF
             compute_topology();
         }
 
+        /// Blocks and entries are taken over, "rhs" is left empty.
+        Mapping3D(Mapping3D &&rhs) noexcept { *this = std::move(rhs); }
+
         ~Mapping3D() { release_all(); }
 
+        Mapping3D &operator=(const Mapping3D &rhs) = delete;
+
+        /// Topology refers to blocks by pointers, thus it is still valid after moving.
+        Mapping3D &operator=(Mapping3D &&rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                release_all();
+                m_blk = std::move(rhs.m_blk);
+                m_entry = std::move(rhs.m_entry);
+                rhs.m_blk.clear();
+                rhs.m_entry.clear();
+
+                m_vertex = std::move(rhs.m_vertex);
+                m_frame = std::move(rhs.m_frame);
+                m_surf = std::move(rhs.m_surf);
+                m_vertexSet = std::move(rhs.m_vertexSet);
+                m_frameSet = std::move(rhs.m_frameSet);
+                m_surfSet = std::move(rhs.m_surfSet);
+                m_surfIndex = std::move(rhs.m_surfIndex);
+                m_partial = std::exchange(rhs.m_partial, false);
+                m_shellOffset = std::move(rhs.m_shellOffset);
+                m_shellNodeSet = std::move(rhs.m_shellNodeSet);
+                m_shellNodeNum = std::exchange(rhs.m_shellNodeNum, 0);
+            }
+            return *this;
+        }
+
         void readFromFile(const std::string &path);
 
         void compute_topology();
 
         void summary(std::ostream &out);
 
-        void numbering();
+        /// Assign global index to nodes, faces and cells.
+        /// Indices on block surfaces are stored, the others are computed on demand,
+        /// see "Block3D::node_index", "Block3D::face_index" and "Block3D::cell_index".
+        /// "HEX_CELL"s of each block are allocated and filled only if "cell_storage" is "true".
+        /// If "subset" is given, only blocks flagged in it are allocated and filled, e.g. blocks
+        /// of a single MPI rank, while indices are the same as those of numbering all blocks.
+        void numbering(bool cell_storage = true, const std::vector<bool> &subset = {});
 
         void writeToFile(const std::string &path);
 
@@ -697,6 +814,47 @@ namespace GridTool::NMF
 
         size_t nNode() const;
 
+        size_t nEntry() const { return m_entry.size(); }
+
+        /// B.C. of the "n"-th (1-based) entry, in order of the map file.
+        int entry_type(size_t n) const { return m_entry(n)->Type(); }
+
+        /// Entry covering the face "(pri, sec)" on surface "f" of block "b", all 1-based,
+        /// where "pri" and "sec" range from 1 to num of nodes in each direction minus 1.
+        /// Returns the 1-based index of the entry, 0 if not covered, and "side" is set
+        /// to 1 or 2 telling which range of the entry lies on the surface.
+        size_t covering_entry(size_t b, short f, size_t pri, size_t sec, short &side) const;
+
+        /// Num of faces on surface "f" of block "b" covered by 1-to-1 interfaces, and the others.
+        /// A surface may have both when it is split into patches.
+        size_t surface_interface_face_num(size_t b, short f) const;
+
+        size_t surface_boundary_face_num(size_t b, short f) const;
+
+        /// Distribute cells into "nPart" parts of balanced size for domain decomposition.
+        /// Parts are grown one by one from blocks most connected through 1-to-1 entries,
+        /// and a block exceeding the remaining share of a part is split into slabs across
+        /// its longest direction. Returns 0-based part of each cell, taking cells in the order
+        /// of "numbering", which needs not be called beforehand.
+        std::vector<int> partition(size_t nPart) const;
+
+        /// Block "b" and local (i, j, k) of the cell with 1-based global index "c",
+        /// the inverse of "Block3D::cell_index", available after numbering.
+        void locate_cell(size_t c, size_t &b, size_t &i, size_t &j, size_t &k) const;
+
+        /// Structured export of the multi-block grid "f_p3d" described by this mapping,
+        /// neither numbering nor cell storage is needed. Blocks are loaded one by one,
+        /// and coordinates of each are written in bulk as raw binary.
+        /// VTK: "<prefix>.vtm" refers to "<prefix>_<n>.vts" of block "n", 1-based.
+        void writeVTK(const std::string &f_p3d, const std::string &prefix) const;
+
+#ifdef TYDF_USE_CGNS
+        /// CGNS: a single base with a structured zone "Block<n>" for block "n", 1-to-1 entries
+        /// become GridConnectivity1to1 on both sides, with the transform from swap and trends,
+        /// and the other entries become BC_t.
+        void writeCGNS(const std::string &f_p3d, const std::string &dst) const;
+#endif
+
         // 1-based indexing
         Block3D &block(size_t n)
         {
@@ -762,17 +920,38 @@ namespace GridTool::NMF
 
         void connecting();
 
+        /// Dense 0-based ids, e.g. the "n"-th frame of the "b"-th block
+        /// is given "Block3D::NumOfFrame * (b - 1) + (n - 1)".
+        static size_t surface_id(const Block3D::SURF *s);
+
+        static size_t frame_id(const Block3D::FRAME *e);
+
+        static size_t vertex_id(const Block3D::VERTEX *v);
+
+        /// Merge equivalent ones by union-find, and assign "global_index" to each class.
         int coloring_surface();
 
         int coloring_frame();
 
         int coloring_vertex();
 
+        /// Number classes of "eqv" from 1, "global_index(id)" refers to the index of element "id".
+        /// Returns the num of classes.
+        template<typename F>
+        int assign_color(COMMON::DISJOINT_SET &eqv, const F &global_index);
+
         void numbering_cell();
 
         void numbering_face();
 
         void numbering_node();
+
+        /// Build "m_surfIndex" from entries.
+        void index_entries();
+
+        /// Merge entries of surface node tables referring to the same node, within each block
+        /// and across 1-to-1 interfaces, see "m_shellNodeSet".
+        void merge_shell_node();
     };
 }
 
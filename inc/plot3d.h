@@ -1,7 +1,10 @@
 #ifndef TYDF_PLOT3D_H
 #define TYDF_PLOT3D_H
 
+#include <array>
+#include <string>
 #include <vector>
+#include <fstream>
 #include "common.h"
 
 namespace GridTool::PLOT3D
@@ -9,8 +12,19 @@ namespace GridTool::PLOT3D
     using COMMON::Vector;
     using COMMON::DIM;
     using COMMON::ArrayND;
+    using COMMON::PLANAR;
 
-    class BLK : public DIM, public ArrayND<Vector>
+    /// Layout of PLOT3D grid files, all are multi-block and whole.
+    enum FILE_FORMAT
+    {
+        FORMATTED = 0,  /// ASCII text.
+        BINARY = 1,     /// Raw binary, without record markers, as written by C.
+        UNFORMATTED = 2 /// Fortran sequential unformatted, with 4-byte record markers.
+    };
+
+    /// Coordinates are stored plane by plane (X, then Y, then Z),
+    /// as laid out in PLOT3D files.
+    class BLK : public DIM, public ArrayND<Vector, PLANAR>
     {
     public:
         BLK(size_t nI, size_t nJ, bool is3D);
@@ -19,6 +33,12 @@ namespace GridTool::PLOT3D
 
         BLK(const BLK &rhs) = default;
 
+        BLK(BLK &&rhs) noexcept = default;
+
+        BLK &operator=(const BLK &rhs) = default;
+
+        BLK &operator=(BLK &&rhs) noexcept = default;
+
         ~BLK() = default;
 
         size_t node_num() const;
@@ -32,6 +52,123 @@ namespace GridTool::PLOT3D
         size_t internal_face_num() const;
     };
 
+    /// Read-only view of a binary or unformatted PLOT3D grid file.
+    /// The file is memory-mapped, and coordinates are accessed in place.
+    /// Record markers, byte order and precision (single or double)
+    /// are detected from the header and the size of the file.
+    class MAPPED_GRID
+    {
+    public:
+        /// Coordinates of a single block within the file.
+        class VIEW
+        {
+        private:
+            const MAPPED_GRID *m_grid;
+
+            /// "K" is 0 if absent.
+            std::array<size_t, 3> m_dim;
+
+            /// Start of X, Y and Z, Z is "nullptr" if absent.
+            std::array<const char*, 3> m_plane;
+
+        public:
+            VIEW(const MAPPED_GRID *grid, const std::array<size_t, 3> &dim, const char *data);
+
+            VIEW(const VIEW &rhs) = default;
+
+            ~VIEW() = default;
+
+            /// "K" dimension is 0 if absent.
+            const std::array<size_t, 3> &dimension() const;
+
+            size_t node_num() const;
+
+            /// 0-based indexing
+            Vector at(size_t i, size_t j, size_t k = 0) const;
+
+            /// 1-based indexing
+            Vector operator()(size_t i, size_t j, size_t k = 1) const;
+
+            /// Copy into a stand-alone block, the caller takes the ownership.
+            BLK *load() const;
+        };
+
+    private:
+        COMMON::MAPPED_FILE m_file;
+
+        int m_format;
+        bool m_single;
+        bool m_swap;
+        std::vector<VIEW> m_blk;
+
+    public:
+        MAPPED_GRID() = delete;
+
+        explicit MAPPED_GRID(const std::string &src);
+
+        MAPPED_GRID(const MAPPED_GRID &rhs) = delete;
+
+        ~MAPPED_GRID() = default;
+
+        size_t numOfBlock() const;
+
+        /// 0-based indexing
+        const VIEW &block(size_t loc_idx) const;
+
+        /// "BINARY" or "UNFORMATTED".
+        int format() const;
+
+        bool single_precision() const;
+
+        /// "true" if byte order differs from that of the host.
+        bool byte_swapped() const;
+
+    private:
+        bool detect(int format, bool swap);
+
+        double value(const char *p) const;
+    };
+
+    /// Sequential reader of PLOT3D grid file in any "FILE_FORMAT".
+    /// Blocks are loaded one after another, so that only 1 block
+    /// has to reside in memory at a time.
+    class READER
+    {
+    private:
+        std::ifstream m_fin;
+
+        /// Binary files are mapped, "nullptr" for formatted ones.
+        MAPPED_GRID *m_bin;
+
+        /// Dimensions of each block as declared, "K" is 0 if absent.
+        std::vector<std::array<size_t, 3>> m_dim;
+
+        /// Num of blocks loaded.
+        size_t m_cnt;
+
+    public:
+        READER() = delete;
+
+        explicit READER(const std::string &src);
+
+        READER(const READER &rhs) = delete;
+
+        ~READER();
+
+        size_t numOfBlock() const;
+
+        /// 0-based indexing, "K" dimension is 0 if absent.
+        const std::array<size_t, 3> &block_dimension(size_t loc_idx) const;
+
+        /// Load the next block, the caller takes the ownership.
+        /// "nullptr" is returned if all blocks have been loaded.
+        BLK *next();
+
+        /// Pass over the next block without loading it, only formatted files are parsed.
+        /// "false" is returned if all blocks have been loaded.
+        bool skip();
+    };
+
     class GRID : public DIM
     {
     private:
@@ -44,20 +181,35 @@ namespace GridTool::PLOT3D
 
         GRID(const GRID &rhs);
 
+        /// Blocks are taken over, "rhs" is left empty.
+        GRID(GRID &&rhs) noexcept;
+
         ~GRID();
 
+        GRID &operator=(const GRID &rhs) = delete;
+
+        GRID &operator=(GRID &&rhs) noexcept;
+
         size_t numOfBlock() const;
 
         /// IO
+        /// Blocks are read and written concurrently by "COMMON::num_of_thread()" threads.
         void readFromFile(const std::string &src);
 
-        void writeToFile(const std::string &dst) const;
+        /// Multi-byte values are written in the byte order of the host.
+        void writeToFile(const std::string &dst, int format = FORMATTED, bool single_precision = false) const;
 
         /// 0-based indexing
         BLK *block(size_t loc_idx);
 
+        /// Append "blk" as the last block, this grid takes the ownership.
+        void append(BLK *blk);
+
     private:
         void release_all();
+
+        /// "BINARY" if "marker" is "false", otherwise "UNFORMATTED".
+        void write_binary(const std::string &dst, bool marker, bool single_precision) const;
     };
 }
 #endif
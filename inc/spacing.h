@@ -1,7 +1,11 @@
 #ifndef TYDF_SPACING_H
 #define TYDF_SPACING_H
 
+#include <cstddef>
 #include <vector>
+#include <map>
+#include <array>
+#include <tuple>
 
 typedef std::vector<double> DIST_ARR;
 
@@ -82,6 +86,92 @@ namespace GridTool::SPACING
      * @param dst Target distribution.
      */
     void hyperbolic_sine(int n, double c, DIST_ARR &dst);
+
+    /// Kinds of distributions evaluated in batch, see "REQUEST".
+    enum KIND
+    {
+        UNIFORM = 0,
+        CHEBSHEV = 1,
+        SINGLE_EXPONENTIAL = 2,
+        DOUBLE_EXPONENTIAL = 3,
+        HYPERBOLIC_TANGENT = 4,
+        HYPERBOLIC_SINE = 5
+    };
+
+    /**
+     * Specification of a single distribution of n nodes.
+     * Parameters are the same as the non-batched version of each kind:
+     *   UNIFORM:            none, through [0, 1];
+     *   CHEBSHEV:           "a", "b", through [a, b];
+     *   SINGLE_EXPONENTIAL: "a";
+     *   DOUBLE_EXPONENTIAL: "a1", "a2", "a3";
+     *   HYPERBOLIC_TANGENT: "b";
+     *   HYPERBOLIC_SINE:    "c".
+     * Unused parameters are ignored.
+     */
+    struct REQUEST
+    {
+        KIND kind;
+        int n;
+        std::array<double, 3> param;
+    };
+
+    /**
+     * Num of nodes of all given distributions.
+     * @param req Specifications.
+     * @param cnt Num of specifications.
+     */
+    std::size_t node_num(const REQUEST *req, std::size_t cnt);
+
+    /**
+     * Evaluate distributions one after another into a preallocated buffer.
+     * Exponential and hyperbolic functions are evaluated in batch by vectorized kernels,
+     * results agree with the non-batched version to within a few ulps of 1,
+     * and are identical whatever "COMMON::simd_isa()" is.
+     * @param req Specifications.
+     * @param cnt Num of specifications.
+     * @param dst Target buffer of at least "node_num(req, cnt)" values,
+     *            the "i"-th distribution follows the "(i-1)"-th one immediately.
+     */
+    void distribute(const REQUEST *req, std::size_t cnt, double *dst);
+
+    /// Memoized distributions, keyed on kind, num of nodes and parameters.
+    /// Not thread-safe, each thread should have its own.
+    class CACHE
+    {
+    private:
+        typedef std::tuple<int, int, double, double, double> KEY;
+
+        std::map<KEY, DIST_ARR> m_entry;
+        std::size_t m_hit = 0, m_miss = 0;
+
+    public:
+        CACHE() = default;
+
+        CACHE(const CACHE &rhs) = default;
+
+        ~CACHE() = default;
+
+        /// Evaluated on the first request, the reference stays valid until "clear".
+        const DIST_ARR &at(const REQUEST &req);
+
+        /// Same as "SPACING::distribute", but only those never requested are evaluated.
+        void distribute(const REQUEST *req, std::size_t cnt, double *dst);
+
+        /// Num of distinct distributions stored.
+        std::size_t size() const;
+
+        /// Num of requests satisfied by stored distributions.
+        std::size_t hit() const;
+
+        /// Num of requests evaluated and then stored.
+        std::size_t miss() const;
+
+        void clear();
+
+    private:
+        static KEY key(const REQUEST &req);
+    };
 }
 
 #endif
@@ -2,6 +2,7 @@
 #define TYDF_XF_H
 
 #include <cstddef>
+#include <cstdint>
 #include <istream>
 #include <ostream>
 #include <iostream>
@@ -15,13 +16,26 @@
 #include <utility>
 #include <algorithm>
 #include <cmath>
+#include <atomic>
+#include <mutex>
 #include "common.h"
 
+#ifdef TYDF_USE_MPI
+#include <mpi.h>
+#endif
+
+namespace GridTool::NMF
+{
+    class Mapping3D;
+}
+
 namespace GridTool::XF
 {
     using GridTool::COMMON::Vector;
     using GridTool::COMMON::DIM;
     using GridTool::COMMON::Array1D;
+    using GridTool::COMMON::IndexArray;
+    using GridTool::COMMON::CSR;
     using GridTool::COMMON::wrong_index;
     using GridTool::COMMON::wrong_string;
 
@@ -36,7 +50,17 @@ namespace GridTool::XF
             CELL = 12,
             FACE = 13,
             EDGE = 11,
-            ZONE = 39, ZONE_MESHING = 45
+            ZONE = 39, ZONE_MESHING = 45,
+
+            /// Binary variants.
+            /// Body of these sections is stored as raw native-endian data
+            /// and terminated by ")End of Binary Section <id>)".
+            NODE_BIN_SP = 2010,
+            NODE_BIN_DP = 3010,
+            CELL_BIN = 2012,
+            CELL_BIN_DP = 3012,
+            FACE_BIN = 2013,
+            FACE_BIN_DP = 3013
         };
 
     private:
@@ -53,6 +77,10 @@ namespace GridTool::XF
 
         virtual void repr(std::ostream &out) = 0;
 
+        /// Binary representation, identical to "repr" by default.
+        /// Only NODE, CELL and FACE have a binary counterpart.
+        virtual void repr_binary(std::ostream &out);
+
         int identity() const;
     };
 
@@ -216,6 +244,13 @@ namespace GridTool::XF
 
         static int str2idx(const std::string &x);
 
+        /// Max num of chars of a single node in text form.
+        static const size_t RecordWidth = 3 * 32 + 1;
+
+        /// Text of a single node with "nd" coordinates within a section body,
+        /// written at "p", and the end of text is returned.
+        static char *put_record(char *p, const Vector &x, int nd);
+
     private:
         int m_type;
 
@@ -224,8 +259,13 @@ namespace GridTool::XF
 
         NODE(size_t zone, size_t first, size_t last, int tp, int ND);
 
+        /// Adopt "coord" as nodal coordinates, whose size must be "last - first + 1".
+        NODE(size_t zone, size_t first, size_t last, int tp, int ND, std::vector<Vector> &&coord);
+
         NODE(const NODE &rhs);
 
+        NODE(NODE &&rhs) noexcept;
+
         ~NODE() = default;
 
         bool is_virtual_node() const;
@@ -241,6 +281,8 @@ namespace GridTool::XF
         int ND() const;
 
         void repr(std::ostream &out);
+
+        void repr_binary(std::ostream &out);
     };
 
     class CELL : public RANGE, public std::vector<int>
@@ -309,8 +351,13 @@ namespace GridTool::XF
 
         CELL(size_t zone, size_t first, size_t last, int type, int elem_type);
 
+        /// Adopt "elem" as element types, whose size must be "last - first + 1".
+        CELL(size_t zone, size_t first, size_t last, int type, int elem_type, std::vector<int> &&elem);
+
         CELL(const CELL &rhs);
 
+        CELL(CELL &&rhs) noexcept;
+
         ~CELL() = default;
 
         /// Type of cells within this section: DEAD cell, FLUID cell or SOLID cell.
@@ -324,6 +371,8 @@ namespace GridTool::XF
         int &element_type();
 
         void repr(std::ostream &out);
+
+        void repr_binary(std::ostream &out);
     };
 
     class CONNECTIVITY
@@ -399,6 +448,14 @@ namespace GridTool::XF
 
         static int str2idx(const std::string &x);
 
+        /// Max num of chars of a single face in text form.
+        static const size_t RecordWidth = 7 * 24 + 1;
+
+        /// Text of a single face with "x" nodes "n" and adjacent cells "c0" and "c1"
+        /// within a section body, where "x" leads the record if "mixed". Written at "p",
+        /// and the end of text is returned.
+        static char *put_record(char *p, int x, const size_t *n, size_t c0, size_t c1, bool mixed);
+
     private:
         int m_bc;
         int m_face;
@@ -408,8 +465,13 @@ namespace GridTool::XF
 
         FACE(size_t zone, size_t first, size_t last, int bc, int face);
 
+        /// Adopt "cnect" as connectivities, whose size must be "last - first + 1".
+        FACE(size_t zone, size_t first, size_t last, int bc, int face, std::vector<CONNECTIVITY> &&cnect);
+
         FACE(const FACE &rhs);
 
+        FACE(FACE &&rhs) noexcept;
+
         ~FACE() = default;
 
         /// B.C. of faces within this group.
@@ -423,6 +485,29 @@ namespace GridTool::XF
         int &face_type();
 
         void repr(std::ostream &out);
+
+        void repr_binary(std::ostream &out);
+    };
+
+    /// Compile-time shape of cells of element type "T", for meshes whose cells are all of the same type.
+    /// Only the shapes glued from structured grids are given, i.e. hex in 3D and quad in 2D.
+    template<int T>
+    struct CELL_SHAPE;
+
+    template<>
+    struct CELL_SHAPE<CELL::HEXAHEDRAL>
+    {
+        static const int FaceType = FACE::QUADRILATERAL;
+        static const size_t NumOfNode = 8;
+        static const size_t NumOfFace = 6;
+    };
+
+    template<>
+    struct CELL_SHAPE<CELL::QUADRILATERAL>
+    {
+        static const int FaceType = FACE::LINEAR;
+        static const size_t NumOfNode = 4;
+        static const size_t NumOfFace = 4;
     };
 
     class ZONE :public SECTION
@@ -524,70 +609,94 @@ namespace GridTool::XF
             internal_error(int err, const std::string &msg) : std::runtime_error("Internal error occurred with error code: " + std::to_string(err) + " and error message: \"" + msg + "\".") {}
         };
 
-    protected:
+    public:
+        /// Read-only views of derived records.
         /// Index of node, face, and cell starts from 1 
         /// and increase continuously. But zone is different.
         struct NODE_ELEM
         {
-            Vector coordinate;
-            bool atBdry;
+            const Vector coordinate;
+            const bool atBdry;
 
             /// Nodal connectivity
-            Array1D<size_t> adjacentNode;
+            const CSR::ROW adjacentNode;
 
             /// Facial connectivity
-            Array1D<size_t> dependentFace;
+            const CSR::ROW dependentFace;
 
             /// Cell connectivity
-            Array1D<size_t> dependentCell;
+            const CSR::ROW dependentCell;
         };
 
         struct FACE_ELEM
         {
-            int type; /// Shape
-            Vector center;
-            double area;
-            bool atBdry;
+            const int type; /// Shape
+            const Vector center;
+            const double area;
+            const bool atBdry;
 
             /// Nodal connectivity
-            Array1D<size_t> includedNode;
+            const CSR::ROW includedNode;
 
             /// Cell connectivity
             /// Legacy notation is adopted.
             /// Should keep in mind that "rightCell" is the cell pointed by thumb when
             /// curling fingers of right hand in the order of nodes within "includedNode".
-            size_t leftCell, rightCell;
+            const size_t leftCell, rightCell;
 
             /// Surface unit normal
             /// Legacy notation is adopted.
             /// "LR" means from "leftCell" to "rightCell"
             /// "RL" means from "rightCell" to "leftCell"
-            Vector n_LR, n_RL;
+            const Vector n_LR, n_RL;
+        };
+
+        /// Outward normal vectors of faces within a cell, evaluated on access.
+        class NORMAL_ROW
+        {
+        private:
+            const MESH *m_mesh;
+            size_t m_cell;
+            bool m_weighted;
+
+        public:
+            NORMAL_ROW(const MESH *mesh, size_t cell, bool weighted);
+
+            size_t size() const;
+
+            /// 0-based indexing
+            Vector at(size_t j) const;
+
+            Vector operator[](size_t j) const;
+
+            /// 1-based indexing
+            Vector operator()(int j) const;
         };
 
         struct CELL_ELEM
         {
-            int type; /// Shape
-            Vector center;
-            double volume;
+            const int type; /// Shape
+            const Vector center;
+            const double volume;
 
             /// Nodal connectivity
-            Array1D<size_t> includedNode;
+            const CSR::ROW includedNode;
 
             /// Facial connectivity
-            Array1D<size_t> includedFace;
+            const CSR::ROW includedFace;
 
             /// Cell connectivity
             /// Size is equal to that of "includedFace".
             /// If adjacent cell is boundary, corresponding value will be set to 0.
-            Array1D<size_t> adjacentCell;
+            const CSR::ROW adjacentCell;
 
             /// Surface outward normal vector
             /// Size is equal to that of "includedFace".
-            Array1D<Vector> n; /// Unit
-            Array1D<Vector> S; /// Norm equals to area of corresponding face
+            const NORMAL_ROW n; /// Unit
+            const NORMAL_ROW S; /// Norm equals to area of corresponding face
         };
 
+    protected:
         struct ZONE_ELEM
         {
             /// Index of this zone.
@@ -609,28 +718,150 @@ namespace GridTool::XF
         size_t m_totalFaceNum;
 
         /// Derived
-        Array1D<NODE_ELEM> m_node;
-        Array1D<FACE_ELEM> m_face;
-        Array1D<CELL_ELEM> m_cell;
+        /// Element-wise quantities are stored in planar form, and
+        /// connectivities are stored in CSR form, whose row "i" refers to element "i+1".
+        /// Computed on demand by "derive", see "NODE_ADJACENCY" etc.
+        mutable COMMON::VectorArray m_nodeCoordinate;
+        mutable std::vector<char> m_nodeAtBdry;
+        mutable CSR m_nodeAdjacentNode;
+        mutable CSR m_nodeDependentFace;
+        mutable CSR m_nodeDependentCell;
+
+        mutable std::vector<int> m_faceType;
+        mutable COMMON::VectorArray m_faceCenter;
+        mutable std::vector<double> m_faceArea;
+        mutable std::vector<char> m_faceAtBdry;
+        mutable CSR m_faceIncludedNode;
+        mutable IndexArray m_faceLeftCell;
+        mutable IndexArray m_faceRightCell;
+        mutable COMMON::VectorArray m_faceNormal; /// "n_LR", "n_RL" is the opposite.
+
+        mutable std::vector<int> m_cellType;
+        mutable COMMON::VectorArray m_cellCenter;
+        mutable std::vector<double> m_cellVolume;
+        mutable CSR m_cellIncludedNode;
+        mutable CSR m_cellIncludedFace;
+        mutable IndexArray m_cellAdjacentCell; /// Share offsets with "m_cellIncludedFace".
+
         size_t m_totalZoneNum;
         std::map<size_t, size_t> m_zoneMapping;
         Array1D<ZONE_ELEM> m_zone;
 
+        /// Features available so far, and the lock taken when computing others.
+        mutable std::atomic<int> m_derived;
+        mutable std::mutex m_deriveLock;
+
+        /// Whether "renumber" is applied since loaded or glued.
+        bool m_renumbered;
+
     public:
+        /// Derived features, each computed on its first access, or beforehand
+        /// if requested when loading or by "derive".
+        /// Nodal coordinates, shapes and nodes of faces, cells besides faces and
+        /// shapes of cells are the primary records, set up along with any of them.
+        enum {
+            NODE_ADJACENCY = 1, /// "nodeAdjacentNode", "nodeDependentFace" and "nodeDependentCell".
+            FACE_GEOMETRY = 2,  /// "faceCenter", "faceArea" and "faceNormal".
+            CELL_ADJACENCY = 4, /// "cellIncludedNode", "cellIncludedFace" and "cellAdjacentCell".
+            CELL_GEOMETRY = 8,  /// "cellCenter" and "cellVolume", on top of "FACE_GEOMETRY" and "CELL_ADJACENCY".
+            ALL_DERIVED = 15
+        };
+
         MESH();
 
-        MESH(const std::string &inp, std::ostream &fout = std::cout);
+        /// Features in "derived" are computed right after loading, others are left until accessed.
+        MESH(const std::string &inp, std::ostream &fout = std::cout, int derived = ALL_DERIVED);
 
         MESH(const std::string &f_nmf, const std::string &f_p3d, std::ostream &fout = std::cout);
 
+        /// Glue with a mapping numbered beforehand, see "NMF::Mapping3D::numbering".
+        /// The same mapping can be reused for grids sharing the topology.
+        MESH(const NMF::Mapping3D &nmf, const std::string &f_p3d, std::ostream &fout = std::cout);
+
         MESH(const MESH &rhs) = delete;
 
+        /// Sections and derived quantities are taken over, "rhs" is left empty.
+        MESH(MESH &&rhs) noexcept;
+
         ~MESH();
 
+        MESH &operator=(const MESH &rhs) = delete;
+
+        MESH &operator=(MESH &&rhs) noexcept;
+
         /// IO
-        void readFromFile(const std::string &src, std::ostream &fout);
+        /// Pure conversion may take "derived" as 0, then nothing but the zone table is set up.
+        /// Records are validated along with the primary ones, thus errors within
+        /// may not be reported until then.
+        void readFromFile(const std::string &src, std::ostream &fout, int derived = ALL_DERIVED);
+
+        /// Sections NODE, CELL and FACE are written in the binary form
+        /// (3010, 2012, 2013) if "binary" is "true".
+        void writeToFile(const std::string &dst, bool binary = false) const;
+
+        /// Glue multi-block grid into "f_msh" directly, in the same layout
+        /// as "MESH(f_nmf, f_p3d).writeToFile(f_msh)", but without holding
+        /// the whole mesh in memory. Only text form is supported.
+        static void glue(const std::string &f_nmf, const std::string &f_p3d, const std::string &f_msh, std::ostream &fout = std::cout);
+
+        static void glue(const NMF::Mapping3D &nmf, const std::string &f_p3d, const std::string &f_msh, std::ostream &fout = std::cout);
+
+#ifdef TYDF_USE_MPI
+        /// Distributed version of "glue", collective over "comm".
+        /// Each rank loads a contiguous range of blocks, shared nodes and interface
+        /// faces are merged on the rank owning their indices, and all sections are
+        /// written with MPI-IO at offsets from prefix sums. The output is identical
+        /// to that of the serial version.
+        static void glue(MPI_Comm comm, const std::string &f_nmf, const std::string &f_p3d, const std::string &f_msh, std::ostream &fout = std::cout);
+#endif
+
+        /// Native checkpoint, see "CHECKPOINT" for the layout.
+        /// Derived quantities are stored as well if "derived" is "true",
+        /// then "readCheckpoint" takes them directly instead of computing them.
+        void writeCheckpoint(const std::string &dst, bool derived = true) const;
+
+        /// "derived" is taken as that of "readFromFile", only the requested quantities are decoded if stored.
+        void readCheckpoint(const std::string &src, std::ostream &fout = std::cout, int derived = ALL_DERIVED);
+
+        /// Compute features in "features" which are not available yet, together with
+        /// those they depend on. Concurrent calls are safe.
+        void derive(int features = ALL_DERIVED) const;
+
+        /// Features available so far.
+        int derived() const;
 
-        void writeToFile(const std::string &dst) const;
+        /// Replace nodal coordinates of a mesh glued from "nmf" by those in "f_p3d".
+        /// Connectivity is kept, only geometric quantities are re-computed.
+        /// A renumbered mesh is rejected, as its nodes are no longer in the order of "nmf".
+        void update_node(const NMF::Mapping3D &nmf, const std::string &f_p3d);
+
+        /// Orderings of "renumber".
+        enum {
+            RCM = 1,    /// Reverse Cuthill-McKee on cell adjacency.
+            HILBERT = 2 /// Hilbert curve through cell centers.
+        };
+
+        /// Renumber cells for locality, then faces in the order of their adjacent cells,
+        /// and nodes in the order of first visit by cells.
+        /// Elements are reordered within their own sections, so that interior faces
+        /// and each boundary zone stay contiguous. Derived quantities are re-computed.
+        /// Bandwidth before and after is reported to "fout", the latter is returned.
+        size_t renumber(int ordering, std::ostream &fout = std::cout);
+
+        /// Max difference between indices of the 2 cells of an interior face.
+        size_t bandwidth() const;
+
+        /// Whether "renumber" is applied since loaded or glued, in which case
+        /// cells are no longer in the order of "NMF::Mapping3D::numbering".
+        bool renumbered() const;
+
+        /// Write part "p" of cells into "<prefix>_<p>.msh", for each 0-based "p" given by "part",
+        /// e.g. from "NMF::Mapping3D::partition", which refers to cells in the order of gluing,
+        /// thus a renumbered mesh is rejected. Elements keep the relative order and zones,
+        /// faces shared with part "q" go to a new "interface" zone oriented outward, and the
+        /// map from local elements to global ones and to halo cells is written into "<prefix>_<p>.map".
+        /// Returns the num of interface faces in total.
+        size_t writePartition(const std::vector<int> &part, const std::string &prefix, bool binary = false, std::ostream &fout = std::cout) const;
 
         /// Num of elements
         size_t numOfNode() const;
@@ -642,17 +873,47 @@ namespace GridTool::XF
         size_t numOfZone() const;
 
         /// 1-based access
-        const NODE_ELEM &node(size_t id) const;
+        NODE_ELEM node(size_t id) const;
+
+        FACE_ELEM face(size_t id) const;
+
+        CELL_ELEM cell(size_t id) const;
+
+        /// Compact storage, for bulk processing.
+        /// Row "i" of each table refers to element "i+1", values are 1-based indices.
+        const COMMON::VectorArray &nodeCoordinate() const;
+
+        const CSR &nodeAdjacentNode() const;
 
-        NODE_ELEM &node(size_t id);
+        const CSR &nodeDependentFace() const;
 
-        const FACE_ELEM &face(size_t id) const;
+        const CSR &nodeDependentCell() const;
 
-        FACE_ELEM &face(size_t id);
+        const COMMON::VectorArray &faceCenter() const;
 
-        const CELL_ELEM &cell(size_t id) const;
+        const std::vector<double> &faceArea() const;
 
-        CELL_ELEM &cell(size_t id);
+        const COMMON::VectorArray &faceNormal() const;
+
+        const CSR &faceIncludedNode() const;
+
+        const IndexArray &faceLeftCell() const;
+
+        const IndexArray &faceRightCell() const;
+
+        const COMMON::VectorArray &cellCenter() const;
+
+        const std::vector<double> &cellVolume() const;
+
+        const CSR &cellIncludedNode() const;
+
+        const CSR &cellIncludedFace() const;
+
+        /// Aligned with entries of "cellIncludedFace".
+        const IndexArray &cellAdjacentCell() const;
+
+        /// Memory occupied by derived records computed so far, in bytes.
+        size_t derived_bytes() const;
 
         /// If "isRealZoneID" is "true", then "id" is the real zone index,
         /// otherwise, "id" is the internal storage index.
@@ -666,21 +927,274 @@ namespace GridTool::XF
 
         void clear_entry();
 
-        void raw2derived();
+        /// Take over all contents of "rhs", whose sections are supposed to be released beforehand.
+        void steal(MESH &rhs);
+
+        /// Sections of a multi-block grid, see "MESH(nmf, f_p3d, fout)".
+        void assemble(const NMF::Mapping3D &nmf, const std::string &f_p3d, std::ostream &fout);
+
+        /// Bit of primary records within "m_derived".
+        enum { PRIMARY = 16 };
 
-        void cell_standardization(CELL_ELEM &c);
+        /// Stages of "derive", each filling its own records only.
+        void derive_primary() const;
 
-        void tet_standardization(CELL_ELEM &tet);
+        void derive_node_adjacency() const;
 
-        void pyramid_standardization(CELL_ELEM &pyramid);
+        void derive_cell_adjacency() const;
 
-        void prism_standardization(CELL_ELEM &prism);
+        void derive_face_geometry() const;
 
-        void hex_standardization(CELL_ELEM &hex);
+        void derive_cell_geometry() const;
 
-        void triangle_standardization(CELL_ELEM &tri);
+        /// Release all derived records, they will be re-computed on demand.
+        void clear_derived();
+
+        /// Zone table from sections, see "zone".
+        void derive_zone();
+
+        /// Declaration of total num of nodes, cells and faces.
+        static void write_declaration(std::ostream &out, size_t nNode, size_t nCell, size_t nFace, bool is3D);
+
+        /// Temporary record of a single cell during standardization.
+        struct CELL_RECORD
+        {
+            int type;
+            Array1D<size_t> includedNode;
+            Array1D<size_t> includedFace;
+        };
+
+        /// Fixed-size counterpart of "CELL_RECORD" for cells of element type "T".
+        template<int T>
+        struct SHAPE_RECORD
+        {
+            std::array<size_t, CELL_SHAPE<T>::NumOfFace> includedFace;
+            std::array<size_t, CELL_SHAPE<T>::NumOfNode> includedNode;
+        };
 
-        void quad_standardization(CELL_ELEM &quad);
+        /// "derive_cell_adjacency" when all cells are of element type "T", and all faces
+        /// are of the corresponding shape. Neither dispatch nor allocation happens per cell.
+        template<int T>
+        void derive_cell_adjacency() const;
+
+        static size_t cell_node_num(int type);
+
+        /// Shape and nodes of a face, available along with primary records.
+        struct FACE_SHAPE
+        {
+            const int type;
+            const CSR::ROW includedNode;
+        };
+
+        FACE_SHAPE face_shape(size_t id) const;
+
+        void cell_standardization(CELL_RECORD &c) const;
+
+        void tet_standardization(CELL_RECORD &tet) const;
+
+        void pyramid_standardization(CELL_RECORD &pyramid) const;
+
+        void prism_standardization(CELL_RECORD &prism) const;
+
+        void hex_standardization(CELL_RECORD &hex) const;
+
+        /// Faces are known to be quadrilateral.
+        void hex_standardization(SHAPE_RECORD<CELL::HEXAHEDRAL> &hex) const;
+
+        void triangle_standardization(CELL_RECORD &tri) const;
+
+        void quad_standardization(CELL_RECORD &quad) const;
+
+        /// Faces are known to be linear.
+        void quad_standardization(SHAPE_RECORD<CELL::QUADRILATERAL> &quad) const;
+    };
+
+    /// Read-only view of a checkpoint written by "MESH::writeCheckpoint".
+    /// Layout, in native byte order:
+    ///   Magic "TYDF-CKP", version, byte order mark, chunk length, offset and size of the directory.
+    ///   Arrays, each split into chunks of "chunk length" elements. Chunks are either raw values,
+    ///   or zigzag varints of differences between consecutive values for indices, and
+    ///   each chunk starts from 0 in the latter case, so that any of them can be decoded alone.
+    ///   Directory, listing arrays by name with the file offset of each chunk, then sections
+    ///   in order of appearance, then the num of elements, derived quantities are present or not, and the mesh is renumbered or not.
+    /// The file is memory-mapped, and only chunks of the requested sections are decoded,
+    /// e.g. to load a single zone.
+    class CHECKPOINT
+    {
+    private:
+        struct ARRAY
+        {
+            int encoding;
+            int attr; /// 64-bit indices or not.
+            size_t elem_size;
+            size_t num;
+            std::vector<std::pair<size_t, size_t>> chunk; /// Offset and length in bytes.
+        };
+
+        struct RECORD
+        {
+            int identity;
+            size_t zone, first, last;
+            int a, b, c; /// Type specifications, depending on the identity.
+            std::string str1, str2;
+        };
+
+        COMMON::MAPPED_FILE m_file;
+        size_t m_chunkLen;
+        std::map<std::string, ARRAY> m_array;
+        std::vector<RECORD> m_record;
+        size_t m_totalNodeNum;
+        size_t m_totalCellNum;
+        size_t m_totalFaceNum;
+        int m_dim;
+        bool m_is3D;
+        bool m_derived;
+        bool m_renumbered;
+
+    public:
+        enum {
+            RAW = 0,
+            DELTA = 1
+        };
+
+        static const char Magic[8];
+
+        static const int Version = 2;
+
+        CHECKPOINT() = delete;
+
+        explicit CHECKPOINT(const std::string &src);
+
+        CHECKPOINT(const CHECKPOINT &rhs) = delete;
+
+        ~CHECKPOINT() = default;
+
+        size_t numOfSection() const;
+
+        /// Identity and zone of the 0-based "i"-th section, zone is 0 if not a range.
+        int identity(size_t i) const;
+
+        size_t zone(size_t i) const;
+
+        /// Decode the 0-based "i"-th section, the caller takes the ownership.
+        SECTION *section(size_t i) const;
+
+        /// Decode the section of zone "id", "nullptr" if absent.
+        SECTION *zone_section(size_t id) const;
+
+        size_t numOfNode() const;
+
+        size_t numOfCell() const;
+
+        size_t numOfFace() const;
+
+        int dimension() const;
+
+        bool is3D() const;
+
+        /// Derived quantities of "MESH" are stored or not.
+        bool has_derived() const;
+
+        /// Written from a mesh reordered by "MESH::renumber" or not.
+        bool renumbered() const;
+
+        /// Decode array "name" into "dst".
+        void read(const std::string &name, std::vector<double> &dst) const;
+
+        void read(const std::string &name, std::vector<char> &dst) const;
+
+        void read(const std::string &name, std::vector<int> &dst) const;
+
+        void read(const std::string &name, IndexArray &dst) const;
+
+        void read(const std::string &name, COMMON::VectorArray &dst) const;
+
+        void read(const std::string &name, CSR &dst) const;
+
+    private:
+        const ARRAY &array(const std::string &name) const;
+
+        /// Copy elements of a "RAW" array to "dst" chunk by chunk concurrently.
+        void decode_raw(const ARRAY &arr, void *dst) const;
+
+        /// Apply "f(i, value)" on each element of a "DELTA" array chunk by chunk concurrently.
+        template<typename F>
+        void decode_index(const ARRAY &arr, const F &f) const;
+    };
+
+    /// Quality metrics of a mesh, evaluated on derived geometry of "MESH".
+    /// Cell-wise:
+    ///   "VOLUME", volume of 3D cells or area of 2D cells, the smaller the worse;
+    ///   "ASPECT_RATIO", max over min area of faces within a cell, which equals
+    ///   the longest edge over the shortest one of a box.
+    /// Face-wise, with "d" from the center of the left cell to that of the right one,
+    /// or to the face center on boundary:
+    ///   "SKEWNESS", distance from the face center to where "d" crosses the face, over |d|, 1 if "d" is parallel to the face;
+    ///   "NON_ORTHOGONALITY", angle between "d" and the face normal, in degrees.
+    /// Elements are evaluated and reduced chunk by chunk concurrently, and chunks are
+    /// merged in order, thus results do not depend on the num of threads.
+    class QUALITY
+    {
+    public:
+        enum {
+            VOLUME = 0,
+            ASPECT_RATIO = 1,
+            SKEWNESS = 2,
+            NON_ORTHOGONALITY = 3
+        };
+
+        static const int NumOfMetric = 4;
+
+        struct METRIC
+        {
+            std::string name;
+            bool cellwise;
+            bool lowerIsWorse; /// The worst element is at "argmin" or "argmax".
+            double min, max, mean;
+            size_t argmin, argmax; /// 1-based index of cell or face, the first one on ties.
+
+            /// Uniform bins over [lo, hi], values outside are counted in the end bins.
+            /// The range is fixed for "SKEWNESS" and "NON_ORTHOGONALITY", and is [min, max] otherwise,
+            /// with a single bin over [lo, lo] if min and max are equal up to rounding errors.
+            double lo, hi;
+            std::vector<size_t> histogram;
+
+            /// 1-based index of the worst element.
+            size_t worst() const;
+        };
+
+    private:
+        std::array<METRIC, NumOfMetric> m_metric;
+        std::array<std::vector<double>, NumOfMetric> m_value;
+        std::array<size_t, NumOfMetric> m_worstCell; /// Cell of the worst element, the left one if a face.
+        bool m_renumbered; /// Whether the mesh is renumbered, see "MESH::renumbered".
+
+    public:
+        QUALITY() = delete;
+
+        /// Geometric features of "mesh" are derived if not yet.
+        explicit QUALITY(const MESH &mesh, size_t nBin = 10);
+
+        QUALITY(const QUALITY &rhs) = delete;
+
+        ~QUALITY() = default;
+
+        const METRIC &metric(int m) const;
+
+        /// Value of each element, entry "i" refers to element "i+1".
+        const std::vector<double> &value(int m) const;
+
+        /// Reductions and histograms of all metrics.
+        void report(std::ostream &out) const;
+
+        /// Worst elements are located at (i, j, k) in blocks of "nmf" as well, where
+        /// the mesh is supposed to be glued from "nmf", and a renumbered one is rejected.
+        /// Faces are located by their left cell, or the right one on boundary,
+        /// and the local index within it, see "NMF::HEX_CELL::FaceSeq".
+        void report(std::ostream &out, const NMF::Mapping3D &nmf) const;
+
+    private:
+        void reduce(int m, size_t nBin, bool fixed, double lo, double hi);
     };
 }
 #endif
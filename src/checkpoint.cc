@@ -0,0 +1,745 @@
+#include "../inc/xf.h"
+#include <cstring>
+
+/// Num of elements within each chunk of an array.
+static const size_t ChunkLen = 1 << 16;
+
+/// Magic, version, byte order mark, chunk length, offset and size of the directory.
+static const size_t HeaderSize = 8 + 4 + 4 + 8 + 8 + 8;
+
+static const uint32_t ByteOrderMark = 0x01020304;
+
+static void put_varint(std::string &buf, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        buf.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    buf.push_back(static_cast<char>(v));
+}
+
+static uint64_t get_varint(const char *&p, const char *end)
+{
+    uint64_t ret = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (p == end)
+            throw std::runtime_error("Unexpected end of checkpoint data.");
+        const auto c = static_cast<unsigned char>(*p++);
+        ret |= static_cast<uint64_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0)
+            return ret;
+    }
+    throw std::runtime_error("Invalid varint in checkpoint data.");
+}
+
+static uint64_t zigzag(uint64_t d)
+{
+    return (d << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(d) >> 63);
+}
+
+static uint64_t unzigzag(uint64_t z)
+{
+    return (z >> 1) ^ (~(z & 1) + 1);
+}
+
+static void put_string(std::string &buf, const std::string &s)
+{
+    put_varint(buf, s.size());
+    buf.append(s);
+}
+
+static std::string get_string(const char *&p, const char *end)
+{
+    const auto n = get_varint(p, end);
+    if (n > static_cast<uint64_t>(end - p))
+        throw std::runtime_error("Unexpected end of checkpoint data.");
+    std::string ret(p, n);
+    p += n;
+    return ret;
+}
+
+template<typename T>
+static void put_fixed(char *&p, T v)
+{
+    std::memcpy(p, &v, sizeof(T));
+    p += sizeof(T);
+}
+
+template<typename T>
+static T get_fixed(const char *&p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+}
+
+/// Arrays are encoded chunk by chunk on worker threads, and written in order
+/// by "COMMON::ASYNC_WRITER", while their locations are listed in the directory.
+class CKPT_WRITER
+{
+private:
+    std::ofstream m_out;
+    size_t m_pos;
+    size_t m_nArray;
+    std::string m_dir;
+
+public:
+    explicit CKPT_WRITER(const std::string &dst) :
+        m_out(dst, std::ios::out | std::ios::binary),
+        m_pos(HeaderSize),
+        m_nArray(0)
+    {
+        if (m_out.fail())
+            throw std::runtime_error("Failed to open checkpoint file: " + dst);
+
+        const std::string placeholder(HeaderSize, '\0');
+        m_out.write(placeholder.data(), placeholder.size());
+    }
+
+    /// "enc(first, last, buf)" appends encoded elements [first, last) to "buf".
+    template<typename F>
+    void array(const std::string &name, int encoding, int attr, size_t elem_size, size_t n, const F &enc)
+    {
+        using GridTool::COMMON::num_of_thread;
+
+        const size_t nChunk = (n + ChunkLen - 1) / ChunkLen;
+        put_string(m_dir, name);
+        put_varint(m_dir, encoding);
+        put_varint(m_dir, attr);
+        put_varint(m_dir, elem_size);
+        put_varint(m_dir, n);
+        put_varint(m_dir, nChunk);
+        ++m_nArray;
+
+        /// One batch of chunks per round, two rounds in flight.
+        const size_t nBatch = std::max<size_t>(num_of_thread(), 1);
+        std::vector<std::string> buf(nBatch);
+        GridTool::COMMON::ASYNC_WRITER writer(m_out, 2 * nBatch);
+        for (size_t c0 = 0; c0 < nChunk; c0 += nBatch)
+        {
+            const size_t nCur = std::min(nBatch, nChunk - c0);
+            GridTool::COMMON::parallel_for(nCur, [&](size_t first, size_t last)
+            {
+                for (size_t c = first; c < last; ++c)
+                {
+                    const size_t lo = (c0 + c) * ChunkLen;
+                    buf[c].clear();
+                    enc(lo, std::min(lo + ChunkLen, n), buf[c]);
+                }
+            });
+            for (size_t c = 0; c < nCur; ++c)
+            {
+                put_varint(m_dir, m_pos);
+                put_varint(m_dir, buf[c].size());
+                m_pos += buf[c].size();
+                writer.push(std::move(buf[c]));
+            }
+        }
+        writer.finish();
+    }
+
+    /// Contiguous values copied as they are.
+    void raw(const std::string &name, const void *data, size_t elem_size, size_t n)
+    {
+        const char *src = static_cast<const char*>(data);
+        array(name, GridTool::XF::CHECKPOINT::RAW, 0, elem_size, n, [src, elem_size](size_t first, size_t last, std::string &buf)
+        {
+            buf.append(src + first * elem_size, (last - first) * elem_size);
+        });
+    }
+
+    /// Indices "get(i)", differences between consecutive ones are stored.
+    template<typename F>
+    void index(const std::string &name, size_t n, bool wide, const F &get)
+    {
+        array(name, GridTool::XF::CHECKPOINT::DELTA, wide ? 1 : 0, 8, n, [&get](size_t first, size_t last, std::string &buf)
+        {
+            uint64_t prev = 0;
+            for (size_t i = first; i < last; ++i)
+            {
+                const auto cur = static_cast<uint64_t>(get(i));
+                put_varint(buf, zigzag(cur - prev));
+                prev = cur;
+            }
+        });
+    }
+
+    void index(const std::string &name, const GridTool::COMMON::IndexArray &src)
+    {
+        index(name, src.size(), src.wide(), [&src](size_t i) { return src[i]; });
+    }
+
+    void index(const std::string &name, const std::vector<int> &src)
+    {
+        index(name, src.size(), false, [&src](size_t i) { return static_cast<int64_t>(src[i]); });
+    }
+
+    void vector_array(const std::string &name, const GridTool::COMMON::VectorArray &src)
+    {
+        static const char *Suffix[3] = { ".x", ".y", ".z" };
+        for (int k = 0; k < 3; ++k)
+            raw(name + Suffix[k], src.plane(k), sizeof(double), src.size());
+    }
+
+    void csr(const std::string &name, const GridTool::COMMON::CSR &src)
+    {
+        index(name + ".offset", src.row_offset());
+        index(name + ".index", src.entry());
+    }
+
+    /// Directory is written after all arrays, and the header is filled at last.
+    void finish(const std::string &tail)
+    {
+        std::string dir;
+        put_varint(dir, m_nArray);
+        dir.append(m_dir);
+        dir.append(tail);
+        m_out.write(dir.data(), dir.size());
+
+        char header[HeaderSize];
+        char *p = header;
+        std::memcpy(p, GridTool::XF::CHECKPOINT::Magic, 8);
+        p += 8;
+        put_fixed<uint32_t>(p, GridTool::XF::CHECKPOINT::Version);
+        put_fixed<uint32_t>(p, ByteOrderMark);
+        put_fixed<uint64_t>(p, ChunkLen);
+        put_fixed<uint64_t>(p, m_pos);
+        put_fixed<uint64_t>(p, dir.size());
+        m_out.seekp(0);
+        m_out.write(header, HeaderSize);
+        m_out.close();
+        if (m_out.fail())
+            throw std::runtime_error("Failed to write checkpoint file.");
+    }
+
+    size_t bytes() const
+    {
+        return m_pos;
+    }
+};
+
+namespace GridTool::XF
+{
+    const char CHECKPOINT::Magic[8] = { 'T', 'Y', 'D', 'F', '-', 'C', 'K', 'P' };
+
+    CHECKPOINT::CHECKPOINT(const std::string &src) :
+        m_file(src),
+        m_chunkLen(0),
+        m_totalNodeNum(0),
+        m_totalCellNum(0),
+        m_totalFaceNum(0),
+        m_dim(3),
+        m_is3D(true),
+        m_derived(false),
+        m_renumbered(false)
+    {
+        if (m_file.size() < HeaderSize || std::memcmp(m_file.begin(), Magic, 8) != 0)
+            throw std::runtime_error("\"" + src + "\" is not a checkpoint.");
+
+        const char *p = m_file.begin() + 8;
+        if (get_fixed<uint32_t>(p) != static_cast<uint32_t>(Version))
+            throw std::runtime_error("Unsupported version of checkpoint \"" + src + "\".");
+        if (get_fixed<uint32_t>(p) != ByteOrderMark)
+            throw std::runtime_error("Byte order of checkpoint \"" + src + "\" is different from that of the host.");
+        m_chunkLen = get_fixed<uint64_t>(p);
+        const auto dirOffset = get_fixed<uint64_t>(p);
+        const auto dirSize = get_fixed<uint64_t>(p);
+        if (m_chunkLen == 0 || dirOffset < HeaderSize || dirOffset > m_file.size() || dirSize != m_file.size() - dirOffset)
+            throw std::runtime_error("Corrupted header of checkpoint \"" + src + "\".");
+
+        /// Arrays
+        p = m_file.begin() + dirOffset;
+        const char *end = m_file.end();
+        const auto nArray = get_varint(p, end);
+        for (uint64_t n = 0; n < nArray; ++n)
+        {
+            const auto name = get_string(p, end);
+            ARRAY arr;
+            arr.encoding = static_cast<int>(get_varint(p, end));
+            arr.attr = static_cast<int>(get_varint(p, end));
+            arr.elem_size = get_varint(p, end);
+            arr.num = get_varint(p, end);
+            const auto nChunk = get_varint(p, end);
+            if (nChunk != (arr.num + m_chunkLen - 1) / m_chunkLen)
+                throw std::runtime_error("Inconsistent num of chunks of array \"" + name + "\".");
+            arr.chunk.resize(nChunk);
+            for (auto &e : arr.chunk)
+            {
+                e.first = get_varint(p, end);
+                e.second = get_varint(p, end);
+                if (e.first < HeaderSize || e.first > dirOffset || e.second > dirOffset - e.first)
+                    throw std::runtime_error("Chunk of array \"" + name + "\" is out of range.");
+            }
+            m_array[name] = std::move(arr);
+        }
+
+        /// Sections
+        const auto nRecord = get_varint(p, end);
+        m_record.resize(nRecord);
+        for (auto &e : m_record)
+        {
+            e.identity = static_cast<int>(unzigzag(get_varint(p, end)));
+            e.zone = get_varint(p, end);
+            e.first = get_varint(p, end);
+            e.last = get_varint(p, end);
+            e.a = static_cast<int>(unzigzag(get_varint(p, end)));
+            e.b = static_cast<int>(unzigzag(get_varint(p, end)));
+            e.c = static_cast<int>(unzigzag(get_varint(p, end)));
+            e.str1 = get_string(p, end);
+            e.str2 = get_string(p, end);
+        }
+
+        /// Mesh
+        m_totalNodeNum = get_varint(p, end);
+        m_totalCellNum = get_varint(p, end);
+        m_totalFaceNum = get_varint(p, end);
+        m_dim = static_cast<int>(get_varint(p, end));
+        m_is3D = get_varint(p, end) != 0;
+        m_derived = get_varint(p, end) != 0;
+        m_renumbered = get_varint(p, end) != 0;
+        if (p != end)
+            throw std::runtime_error("Trailing data in directory of checkpoint \"" + src + "\".");
+    }
+
+    size_t CHECKPOINT::numOfSection() const
+    {
+        return m_record.size();
+    }
+
+    int CHECKPOINT::identity(size_t i) const
+    {
+        return m_record.at(i).identity;
+    }
+
+    size_t CHECKPOINT::zone(size_t i) const
+    {
+        return m_record.at(i).zone;
+    }
+
+    size_t CHECKPOINT::numOfNode() const
+    {
+        return m_totalNodeNum;
+    }
+
+    size_t CHECKPOINT::numOfCell() const
+    {
+        return m_totalCellNum;
+    }
+
+    size_t CHECKPOINT::numOfFace() const
+    {
+        return m_totalFaceNum;
+    }
+
+    int CHECKPOINT::dimension() const
+    {
+        return m_dim;
+    }
+
+    bool CHECKPOINT::is3D() const
+    {
+        return m_is3D;
+    }
+
+    bool CHECKPOINT::has_derived() const
+    {
+        return m_derived;
+    }
+
+    bool CHECKPOINT::renumbered() const
+    {
+        return m_renumbered;
+    }
+
+    const CHECKPOINT::ARRAY &CHECKPOINT::array(const std::string &name) const
+    {
+        auto it = m_array.find(name);
+        if (it == m_array.end())
+            throw std::runtime_error("Array \"" + name + "\" is not found in checkpoint.");
+        return it->second;
+    }
+
+    void CHECKPOINT::decode_raw(const ARRAY &arr, void *dst) const
+    {
+        if (arr.encoding != RAW)
+            throw std::runtime_error("Inconsistent encoding of checkpoint array.");
+
+        char *buf = static_cast<char*>(dst);
+        COMMON::parallel_for(arr.chunk.size(), [&](size_t first, size_t last)
+        {
+            for (size_t c = first; c < last; ++c)
+            {
+                const size_t n = std::min(m_chunkLen, arr.num - c * m_chunkLen);
+                if (arr.chunk[c].second != n * arr.elem_size)
+                    throw std::runtime_error("Corrupted chunk of checkpoint array.");
+                std::memcpy(buf + c * m_chunkLen * arr.elem_size, m_file.begin() + arr.chunk[c].first, arr.chunk[c].second);
+            }
+        });
+    }
+
+    template<typename F>
+    void CHECKPOINT::decode_index(const ARRAY &arr, const F &f) const
+    {
+        if (arr.encoding != DELTA)
+            throw std::runtime_error("Inconsistent encoding of checkpoint array.");
+
+        COMMON::parallel_for(arr.chunk.size(), [&](size_t first, size_t last)
+        {
+            for (size_t c = first; c < last; ++c)
+            {
+                const char *p = m_file.begin() + arr.chunk[c].first;
+                const char *end = p + arr.chunk[c].second;
+                const size_t lo = c * m_chunkLen, hi = std::min(lo + m_chunkLen, arr.num);
+                uint64_t cur = 0;
+                for (size_t i = lo; i < hi; ++i)
+                {
+                    cur += unzigzag(get_varint(p, end));
+                    f(i, cur);
+                }
+                if (p != end)
+                    throw std::runtime_error("Corrupted chunk of checkpoint array.");
+            }
+        });
+    }
+
+    void CHECKPOINT::read(const std::string &name, std::vector<double> &dst) const
+    {
+        const auto &arr = array(name);
+        if (arr.elem_size != sizeof(double))
+            throw std::runtime_error("Inconsistent element size of array \"" + name + "\".");
+        dst.resize(arr.num);
+        decode_raw(arr, dst.data());
+    }
+
+    void CHECKPOINT::read(const std::string &name, std::vector<char> &dst) const
+    {
+        const auto &arr = array(name);
+        if (arr.elem_size != sizeof(char))
+            throw std::runtime_error("Inconsistent element size of array \"" + name + "\".");
+        dst.resize(arr.num);
+        decode_raw(arr, dst.data());
+    }
+
+    void CHECKPOINT::read(const std::string &name, std::vector<int> &dst) const
+    {
+        const auto &arr = array(name);
+        dst.resize(arr.num);
+        decode_index(arr, [&dst](size_t i, uint64_t v) { dst[i] = static_cast<int>(static_cast<int64_t>(v)); });
+    }
+
+    void CHECKPOINT::read(const std::string &name, IndexArray &dst) const
+    {
+        const auto &arr = array(name);
+        dst.allocate(arr.num, arr.attr ? std::numeric_limits<size_t>::max() : 0);
+        decode_index(arr, [&dst](size_t i, uint64_t v) { dst.set(i, v); });
+    }
+
+    void CHECKPOINT::read(const std::string &name, COMMON::VectorArray &dst) const
+    {
+        static const char *Suffix[3] = { ".x", ".y", ".z" };
+
+        const auto &x = array(name + Suffix[0]);
+        dst.assign(x.num);
+        for (int k = 0; k < 3; ++k)
+        {
+            const auto &arr = array(name + Suffix[k]);
+            if (arr.num != x.num || arr.elem_size != sizeof(COMMON::Scalar))
+                throw std::runtime_error("Inconsistent components of array \"" + name + "\".");
+            decode_raw(arr, dst.plane(k));
+        }
+    }
+
+    void CHECKPOINT::read(const std::string &name, CSR &dst) const
+    {
+        IndexArray offset, index;
+        read(name + ".offset", offset);
+        read(name + ".index", index);
+        dst.assign(std::move(offset), std::move(index));
+    }
+
+    SECTION *CHECKPOINT::section(size_t i) const
+    {
+        static_assert(sizeof(Vector) == 3 * sizeof(COMMON::Scalar), "Components of a vector are not contiguous.");
+
+        const auto &rec = m_record.at(i);
+        const std::string prefix = std::to_string(i) + ".";
+        switch (rec.identity)
+        {
+        case SECTION::COMMENT:
+            return new COMMENT(rec.str1);
+        case SECTION::HEADER:
+            return new HEADER(rec.str1);
+        case SECTION::DIMENSION:
+            return new DIMENSION(rec.a, rec.b != 0);
+        case SECTION::NODE:
+        {
+            const auto &arr = array(prefix + "coord");
+            if (arr.elem_size != sizeof(COMMON::Scalar) || arr.num != 3 * (rec.last - rec.first + 1))
+                throw std::runtime_error("Inconsistent num of nodes in zone " + std::to_string(rec.zone) + ".");
+            std::vector<Vector> coord(rec.last - rec.first + 1);
+            decode_raw(arr, coord.data());
+            return new NODE(rec.zone, rec.first, rec.last, rec.a, rec.b, std::move(coord));
+        }
+        case SECTION::CELL:
+        {
+            auto e = new CELL(rec.zone, rec.first, rec.last, rec.a, rec.b);
+            if (rec.b == CELL::MIXED)
+            {
+                std::vector<int> elem;
+                try
+                {
+                    read(prefix + "elem", elem);
+                    if (elem.size() != e->num())
+                        throw std::runtime_error("Inconsistent num of cells in zone " + std::to_string(rec.zone) + ".");
+                }
+                catch (...)
+                {
+                    delete e;
+                    throw;
+                }
+                static_cast<std::vector<int>&>(*e).swap(elem);
+            }
+            return e;
+        }
+        case SECTION::FACE:
+        {
+            const size_t N = rec.last - rec.first + 1;
+            std::vector<CONNECTIVITY> cnect(N);
+            const auto &node = array(prefix + "node");
+            const auto &c0 = array(prefix + "c0");
+            const auto &c1 = array(prefix + "c1");
+            if (node.num != 4 * N || c0.num != N || c1.num != N)
+                throw std::runtime_error("Inconsistent num of faces in zone " + std::to_string(rec.zone) + ".");
+            decode_index(node, [&cnect](size_t k, uint64_t v) { cnect[k / 4].n[k % 4] = v; });
+            decode_index(c0, [&cnect](size_t k, uint64_t v) { cnect[k].c[0] = v; });
+            decode_index(c1, [&cnect](size_t k, uint64_t v) { cnect[k].c[1] = v; });
+            if (rec.b == FACE::MIXED)
+            {
+                const auto &x = array(prefix + "x");
+                if (x.num != N)
+                    throw std::runtime_error("Inconsistent num of faces in zone " + std::to_string(rec.zone) + ".");
+                decode_index(x, [&cnect](size_t k, uint64_t v) { cnect[k].x = static_cast<int>(v); });
+            }
+            else
+            {
+                for (auto &e : cnect)
+                    e.x = rec.b;
+            }
+            return new FACE(rec.zone, rec.first, rec.last, rec.a, rec.b, std::move(cnect));
+        }
+        case SECTION::ZONE:
+            return new ZONE(static_cast<int>(rec.zone), rec.str1, rec.str2, rec.a);
+        default:
+            throw std::runtime_error("Unsupported section " + std::to_string(rec.identity) + " in checkpoint.");
+        }
+    }
+
+    SECTION *CHECKPOINT::zone_section(size_t id) const
+    {
+        for (size_t i = 0; i < m_record.size(); ++i)
+        {
+            const auto t = m_record[i].identity;
+            if ((t == SECTION::NODE || t == SECTION::CELL || t == SECTION::FACE) && m_record[i].zone == id)
+                return section(i);
+        }
+        return nullptr;
+    }
+
+    void MESH::writeCheckpoint(const std::string &dst, bool derived) const
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::writeCheckpoint");
+
+        CKPT_WRITER out(dst);
+        std::string rec;
+        put_varint(rec, m_content.size());
+        auto put_record = [&rec](int identity, size_t zone, size_t first, size_t last, int a, int b, int c, const std::string &s1, const std::string &s2)
+        {
+            put_varint(rec, zigzag(static_cast<uint64_t>(static_cast<int64_t>(identity))));
+            put_varint(rec, zone);
+            put_varint(rec, first);
+            put_varint(rec, last);
+            put_varint(rec, zigzag(static_cast<uint64_t>(static_cast<int64_t>(a))));
+            put_varint(rec, zigzag(static_cast<uint64_t>(static_cast<int64_t>(b))));
+            put_varint(rec, zigzag(static_cast<uint64_t>(static_cast<int64_t>(c))));
+            put_string(rec, s1);
+            put_string(rec, s2);
+        };
+
+        for (size_t i = 0; i < m_content.size(); ++i)
+        {
+            const auto e = m_content[i];
+            const std::string prefix = std::to_string(i) + ".";
+            switch (e->identity())
+            {
+            case SECTION::COMMENT:
+            case SECTION::HEADER:
+                put_record(e->identity(), 0, 0, 0, 0, 0, 0, dynamic_cast<const STR*>(e)->str(), "");
+                break;
+            case SECTION::DIMENSION:
+            {
+                const auto curObj = dynamic_cast<const DIMENSION*>(e);
+                put_record(e->identity(), 0, 0, 0, curObj->ND(), curObj->is3D() ? 1 : 0, 0, "", "");
+                break;
+            }
+            case SECTION::NODE:
+            {
+                const auto curObj = dynamic_cast<const NODE*>(e);
+                put_record(e->identity(), curObj->zone(), curObj->first_index(), curObj->last_index(), curObj->type(), curObj->ND(), 0, "", "");
+                out.raw(prefix + "coord", curObj->data(), sizeof(COMMON::Scalar), 3 * curObj->num());
+                break;
+            }
+            case SECTION::CELL:
+            {
+                const auto curObj = dynamic_cast<const CELL*>(e);
+                put_record(e->identity(), curObj->zone(), curObj->first_index(), curObj->last_index(), curObj->type(), curObj->element_type(), 0, "", "");
+                if (curObj->element_type() == CELL::MIXED)
+                    out.index(prefix + "elem", *curObj);
+                break;
+            }
+            case SECTION::FACE:
+            {
+                const auto curObj = dynamic_cast<const FACE*>(e);
+                put_record(e->identity(), curObj->zone(), curObj->first_index(), curObj->last_index(), curObj->bc_type(), curObj->face_type(), 0, "", "");
+
+                /// Nodes are padded to 4 per face, so that faces are located directly.
+                const auto &f = *curObj;
+                if (f.face_type() == FACE::MIXED)
+                    out.index(prefix + "x", f.size(), false, [&f](size_t k) { return f[k].x; });
+                out.index(prefix + "node", 4 * f.size(), false, [&f](size_t k) { return k % 4 < static_cast<size_t>(f[k / 4].x) ? f[k / 4].n[k % 4] : 0; });
+                out.index(prefix + "c0", f.size(), false, [&f](size_t k) { return f[k].c[0]; });
+                out.index(prefix + "c1", f.size(), false, [&f](size_t k) { return f[k].c[1]; });
+                break;
+            }
+            case SECTION::ZONE:
+            {
+                const auto curObj = dynamic_cast<const ZONE*>(e);
+                put_record(e->identity(), curObj->zone(), 0, 0, curObj->domain(), 0, 0, curObj->type(), curObj->name());
+                break;
+            }
+            default:
+                throw std::runtime_error("Unsupported section " + std::to_string(e->identity()) + " for checkpoint.");
+            }
+        }
+
+        /// Derived quantities, computed beforehand if not yet.
+        const bool withDerived = derived && numOfCell() != 0;
+        if (withDerived)
+        {
+            derive(ALL_DERIVED);
+
+            out.vector_array("nodeCoordinate", m_nodeCoordinate);
+            out.raw("nodeAtBdry", m_nodeAtBdry.data(), sizeof(char), m_nodeAtBdry.size());
+            out.csr("nodeAdjacentNode", m_nodeAdjacentNode);
+            out.csr("nodeDependentFace", m_nodeDependentFace);
+            out.csr("nodeDependentCell", m_nodeDependentCell);
+
+            out.index("faceType", m_faceType);
+            out.vector_array("faceCenter", m_faceCenter);
+            out.raw("faceArea", m_faceArea.data(), sizeof(double), m_faceArea.size());
+            out.raw("faceAtBdry", m_faceAtBdry.data(), sizeof(char), m_faceAtBdry.size());
+            out.csr("faceIncludedNode", m_faceIncludedNode);
+            out.index("faceLeftCell", m_faceLeftCell);
+            out.index("faceRightCell", m_faceRightCell);
+            out.vector_array("faceNormal", m_faceNormal);
+
+            out.index("cellType", m_cellType);
+            out.vector_array("cellCenter", m_cellCenter);
+            out.raw("cellVolume", m_cellVolume.data(), sizeof(double), m_cellVolume.size());
+            out.csr("cellIncludedNode", m_cellIncludedNode);
+            out.csr("cellIncludedFace", m_cellIncludedFace);
+            out.index("cellAdjacentCell", m_cellAdjacentCell);
+        }
+
+        put_varint(rec, m_totalNodeNum);
+        put_varint(rec, m_totalCellNum);
+        put_varint(rec, m_totalFaceNum);
+        put_varint(rec, m_dim);
+        put_varint(rec, m_is3D ? 1 : 0);
+        put_varint(rec, withDerived ? 1 : 0);
+        put_varint(rec, m_renumbered ? 1 : 0);
+        out.finish(rec);
+        TYDF_PROFILE_COUNT("ckpt.bytes_written", out.bytes() + rec.size());
+    }
+
+    void MESH::readCheckpoint(const std::string &src, std::ostream &fout, int derived)
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::readCheckpoint");
+
+        fout << "Reading checkpoint \"" << src << "\" ... ";
+        const CHECKPOINT ckpt(src);
+
+        clear_entry();
+        clear_derived();
+        m_renumbered = ckpt.renumbered();
+        m_dim = ckpt.dimension();
+        m_is3D = ckpt.is3D();
+        m_totalNodeNum = ckpt.numOfNode();
+        m_totalCellNum = ckpt.numOfCell();
+        m_totalFaceNum = ckpt.numOfFace();
+        for (size_t i = 0; i < ckpt.numOfSection(); ++i)
+            add_entry(ckpt.section(i));
+        fout << "Done!" << std::endl;
+
+        derive_zone();
+        if (!ckpt.has_derived())
+        {
+            if (derived != 0)
+            {
+                fout << "Converting into high-level representation ... ";
+                derive(derived);
+                fout << "Done!" << std::endl;
+            }
+            return;
+        }
+
+        /// Only the requested quantities, with their dependencies as in "derive".
+        if (derived == 0)
+            return;
+        if (derived & CELL_GEOMETRY)
+            derived |= FACE_GEOMETRY | CELL_ADJACENCY;
+        derived = (derived & ALL_DERIVED) | PRIMARY;
+
+        ckpt.read("nodeCoordinate", m_nodeCoordinate);
+        ckpt.read("nodeAtBdry", m_nodeAtBdry);
+        ckpt.read("faceType", m_faceType);
+        ckpt.read("faceAtBdry", m_faceAtBdry);
+        ckpt.read("faceIncludedNode", m_faceIncludedNode);
+        ckpt.read("faceLeftCell", m_faceLeftCell);
+        ckpt.read("faceRightCell", m_faceRightCell);
+        ckpt.read("cellType", m_cellType);
+        if (m_nodeCoordinate.size() != numOfNode() || m_faceType.size() != numOfFace() || m_cellType.size() != numOfCell())
+            throw std::runtime_error("Inconsistent num of elements of derived quantities in checkpoint.");
+
+        if (derived & NODE_ADJACENCY)
+        {
+            ckpt.read("nodeAdjacentNode", m_nodeAdjacentNode);
+            ckpt.read("nodeDependentFace", m_nodeDependentFace);
+            ckpt.read("nodeDependentCell", m_nodeDependentCell);
+        }
+        if (derived & CELL_ADJACENCY)
+        {
+            ckpt.read("cellIncludedNode", m_cellIncludedNode);
+            ckpt.read("cellIncludedFace", m_cellIncludedFace);
+            ckpt.read("cellAdjacentCell", m_cellAdjacentCell);
+        }
+        if (derived & FACE_GEOMETRY)
+        {
+            ckpt.read("faceCenter", m_faceCenter);
+            ckpt.read("faceArea", m_faceArea);
+            ckpt.read("faceNormal", m_faceNormal);
+            if (m_faceArea.size() != numOfFace())
+                throw std::runtime_error("Inconsistent num of elements of derived quantities in checkpoint.");
+        }
+        if (derived & CELL_GEOMETRY)
+        {
+            ckpt.read("cellCenter", m_cellCenter);
+            ckpt.read("cellVolume", m_cellVolume);
+            if (m_cellVolume.size() != numOfCell())
+                throw std::runtime_error("Inconsistent num of elements of derived quantities in checkpoint.");
+        }
+        m_derived.store(derived, std::memory_order_release);
+    }
+}
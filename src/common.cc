@@ -1,5 +1,21 @@
+#include <fstream>
+#include <ostream>
 #include "../inc/common.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#define TYDF_HAS_MMAP
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define TYDF_HAS_X86_SIMD
+#endif
+
 namespace GridTool::COMMON
 {
     Scalar relaxation(Scalar a, Scalar b, Scalar x)
@@ -7,6 +23,12 @@ namespace GridTool::COMMON
         return (1.0 - x) * a + x * b;
     }
 
+    size_t &num_of_thread()
+    {
+        static size_t n = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        return n;
+    }
+
     struct DIM::wrong_dimension : public wrong_index
     {
         wrong_dimension(int dim) :
@@ -216,6 +238,168 @@ namespace GridTool::COMMON
         this->operator/=(L);
     }
 
+    IndexArray::IndexArray() :
+        m_wide(false)
+    {
+        /// Empty body.
+    }
+
+    IndexArray::IndexArray(size_t n, size_t maxVal) :
+        m_wide(false)
+    {
+        allocate(n, maxVal);
+    }
+
+    void IndexArray::allocate(size_t n, size_t maxVal)
+    {
+        clear();
+        m_wide = maxVal > std::numeric_limits<uint32_t>::max();
+        if (m_wide)
+            m_broad.assign(n, 0);
+        else
+            m_narrow.assign(n, 0);
+    }
+
+    void IndexArray::clear()
+    {
+        std::vector<uint32_t>().swap(m_narrow);
+        std::vector<uint64_t>().swap(m_broad);
+        m_wide = false;
+    }
+
+    bool IndexArray::wide() const
+    {
+        return m_wide;
+    }
+
+    size_t IndexArray::bytes() const
+    {
+        return m_wide ? m_broad.size() * sizeof(uint64_t) : m_narrow.size() * sizeof(uint32_t);
+    }
+
+    bool CSR::ROW::contains(size_t x) const
+    {
+        for (size_t k = m_first; k < m_last; ++k)
+            if ((*m_data)[k] == x)
+                return true;
+
+        return false;
+    }
+
+    bool CSR::ROW::contains(size_t a, size_t b) const
+    {
+        bool flag_a = false, flag_b = false;
+        for (size_t k = m_first; k < m_last; ++k)
+        {
+            const size_t x = (*m_data)[k];
+            if (!flag_a && a == x)
+                flag_a = true;
+            if (!flag_b && b == x)
+                flag_b = true;
+
+            if (flag_a && flag_b)
+                return true;
+        }
+        return false;
+    }
+
+    void CSR::allocate(const std::vector<size_t> &cnt, size_t maxVal)
+    {
+        const size_t N = cnt.size();
+
+        size_t total = 0;
+        for (auto e : cnt)
+            total += e;
+
+        m_offset.allocate(N + 1, total);
+        size_t pos = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            m_offset.set(i, pos);
+            pos += cnt[i];
+        }
+        m_offset.set(N, pos);
+
+        m_index.allocate(total, maxVal);
+    }
+
+    void CSR::allocate(size_t n, size_t len, size_t maxVal)
+    {
+        const size_t total = n * len;
+
+        m_offset.allocate(n + 1, total);
+        for (size_t i = 0; i <= n; ++i)
+            m_offset.set(i, i * len);
+
+        m_index.allocate(total, maxVal);
+    }
+
+    void CSR::clear()
+    {
+        m_offset.clear();
+        m_index.clear();
+    }
+
+    size_t CSR::bytes() const
+    {
+        return m_offset.bytes() + m_index.bytes();
+    }
+
+    const IndexArray &CSR::entry() const
+    {
+        return m_index;
+    }
+
+    const IndexArray &CSR::row_offset() const
+    {
+        return m_offset;
+    }
+
+    void CSR::assign(IndexArray &&offset, IndexArray &&index)
+    {
+        const size_t N = offset.size();
+        if (N == 0 ? index.size() != 0 : offset[0] != 0 || offset[N - 1] != index.size())
+            throw std::invalid_argument("Inconsistent offsets of CSR.");
+        for (size_t i = 1; i < N; ++i)
+            if (offset[i] < offset[i - 1])
+                throw std::invalid_argument("Offsets of CSR are not ascending.");
+
+        m_offset = std::move(offset);
+        m_index = std::move(index);
+    }
+
+    VectorArray::VectorArray(size_t n)
+    {
+        assign(n);
+    }
+
+    void VectorArray::assign(size_t n)
+    {
+        for (auto &e : m_comp)
+            e.assign(n, 0.0);
+    }
+
+    void VectorArray::clear()
+    {
+        for (auto &e : m_comp)
+            std::vector<Scalar>().swap(e);
+    }
+
+    size_t VectorArray::bytes() const
+    {
+        return 3 * size() * sizeof(Scalar);
+    }
+
+    const Scalar *VectorArray::plane(int k) const
+    {
+        return m_comp.at(k).data();
+    }
+
+    Scalar *VectorArray::plane(int k)
+    {
+        return m_comp.at(k).data();
+    }
+
     void delta(const Vector &na, const Vector &nb, Vector &dst)
     {
         dst = nb;
@@ -321,3 +505,729 @@ namespace GridTool::COMMON
         dst_LR *= -1.0;
     }
 }
+
+#ifdef TYDF_HAS_X86_SIMD
+/// Kernels below are compiled for specific instruction sets, and are
+/// only invoked after "__builtin_cpu_supports" has been checked.
+/// Operations are carried out in the same order as the non-batched version,
+/// and FMA is NOT enabled, so that results are bitwise identical.
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#pragma GCC optimize("fp-contract=off")
+namespace GridTool::COMMON::AVX2
+{
+    typedef __m256d V;
+    static const size_t W = 4;
+
+    struct P
+    {
+        V x, y, z;
+    };
+
+    static inline P gather(const Scalar *const c[3], const size_t *node, size_t s)
+    {
+        const __m256i idx = _mm256_set_epi64x(node[3 * s], node[2 * s], node[s], node[0]);
+        return { _mm256_i64gather_pd(c[0], idx, 8), _mm256_i64gather_pd(c[1], idx, 8), _mm256_i64gather_pd(c[2], idx, 8) };
+    }
+
+    static inline void store(const P &a, Scalar *const dst[3], size_t i)
+    {
+        _mm256_storeu_pd(dst[0] + i, a.x);
+        _mm256_storeu_pd(dst[1] + i, a.y);
+        _mm256_storeu_pd(dst[2] + i, a.z);
+    }
+
+    /// "b - a"
+    static inline P delta(const P &a, const P &b)
+    {
+        return { _mm256_sub_pd(b.x, a.x), _mm256_sub_pd(b.y, a.y), _mm256_sub_pd(b.z, a.z) };
+    }
+
+    static inline V norm(const P &a)
+    {
+        V ret = _mm256_mul_pd(a.x, a.x);
+        ret = _mm256_add_pd(ret, _mm256_mul_pd(a.y, a.y));
+        ret = _mm256_add_pd(ret, _mm256_mul_pd(a.z, a.z));
+        return _mm256_sqrt_pd(ret);
+    }
+
+    static inline P cross(const P &a, const P &b)
+    {
+        return {
+            _mm256_sub_pd(_mm256_mul_pd(a.y, b.z), _mm256_mul_pd(a.z, b.y)),
+            _mm256_sub_pd(_mm256_mul_pd(a.z, b.x), _mm256_mul_pd(a.x, b.z)),
+            _mm256_sub_pd(_mm256_mul_pd(a.x, b.y), _mm256_mul_pd(a.y, b.x))
+        };
+    }
+
+    static inline P normalize(const P &a, const V &factor)
+    {
+        const V L = norm(a);
+        return { _mm256_mul_pd(_mm256_div_pd(a.x, L), factor), _mm256_mul_pd(_mm256_div_pd(a.y, L), factor), _mm256_mul_pd(_mm256_div_pd(a.z, L), factor) };
+    }
+
+    /// Heron's formula
+    static inline V area(const P &na, const P &nb, const P &nc)
+    {
+        const V c = norm(delta(na, nb));
+        const V a = norm(delta(nb, nc));
+        const V b = norm(delta(nc, na));
+        const V p = _mm256_mul_pd(_mm256_set1_pd(0.5), _mm256_add_pd(_mm256_add_pd(a, b), c));
+        V S = _mm256_mul_pd(p, _mm256_sub_pd(p, a));
+        S = _mm256_mul_pd(S, _mm256_sub_pd(p, b));
+        S = _mm256_mul_pd(S, _mm256_sub_pd(p, c));
+        return _mm256_sqrt_pd(S);
+    }
+
+    static inline P center(const P &na, const P &nb, const P &nc)
+    {
+        const V d = _mm256_set1_pd(3.0);
+        return {
+            _mm256_div_pd(_mm256_add_pd(_mm256_add_pd(nc.x, nb.x), na.x), d),
+            _mm256_div_pd(_mm256_add_pd(_mm256_add_pd(nc.y, nb.y), na.y), d),
+            _mm256_div_pd(_mm256_add_pd(_mm256_add_pd(nc.z, nb.z), na.z), d)
+        };
+    }
+
+    static size_t triangle(size_t n, const Scalar *const coord[3], const size_t *node, Scalar *S, Scalar *const rc[3], Scalar *const n_LR[3])
+    {
+        const V one = _mm256_set1_pd(1.0);
+        size_t i = 0;
+        for (; i + W <= n; i += W)
+        {
+            const size_t *cur = node + 3 * i;
+            const P p1 = gather(coord, cur, 3);
+            const P p2 = gather(coord, cur + 1, 3);
+            const P p3 = gather(coord, cur + 2, 3);
+
+            _mm256_storeu_pd(S + i, area(p1, p2, p3));
+            store(center(p1, p2, p3), rc, i);
+            store(normalize(cross(delta(p1, p2), delta(p1, p3)), one), n_LR, i);
+        }
+        return i;
+    }
+
+    static size_t quadrilateral(size_t n, const Scalar *const coord[3], const size_t *node, Scalar *S, Scalar *const rc[3], Scalar *const n_LR[3])
+    {
+        const V one = _mm256_set1_pd(1.0);
+        const V minus_one = _mm256_set1_pd(-1.0);
+        size_t i = 0;
+        for (; i + W <= n; i += W)
+        {
+            const size_t *cur = node + 4 * i;
+            const P p1 = gather(coord, cur, 4);
+            const P p2 = gather(coord, cur + 1, 4);
+            const P p3 = gather(coord, cur + 2, 4);
+            const P p4 = gather(coord, cur + 3, 4);
+
+            const V S123 = area(p1, p2, p3);
+            const V S134 = area(p1, p3, p4);
+            _mm256_storeu_pd(S + i, _mm256_add_pd(S123, S134));
+
+            const V alpha = _mm256_div_pd(S123, _mm256_add_pd(S123, S134));
+            const V beta = _mm256_sub_pd(one, alpha);
+            const P rc123 = center(p1, p2, p3);
+            const P rc134 = center(p1, p3, p4);
+            store({
+                _mm256_add_pd(_mm256_mul_pd(rc123.x, alpha), _mm256_mul_pd(rc134.x, beta)),
+                _mm256_add_pd(_mm256_mul_pd(rc123.y, alpha), _mm256_mul_pd(rc134.y, beta)),
+                _mm256_add_pd(_mm256_mul_pd(rc123.z, alpha), _mm256_mul_pd(rc134.z, beta))
+            }, rc, i);
+
+            store(normalize(cross(delta(p2, p4), delta(p1, p3)), minus_one), n_LR, i);
+        }
+        return i;
+    }
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off")
+namespace GridTool::COMMON::AVX512
+{
+    typedef __m512d V;
+    static const size_t W = 8;
+
+    /// Masked forms with all lanes active and the rest zeroed, as the plain ones
+    /// pass an undefined vector through, which is flagged by "-Wmaybe-uninitialized".
+    static const __mmask8 All = 0xFF;
+
+    struct P
+    {
+        V x, y, z;
+    };
+
+    static inline P gather(const Scalar *const c[3], const size_t *node, size_t s)
+    {
+        const __m512i idx = _mm512_set_epi64(node[7 * s], node[6 * s], node[5 * s], node[4 * s], node[3 * s], node[2 * s], node[s], node[0]);
+        const V zero = _mm512_setzero_pd();
+        return {
+            _mm512_mask_i64gather_pd(zero, All, idx, c[0], 8),
+            _mm512_mask_i64gather_pd(zero, All, idx, c[1], 8),
+            _mm512_mask_i64gather_pd(zero, All, idx, c[2], 8)
+        };
+    }
+
+    static inline void store(const P &a, Scalar *const dst[3], size_t i)
+    {
+        _mm512_storeu_pd(dst[0] + i, a.x);
+        _mm512_storeu_pd(dst[1] + i, a.y);
+        _mm512_storeu_pd(dst[2] + i, a.z);
+    }
+
+    /// "b - a"
+    static inline P delta(const P &a, const P &b)
+    {
+        return { _mm512_sub_pd(b.x, a.x), _mm512_sub_pd(b.y, a.y), _mm512_sub_pd(b.z, a.z) };
+    }
+
+    static inline V norm(const P &a)
+    {
+        V ret = _mm512_mul_pd(a.x, a.x);
+        ret = _mm512_add_pd(ret, _mm512_mul_pd(a.y, a.y));
+        ret = _mm512_add_pd(ret, _mm512_mul_pd(a.z, a.z));
+        return _mm512_maskz_sqrt_pd(All, ret);
+    }
+
+    static inline P cross(const P &a, const P &b)
+    {
+        return {
+            _mm512_sub_pd(_mm512_mul_pd(a.y, b.z), _mm512_mul_pd(a.z, b.y)),
+            _mm512_sub_pd(_mm512_mul_pd(a.z, b.x), _mm512_mul_pd(a.x, b.z)),
+            _mm512_sub_pd(_mm512_mul_pd(a.x, b.y), _mm512_mul_pd(a.y, b.x))
+        };
+    }
+
+    static inline P normalize(const P &a, const V &factor)
+    {
+        const V L = norm(a);
+        return { _mm512_mul_pd(_mm512_div_pd(a.x, L), factor), _mm512_mul_pd(_mm512_div_pd(a.y, L), factor), _mm512_mul_pd(_mm512_div_pd(a.z, L), factor) };
+    }
+
+    /// Heron's formula
+    static inline V area(const P &na, const P &nb, const P &nc)
+    {
+        const V c = norm(delta(na, nb));
+        const V a = norm(delta(nb, nc));
+        const V b = norm(delta(nc, na));
+        const V p = _mm512_mul_pd(_mm512_set1_pd(0.5), _mm512_add_pd(_mm512_add_pd(a, b), c));
+        V S = _mm512_mul_pd(p, _mm512_sub_pd(p, a));
+        S = _mm512_mul_pd(S, _mm512_sub_pd(p, b));
+        S = _mm512_mul_pd(S, _mm512_sub_pd(p, c));
+        return _mm512_maskz_sqrt_pd(All, S);
+    }
+
+    static inline P center(const P &na, const P &nb, const P &nc)
+    {
+        const V d = _mm512_set1_pd(3.0);
+        return {
+            _mm512_div_pd(_mm512_add_pd(_mm512_add_pd(nc.x, nb.x), na.x), d),
+            _mm512_div_pd(_mm512_add_pd(_mm512_add_pd(nc.y, nb.y), na.y), d),
+            _mm512_div_pd(_mm512_add_pd(_mm512_add_pd(nc.z, nb.z), na.z), d)
+        };
+    }
+
+    static size_t triangle(size_t n, const Scalar *const coord[3], const size_t *node, Scalar *S, Scalar *const rc[3], Scalar *const n_LR[3])
+    {
+        const V one = _mm512_set1_pd(1.0);
+        size_t i = 0;
+        for (; i + W <= n; i += W)
+        {
+            const size_t *cur = node + 3 * i;
+            const P p1 = gather(coord, cur, 3);
+            const P p2 = gather(coord, cur + 1, 3);
+            const P p3 = gather(coord, cur + 2, 3);
+
+            _mm512_storeu_pd(S + i, area(p1, p2, p3));
+            store(center(p1, p2, p3), rc, i);
+            store(normalize(cross(delta(p1, p2), delta(p1, p3)), one), n_LR, i);
+        }
+        return i;
+    }
+
+    static size_t quadrilateral(size_t n, const Scalar *const coord[3], const size_t *node, Scalar *S, Scalar *const rc[3], Scalar *const n_LR[3])
+    {
+        const V one = _mm512_set1_pd(1.0);
+        const V minus_one = _mm512_set1_pd(-1.0);
+        size_t i = 0;
+        for (; i + W <= n; i += W)
+        {
+            const size_t *cur = node + 4 * i;
+            const P p1 = gather(coord, cur, 4);
+            const P p2 = gather(coord, cur + 1, 4);
+            const P p3 = gather(coord, cur + 2, 4);
+            const P p4 = gather(coord, cur + 3, 4);
+
+            const V S123 = area(p1, p2, p3);
+            const V S134 = area(p1, p3, p4);
+            _mm512_storeu_pd(S + i, _mm512_add_pd(S123, S134));
+
+            const V alpha = _mm512_div_pd(S123, _mm512_add_pd(S123, S134));
+            const V beta = _mm512_sub_pd(one, alpha);
+            const P rc123 = center(p1, p2, p3);
+            const P rc134 = center(p1, p3, p4);
+            store({
+                _mm512_add_pd(_mm512_mul_pd(rc123.x, alpha), _mm512_mul_pd(rc134.x, beta)),
+                _mm512_add_pd(_mm512_mul_pd(rc123.y, alpha), _mm512_mul_pd(rc134.y, beta)),
+                _mm512_add_pd(_mm512_mul_pd(rc123.z, alpha), _mm512_mul_pd(rc134.z, beta))
+            }, rc, i);
+
+            store(normalize(cross(delta(p2, p4), delta(p1, p3)), minus_one), n_LR, i);
+        }
+        return i;
+    }
+}
+#pragma GCC pop_options
+#endif
+
+namespace GridTool::COMMON
+{
+    SIMD_ISA simd_supported()
+    {
+#ifdef TYDF_HAS_X86_SIMD
+        static const SIMD_ISA isa = __builtin_cpu_supports("avx512f") ? AVX512_ISA : (__builtin_cpu_supports("avx2") ? AVX2_ISA : SCALAR_ISA);
+        return isa;
+#else
+        return SCALAR_ISA;
+#endif
+    }
+
+    SIMD_ISA &simd_isa()
+    {
+        static SIMD_ISA isa = simd_supported();
+        return isa;
+    }
+
+    void triangle_geometry(size_t n, const Scalar *const coord[3], const size_t *node, Scalar *area, Scalar *const center[3], Scalar *const normal[3])
+    {
+        size_t i = 0;
+#ifdef TYDF_HAS_X86_SIMD
+        const SIMD_ISA isa = std::min(simd_isa(), simd_supported());
+        if (isa == AVX512_ISA)
+            i = AVX512::triangle(n, coord, node, area, center, normal);
+        else if (isa == AVX2_ISA)
+            i = AVX2::triangle(n, coord, node, area, center, normal);
+#endif
+
+        /// Remaining ones
+        for (; i < n; ++i)
+        {
+            const size_t *cur = node + 3 * i;
+            const Vector p1(coord[0][cur[0]], coord[1][cur[0]], coord[2][cur[0]]);
+            const Vector p2(coord[0][cur[1]], coord[1][cur[1]], coord[2][cur[1]]);
+            const Vector p3(coord[0][cur[2]], coord[1][cur[2]], coord[2][cur[2]]);
+
+            Vector rc, n_LR, n_RL;
+            area[i] = triangle_area(p1, p2, p3);
+            triangle_center(p1, p2, p3, rc);
+            triangle_normal(p1, p2, p3, n_LR, n_RL);
+            for (int k = 0; k < 3; ++k)
+            {
+                center[k][i] = rc[k];
+                normal[k][i] = n_LR[k];
+            }
+        }
+    }
+
+    void quadrilateral_geometry(size_t n, const Scalar *const coord[3], const size_t *node, Scalar *area, Scalar *const center[3], Scalar *const normal[3])
+    {
+        size_t i = 0;
+#ifdef TYDF_HAS_X86_SIMD
+        const SIMD_ISA isa = std::min(simd_isa(), simd_supported());
+        if (isa == AVX512_ISA)
+            i = AVX512::quadrilateral(n, coord, node, area, center, normal);
+        else if (isa == AVX2_ISA)
+            i = AVX2::quadrilateral(n, coord, node, area, center, normal);
+#endif
+
+        /// Remaining ones
+        for (; i < n; ++i)
+        {
+            const size_t *cur = node + 4 * i;
+            const Vector p1(coord[0][cur[0]], coord[1][cur[0]], coord[2][cur[0]]);
+            const Vector p2(coord[0][cur[1]], coord[1][cur[1]], coord[2][cur[1]]);
+            const Vector p3(coord[0][cur[2]], coord[1][cur[2]], coord[2][cur[2]]);
+            const Vector p4(coord[0][cur[3]], coord[1][cur[3]], coord[2][cur[3]]);
+
+            Vector rc, n_LR, n_RL;
+            area[i] = quadrilateral_area(p1, p2, p3, p4);
+            quadrilateral_center(p1, p2, p3, p4, rc);
+            quadrilateral_normal(p1, p2, p3, p4, n_LR, n_RL);
+            for (int k = 0; k < 3; ++k)
+            {
+                center[k][i] = rc[k];
+                normal[k][i] = n_LR[k];
+            }
+        }
+    }
+
+    DISJOINT_SET::DISJOINT_SET(size_t n)
+    {
+        reset(n);
+    }
+
+    void DISJOINT_SET::reset(size_t n)
+    {
+        m_parent.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            m_parent[i] = i;
+        m_size.assign(n, 1);
+        m_parity.assign(n, 0);
+    }
+
+    size_t DISJOINT_SET::size() const
+    {
+        return m_parent.size();
+    }
+
+    size_t DISJOINT_SET::find(size_t x)
+    {
+        size_t r = x;
+        unsigned char p = 0;
+        while (m_parent[r] != r)
+        {
+            p ^= m_parity[r];
+            r = m_parent[r];
+        }
+
+        /// Compress the path, "p" is the parity of "x" relative to "r".
+        while (x != r)
+        {
+            const size_t y = m_parent[x];
+            const unsigned char q = m_parity[x];
+            m_parent[x] = r;
+            m_parity[x] = p;
+            p ^= q;
+            x = y;
+        }
+        return r;
+    }
+
+    bool DISJOINT_SET::parity(size_t x)
+    {
+        find(x);
+        return m_parity[x] != 0;
+    }
+
+    bool DISJOINT_SET::unite(size_t a, size_t b, bool p)
+    {
+        size_t ra = find(a), rb = find(b);
+        const unsigned char pa = m_parity[a], pb = m_parity[b];
+        if (ra == rb)
+            return (pa ^ pb) == static_cast<unsigned char>(p);
+
+        if (m_size[ra] < m_size[rb])
+            std::swap(ra, rb);
+        m_parent[rb] = ra;
+        m_size[ra] += m_size[rb];
+        m_parity[rb] = pa ^ pb ^ static_cast<unsigned char>(p);
+        return true;
+    }
+
+    MAPPED_FILE::MAPPED_FILE(const std::string &src) :
+        m_data(nullptr),
+        m_size(0),
+        m_mapped(false)
+    {
+#ifdef TYDF_HAS_MMAP
+        const int fd = ::open(src.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Failed to open input file: \"" + src + "\".");
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+                m_data = static_cast<const char*>(p);
+                m_size = st.st_size;
+                m_mapped = true;
+            }
+        }
+        ::close(fd);
+        if (m_mapped)
+            return;
+#endif
+        std::ifstream fin(src, std::ios::binary);
+        if (fin.fail())
+            throw std::runtime_error("Failed to open input file: \"" + src + "\".");
+        m_buf.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+        m_data = m_buf.data();
+        m_size = m_buf.size();
+    }
+
+    MAPPED_FILE::~MAPPED_FILE()
+    {
+#ifdef TYDF_HAS_MMAP
+        if (m_mapped)
+            ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    ASYNC_WRITER::ASYNC_WRITER(std::ostream &out, size_t depth) :
+        m_out(out),
+        m_depth(std::max<size_t>(depth, 1)),
+        m_done(false)
+    {
+        m_worker = std::thread(&ASYNC_WRITER::run, this);
+    }
+
+    ASYNC_WRITER::~ASYNC_WRITER()
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mtx);
+            m_done = true;
+        }
+        m_cv.notify_all();
+        if (m_worker.joinable())
+            m_worker.join();
+    }
+
+    void ASYNC_WRITER::run()
+    {
+        std::unique_lock<std::mutex> lck(m_mtx);
+        while (true)
+        {
+            m_cv.wait(lck, [this]() { return m_done || !m_queue.empty(); });
+            if (m_queue.empty())
+                return;
+
+            /// The front stays in the queue while being written, thus it counts as pending.
+            const std::string &buf = m_queue.front();
+            lck.unlock();
+            bool ok = true;
+            if (!m_err)
+            {
+                m_out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                ok = !m_out.fail();
+            }
+            lck.lock();
+            if (!ok)
+                m_err = std::make_exception_ptr(std::runtime_error("Failed to write output file."));
+            m_queue.pop_front();
+            m_cv.notify_all();
+        }
+    }
+
+    void ASYNC_WRITER::push(std::string &&buf)
+    {
+        std::unique_lock<std::mutex> lck(m_mtx);
+        m_cv.wait(lck, [this]() { return m_queue.size() < m_depth; });
+        if (m_err)
+            std::rethrow_exception(m_err);
+        m_queue.push_back(std::move(buf));
+        lck.unlock();
+        m_cv.notify_all();
+    }
+
+    void ASYNC_WRITER::finish()
+    {
+        std::unique_lock<std::mutex> lck(m_mtx);
+        m_cv.wait(lck, [this]() { return m_queue.empty(); });
+        if (m_err)
+            std::rethrow_exception(m_err);
+    }
+
+    size_t peak_rss()
+    {
+#if defined(__linux__)
+        /// "ru_maxrss" also keeps the peak of exited threads, which survives "reset_peak_rss".
+        std::ifstream fin("/proc/self/status");
+        std::string s;
+        while (std::getline(fin, s))
+            if (s.compare(0, 6, "VmHWM:") == 0)
+                return std::stoul(s.substr(6));
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage usage;
+        if (::getrusage(RUSAGE_SELF, &usage) == 0)
+        {
+#ifdef __APPLE__
+            return static_cast<size_t>(usage.ru_maxrss) / 1024;
+#else
+            return static_cast<size_t>(usage.ru_maxrss);
+#endif
+        }
+#endif
+        return 0;
+    }
+
+    void reset_peak_rss()
+    {
+#if defined(__linux__)
+        std::ofstream fout("/proc/self/clear_refs");
+        fout << "5";
+#endif
+    }
+
+    /// Names are quoted as JSON strings.
+    static void write_name(std::ostream &out, const std::string &name)
+    {
+        out << '"';
+        for (auto c : name)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\';
+            out << c;
+        }
+        out << '"';
+    }
+
+    PROFILER::PROFILER() :
+        m_origin(std::chrono::steady_clock::now())
+    {
+        /// Empty body.
+    }
+
+    void PROFILER::reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_origin = std::chrono::steady_clock::now();
+        m_thread.clear();
+        m_event.clear();
+        m_sample.clear();
+        m_counter.clear();
+    }
+
+    double PROFILER::now() const
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_origin).count();
+    }
+
+    size_t PROFILER::thread_index()
+    {
+        const auto id = std::this_thread::get_id();
+        const auto it = std::find(m_thread.begin(), m_thread.end(), id);
+        if (it != m_thread.end())
+            return it - m_thread.begin();
+        m_thread.push_back(id);
+        return m_thread.size() - 1;
+    }
+
+    void PROFILER::record(const std::string &name, double start, double finish)
+    {
+        const size_t rss = peak_rss();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_event.push_back({ name, start, finish - start, thread_index(), rss });
+    }
+
+    void PROFILER::count(const std::string &name, long long val)
+    {
+        const double t = now();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &cnt = m_counter[name];
+        cnt += val;
+        m_sample.push_back({ name, t, cnt });
+    }
+
+    std::vector<PROFILER::EVENT> PROFILER::events() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_event;
+    }
+
+    std::map<std::string, long long> PROFILER::counters() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_counter;
+    }
+
+    long long PROFILER::counter(const std::string &name) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto it = m_counter.find(name);
+        return it == m_counter.end() ? 0 : it->second;
+    }
+
+    void PROFILER::dump_json(std::ostream &out) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        /// Events of the same name are summed up, in the order of first appearance.
+        std::vector<std::string> name;
+        std::map<std::string, std::pair<size_t, double>> total;
+        for (const auto &e : m_event)
+        {
+            auto &t = total[e.name];
+            if (t.first == 0)
+                name.push_back(e.name);
+            ++t.first;
+            t.second += e.duration;
+        }
+
+        out << "{\n  \"events\": [";
+        for (size_t i = 0; i < m_event.size(); ++i)
+        {
+            const auto &e = m_event[i];
+            out << (i ? ",\n    " : "\n    ") << "{ \"name\": ";
+            write_name(out, e.name);
+            out << ", \"start_us\": " << e.start << ", \"duration_us\": " << e.duration;
+            out << ", \"thread\": " << e.thread << ", \"peak_rss_kb\": " << e.peak_rss << " }";
+        }
+        out << "\n  ],\n  \"stages\": [";
+        for (size_t i = 0; i < name.size(); ++i)
+        {
+            const auto &t = total[name[i]];
+            out << (i ? ",\n    " : "\n    ") << "{ \"name\": ";
+            write_name(out, name[i]);
+            out << ", \"calls\": " << t.first << ", \"total_us\": " << t.second << " }";
+        }
+        out << "\n  ],\n  \"counters\": {";
+        bool first = true;
+        for (const auto &c : m_counter)
+        {
+            out << (first ? "\n    " : ",\n    ");
+            write_name(out, c.first);
+            out << ": " << c.second;
+            first = false;
+        }
+        out << "\n  },\n  \"peak_rss_kb\": " << peak_rss() << "\n}" << std::endl;
+    }
+
+    void PROFILER::dump_trace(std::ostream &out) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        /// Complete events ("X") for timers, and counter events ("C") for counters.
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for (const auto &e : m_event)
+        {
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            write_name(out, e.name);
+            out << ",\"cat\":\"TYDF\",\"ph\":\"X\",\"ts\":" << e.start << ",\"dur\":" << e.duration;
+            out << ",\"pid\":0,\"tid\":" << e.thread << ",\"args\":{\"peak_rss_kb\":" << e.peak_rss << "}}";
+            first = false;
+        }
+        for (const auto &e : m_sample)
+        {
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            write_name(out, e.name);
+            out << ",\"cat\":\"TYDF\",\"ph\":\"C\",\"ts\":" << e.time << ",\"pid\":0,\"args\":{\"value\":" << e.value << "}}";
+            first = false;
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    }
+
+    PROFILER &profiler()
+    {
+        static PROFILER p;
+        return p;
+    }
+
+    SCOPED_TIMER::SCOPED_TIMER(const char *name) :
+        m_name(name),
+        m_start(profiler().now())
+    {
+        /// Empty body.
+    }
+
+    SCOPED_TIMER::~SCOPED_TIMER()
+    {
+        auto &p = profiler();
+        p.record(m_name, m_start, p.now());
+    }
+}
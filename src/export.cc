@@ -0,0 +1,251 @@
+#include "../inc/nmf.h"
+#include "../inc/plot3d.h"
+#include <cstdint>
+
+#ifdef TYDF_USE_CGNS
+#include <cgnslib.h>
+#endif
+
+/// Blocks of "p3d" must be of the same dimensions as those of "nmf".
+static void check_dimension(const GridTool::NMF::Mapping3D &nmf, const GridTool::PLOT3D::READER &p3d)
+{
+    if (nmf.nBlock() != p3d.numOfBlock())
+        throw std::invalid_argument("Inconsistent num of blocks between NMF and PLOT3D.");
+    for (size_t n = 1; n <= nmf.nBlock(); ++n)
+    {
+        const auto &b = nmf.block(n);
+        const std::array<size_t, 3> dim = { b.IDIM(), b.JDIM(), b.KDIM() };
+        if (dim != p3d.block_dimension(n - 1))
+            throw std::invalid_argument("Inconsistent dimensions of Block " + std::to_string(n) + " between NMF and PLOT3D.");
+    }
+}
+
+/// Name of a file without the leading directories.
+static std::string base_name(const std::string &path)
+{
+    const auto pos = path.find_last_of("/\\");
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+static const char *host_byte_order()
+{
+    const uint16_t x = 1;
+    return *reinterpret_cast<const unsigned char*>(&x) == 1 ? "LittleEndian" : "BigEndian";
+}
+
+/// Structured grid of a single block, with points in the appended section as raw binary.
+static void write_vts(const std::string &dst, const GridTool::PLOT3D::BLK &blk)
+{
+    const size_t nI = blk.nI(), nJ = blk.nJ(), nK = blk.nK();
+    const size_t n = blk.size();
+
+    /// VTK takes interleaved components.
+    std::vector<double> buf(3 * n);
+    const double *const plane[3] = { blk.plane(0), blk.plane(1), blk.plane(2) };
+    GridTool::COMMON::parallel_for(n, [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+            for (int c = 0; c < 3; ++c)
+                buf[3 * i + c] = plane[c][i];
+    }, 1 << 14);
+
+    std::ofstream fout(dst, std::ios::binary);
+    if (fout.fail())
+        throw std::runtime_error("Failed to open target file: \"" + dst + "\".");
+
+    const std::string extent = "0 " + std::to_string(nI - 1) + " 0 " + std::to_string(nJ - 1) + " 0 " + std::to_string(nK - 1);
+    fout << "<?xml version=\"1.0\"?>\n";
+    fout << "<VTKFile type=\"StructuredGrid\" version=\"1.0\" byte_order=\"" << host_byte_order() << "\" header_type=\"UInt64\">\n";
+    fout << "  <StructuredGrid WholeExtent=\"" << extent << "\">\n";
+    fout << "    <Piece Extent=\"" << extent << "\">\n";
+    fout << "      <Points>\n";
+    fout << "        <DataArray type=\"Float64\" Name=\"Points\" NumberOfComponents=\"3\" format=\"appended\" offset=\"0\"/>\n";
+    fout << "      </Points>\n";
+    fout << "    </Piece>\n";
+    fout << "  </StructuredGrid>\n";
+    fout << "  <AppendedData encoding=\"raw\">\n";
+    fout << "   _";
+    const uint64_t nByte = buf.size() * sizeof(double);
+    fout.write(reinterpret_cast<const char*>(&nByte), sizeof(nByte));
+    fout.write(reinterpret_cast<const char*>(buf.data()), nByte);
+    fout << "\n  </AppendedData>\n";
+    fout << "</VTKFile>\n";
+    if (fout.fail())
+        throw std::runtime_error("Failed to write \"" + dst + "\".");
+}
+
+#ifdef TYDF_USE_CGNS
+static void cgns_check(int err)
+{
+    if (err != CG_OK)
+        throw std::runtime_error(std::string("CGNS error: ") + cg_get_error());
+}
+
+static CGNS_ENUMT(BCType_t) cgns_bc_type(int bc)
+{
+    switch (bc)
+    {
+    case GridTool::NMF::BC::SYM:
+        return CGNS_ENUMV(BCSymmetryPlane);
+    case GridTool::NMF::BC::WALL:
+        return CGNS_ENUMV(BCWall);
+    case GridTool::NMF::BC::INFLOW:
+        return CGNS_ENUMV(BCInflow);
+    case GridTool::NMF::BC::OUTFLOW:
+        return CGNS_ENUMV(BCOutflow);
+    case GridTool::NMF::BC::FAR:
+        return CGNS_ENUMV(BCFarfield);
+    default:
+        return CGNS_ENUMV(BCTypeUserDefined);
+    }
+}
+#endif
+
+namespace GridTool::NMF
+{
+    void Mapping3D::writeVTK(const std::string &f_p3d, const std::string &prefix) const
+    {
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::writeVTK");
+
+        PLOT3D::READER p3d(f_p3d);
+        check_dimension(*this, p3d);
+
+        std::ofstream fout(prefix + ".vtm");
+        if (fout.fail())
+            throw std::runtime_error("Failed to open target file: \"" + prefix + ".vtm\".");
+
+        fout << "<?xml version=\"1.0\"?>\n";
+        fout << "<VTKFile type=\"vtkMultiBlockDataSet\" version=\"1.0\" byte_order=\"" << host_byte_order() << "\" header_type=\"UInt64\">\n";
+        fout << "  <vtkMultiBlockDataSet>\n";
+        for (size_t n = 1; n <= nBlock(); ++n)
+        {
+            const std::string f_vts = prefix + "_" + std::to_string(n) + ".vts";
+            const PLOT3D::BLK *g = p3d.next();
+            write_vts(f_vts, *g);
+            delete g;
+
+            fout << "    <DataSet index=\"" << n - 1 << "\" name=\"Block" << n << "\" file=\"" << base_name(f_vts) << "\"/>\n";
+        }
+        fout << "  </vtkMultiBlockDataSet>\n";
+        fout << "</VTKFile>\n";
+    }
+
+#ifdef TYDF_USE_CGNS
+    void Mapping3D::writeCGNS(const std::string &f_p3d, const std::string &dst) const
+    {
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::writeCGNS");
+
+        PLOT3D::READER p3d(f_p3d);
+        check_dimension(*this, p3d);
+
+        int fn = 0, B = 0;
+        cgns_check(cg_open(dst.c_str(), CG_MODE_WRITE, &fn));
+        try
+        {
+            cgns_check(cg_base_write(fn, "Base", 3, 3, &B));
+
+            /// Zones are "1", "2", ... in order of creation, i.e. the same as blocks.
+            auto zone_name = [](size_t n) { return "Block" + std::to_string(n); };
+            for (size_t n = 1; n <= nBlock(); ++n)
+            {
+                const auto &b = block(n);
+                const cgsize_t size[9] = {
+                    static_cast<cgsize_t>(b.IDIM()), static_cast<cgsize_t>(b.JDIM()), static_cast<cgsize_t>(b.KDIM()),
+                    static_cast<cgsize_t>(b.IDIM() - 1), static_cast<cgsize_t>(b.JDIM() - 1), static_cast<cgsize_t>(b.KDIM() - 1),
+                    0, 0, 0
+                };
+                int Z = 0;
+                cgns_check(cg_zone_write(fn, B, zone_name(n).c_str(), size, CGNS_ENUMV(Structured), &Z));
+
+                /// Planes of a PLOT3D block are laid out as CGNS takes, with "i" varying fastest.
+                const PLOT3D::BLK *g = p3d.next();
+                static const char *const CoordName[3] = { "CoordinateX", "CoordinateY", "CoordinateZ" };
+                for (int c = 0; c < 3; ++c)
+                {
+                    int C = 0;
+                    cgns_check(cg_coord_write(fn, B, Z, CGNS_ENUMV(RealDouble), CoordName[c], g->plane(c), &C));
+                }
+                delete g;
+            }
+
+            /// Axes of the primary, secondary and normal direction of each surface, 0-based.
+            static const int Axis[6][3] = { { 0, 1, 2 }, { 0, 1, 2 }, { 1, 2, 0 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 0, 1 } };
+
+            /// (i, j, k) of node "(pri, sec)" on "rg".
+            auto point = [this](const auto &rg, size_t pri, size_t sec, cgsize_t *dst)
+            {
+                size_t i, j, k;
+                block(rg.B()).surface_node_coordinate(rg.F(), pri, sec, i, j, k);
+                dst[0] = static_cast<cgsize_t>(i);
+                dst[1] = static_cast<cgsize_t>(j);
+                dst[2] = static_cast<cgsize_t>(k);
+            };
+
+            /// Node "(l1, l2)" steps from the start of "src" corresponds to that of "dst",
+            /// in the same correspondence as "numbering_node".
+            /// Range is ascending on "src", and "transform" maps axes of "src" to those of "dst".
+            auto connect = [&point](const auto &src, const auto &dst, bool swap, cgsize_t *range, cgsize_t *donor, int *transform)
+            {
+                const int d1 = src.pri_trend() ? 1 : -1, d2 = src.sec_trend() ? 1 : -1;
+                const int e1 = dst.pri_trend() ? 1 : -1, e2 = dst.sec_trend() ? 1 : -1;
+                const size_t L1 = src.pri_node_num() - 1, L2 = src.sec_node_num() - 1;
+
+                auto donor_point = [&](size_t l1, size_t l2, cgsize_t *p)
+                {
+                    if (swap)
+                        std::swap(l1, l2);
+                    point(dst, dst.S1() + e1 * static_cast<long long>(l1), dst.S2() + e2 * static_cast<long long>(l2), p);
+                };
+
+                const size_t l1 = d1 > 0 ? 0 : L1, l2 = d2 > 0 ? 0 : L2;
+                point(src, std::min(src.S1(), src.E1()), std::min(src.S2(), src.E2()), range);
+                point(src, std::max(src.S1(), src.E1()), std::max(src.S2(), src.E2()), range + 3);
+                donor_point(l1, l2, donor);
+                donor_point(L1 - l1, L2 - l2, donor + 3);
+
+                const auto &a = Axis[src.F() - 1], &b = Axis[dst.F() - 1];
+                transform[a[0]] = d1 * (swap ? e2 * (b[1] + 1) : e1 * (b[0] + 1));
+                transform[a[1]] = d2 * (swap ? e1 * (b[0] + 1) : e2 * (b[1] + 1));
+
+                /// Stepping out of "src" is stepping into "dst".
+                const int out = src.F() % 2 == 0 ? 1 : -1, in = dst.F() % 2 == 0 ? -1 : 1;
+                transform[a[2]] = out * in * (b[2] + 1);
+            };
+
+            for (size_t e = 1; e <= nEntry(); ++e)
+            {
+                const auto p = m_entry(e);
+                const std::string name = "Entry" + std::to_string(e);
+                if (p->Type() == BC::ONE_TO_ONE)
+                {
+                    const auto q = static_cast<const DoubleSideEntry*>(p);
+                    const auto &rg1 = q->Range1();
+                    const auto &rg2 = q->Range2();
+
+                    cgsize_t range[6], donor[6];
+                    int transform[3], I = 0;
+                    connect(rg1, rg2, q->Swap(), range, donor, transform);
+                    cgns_check(cg_1to1_write(fn, B, static_cast<int>(rg1.B()), (name + "_1").c_str(), zone_name(rg2.B()).c_str(), range, donor, transform, &I));
+                    connect(rg2, rg1, q->Swap(), range, donor, transform);
+                    cgns_check(cg_1to1_write(fn, B, static_cast<int>(rg2.B()), (name + "_2").c_str(), zone_name(rg1.B()).c_str(), range, donor, transform, &I));
+                }
+                else
+                {
+                    const auto &rg = p->Range1();
+                    cgsize_t pnts[6];
+                    point(rg, std::min(rg.S1(), rg.E1()), std::min(rg.S2(), rg.E2()), pnts);
+                    point(rg, std::max(rg.S1(), rg.E1()), std::max(rg.S2(), rg.E2()), pnts + 3);
+                    int BC = 0;
+                    cgns_check(cg_boco_write(fn, B, static_cast<int>(rg.B()), name.c_str(), cgns_bc_type(p->Type()), CGNS_ENUMV(PointRange), 2, pnts, &BC));
+                }
+            }
+        }
+        catch (...)
+        {
+            cg_close(fn);
+            throw;
+        }
+        cgns_check(cg_close(fn));
+    }
+#endif
+}
@@ -11,6 +11,210 @@ static std::string version_str()
     return "V" + std::to_string(major) + "." + std::to_string(minor) + "." + std::to_string(patch);
 }
 
+/// Local node sequence (1-based, see "NMF::HEX_CELL::NodeSeq") of each face
+/// of a hex cell (1-based, see "NMF::HEX_CELL::FaceSeq"), ordered such that the
+/// thumb of right hand points into the cell when curling fingers along the nodes.
+static const short FACE_NODE_SEQ[6][4] = {
+    { 4, 8, 5, 1 }, /// K-min
+    { 6, 7, 3, 2 }, /// K-max
+    { 2, 1, 5, 6 }, /// I-min
+    { 7, 8, 4, 3 }, /// I-max
+    { 1, 2, 3, 4 }, /// J-min
+    { 7, 6, 5, 8 }  /// J-max
+};
+
+/// Offsets in (i, j, k) of each local node (1-based, see "NMF::HEX_CELL::NodeSeq")
+/// of a hex cell, with respect to the left-most, bottom-most and back-most node.
+static const short NODE_SHIFT[8][3] = {
+    { 0, 0, 0 },
+    { 0, 0, 1 },
+    { 1, 0, 1 },
+    { 1, 0, 0 },
+    { 0, 1, 0 },
+    { 0, 1, 1 },
+    { 1, 1, 1 },
+    { 1, 1, 0 }
+};
+
+/// Position of each face of a hex cell when visiting the cell,
+/// faces at the lower side come first, see "MESH::MESH".
+static const short FACE_VISIT_SEQ[6] = { 0, 3, 1, 4, 2, 5 };
+
+/// Global index of nodes on the "f"-th face of cell (i, j, k), ordered as "FACE_NODE_SEQ".
+static void face_node(const GridTool::NMF::Block3D &b, size_t i, size_t j, size_t k, short f, size_t *dst)
+{
+    for (short r = 0; r < 4; ++r)
+    {
+        const auto &d = NODE_SHIFT[FACE_NODE_SEQ[f - 1][r] - 1];
+        dst[r] = b.node_index(i + d[0], j + d[1], k + d[2]);
+    }
+}
+
+/// Cell (i, j, k) adjacent to the face on surface "f", see "NMF::Block3D::surface_face_index".
+static void surface_cell(const GridTool::NMF::Block3D &b, short f, size_t pri, size_t sec, size_t &i, size_t &j, size_t &k)
+{
+    switch (f)
+    {
+    case 1:
+        i = pri;
+        j = sec;
+        k = 1;
+        break;
+    case 2:
+        i = pri;
+        j = sec;
+        k = b.KDIM() - 1;
+        break;
+    case 3:
+        i = 1;
+        j = pri;
+        k = sec;
+        break;
+    case 4:
+        i = b.IDIM() - 1;
+        j = pri;
+        k = sec;
+        break;
+    case 5:
+        i = sec;
+        j = 1;
+        k = pri;
+        break;
+    case 6:
+        i = sec;
+        j = b.JDIM() - 1;
+        k = pri;
+        break;
+    default:
+        throw std::invalid_argument("Invalid surface index: " + std::to_string(f) + ".");
+    }
+}
+
+/// Records of "n" nodes or quadrilateral faces formatted as in "NODE::repr" and "FACE::repr",
+/// where "pos(r)" gives the r-th node, and "cnct(r, nd, c)" gives nodes and cells of the r-th face.
+/// Records are formatted concurrently, thus both are called from multiple threads.
+template<typename F>
+static void write_nodes(std::ostream &out, size_t n, const F &pos)
+{
+    using namespace GridTool;
+
+    COMMON::write_records(out, n, [&pos](size_t first, size_t last, std::string &buf)
+    {
+        COMMON::append_records(buf, first, last, XF::NODE::RecordWidth, [&pos](size_t r, char *p)
+        {
+            return XF::NODE::put_record(p, pos(r), 3);
+        });
+    });
+}
+
+template<typename F>
+static void write_faces(std::ostream &out, size_t n, const F &cnct)
+{
+    using namespace GridTool;
+
+    COMMON::write_records(out, n, [&cnct](size_t first, size_t last, std::string &buf)
+    {
+        COMMON::append_records(buf, first, last, XF::FACE::RecordWidth, [&cnct](size_t r, char *p)
+        {
+            size_t nd[4], c[2];
+            cnct(r, nd, c);
+            return XF::FACE::put_record(p, 4, nd, c[0], c[1], false);
+        });
+    });
+}
+
+#ifdef TYDF_USE_MPI
+/// Single record of a node or a face, same as "write_nodes" and "write_faces".
+static void write_node(std::ostream &out, const GridTool::COMMON::Vector &p)
+{
+    char buf[GridTool::XF::NODE::RecordWidth];
+    out.write(buf, GridTool::XF::NODE::put_record(buf, p, 3) - buf);
+}
+
+static void write_face(std::ostream &out, const size_t *nd, size_t c0, size_t c1)
+{
+    char buf[GridTool::XF::FACE::RecordWidth];
+    out.write(buf, GridTool::XF::FACE::put_record(buf, 4, nd, c0, c1, false) - buf);
+}
+
+static void mpi_check(int err, const char *what)
+{
+    if (err != MPI_SUCCESS)
+        throw std::runtime_error(std::string("Failure of \"") + what + "\".");
+}
+
+/// Send "snd[r]" to rank "r" and receive from all, in the order of senders.
+template<typename T>
+static std::vector<T> all_to_all(MPI_Comm comm, const std::vector<std::vector<T>> &snd)
+{
+    const int P = static_cast<int>(snd.size());
+    std::vector<int> sc(P), rc(P), sd(P, 0), rd(P, 0);
+    for (int r = 0; r < P; ++r)
+        sc[r] = static_cast<int>(snd[r].size());
+    mpi_check(MPI_Alltoall(sc.data(), 1, MPI_INT, rc.data(), 1, MPI_INT, comm), "MPI_Alltoall");
+    for (int r = 1; r < P; ++r)
+    {
+        sd[r] = sd[r - 1] + sc[r - 1];
+        rd[r] = rd[r - 1] + rc[r - 1];
+    }
+
+    std::vector<T> sbuf, rbuf(rd[P - 1] + rc[P - 1]);
+    sbuf.reserve(sd[P - 1] + sc[P - 1]);
+    for (const auto &e : snd)
+        sbuf.insert(sbuf.end(), e.begin(), e.end());
+
+    MPI_Datatype t;
+    mpi_check(MPI_Type_contiguous(sizeof(T), MPI_BYTE, &t), "MPI_Type_contiguous");
+    mpi_check(MPI_Type_commit(&t), "MPI_Type_commit");
+    mpi_check(MPI_Alltoallv(sbuf.data(), sc.data(), sd.data(), t, rbuf.data(), rc.data(), rd.data(), t, comm), "MPI_Alltoallv");
+    MPI_Type_free(&t);
+    return rbuf;
+}
+
+/// Write "buf" of all ranks one after another from "base", in the order of ranks.
+/// Returns the end of the last one.
+static MPI_Offset write_ordered(MPI_File fh, MPI_Comm comm, MPI_Offset base, const std::string &buf)
+{
+    /// Counts of a single call are limited to "int".
+    static const long long Chunk = 1LL << 30;
+
+    int rank = 0;
+    MPI_Comm_rank(comm, &rank);
+    long long len = static_cast<long long>(buf.size()), off = 0, total = 0;
+    mpi_check(MPI_Exscan(&len, &off, 1, MPI_LONG_LONG, MPI_SUM, comm), "MPI_Exscan");
+    if (rank == 0)
+        off = 0;
+    mpi_check(MPI_Allreduce(&len, &total, 1, MPI_LONG_LONG, MPI_SUM, comm), "MPI_Allreduce");
+
+    long long nChunk = (len + Chunk - 1) / Chunk, maxChunk = 0;
+    mpi_check(MPI_Allreduce(&nChunk, &maxChunk, 1, MPI_LONG_LONG, MPI_MAX, comm), "MPI_Allreduce");
+    for (long long c = 0; c < maxChunk; ++c)
+    {
+        const long long first = std::min(c * Chunk, len), last = std::min(first + Chunk, len);
+        mpi_check(MPI_File_write_at_all(fh, base + off + first, buf.data() + first, static_cast<int>(last - first), MPI_CHAR, MPI_STATUS_IGNORE), "MPI_File_write_at_all");
+    }
+    return base + total;
+}
+#endif
+
+static void check_consistency(const GridTool::NMF::Mapping3D &nmf, const GridTool::PLOT3D::READER &p3d)
+{
+    const size_t NBLK = nmf.nBlock();
+    if (NBLK != p3d.numOfBlock())
+        throw std::invalid_argument("Inconsistent num of blocks between NMF and PLOT3D.");
+    for (size_t n = 1; n <= NBLK; ++n)
+    {
+        const auto &b = nmf.block(n);
+        const auto &g = p3d.block_dimension(n - 1);
+        if (b.IDIM() != g[0])
+            throw std::invalid_argument("Inconsistent num of nodes in I dimension of Block " + std::to_string(n) + ".");
+        if (b.JDIM() != g[1])
+            throw std::invalid_argument("Inconsistent num of nodes in J dimension of Block " + std::to_string(n) + ".");
+        if (b.KDIM() != g[2])
+            throw std::invalid_argument("Inconsistent num of nodes in K dimension of Block " + std::to_string(n) + ".");
+    }
+}
+
 namespace GridTool::XF
 {
     MESH::MESH(const std::string &f_nmf, const std::string &f_p3d, std::ostream &fout) :
@@ -18,47 +222,61 @@ namespace GridTool::XF
         m_totalNodeNum(0),
         m_totalCellNum(0),
         m_totalFaceNum(0),
-        m_totalZoneNum(0)
+        m_totalZoneNum(0),
+        m_derived(0),
+        m_renumbered(false)
     {
         /// Load mapping file.
-        auto nmf = new NMF::Mapping3D(f_nmf);
-        nmf->compute_topology();
-        nmf->numbering();
+        /// Topology has been computed during construction.
+        /// Only indices on block surfaces are stored when numbering.
+        NMF::Mapping3D nmf(f_nmf);
+        nmf.numbering(false);
 
-        /// Load grid file.
-        auto p3d = new PLOT3D::GRID(f_p3d);
+        assemble(nmf, f_p3d, fout);
+    }
+
+    MESH::MESH(const NMF::Mapping3D &nmf, const std::string &f_p3d, std::ostream &fout) :
+        DIM(3),
+        m_totalNodeNum(0),
+        m_totalCellNum(0),
+        m_totalFaceNum(0),
+        m_totalZoneNum(0),
+        m_derived(0),
+        m_renumbered(false)
+    {
+        assemble(nmf, f_p3d, fout);
+    }
+
+    void MESH::assemble(const NMF::Mapping3D &nmf, const std::string &f_p3d, std::ostream &fout)
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::assemble");
+
+        /// Open grid file, blocks are loaded one by one.
+        PLOT3D::READER p3d(f_p3d);
 
         /// Check consistency.
-        const size_t NBLK = nmf->nBlock();
-        if (NBLK != p3d->numOfBlock())
-            throw std::invalid_argument("Inconsistent num of blocks between NMF and PLOT3D.");
-        for (size_t n = 1; n <= NBLK; ++n)
-        {
-            const auto &b = nmf->block(n);
-            auto g = p3d->block(n - 1);
-            if (b.IDIM() != g->nI())
-                throw std::invalid_argument("Inconsistent num of nodes in I dimension of Block " + std::to_string(n) + ".");
-            if (b.JDIM() != g->nJ())
-                throw std::invalid_argument("Inconsistent num of nodes in J dimension of Block " + std::to_string(n) + ".");
-            if (b.KDIM() != g->nK())
-                throw std::invalid_argument("Inconsistent num of nodes in K dimension of Block " + std::to_string(n) + ".");
-        }
+        check_consistency(nmf, p3d);
+        const size_t NBLK = nmf.nBlock();
 
-        /// Allocate storage.
-        m_totalNodeNum = nmf->nNode();
-        m_totalCellNum = nmf->nCell();
+        /// Counting.
+        m_totalNodeNum = nmf.nNode();
+        m_totalCellNum = nmf.nCell();
         size_t innerFaceNum = 0, bdryFaceNum = 0;
-        nmf->nFace(m_totalFaceNum, innerFaceNum, bdryFaceNum);
-        m_node.resize(numOfNode());
-        m_face.resize(numOfFace());
-        m_cell.resize(numOfCell());
+        nmf.nFace(m_totalFaceNum, innerFaceNum, bdryFaceNum);
+
+        /// Release previous contents.
+        clear_entry();
 
-        /// Copy node info.
-        std::vector<bool> visited(m_node.size(), false);
+        add_entry(new HEADER("Block-Glue " + version_str()));
+        add_entry(new DIMENSION(3));
+
+        /// Nodal coordinates
+        auto part1 = new NODE(1, 1, numOfNode(), NODE::ANY, 3);
+        std::vector<bool> visited(numOfNode(), false);
         for (size_t n = 1; n <= NBLK; ++n)
         {
-            auto &b = nmf->block(n);
-            auto &g = *p3d->block(n - 1);
+            const auto &b = nmf.block(n);
+            auto g = p3d.next();
 
             const size_t nI = b.IDIM();
             const size_t nJ = b.JDIM();
@@ -73,596 +291,826 @@ namespace GridTool::XF
 
                         if (!visited[idx - 1])
                         {
-                            node(idx).coordinate = g(i, j, k);
+                            part1->at(idx - 1) = (*g)(i, j, k);
                             visited[idx - 1] = true;
                         }
                     }
-        }
 
-        /// Copy cell info.
-        for (size_t n = 1; n <= NBLK; ++n)
-        {
-            auto &b = nmf->block(n);
-
-            const size_t nI = b.IDIM();
-            const size_t nJ = b.JDIM();
-            const size_t nK = b.KDIM();
-
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t j = 1; j < nJ; ++j)
-                    for (size_t i = 1; i < nI; ++i)
-                    {
-                        const auto &nc = b.cell(i, j, k);
-                        const auto idx = nc.CellSeq();
-                        auto &fc = cell(idx);
+            delete g;
+        }
+        add_entry(part1);
 
-                        fc.type = CELL::HEXAHEDRAL;
+        /// Cell specifications
+        /// Here, only possible choice for cell is hex.
+        add_entry(new CELL(2, 1, numOfCell(), CELL::FLUID, CELL::HEXAHEDRAL));
 
-                        fc.includedFace.resize(NMF::Block3D::NumOfSurf);
-                        for (short r = 1; r <= NMF::Block3D::NumOfSurf; ++r)
-                            fc.includedFace(r) = nc.FaceSeq(r);
+        /// Face sections.
+        /// Here, only possible choice for face is quad.
+        /// Index assignment convention:
+        ///   1 : Nodal coordinates.
+        ///   2 : Cell specification.
+        ///   3 : Internal faces.
+        ///   4 - N : Boundary faces, each boundary surface forms a zone.
+        /// Internal faces are numbered before boundary ones,
+        /// and faces on the same boundary surface are numbered continuously.
+        std::vector<CONNECTIVITY*> slot(numOfFace(), nullptr);
+        auto register_section = [&](FACE *f)
+        {
+            for (size_t i = f->first_index(); i <= f->last_index(); ++i)
+                slot[i - 1] = &f->at(i - f->first_index());
+            add_entry(f);
+        };
 
-                        fc.includedNode.resize(NMF::Block3D::NumOfVertex);
-                        for (short r = 1; r <= NMF::Block3D::NumOfVertex; ++r)
-                            fc.includedNode(r) = nc.NodeSeq(r);
-                    }
+        register_section(new FACE(3, 1, innerFaceNum, BC::INTERIOR, FACE::QUADRILATERAL));
+        size_t patch_idx = 4;
+        size_t face_pos_R = innerFaceNum;
+        std::vector<std::string> patch_name;
+        for (size_t i = 1; i <= NBLK; ++i)
+        {
+            for (short j = 1; j <= NMF::Block3D::NumOfSurf; ++j)
+            {
+                const auto nBF = nmf.surface_boundary_face_num(i, j);
+                if (nBF > 0)
+                {
+                    const size_t face_pos_L = face_pos_R + 1;
+                    face_pos_R = face_pos_L + nBF - 1;
+                    register_section(new FACE(patch_idx, face_pos_L, face_pos_R, BC::WALL, FACE::QUADRILATERAL));
+                    patch_name.push_back("B" + std::to_string(i) + "F" + std::to_string(j));
+                    ++patch_idx;
+                }
+            }
         }
+        if (face_pos_R != numOfFace())
+            throw std::runtime_error("Inconsistent num of boundary faces.");
+
+        /// Face connectivity.
+        /// "c0" is the cell first visiting the face, "c1" is the other one, if any.
+        /// Faces between 2 cells of the same block are visited only once from the cell
+        /// with larger index, thus "adj" is given, while faces on block surfaces may be
+        /// visited twice if the surface is shared by 2 blocks.
+        visited.assign(numOfFace(), false);
+        auto assign_face = [&](const NMF::Block3D &b, size_t i, size_t j, size_t k, short f, size_t adj)
+        {
+            const auto faceIndex = b.face_index(i, j, k, f);
+            auto &curFace = *COMMON::at_unchecked(slot, faceIndex - 1);
+
+            if (visited[faceIndex - 1])
+            {
+                if (adj != 0 || curFace.c[1] != 0)
+                    throw std::runtime_error("Double-Sided face should not appear more than twice!");
+                curFace.c[1] = b.cell_index(i, j, k);
+            }
+            else
+            {
+                curFace.x = 4;
+                face_node(b, i, j, k, f, curFace.n);
+                curFace.c[0] = b.cell_index(i, j, k);
+                curFace.c[1] = adj;
+                visited[faceIndex - 1] = true;
+            }
+        };
 
-        /// Copy face info.
-        visited.resize(m_face.size(), false);
-        std::fill(visited.begin(), visited.end(), false);
         for (size_t n = 1; n <= NBLK; ++n)
         {
-            auto &b = nmf->block(n);
+            const auto &b = nmf.block(n);
 
             const size_t nI = b.IDIM();
             const size_t nJ = b.JDIM();
             const size_t nK = b.KDIM();
 
-            /// Internal I direction
             for (size_t k = 1; k < nK; ++k)
                 for (size_t j = 1; j < nJ; ++j)
-                    for (size_t i = 2; i < nI; ++i)
-                    {
-                        const auto &curCell = b.cell(i, j, k);
-                        const auto &adjCell = b.cell(i - 1, j, k);
-
-                        const auto faceIndex = curCell.FaceSeq(1);
-                        auto &curFace = face(faceIndex);
-
-                        curFace.atBdry = false;
-
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(1);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(8);
-                        curFace.includedNode(4) = curCell.NodeSeq(4);
-
-                        curFace.leftCell = adjCell.CellSeq();
-                        curFace.rightCell = curCell.CellSeq();
-
-                        visited[faceIndex - 1] = true;
-                    }
-
-            /// Internal J direction
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t i = 1; i < nI; ++i)
-                    for (size_t j = 2; j < nJ; ++j)
+                    for (size_t i = 1; i < nI; ++i)
                     {
-                        const auto &curCell = b.cell(i, j, k);
-                        const auto &adjCell = b.cell(i, j - 1, k);
-
-                        const auto faceIndex = curCell.FaceSeq(3);
-                        auto &curFace = face(faceIndex);
-
-                        curFace.atBdry = false;
-
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(6);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(1);
-                        curFace.includedNode(4) = curCell.NodeSeq(2);
-
-                        curFace.leftCell = adjCell.CellSeq();
-                        curFace.rightCell = curCell.CellSeq();
-
-                        visited[faceIndex - 1] = true;
+                        assign_face(b, i, j, k, 1, k > 1 ? b.cell_index(i, j, k - 1) : 0);
+                        assign_face(b, i, j, k, 3, i > 1 ? b.cell_index(i - 1, j, k) : 0);
+                        assign_face(b, i, j, k, 5, j > 1 ? b.cell_index(i, j - 1, k) : 0);
+                        if (k == nK - 1)
+                            assign_face(b, i, j, k, 2, 0);
+                        if (i == nI - 1)
+                            assign_face(b, i, j, k, 4, 0);
+                        if (j == nJ - 1)
+                            assign_face(b, i, j, k, 6, 0);
                     }
+        }
+        for (size_t i = 0; i < numOfFace(); ++i)
+            if (!visited[i])
+                throw std::runtime_error("Face " + std::to_string(i + 1) + " is not assigned.");
 
-            /// Internal k direction
-            for (size_t i = 1; i < nI; ++i)
-                for (size_t j = 1; j < nJ; ++j)
-                    for (size_t k = 2; k < nK; ++k)
-                    {
-                        const auto &curCell = b.cell(i, j, k);
-                        const auto &adjCell = b.cell(i, j, k - 1);
+        /// Zone specifications.
+        /// No need to show NODE zone.
+        add_entry(new COMMENT("Zone Sections"));
+        add_entry(new ZONE(2, "fluid", "FLUID"));
+        add_entry(new ZONE(3, "interior", "int_FLUID"));
+        for (size_t i = 0; i < patch_name.size(); ++i)
+        {
+            /// Set to "wall" by default.
+            /// Can be mapped according to NMF specification or assigned mannually in FLUENT.
+            add_entry(new ZONE(i + 4, "wall", patch_name[i]));
+        }
 
-                        const auto faceIndex = curCell.FaceSeq(5);
-                        auto &curFace = face(faceIndex);
+        /// Derived quantities.
+        derive_zone();
+        fout << "Converting into high-level representation ... ";
+        derive(ALL_DERIVED);
+        fout << "Done!" << std::endl;
+    }
 
-                        curFace.atBdry = false;
+    void MESH::glue(const std::string &f_nmf, const std::string &f_p3d, const std::string &f_msh, std::ostream &fout)
+    {
+        /// Load mapping file.
+        /// Only indices on block surfaces are stored when numbering.
+        NMF::Mapping3D nmf(f_nmf);
+        nmf.numbering(false);
 
-                        curFace.type = FACE::QUADRILATERAL;
+        glue(nmf, f_p3d, f_msh, fout);
+    }
 
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(4);
-                        curFace.includedNode(2) = curCell.NodeSeq(3);
-                        curFace.includedNode(3) = curCell.NodeSeq(2);
-                        curFace.includedNode(4) = curCell.NodeSeq(1);
+    void MESH::glue(const NMF::Mapping3D &nmf, const std::string &f_p3d, const std::string &f_msh, std::ostream &fout)
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::glue");
 
-                        curFace.leftCell = adjCell.CellSeq();
-                        curFace.rightCell = curCell.CellSeq();
+        /// Open grid file, blocks are loaded one by one.
+        PLOT3D::READER p3d(f_p3d);
 
-                        visited[faceIndex - 1] = true;
-                    }
+        /// Check consistency.
+        check_consistency(nmf, p3d);
+        const size_t NBLK = nmf.nBlock();
+
+        /// Counting.
+        const size_t totalNodeNum = nmf.nNode();
+        const size_t totalCellNum = nmf.nCell();
+        size_t totalFaceNum = 0, innerFaceNum = 0, bdryFaceNum = 0;
+        nmf.nFace(totalFaceNum, innerFaceNum, bdryFaceNum);
+
+        /// Nodes and faces inside blocks are numbered ahead of
+        /// the others, see "NMF::Mapping3D::numbering".
+        size_t interiorNodeNum = 0, blockInternalFaceNum = 0;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            interiorNodeNum += b.block_internal_node_num();
+            blockInternalFaceNum += b.face_num() - b.shell_face_num();
+        }
 
-            /// I-MIN
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t j = 1; j < nJ; ++j)
-                {
-                    const auto &curCell = b.cell(1, j, k);
-                    const auto faceIndex = curCell.FaceSeq(1);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(1);
+        /// Open target file.
+        std::ofstream out(f_msh);
+        if (out.fail())
+            throw std::runtime_error("Failed to open output grid file: " + f_msh);
+
+        HEADER("Block-Glue " + version_str()).repr(out);
+        DIMENSION(3).repr(out);
+        write_declaration(out, totalNodeNum, totalCellNum, totalFaceNum, true);
+
+        /// Nodal coordinates.
+        /// Block-interior nodes are written as each block is loaded,
+        /// while the others are kept until all blocks are visited.
+        fout << "Writing nodes ... ";
+        out << "(" << std::dec << SECTION::NODE;
+        out << " (" << std::hex << 1 << " " << 1 << " " << totalNodeNum << " ";
+        out << std::dec << NODE::ANY << " " << 3 << ")(" << std::endl;
+
+        std::vector<Vector> shellNode(totalNodeNum - interiorNodeNum);
+        std::vector<bool> visited(shellNode.size(), false);
+        size_t cnt = 0;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            auto g = p3d.next();
+            const auto &blk = *g;
 
-                    if (visited[faceIndex - 1])
+            for (size_t k = 1; k <= b.KDIM(); ++k)
+                for (size_t j = 1; j <= b.JDIM(); ++j)
+                    for (size_t i = 1; i <= b.IDIM(); ++i)
                     {
-                        if (!curFace.atBdry)
+                        const auto idx = b.node_index(i, j, k);
+                        if (idx > interiorNodeNum)
                         {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
+                            const auto loc_idx = idx - interiorNodeNum - 1;
+                            if (!visited[loc_idx])
+                            {
+                                shellNode[loc_idx] = blk(i, j, k);
+                                visited[loc_idx] = true;
+                            }
                         }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
                     }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.atBdry = !curSurf.neighbourSurf;
-
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(1);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(8);
-                        curFace.includedNode(4) = curCell.NodeSeq(4);
-
-                        /// On I-MIN Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
-
-                        visited[faceIndex - 1] = true;
-                    }
-                }
 
-            /// I-MAX
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t j = 1; j < nJ; ++j)
-                {
-                    const auto &curCell = b.cell(nI - 1, j, k);
-                    const auto faceIndex = curCell.FaceSeq(2);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(2);
+            /// Block-interior nodes in the order of (k, j, i).
+            const size_t nI = b.IDIM() - 2, nJ = b.JDIM() - 2;
+            write_nodes(out, b.block_internal_node_num(), [&b, &blk, nI, nJ, cnt](size_t r)
+            {
+                const size_t i = r % nI + 2, j = r / nI % nJ + 2, k = r / nI / nJ + 2;
+                if (b.node_index(i, j, k) != cnt + r + 1)
+                    throw std::runtime_error("Block-interior nodes are not numbered continuously.");
+                return blk(i, j, k);
+            });
+            cnt += b.block_internal_node_num();
+
+            delete g;
+        }
+        write_nodes(out, shellNode.size(), [&shellNode](size_t r)
+        {
+            return shellNode[r];
+        });
+        out << "))" << std::endl;
+        fout << "Done!" << std::endl;
 
-                    if (visited[faceIndex - 1])
+        /// Cell specifications
+        /// Here, only possible choice for cell is hex.
+        out << "(" << std::dec << SECTION::CELL << " (" << std::hex;
+        out << 2 << " " << 1 << " " << totalCellNum << " ";
+        out << CELL::FLUID << " " << CELL::HEXAHEDRAL << "))" << std::endl;
+
+        /// Faces on interfaces between blocks.
+        /// "c0" is the cell first visiting the face, in the same order as "MESH::MESH".
+        fout << "Writing faces ... ";
+        struct INTERFACE_FACE
+        {
+            size_t n[4];
+            size_t c[2];
+            size_t seq;
+        };
+        std::vector<INTERFACE_FACE> interfaceFace(innerFaceNum - blockInternalFaceNum);
+        for (auto &e : interfaceFace)
+            e.c[0] = e.c[1] = 0;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            for (short f = 1; f <= NMF::Block3D::NumOfSurf; ++f)
+            {
+                if (nmf.surface_interface_face_num(n, f) == 0)
+                    continue;
+
+                /// Surfaces split into patches have boundary faces as well.
+                size_t n_pri = 0, n_sec = 0, i = 0, j = 0, k = 0;
+                b.surface_size(f, n_pri, n_sec);
+                for (size_t sec = 1; sec < n_sec; ++sec)
+                    for (size_t pri = 1; pri < n_pri; ++pri)
                     {
-                        if (!curFace.atBdry)
+                        const size_t faceIndex = b.surface_face_index(f, pri, sec);
+                        if (faceIndex > innerFaceNum)
+                            continue;
+
+                        auto &e = COMMON::at_unchecked(interfaceFace, faceIndex - blockInternalFaceNum - 1);
+                        surface_cell(b, f, pri, sec, i, j, k);
+                        const size_t c = b.cell_index(i, j, k);
+                        const size_t seq = NMF::Block3D::NumOfSurf * c + FACE_VISIT_SEQ[f - 1];
+
+                        if (e.c[1] != 0)
+                            throw std::runtime_error("Double-Sided face should not appear more than twice!");
+                        else if (e.c[0] == 0 || seq < e.seq)
                         {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
+                            e.c[1] = e.c[0];
+                            e.c[0] = c;
+                            e.seq = seq;
+                            face_node(b, i, j, k, f, e.n);
                         }
                         else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
+                            e.c[1] = c;
                     }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
+            }
+        }
 
-                        curFace.atBdry = !curSurf.neighbourSurf;
+        /// Internal faces.
+        out << "(" << std::dec << SECTION::FACE << " (" << std::hex;
+        out << 3 << " " << 1 << " " << innerFaceNum << " ";
+        out << BC::INTERIOR << " " << FACE::QUADRILATERAL << ")(" << std::endl;
 
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(2);
-                        curFace.includedNode(2) = curCell.NodeSeq(3);
-                        curFace.includedNode(3) = curCell.NodeSeq(7);
-                        curFace.includedNode(4) = curCell.NodeSeq(6);
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
 
-                        /// On I-MAX Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
+            /// Num of cells in each direction.
+            const size_t mI = b.IDIM() - 1;
+            const size_t mJ = b.JDIM() - 1;
+            const size_t mK = b.KDIM() - 1;
 
-                        visited[faceIndex - 1] = true;
-                    }
-                }
+            /// Same order as "NMF::Mapping3D::numbering_face".
+            /// Each face is visited from the cell with larger index.
+            write_faces(out, (mK - 1) * mJ * mI, [&b, mI, mJ](size_t r, size_t *nd, size_t *c)
+            {
+                const size_t i = r % mI + 1, j = r / mI % mJ + 1, k = r / mI / mJ + 2;
+                face_node(b, i, j, k, 1, nd);
+                c[0] = b.cell_index(i, j, k);
+                c[1] = b.cell_index(i, j, k - 1);
+            });
 
-            /// J-MIN
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t i = 1; i < nI; ++i)
-                {
-                    const auto &curCell = b.cell(i, 1, k);
-                    const auto faceIndex = curCell.FaceSeq(3);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(3);
+            write_faces(out, (mI - 1) * mK * mJ, [&b, mJ, mK](size_t r, size_t *nd, size_t *c)
+            {
+                const size_t j = r % mJ + 1, k = r / mJ % mK + 1, i = r / mJ / mK + 2;
+                face_node(b, i, j, k, 3, nd);
+                c[0] = b.cell_index(i, j, k);
+                c[1] = b.cell_index(i - 1, j, k);
+            });
 
-                    if (visited[faceIndex - 1])
+            write_faces(out, (mJ - 1) * mI * mK, [&b, mK, mI](size_t r, size_t *nd, size_t *c)
+            {
+                const size_t k = r % mK + 1, i = r / mK % mI + 1, j = r / mK / mI + 2;
+                face_node(b, i, j, k, 5, nd);
+                c[0] = b.cell_index(i, j, k);
+                c[1] = b.cell_index(i, j - 1, k);
+            });
+        }
+        for (size_t i = 0; i < interfaceFace.size(); ++i)
+            if (interfaceFace[i].c[1] == 0)
+                throw std::runtime_error("Face " + std::to_string(blockInternalFaceNum + i + 1) + " is not assigned.");
+        write_faces(out, interfaceFace.size(), [&interfaceFace](size_t r, size_t *nd, size_t *c)
+        {
+            const auto &e = interfaceFace[r];
+            std::copy(e.n, e.n + 4, nd);
+            c[0] = e.c[0];
+            c[1] = e.c[1];
+        });
+        std::vector<INTERFACE_FACE>().swap(interfaceFace);
+        out << "))" << std::endl;
+
+        /// Boundary faces, each boundary surface forms a zone.
+        /// Surfaces split into patches have interface faces as well,
+        /// thus local indices of boundary faces are collected beforehand.
+        size_t patch_idx = 4;
+        cnt = innerFaceNum;
+        std::vector<std::string> patch_name;
+        std::vector<std::pair<size_t, size_t>> bdryFace;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            for (short f = 1; f <= NMF::Block3D::NumOfSurf; ++f)
+            {
+                const auto nBF = nmf.surface_boundary_face_num(n, f);
+                if (nBF == 0)
+                    continue;
+
+                out << "(" << std::dec << SECTION::FACE << " (" << std::hex;
+                out << patch_idx << " " << cnt + 1 << " " << cnt + nBF << " ";
+                out << BC::WALL << " " << FACE::QUADRILATERAL << ")(" << std::endl;
+
+                size_t n_pri = 0, n_sec = 0;
+                b.surface_size(f, n_pri, n_sec);
+                bdryFace.clear();
+                for (size_t sec = 1; sec < n_sec; ++sec)
+                    for (size_t pri = 1; pri < n_pri; ++pri)
                     {
-                        if (!curFace.atBdry)
-                        {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
-                        }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
+                        const size_t faceIndex = b.surface_face_index(f, pri, sec);
+                        if (faceIndex <= innerFaceNum)
+                            continue;
+                        if (faceIndex != ++cnt)
+                            throw std::runtime_error("Faces on boundary surface are not numbered continuously.");
+                        bdryFace.emplace_back(pri, sec);
                     }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
 
-                        curFace.atBdry = !curSurf.neighbourSurf;
+                write_faces(out, bdryFace.size(), [&b, f, &bdryFace](size_t r, size_t *nd, size_t *c)
+                {
+                    size_t i = 0, j = 0, k = 0;
+                    surface_cell(b, f, bdryFace[r].first, bdryFace[r].second, i, j, k);
+                    face_node(b, i, j, k, f, nd);
+                    c[0] = b.cell_index(i, j, k);
+                    c[1] = 0;
+                });
+                out << "))" << std::endl;
+
+                patch_name.push_back("B" + std::to_string(n) + "F" + std::to_string(f));
+                ++patch_idx;
+            }
+        }
+        if (cnt != totalFaceNum)
+            throw std::runtime_error("Inconsistent num of boundary faces.");
+        fout << "Done!" << std::endl;
 
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(6);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(1);
-                        curFace.includedNode(4) = curCell.NodeSeq(2);
+        /// Zone specifications.
+        /// No need to show NODE zone.
+        COMMENT("Zone Sections").repr(out);
+        ZONE(2, "fluid", "FLUID").repr(out);
+        ZONE(3, "interior", "int_FLUID").repr(out);
+        for (size_t i = 0; i < patch_name.size(); ++i)
+            ZONE(i + 4, "wall", patch_name[i]).repr(out);
+        TYDF_PROFILE_COUNT("glue.bytes_written", static_cast<long long>(out.tellp()));
+
+        /// Close target file.
+        out.close();
+    }
 
-                        /// On J-MIN Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
+#ifdef TYDF_USE_MPI
+    void MESH::glue(MPI_Comm comm, const std::string &f_nmf, const std::string &f_p3d, const std::string &f_msh, std::ostream &fout)
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::glue(MPI)");
+
+        int rank = 0, nRank = 1;
+        mpi_check(MPI_Comm_rank(comm, &rank), "MPI_Comm_rank");
+        mpi_check(MPI_Comm_size(comm, &nRank), "MPI_Comm_size");
+        const size_t P = static_cast<size_t>(nRank);
+        const bool master = rank == 0;
+
+        /// The mapping file is small, every rank holds the whole topology,
+        /// thus the global numbering is the same as the serial one.
+        NMF::Mapping3D nmf(f_nmf);
+        const size_t NBLK = nmf.nBlock();
+
+        /// Blocks are distributed in contiguous ranges balanced by cells,
+        /// so that each section is written by ranks in ascending order.
+        std::vector<size_t> owner(NBLK + 1, 0);
+        std::vector<bool> local(NBLK + 1, false);
+        {
+            const size_t NC = nmf.nCell();
+            size_t acc = 0;
+            for (size_t n = 1; n <= NBLK; ++n)
+            {
+                const size_t nc = nmf.block(n).cell_num();
+                owner[n] = std::min(P - 1, (acc + nc / 2) * P / std::max<size_t>(NC, 1));
+                local[n] = owner[n] == static_cast<size_t>(rank);
+                acc += nc;
+            }
+        }
 
-                        visited[faceIndex - 1] = true;
-                    }
-                }
+        /// Indices on block surfaces are stored for local blocks only.
+        nmf.numbering(false, std::vector<bool>(local.begin() + 1, local.end()));
 
-            /// J-MAX
-            for (size_t k = 1; k < nK; ++k)
-                for (size_t i = 1; i < nI; ++i)
-                {
-                    const auto &curCell = b.cell(i, nJ - 1, k);
-                    const auto faceIndex = curCell.FaceSeq(4);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(4);
+        /// Open grid file, local blocks are loaded one by one.
+        PLOT3D::READER p3d(f_p3d);
+        check_consistency(nmf, p3d);
 
-                    if (visited[faceIndex - 1])
+        /// Counting.
+        const size_t totalNodeNum = nmf.nNode();
+        const size_t totalCellNum = nmf.nCell();
+        size_t totalFaceNum = 0, innerFaceNum = 0, bdryFaceNum = 0;
+        nmf.nFace(totalFaceNum, innerFaceNum, bdryFaceNum);
+        size_t interiorNodeNum = 0, blockInternalFaceNum = 0;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            interiorNodeNum += b.block_internal_node_num();
+            blockInternalFaceNum += b.face_num() - b.shell_face_num();
+        }
+        const size_t shellNodeNum = totalNodeNum - interiorNodeNum;
+        const size_t interfaceFaceNum = innerFaceNum - blockInternalFaceNum;
+
+        /// Shell nodes and interface faces are gathered on the rank
+        /// owning the range of indices they belong to.
+        const size_t nodeChunk = std::max<size_t>(1, (shellNodeNum + P - 1) / P);
+        const size_t faceChunk = std::max<size_t>(1, (interfaceFaceNum + P - 1) / P);
+        const size_t nodeFirst = std::min(rank * nodeChunk, shellNodeNum);
+        const size_t nodeLast = std::min(nodeFirst + nodeChunk, shellNodeNum);
+        const size_t faceFirst = std::min(rank * faceChunk, interfaceFaceNum);
+        const size_t faceLast = std::min(faceFirst + faceChunk, interfaceFaceNum);
+
+        /// Open target file, truncated in case it exists.
+        MPI_File fh;
+        mpi_check(MPI_File_open(comm, f_msh.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh), "MPI_File_open");
+        mpi_check(MPI_File_set_size(fh, 0), "MPI_File_set_size");
+        MPI_Offset pos = 0;
+
+        std::ostringstream out;
+        if (master)
+        {
+            HEADER("Block-Glue " + version_str()).repr(out);
+            DIMENSION(3).repr(out);
+            write_declaration(out, totalNodeNum, totalCellNum, totalFaceNum, true);
+            out << "(" << std::dec << SECTION::NODE;
+            out << " (" << std::hex << 1 << " " << 1 << " " << totalNodeNum << " ";
+            out << std::dec << NODE::ANY << " " << 3 << ")(" << std::endl;
+        }
+        pos = write_ordered(fh, comm, pos, out.str());
+
+        /// Nodal coordinates.
+        /// Shared nodes take coordinates from the first visit in the serial
+        /// order, i.e. the smallest (block, linear index within block).
+        if (master)
+            fout << "Writing nodes ... ";
+        struct SHELL_NODE
+        {
+            size_t idx;
+            size_t blk;
+            size_t seq;
+            double x[3];
+        };
+        std::vector<std::vector<SHELL_NODE>> nodeToSend(P);
+        out.str("");
+        size_t cnt = 0;
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            const auto &b = nmf.block(n);
+            if (!local[n])
+            {
+                if (!p3d.skip())
+                    throw std::runtime_error("Failed to pass over Block " + std::to_string(n) + " in grid file.");
+                cnt += b.block_internal_node_num();
+                continue;
+            }
+
+            auto g = p3d.next();
+            size_t seq = 0;
+            for (size_t k = 1; k <= b.KDIM(); ++k)
+                for (size_t j = 1; j <= b.JDIM(); ++j)
+                    for (size_t i = 1; i <= b.IDIM(); ++i, ++seq)
                     {
-                        if (!curFace.atBdry)
+                        const auto idx = b.node_index(i, j, k);
+                        const auto &p = (*g)(i, j, k);
+                        if (idx > interiorNodeNum)
                         {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
+                            const auto loc_idx = idx - interiorNodeNum - 1;
+                            nodeToSend[loc_idx / nodeChunk].push_back({ loc_idx, n, seq, { p.x(), p.y(), p.z() } });
                         }
+                        else if (idx == ++cnt)
+                            write_node(out, p);
                         else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
+                            throw std::runtime_error("Block-interior nodes are not numbered continuously.");
                     }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
 
-                        curFace.atBdry = !curSurf.neighbourSurf;
+            delete g;
+        }
+        pos = write_ordered(fh, comm, pos, out.str());
 
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(3);
-                        curFace.includedNode(2) = curCell.NodeSeq(4);
-                        curFace.includedNode(3) = curCell.NodeSeq(8);
-                        curFace.includedNode(4) = curCell.NodeSeq(7);
+        {
+            const auto rcv = all_to_all(comm, nodeToSend);
+            std::vector<std::vector<SHELL_NODE>>().swap(nodeToSend);
 
-                        /// On J-MAX Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
+            std::vector<const SHELL_NODE *> shellNode(nodeLast - nodeFirst, nullptr);
+            for (const auto &e : rcv)
+            {
+                auto &cur = shellNode.at(e.idx - nodeFirst);
+                if (cur == nullptr || e.blk < cur->blk || (e.blk == cur->blk && e.seq < cur->seq))
+                    cur = &e;
+            }
 
-                        visited[faceIndex - 1] = true;
-                    }
-                }
+            out.str("");
+            for (size_t i = 0; i < shellNode.size(); ++i)
+            {
+                if (shellNode[i] == nullptr)
+                    throw std::runtime_error("Node " + std::to_string(interiorNodeNum + nodeFirst + i + 1) + " is not assigned.");
+                const auto &x = shellNode[i]->x;
+                write_node(out, Vector(x[0], x[1], x[2]));
+            }
+            pos = write_ordered(fh, comm, pos, out.str());
+        }
+        if (master)
+            fout << "Done!" << std::endl;
 
-            /// K-MIN
-            for (size_t i = 1; i < nI; ++i)
-                for (size_t j = 1; j < nJ; ++j)
-                {
-                    const auto &curCell = b.cell(i, j, 1);
-                    const auto faceIndex = curCell.FaceSeq(5);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(5);
+        /// Cell specifications and the header of internal faces.
+        out.str("");
+        if (master)
+        {
+            out << "))" << std::endl;
+            out << "(" << std::dec << SECTION::CELL << " (" << std::hex;
+            out << 2 << " " << 1 << " " << totalCellNum << " ";
+            out << CELL::FLUID << " " << CELL::HEXAHEDRAL << "))" << std::endl;
+            out << "(" << std::dec << SECTION::FACE << " (" << std::hex;
+            out << 3 << " " << 1 << " " << innerFaceNum << " ";
+            out << BC::INTERIOR << " " << FACE::QUADRILATERAL << ")(" << std::endl;
+        }
+        pos = write_ordered(fh, comm, pos, out.str());
+
+        /// Faces inside local blocks.
+        if (master)
+            fout << "Writing faces ... ";
+        out.str("");
+        out << std::hex;
+        size_t nd[4];
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            if (!local[n])
+                continue;
+
+            const auto &b = nmf.block(n);
+            const size_t nI = b.IDIM();
+            const size_t nJ = b.JDIM();
+            const size_t nK = b.KDIM();
 
-                    if (visited[faceIndex - 1])
+            /// Same order as "NMF::Mapping3D::numbering_face".
+            for (size_t k = 2; k < nK; ++k)
+                for (size_t j = 1; j < nJ; ++j)
+                    for (size_t i = 1; i < nI; ++i)
                     {
-                        if (!curFace.atBdry)
-                        {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
-                        }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
+                        face_node(b, i, j, k, 1, nd);
+                        write_face(out, nd, b.cell_index(i, j, k), b.cell_index(i, j, k - 1));
                     }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.atBdry = !curSurf.neighbourSurf;
-
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(4);
-                        curFace.includedNode(2) = curCell.NodeSeq(3);
-                        curFace.includedNode(3) = curCell.NodeSeq(2);
-                        curFace.includedNode(4) = curCell.NodeSeq(1);
-
-                        /// On K-MIN Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
 
-                        visited[faceIndex - 1] = true;
+            for (size_t i = 2; i < nI; ++i)
+                for (size_t k = 1; k < nK; ++k)
+                    for (size_t j = 1; j < nJ; ++j)
+                    {
+                        face_node(b, i, j, k, 3, nd);
+                        write_face(out, nd, b.cell_index(i, j, k), b.cell_index(i - 1, j, k));
                     }
-                }
-
-            /// K-MAX
-            for (size_t i = 1; i < nI; ++i)
-                for (size_t j = 1; j < nJ; ++j)
-                {
-                    const auto &curCell = b.cell(i, j, nK - 1);
-                    const auto faceIndex = curCell.FaceSeq(6);
-                    auto &curFace = face(faceIndex);
-                    const auto &curSurf = b.surf(6);
 
-                    if (visited[faceIndex - 1])
+            for (size_t j = 2; j < nJ; ++j)
+                for (size_t i = 1; i < nI; ++i)
+                    for (size_t k = 1; k < nK; ++k)
                     {
-                        if (!curFace.atBdry)
-                        {
-                            /// Second-Round of Double-Sided Case
-                            /// Update undetermined cell index.
-                            if (curFace.leftCell == 0)
-                                curFace.leftCell = curCell.CellSeq();
-                            else if (curFace.rightCell == 0)
-                                curFace.rightCell = curCell.CellSeq();
-                            else
-                                throw std::runtime_error("Double-Sided face should not appear more than twice!");
-                        }
-                        else
-                            throw std::runtime_error("Boundary face shouldn't appear twice!");
+                        face_node(b, i, j, k, 5, nd);
+                        write_face(out, nd, b.cell_index(i, j, k), b.cell_index(i, j - 1, k));
                     }
-                    else
-                    {
-                        curFace.type = FACE::QUADRILATERAL;
-
-                        curFace.atBdry = !curSurf.neighbourSurf;
+        }
+        pos = write_ordered(fh, comm, pos, out.str());
 
-                        curFace.includedNode.resize(4);
-                        curFace.includedNode(1) = curCell.NodeSeq(8);
-                        curFace.includedNode(2) = curCell.NodeSeq(5);
-                        curFace.includedNode(3) = curCell.NodeSeq(6);
-                        curFace.includedNode(4) = curCell.NodeSeq(7);
+        /// Faces on interfaces between blocks, each one is visited from
+        /// exactly 2 sides, "c0" is decided the same way as the serial version.
+        struct INTERFACE_FACE
+        {
+            size_t idx;
+            size_t seq;
+            size_t n[4];
+            size_t c;
+        };
+        std::vector<std::vector<INTERFACE_FACE>> faceToSend(P);
+        for (size_t n = 1; n <= NBLK; ++n)
+        {
+            if (!local[n])
+                continue;
 
-                        /// On K-MAX Surface, if current face is Single-Sided,
-                        /// then index of left cell is set to 0 according to
-                        /// right-hand convention; If current face is Double-Sided,
-                        /// it is also set to 0 at this stage, and will be
-                        /// updated further by loops of other blocks.
-                        curFace.leftCell = 0;
-                        curFace.rightCell = curCell.CellSeq();
+            const auto &b = nmf.block(n);
+            for (short f = 1; f <= NMF::Block3D::NumOfSurf; ++f)
+            {
+                if (nmf.surface_interface_face_num(n, f) == 0)
+                    continue;
 
-                        visited[faceIndex - 1] = true;
+                size_t n_pri = 0, n_sec = 0, i = 0, j = 0, k = 0;
+                b.surface_size(f, n_pri, n_sec);
+                for (size_t sec = 1; sec < n_sec; ++sec)
+                    for (size_t pri = 1; pri < n_pri; ++pri)
+                    {
+                        const size_t faceIndex = b.surface_face_index(f, pri, sec);
+                        if (faceIndex > innerFaceNum)
+                            continue;
+
+                        INTERFACE_FACE e;
+                        e.idx = faceIndex - blockInternalFaceNum - 1;
+                        surface_cell(b, f, pri, sec, i, j, k);
+                        e.c = b.cell_index(i, j, k);
+                        e.seq = NMF::Block3D::NumOfSurf * e.c + FACE_VISIT_SEQ[f - 1];
+                        face_node(b, i, j, k, f, e.n);
+                        faceToSend[e.idx / faceChunk].push_back(e);
                     }
-                }
+            }
         }
 
-        /// Assign ZONE info.
-        /// Here, only possible choice for cell is hex;
-        /// only possible choice for face is quad.
-        /// Index assignment convention:
-        ///   1 : Nodal coordinates.
-        ///   2 : Cell specification.
-        ///   3 : Internal faces.
-        ///   4 - N : Boundary faces. 
-
-        /// Count total zones.
-        m_totalZoneNum = 0;
-        for (size_t i = 1; i <= NBLK; ++i)
         {
-            const auto &b = nmf->block(i);
-            for (short j = 1; j <= NMF::Block3D::NumOfSurf; ++j)
+            const auto rcv = all_to_all(comm, faceToSend);
+            std::vector<std::vector<INTERFACE_FACE>>().swap(faceToSend);
+
+            std::vector<std::array<const INTERFACE_FACE *, 2>> interfaceFace(faceLast - faceFirst, { nullptr, nullptr });
+            for (const auto &e : rcv)
             {
-                const auto &s = b.surf(j);
-                if (s.neighbourSurf == nullptr)
-                    ++m_totalZoneNum;
+                auto &cur = interfaceFace.at(e.idx - faceFirst);
+                if (cur[1] != nullptr)
+                    throw std::runtime_error("Double-Sided face should not appear more than twice!");
+                else if (cur[0] == nullptr)
+                    cur[0] = &e;
+                else if (e.seq < cur[0]->seq)
+                {
+                    cur[1] = cur[0];
+                    cur[0] = &e;
+                }
+                else
+                    cur[1] = &e;
             }
-        }
-        m_totalZoneNum += 3;
-
-        /// Allocate storage.
-        m_zone.resize(m_totalZoneNum);
 
-        /// Assign default index.
-        for (size_t i = 1; i <= m_totalZoneNum; ++i)
-        {
-            auto &z = zone(i);
-            z.ID = i;
-            z.obj = nullptr;
+            out.str("");
+            for (size_t i = 0; i < interfaceFace.size(); ++i)
+            {
+                const auto &e = interfaceFace[i];
+                if (e[1] == nullptr)
+                    throw std::runtime_error("Face " + std::to_string(blockInternalFaceNum + faceFirst + i + 1) + " is not assigned.");
+                write_face(out, e[0]->n, e[0]->c, e[1]->c);
+            }
+            if (rank == nRank - 1)
+                out << "))" << std::endl;
+            pos = write_ordered(fh, comm, pos, out.str());
         }
 
-        /// ZONE-1
-        auto &zone1 = zone(1);
-        zone1.type = "";
-        zone1.name = "NODE";
-
-        /// ZONE-2
-        auto &zone2 = zone(2);
-        zone2.type = "fluid";
-        zone2.name = "FLUID";
-
-        /// ZONE-3
-        auto &zone3 = zone(3);
-        zone3.type = "interior";
-        zone3.name = "int_FLUID";
-
-        /// ZONE-4 and later
+        /// Boundary faces, each boundary surface forms a zone.
+        /// Zone and face indices of non-local blocks are counted from the topology.
         size_t patch_idx = 4;
-        for (size_t i = 1; i <= NBLK; ++i)
+        cnt = innerFaceNum;
+        std::vector<std::string> patch_name;
+        out.str("");
+        for (size_t n = 1; n <= NBLK; ++n)
         {
-            const auto &b = nmf->block(i);
-            for (short j = 1; j <= NMF::Block3D::NumOfSurf; ++j)
+            const auto &b = nmf.block(n);
+            for (short f = 1; f <= NMF::Block3D::NumOfSurf; ++f)
             {
-                const auto &s = b.surf(j);
-                if (s.neighbourSurf == nullptr)
+                const auto nBF = nmf.surface_boundary_face_num(n, f);
+                if (nBF == 0)
+                    continue;
+
+                patch_name.push_back("B" + std::to_string(n) + "F" + std::to_string(f));
+                if (!local[n])
                 {
-                    auto &z = zone(patch_idx);
+                    cnt += nBF;
                     ++patch_idx;
+                    continue;
+                }
 
-                    /// Set to "wall" by default.
-                    /// Can be mapped according to NMF specification or assigned mannually in FLUENT.
-                    z.type = "wall";
+                out << "(" << std::dec << SECTION::FACE << " (" << std::hex;
+                out << patch_idx << " " << cnt + 1 << " " << cnt + nBF << " ";
+                out << BC::WALL << " " << FACE::QUADRILATERAL << ")(" << std::endl;
 
-                    z.name = "B" + std::to_string(i) + "F" + std::to_string(j);
-                }
+                size_t n_pri = 0, n_sec = 0, i = 0, j = 0, k = 0;
+                b.surface_size(f, n_pri, n_sec);
+                for (size_t sec = 1; sec < n_sec; ++sec)
+                    for (size_t pri = 1; pri < n_pri; ++pri)
+                    {
+                        const size_t faceIndex = b.surface_face_index(f, pri, sec);
+                        if (faceIndex <= innerFaceNum)
+                            continue;
+                        if (faceIndex != ++cnt)
+                            throw std::runtime_error("Faces on boundary surface are not numbered continuously.");
+
+                        surface_cell(b, f, pri, sec, i, j, k);
+                        face_node(b, i, j, k, f, nd);
+                        write_face(out, nd, b.cell_index(i, j, k), 0);
+                    }
+                out << "))" << std::endl;
+                ++patch_idx;
             }
         }
+        if (cnt != totalFaceNum)
+            throw std::runtime_error("Inconsistent num of boundary faces.");
+        pos = write_ordered(fh, comm, pos, out.str());
+        if (master)
+            fout << "Done!" << std::endl;
 
-        /// Convert to primary form.
-        clear_entry();
-
-        add_entry(new HEADER("Block-Glue " + version_str()));
-        add_entry(new DIMENSION(3));
-
-        /// Nodal coordinates
-        auto part1 = new NODE(1, 1, numOfNode(), NODE::ANY, 3);
-        for (size_t i = 0; i < numOfNode(); ++i)
-            part1->at(i) = node(i + 1).coordinate;
-        zone(1).obj = part1;
-        add_entry(part1);
-
-        /// Cell specifications
-        auto part2 = new CELL(2, 1, numOfCell(), CELL::FLUID, CELL::HEXAHEDRAL);
-        zone(2).obj = part2;
-        add_entry(part2);
-
-        /// Internal faces connectivity
-        size_t face_pos_L = 1;
-        size_t face_pos_R = face_pos_L + innerFaceNum - 1;
-        auto part3 = new FACE(3, face_pos_L, face_pos_R, BC::INTERIOR, FACE::QUADRILATERAL);
-        for (size_t i = 0; i < innerFaceNum; ++i)
+        /// Zone specifications.
+        out.str("");
+        if (master)
         {
-            auto &raw_f = part3->at(i);
-            const auto &derived_f = face(i + 1);
+            COMMENT("Zone Sections").repr(out);
+            ZONE(2, "fluid", "FLUID").repr(out);
+            ZONE(3, "interior", "int_FLUID").repr(out);
+            for (size_t i = 0; i < patch_name.size(); ++i)
+                ZONE(i + 4, "wall", patch_name[i]).repr(out);
+        }
+        pos = write_ordered(fh, comm, pos, out.str());
+        TYDF_PROFILE_COUNT("glue.bytes_written", static_cast<long long>(pos));
 
-            raw_f.x = 4;
+        /// Close target file.
+        mpi_check(MPI_File_close(&fh), "MPI_File_close");
+    }
+#endif
 
-            raw_f.n[0] = derived_f.includedNode.at(0);
-            raw_f.n[1] = derived_f.includedNode.at(1);
-            raw_f.n[2] = derived_f.includedNode.at(2);
-            raw_f.n[3] = derived_f.includedNode.at(3);
+    void MESH::update_node(const NMF::Mapping3D &nmf, const std::string &f_p3d)
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::update_node");
 
-            raw_f.c[0] = derived_f.rightCell;
-            raw_f.c[1] = derived_f.leftCell;
-        }
-        zone(3).obj = part3;
-        add_entry(part3);
+        /// Open grid file, blocks are loaded one by one.
+        PLOT3D::READER p3d(f_p3d);
 
-        /// Boundary faces connectivity
-        patch_idx = 4;
-        for (size_t i = 1; i <= NBLK; ++i)
+        /// Check consistency.
+        check_consistency(nmf, p3d);
+        if (nmf.nNode() != numOfNode())
+            throw std::invalid_argument("Inconsistent num of nodes between NMF and MESH.");
+        if (m_renumbered)
+            throw std::runtime_error("Nodes of a renumbered mesh are not in the order of NMF.");
+
+        std::vector<NODE*> nodeSect;
+        for (auto curPtr : m_content)
         {
-            const auto &b = nmf->block(i);
-            for (short j = 1; j <= NMF::Block3D::NumOfSurf; ++j)
+            if (curPtr->identity() == SECTION::NODE)
             {
-                const auto &s = b.surf(j);
-                if (s.neighbourSurf == nullptr)
-                {
-                    const size_t cfn = b.surface_face_num(j);
-
-                    face_pos_L = face_pos_R + 1;
-                    face_pos_R = face_pos_L + cfn - 1;
-
-                    auto part_bfi = new FACE(patch_idx, face_pos_L, face_pos_R, BC::WALL, FACE::QUADRILATERAL);
-                    for (size_t k = 0; k < cfn; ++k)
-                    {
-                        auto &raw_f = part_bfi->at(k);
-                        const auto &derived_f = face(k + face_pos_L);
-
-                        raw_f.x = 4;
-
-                        raw_f.n[0] = derived_f.includedNode.at(0);
-                        raw_f.n[1] = derived_f.includedNode.at(1);
-                        raw_f.n[2] = derived_f.includedNode.at(2);
-                        raw_f.n[3] = derived_f.includedNode.at(3);
-
-                        raw_f.c[0] = derived_f.rightCell;
-                        raw_f.c[1] = derived_f.leftCell;
-                    }
-
-                    zone(patch_idx).obj = part_bfi;
-                    ++patch_idx;
-                    add_entry(part_bfi);
-                }
+                auto curObj = dynamic_cast<NODE*>(curPtr);
+                if (curObj == nullptr)
+                    throw std::runtime_error("Internal error: NODE section can not be identified.");
+                nodeSect.push_back(curObj);
             }
         }
+        auto node_entry = [&nodeSect](size_t idx) -> Vector &
+        {
+            for (auto e : nodeSect)
+                if (e->first_index() <= idx && idx <= e->last_index())
+                    return e->at(idx - e->first_index());
+            throw std::runtime_error("Node " + std::to_string(idx) + " is not included in any NODE section.");
+        };
+
+        /// Nodal coordinates are taken from sections directly if not set up yet.
+        const bool primary = (m_derived.load() & PRIMARY) != 0;
+
+        /// Shared nodes take coordinates from the first block, as "MESH::MESH" does.
+        std::vector<bool> visited(numOfNode(), false);
+        for (size_t n = 1; n <= nmf.nBlock(); ++n)
+        {
+            const auto &b = nmf.block(n);
+            auto g = p3d.next();
 
-        /// Zone mapping relations.
-        /// Here storage index is consistent with real index.
-        m_zoneMapping.clear();
-        for (size_t i = 1; i <= numOfZone(); ++i)
-            m_zoneMapping.emplace(i, i);
+            for (size_t k = 1; k <= b.KDIM(); ++k)
+                for (size_t j = 1; j <= b.JDIM(); ++j)
+                    for (size_t i = 1; i <= b.IDIM(); ++i)
+                    {
+                        const auto idx = b.node_index(i, j, k);
+                        if (!visited[idx - 1])
+                        {
+                            const auto &p = (*g)(i, j, k);
+                            node_entry(idx) = p;
+                            if (primary)
+                                m_nodeCoordinate.set(idx - 1, p);
+                            visited[idx - 1] = true;
+                        }
+                    }
 
-        /// Zone specifications.
-        /// No need to show NODE zone.
-        add_entry(new COMMENT("Zone Sections"));
-        for (size_t i = 2; i <= numOfZone(); ++i)
-        {
-            const auto &derived_z = zone(i);
-            auto raw_z = new ZONE(i, derived_z.type, derived_z.name);
-            add_entry(raw_z);
+            delete g;
         }
 
-        /// Finalize.
-        delete nmf;
-        delete p3d;
+        /// Geometric features computed before are re-computed, others are left on demand.
+        static const int Geometry = FACE_GEOMETRY | CELL_GEOMETRY;
+        const int features = derived() & Geometry;
+        m_derived.fetch_and(~Geometry);
+        derive(features);
     }
 }
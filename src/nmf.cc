@@ -1,8 +1,6 @@
 #include <iostream>
 #include <set>
-#include <map>
-#include <queue>
-#include <stack>
+#include <charconv>
 #include "../inc/nmf.h"
 
 static bool isWhite(char c)
@@ -10,26 +8,106 @@ static bool isWhite(char c)
     return c == '\n' || c == ' ' || c == '\t';
 }
 
-static bool isBlankLine(const std::string &s)
+/// Same as "\\s" in regular expressions.
+static bool isSpace(char c)
 {
-    for (const auto &e : s)
-        if (!isWhite(e))
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool isBlankLine(const char *first, const char *last)
+{
+    for (; first != last; ++first)
+        if (!isWhite(*first))
             return false;
     return true;
 }
 
-static bool checkStarting(const std::string &s, char c)
+static bool checkStarting(const char *first, const char *last, char c)
 {
-    for (const auto &e : s)
+    for (; first != last; ++first)
     {
-        if (isWhite(e))
+        if (isWhite(*first))
             continue;
         else
-            return e == c;
+            return *first == c;
     }
     return false;
 }
 
+/// Extract the next line from [p, end) like "std::getline", "p" is advanced past the line break.
+static bool getLine(const char *&p, const char *end, const char *&first, const char *&last)
+{
+    if (p == end)
+        return false;
+
+    first = p;
+    while (p != end && *p != '\n')
+        ++p;
+    last = p;
+    if (p != end)
+        ++p;
+    return true;
+}
+
+/// Match [first, last) against "\\s*(\\d+)(\\s+(\\d+)){n-1}\\s*", digits of each integer go to "dst".
+static bool matchIntegers(const char *first, const char *last, size_t n, std::string *dst)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        const char *p = first;
+        while (first != last && isSpace(*first))
+            ++first;
+        if (i > 0 && p == first)
+            return false;
+
+        p = first;
+        while (first != last && isDigit(*first))
+            ++first;
+        if (p == first)
+            return false;
+        dst[i].assign(p, first);
+    }
+
+    while (first != last && isSpace(*first))
+        ++first;
+    return first == last;
+}
+
+/// Next whitespace-separated token from [p, end), empty if exhausted.
+static std::string nextToken(const char *&p, const char *end)
+{
+    while (p != end && isSpace(*p))
+        ++p;
+    const char *q = p;
+    while (p != end && !isSpace(*p))
+        ++p;
+    return std::string(q, p);
+}
+
+/// Next whitespace-separated integer from [p, end), 0 if exhausted or invalid.
+template<typename T>
+static T nextInteger(const char *&p, const char *end)
+{
+    while (p != end && isSpace(*p))
+        ++p;
+    if (p != end && *p == '+')
+        ++p;
+
+    T ret = 0;
+    const char *q = p;
+    while (p != end && !isSpace(*p))
+        ++p;
+    const auto res = std::from_chars(q, p, ret);
+    if (res.ec != std::errc() || res.ptr != p)
+        ret = 0;
+    return ret;
+}
+
 static void distribute_index(size_t s, size_t e, std::vector<size_t> &dst)
 {
     if (s > e)
@@ -144,22 +222,22 @@ namespace GridTool::NMF
 
     size_t QUAD_CELL::NodeSeq(size_t n) const
     {
-        return m_node.at(n - 1);
+        return COMMON::at_unchecked(m_node, n - 1);
     }
 
     size_t &QUAD_CELL::NodeSeq(size_t n)
     {
-        return m_node.at(n - 1);
+        return COMMON::at_unchecked(m_node, n - 1);
     }
 
     size_t QUAD_CELL::FaceSeq(size_t n) const
     {
-        return m_face.at(n - 1);
+        return COMMON::at_unchecked(m_face, n - 1);
     }
 
     size_t &QUAD_CELL::FaceSeq(size_t n)
     {
-        return m_face.at(n - 1);
+        return COMMON::at_unchecked(m_face, n - 1);
     }
 
     HEX_CELL::HEX_CELL(size_t idx) :
@@ -172,22 +250,22 @@ namespace GridTool::NMF
 
     size_t HEX_CELL::NodeSeq(size_t n) const
     {
-        return m_node.at(n - 1);
+        return COMMON::at_unchecked(m_node, n - 1);
     }
 
     size_t &HEX_CELL::NodeSeq(size_t n)
     {
-        return m_node.at(n - 1);
+        return COMMON::at_unchecked(m_node, n - 1);
     }
 
     size_t HEX_CELL::FaceSeq(size_t n) const
     {
-        return m_face.at(n - 1);
+        return COMMON::at_unchecked(m_face, n - 1);
     }
 
     size_t &HEX_CELL::FaceSeq(size_t n)
     {
-        return m_face.at(n - 1);
+        return COMMON::at_unchecked(m_face, n - 1);
     }
 
     BLOCK::BLOCK(size_t nI, size_t nJ) :
@@ -275,7 +353,7 @@ namespace GridTool::NMF
 
     Block2D::Block2D(int nI, int nJ) :
         BLOCK(nI, nJ),
-        m_cell(cell_num(), nullptr),
+        m_cell(),
         m_vertex(NumOfVertex),
         m_frame(NumOfFrame)
     {
@@ -288,16 +366,11 @@ namespace GridTool::NMF
 
     Block2D::Block2D(const Block2D &rhs) :
         BLOCK(rhs.IDIM(), rhs.JDIM()),
-        m_cell(rhs.m_cell.size(), nullptr),
+        m_cell(rhs.m_cell),
         m_frame(rhs.m_frame),
         m_vertex(rhs.m_vertex)
     {
-        for (size_t i = 0; i < m_cell.size(); ++i)
-        {
-            auto p = rhs.m_cell[i];
-            if (p)
-                m_cell[i] = new QUAD_CELL(*p);
-        }
+        /// Empty body.
     }
 
     Block2D::~Block2D()
@@ -307,29 +380,19 @@ namespace GridTool::NMF
 
     void Block2D::release_cell_storage()
     {
-        for (auto &c : m_cell)
-            if (c != nullptr)
-            {
-                delete c;
-                c = nullptr;
-            }
+        Array1D<QUAD_CELL>().swap(m_cell);
     }
 
     void Block2D::allocate_cell_storage()
     {
-        for (auto &c : m_cell)
-        {
-            c = new QUAD_CELL();
-            if (!c)
-                throw std::bad_alloc();
-        }
+        m_cell.assign(cell_num(), QUAD_CELL());
     }
 
     const QUAD_CELL &Block2D::cell(size_t i, size_t j) const
     {
         const size_t i0 = i - 1, j0 = j - 1; /// Convert 1-based index to 0-based
         const size_t idx = i0 + (IDIM() - 1) * j0;
-        return *m_cell.at(idx);
+        return COMMON::at_unchecked(m_cell, idx);
     }
 
 
@@ -337,7 +400,7 @@ namespace GridTool::NMF
     {
         const size_t i0 = i - 1, j0 = j - 1; /// Convert 1-based index to 0-based
         const size_t idx = i0 + (IDIM() - 1) * j0;
-        return *m_cell.at(idx);
+        return COMMON::at_unchecked(m_cell, idx);
     }
 
     const Block2D::FRAME &Block2D::frame(short n) const
@@ -432,10 +495,15 @@ namespace GridTool::NMF
 
     Block3D::Block3D(int nI, int nJ, int nK) :
         BLOCK(nI, nJ, nK),
-        m_cell(cell_num(), nullptr),
+        m_cell(),
         m_vertex(NumOfVertex),
         m_frame(NumOfFrame),
-        m_surf(NumOfSurf)
+        m_surf(NumOfSurf),
+        m_surfNode(NumOfSurf),
+        m_surfFace(NumOfSurf),
+        m_nodeOffset(0),
+        m_faceOffset(0),
+        m_cellOffset(0)
     {
         setup_dependence();
         establish_connections();
@@ -443,10 +511,15 @@ namespace GridTool::NMF
 
     Block3D::Block3D(const Block3D &rhs) :
         BLOCK(rhs.IDIM(), rhs.JDIM(), rhs.KDIM()), // Only copy dimensions
-        m_cell(cell_num(), nullptr),
+        m_cell(),
         m_vertex(NumOfVertex),
         m_frame(NumOfFrame),
-        m_surf(NumOfSurf)
+        m_surf(NumOfSurf),
+        m_surfNode(NumOfSurf),
+        m_surfFace(NumOfSurf),
+        m_nodeOffset(0),
+        m_faceOffset(0),
+        m_cellOffset(0)
     {
         setup_dependence();
         establish_connections();
@@ -459,36 +532,27 @@ namespace GridTool::NMF
 
     void Block3D::release_cell_storage()
     {
-        for (auto &c : m_cell)
-            if (c != nullptr)
-            {
-                delete c;
-                c = nullptr;
-            }
+        Array1D<HEX_CELL>().swap(m_cell);
     }
 
     void Block3D::allocate_cell_storage()
     {
-        for (auto &c : m_cell)
-        {
-            c = new HEX_CELL();
-            if (!c)
-                throw std::bad_alloc();
-        }
+        TYDF_PROFILE_COUNT("nmf.alloc_bytes", cell_num() * sizeof(HEX_CELL));
+        m_cell.assign(cell_num(), HEX_CELL());
     }
 
     HEX_CELL &Block3D::cell(size_t i, size_t j, size_t k)
     {
         const size_t i0 = i - 1, j0 = j - 1, k0 = k - 1; /// Convert 1-based index to 0-based
         const size_t idx = i0 + (IDIM() - 1) * (j0 + (JDIM() - 1) * k0);
-        return *m_cell.at(idx);
+        return COMMON::at_unchecked(m_cell, idx);
     }
 
     const HEX_CELL &Block3D::cell(size_t i, size_t j, size_t k) const
     {
         const size_t i0 = i - 1, j0 = j - 1, k0 = k - 1; /// Convert 1-based index to 0-based
         const size_t idx = i0 + (IDIM() - 1) * (j0 + (JDIM() - 1) * k0);
-        return *m_cell.at(idx);
+        return COMMON::at_unchecked(m_cell, idx);
     }
 
     Block3D::VERTEX &Block3D::vertex(short n)
@@ -758,85 +822,133 @@ namespace GridTool::NMF
         }
     }
 
-    size_t &Block3D::surface_face_index(short f, size_t pri, size_t sec)
+    void Block3D::surface_size(short f, size_t &n_pri, size_t &n_sec) const
     {
-        HEX_CELL *p = nullptr;
-
         switch (f)
         {
         case 1:
-            p = &cell(pri, sec, 1);
-            break;
         case 2:
-            p = &cell(pri, sec, KDIM() - 1);
+            n_pri = IDIM();
+            n_sec = JDIM();
             break;
         case 3:
-            p = &cell(1, pri, sec);
-            break;
         case 4:
-            p = &cell(IDIM() - 1, pri, sec);
+            n_pri = JDIM();
+            n_sec = KDIM();
             break;
         case 5:
-            p = &cell(sec, 1, pri);
-            break;
         case 6:
-            p = &cell(sec, JDIM() - 1, pri);
+            n_pri = KDIM();
+            n_sec = IDIM();
             break;
         default:
             throw not_a_surface(f);
         }
-        return p->FaceSeq(f);
     }
 
-    size_t &Block3D::vertex_node_index(short v)
+    void Block3D::release_shell_storage()
     {
-        HEX_CELL *p = nullptr;
-        switch (v)
+        for (auto &e : m_surfNode)
+            std::vector<size_t>().swap(e);
+        for (auto &e : m_surfFace)
+            std::vector<size_t>().swap(e);
+    }
+
+    bool Block3D::has_shell_storage() const
+    {
+        return !m_surfNode(1).empty();
+    }
+
+    void Block3D::allocate_shell_storage()
+    {
+        for (short f = 1; f <= NumOfSurf; ++f)
+        {
+            size_t n_pri = 0, n_sec = 0;
+            surface_size(f, n_pri, n_sec);
+            m_surfNode(f).assign(n_pri * n_sec, 0);
+            m_surfFace(f).assign((n_pri - 1) * (n_sec - 1), 0);
+            TYDF_PROFILE_COUNT("nmf.alloc_bytes", (n_pri * n_sec + (n_pri - 1) * (n_sec - 1)) * sizeof(size_t));
+        }
+    }
+
+    size_t &Block3D::surface_face_index(short f, size_t pri, size_t sec)
+    {
+        size_t n_pri = 0, n_sec = 0;
+        surface_size(f, n_pri, n_sec);
+        return COMMON::at_unchecked(m_surfFace.unchecked(f), (pri - 1) + (sec - 1) * (n_pri - 1));
+    }
+
+    size_t Block3D::surface_face_index(short f, size_t pri, size_t sec) const
+    {
+        size_t n_pri = 0, n_sec = 0;
+        surface_size(f, n_pri, n_sec);
+        return COMMON::at_unchecked(m_surfFace.unchecked(f), (pri - 1) + (sec - 1) * (n_pri - 1));
+    }
+
+    size_t &Block3D::surface_node_index(short f, size_t pri, size_t sec)
+    {
+        size_t n_pri = 0, n_sec = 0;
+        surface_size(f, n_pri, n_sec);
+        return COMMON::at_unchecked(m_surfNode.unchecked(f), (pri - 1) + (sec - 1) * n_pri);
+    }
+
+    size_t Block3D::surface_node_index(short f, size_t pri, size_t sec) const
+    {
+        size_t n_pri = 0, n_sec = 0;
+        surface_size(f, n_pri, n_sec);
+        return COMMON::at_unchecked(m_surfNode.unchecked(f), (pri - 1) + (sec - 1) * n_pri);
+    }
 
+    void Block3D::vertex_node_coordinate(short v, size_t &i, size_t &j, size_t &k) const
+    {
+        switch (v)
         {
         case 1:
-            p = &cell(1, 1, 1);
+            i = 1;
+            j = 1;
+            k = 1;
             break;
         case 2:
-            p = &cell(1, 1, KDIM() - 1);
+            i = 1;
+            j = 1;
+            k = KDIM();
             break;
         case 3:
-            p = &cell(IDIM() - 1, 1, KDIM() - 1);
+            i = IDIM();
+            j = 1;
+            k = KDIM();
             break;
         case 4:
-            p = &cell(IDIM() - 1, 1, 1);
+            i = IDIM();
+            j = 1;
+            k = 1;
             break;
         case 5:
-            p = &cell(1, JDIM() - 1, 1);
+            i = 1;
+            j = JDIM();
+            k = 1;
             break;
         case 6:
-            p = &cell(1, JDIM() - 1, KDIM() - 1);
+            i = 1;
+            j = JDIM();
+            k = KDIM();
             break;
         case 7:
-            p = &cell(IDIM() - 1, JDIM() - 1, KDIM() - 1);
+            i = IDIM();
+            j = JDIM();
+            k = KDIM();
             break;
         case 8:
-            p = &cell(IDIM() - 1, JDIM() - 1, 1);
+            i = IDIM();
+            j = JDIM();
+            k = 1;
             break;
         default:
             throw not_a_vertex(v);
         }
-        return p->NodeSeq(v);
-    }
-
-    void Block3D::interior_node_occurance(size_t i, size_t j, size_t k, std::vector<size_t*> &oc)
-    {
-        oc[0] = &cell(i - 1, j - 1, k - 1).NodeSeq(7);
-        oc[1] = &cell(i, j - 1, k - 1).NodeSeq(6);
-        oc[2] = &cell(i - 1, j, k - 1).NodeSeq(3);
-        oc[3] = &cell(i, j, k - 1).NodeSeq(2);
-        oc[4] = &cell(i - 1, j - 1, k).NodeSeq(8);
-        oc[5] = &cell(i, j - 1, k).NodeSeq(5);
-        oc[6] = &cell(i - 1, j, k).NodeSeq(4);
-        oc[7] = &cell(i, j, k).NodeSeq(1);
     }
 
-    void Block3D::surface_node_coordinate(short f, size_t pri_seq, size_t sec_seq, size_t &i, size_t &j, size_t &k)
+    void Block3D::surface_node_coordinate(short f, size_t pri_seq, size_t sec_seq, size_t &i, size_t &j, size_t &k) const
     {
         switch (f)
         {
@@ -875,281 +987,213 @@ namespace GridTool::NMF
         }
     }
 
-    void Block3D::surface_internal_node_occurance(short f, size_t pri, size_t sec, std::vector<size_t*> &oc)
-    {
-        size_t i = 0, j = 0, k = 0;
-
-        surface_node_coordinate(f, pri, sec, i, j, k);
-        switch (f)
-        {
-        case 1:
-            oc[0] = &cell(i, j, k).NodeSeq(1);
-            oc[1] = &cell(i - 1, j, k).NodeSeq(4);
-            oc[2] = &cell(i, j - 1, k).NodeSeq(5);
-            oc[3] = &cell(i - 1, j - 1, k).NodeSeq(8);
-            break;
-        case 2:
-            oc[0] = &cell(i, j, k - 1).NodeSeq(2);
-            oc[1] = &cell(i - 1, j, k - 1).NodeSeq(3);
-            oc[2] = &cell(i, j - 1, k - 1).NodeSeq(6);
-            oc[3] = &cell(i - 1, j - 1, k - 1).NodeSeq(7);
-            break;
-        case 3:
-            oc[0] = &cell(i, j, k).NodeSeq(1);
-            oc[1] = &cell(i, j - 1, k).NodeSeq(5);
-            oc[2] = &cell(i, j, k - 1).NodeSeq(2);
-            oc[3] = &cell(i, j - 1, k - 1).NodeSeq(6);
-            break;
-        case 4:
-            oc[0] = &cell(i - 1, j, k).NodeSeq(4);
-            oc[1] = &cell(i - 1, j - 1, k).NodeSeq(8);
-            oc[2] = &cell(i - 1, j, k - 1).NodeSeq(3);
-            oc[3] = &cell(i - 1, j - 1, k - 1).NodeSeq(7);
-            break;
-        case 5:
-            oc[0] = &cell(i, j, k).NodeSeq(1);
-            oc[1] = &cell(i - 1, j, k).NodeSeq(4);
-            oc[2] = &cell(i, j, k - 1).NodeSeq(2);
-            oc[3] = &cell(i - 1, j, k - 1).NodeSeq(3);
-            break;
-        case 6:
-            oc[0] = &cell(i, j - 1, k).NodeSeq(5);
-            oc[1] = &cell(i - 1, j - 1, k).NodeSeq(8);
-            oc[2] = &cell(i, j - 1, k - 1).NodeSeq(6);
-            oc[3] = &cell(i - 1, j - 1, k - 1).NodeSeq(7);
-            break;
-        default:
-            throw not_a_surface(f);
-        }
-    }
-
-    void Block3D::frame_internal_node_occurace(short f, size_t idx, std::vector<size_t*> &oc)
+    void Block3D::frame_node_coordinate(short f, size_t idx, size_t &i, size_t &j, size_t &k) const
     {
         switch (f - 1)
         {
         case 0:
-            oc[0] = &cell(1, 1, idx).NodeSeq(1);
-            oc[1] = &cell(1, 1, idx - 1).NodeSeq(2);
+            i = 1;
+            j = 1;
+            k = idx;
             break;
         case 1:
-            oc[0] = &cell(IDIM() - 1, 1, idx).NodeSeq(4);
-            oc[1] = &cell(IDIM() - 1, 1, idx - 1).NodeSeq(3);
+            i = IDIM();
+            j = 1;
+            k = idx;
             break;
         case 2:
-            oc[0] = &cell(IDIM() - 1, JDIM() - 1, idx).NodeSeq(8);
-            oc[1] = &cell(IDIM() - 1, JDIM() - 1, idx - 1).NodeSeq(7);
+            i = IDIM();
+            j = JDIM();
+            k = idx;
             break;
         case 3:
-            oc[0] = &cell(1, JDIM() - 1, idx).NodeSeq(5);
-            oc[1] = &cell(1, JDIM() - 1, idx - 1).NodeSeq(6);
+            i = 1;
+            j = JDIM();
+            k = idx;
             break;
         case 4:
-            oc[0] = &cell(idx, 1, 1).NodeSeq(1);
-            oc[1] = &cell(idx - 1, 1, 1).NodeSeq(4);
+            i = idx;
+            j = 1;
+            k = 1;
             break;
         case 5:
-            oc[0] = &cell(idx, 1, KDIM() - 1).NodeSeq(2);
-            oc[1] = &cell(idx - 1, 1, KDIM() - 1).NodeSeq(3);
+            i = idx;
+            j = 1;
+            k = KDIM();
             break;
         case 6:
-            oc[0] = &cell(idx, JDIM() - 1, KDIM() - 1).NodeSeq(6);
-            oc[1] = &cell(idx - 1, JDIM() - 1, KDIM() - 1).NodeSeq(7);
+            i = idx;
+            j = JDIM();
+            k = KDIM();
             break;
         case 7:
-            oc[0] = &cell(idx, JDIM() - 1, 1).NodeSeq(5);
-            oc[1] = &cell(idx - 1, JDIM() - 1, 1).NodeSeq(8);
+            i = idx;
+            j = JDIM();
+            k = 1;
             break;
         case 8:
-            oc[0] = &cell(1, idx, 1).NodeSeq(1);
-            oc[1] = &cell(1, idx - 1, 1).NodeSeq(5);
+            i = 1;
+            j = idx;
+            k = 1;
             break;
         case 9:
-            oc[0] = &cell(1, idx, KDIM() - 1).NodeSeq(2);
-            oc[1] = &cell(1, idx - 1, KDIM() - 1).NodeSeq(6);
+            i = 1;
+            j = idx;
+            k = KDIM();
             break;
         case 10:
-            oc[0] = &cell(IDIM() - 1, idx, KDIM() - 1).NodeSeq(3);
-            oc[1] = &cell(IDIM() - 1, idx - 1, KDIM() - 1).NodeSeq(7);
+            i = IDIM();
+            j = idx;
+            k = KDIM();
             break;
         case 11:
-            oc[0] = &cell(IDIM() - 1, idx, 1).NodeSeq(4);
-            oc[1] = &cell(IDIM() - 1, idx - 1, 1).NodeSeq(8);
+            i = IDIM();
+            j = idx;
+            k = 1;
             break;
         default:
             throw not_a_frame(f);
         }
     }
 
-    size_t Block3D::node_index(size_t i, size_t j, size_t k)
+    void Block3D::assign_node_index(size_t i, size_t j, size_t k, size_t val)
+    {
+        bool flag = false;
+        if (k == 1)
+        {
+            surface_node_index(1, i, j) = val;
+            flag = true;
+        }
+        if (k == KDIM())
+        {
+            surface_node_index(2, i, j) = val;
+            flag = true;
+        }
+        if (i == 1)
+        {
+            surface_node_index(3, j, k) = val;
+            flag = true;
+        }
+        if (i == IDIM())
+        {
+            surface_node_index(4, j, k) = val;
+            flag = true;
+        }
+        if (j == 1)
+        {
+            surface_node_index(5, k, i) = val;
+            flag = true;
+        }
+        if (j == JDIM())
+        {
+            surface_node_index(6, k, i) = val;
+            flag = true;
+        }
+        if (!flag)
+            throw std::invalid_argument("Node (" + std::to_string(i) + ", " + std::to_string(j) + ", " + std::to_string(k) + ") is not on block surfaces.");
+    }
+
+    size_t Block3D::node_index(size_t i, size_t j, size_t k) const
     {
+#ifdef TYDF_CHECKED_ACCESS
         if (i == 0 || j == 0 || k == 0)
             throw std::invalid_argument("Should be 1-based index.");
         if (i > IDIM() || j > JDIM() || k > KDIM())
             throw std::invalid_argument("Out of range.");
+#endif
+
+        if (k == 1)
+            return surface_node_index(1, i, j);
+        else if (k == KDIM())
+            return surface_node_index(2, i, j);
+        else if (i == 1)
+            return surface_node_index(3, j, k);
+        else if (i == IDIM())
+            return surface_node_index(4, j, k);
+        else if (j == 1)
+            return surface_node_index(5, k, i);
+        else if (j == JDIM())
+            return surface_node_index(6, k, i);
+        else
+            return m_nodeOffset + ((k - 2) * (JDIM() - 2) + (j - 2)) * (IDIM() - 2) + (i - 1);
+    }
 
-        const auto v = isVertexNode(i, j, k);
-        if (v != -1)
-            return vertex_node_index(v);
+    size_t Block3D::cell_index(size_t i, size_t j, size_t k) const
+    {
+        return m_cellOffset + ((k - 1) * (JDIM() - 1) + (j - 1)) * (IDIM() - 1) + i;
+    }
 
-        std::vector<size_t*> c;
+    size_t Block3D::face_index(size_t i, size_t j, size_t k, short f) const
+    {
+        /// Num of internal faces in K and I direction, see "Mapping3D::numbering_face".
+        const size_t nK = (KDIM() - 2) * (JDIM() - 1) * (IDIM() - 1);
+        const size_t nI = (IDIM() - 2) * (KDIM() - 1) * (JDIM() - 1);
 
-        short f;
-        size_t f_idx;
-        isFrameInternalNode(i, j, k, f, f_idx);
-        if (f != -1)
+        switch (f)
         {
-            frame_internal_node_occurace(f, f_idx, c);
-            return *c[0];
+        case 1:
+            if (k == 1)
+                return surface_face_index(1, i, j);
+            else
+                return m_faceOffset + ((k - 2) * (JDIM() - 1) + (j - 1)) * (IDIM() - 1) + i;
+        case 2:
+            if (k == KDIM() - 1)
+                return surface_face_index(2, i, j);
+            else
+                return m_faceOffset + ((k - 1) * (JDIM() - 1) + (j - 1)) * (IDIM() - 1) + i;
+        case 3:
+            if (i == 1)
+                return surface_face_index(3, j, k);
+            else
+                return m_faceOffset + nK + ((i - 2) * (KDIM() - 1) + (k - 1)) * (JDIM() - 1) + j;
+        case 4:
+            if (i == IDIM() - 1)
+                return surface_face_index(4, j, k);
+            else
+                return m_faceOffset + nK + ((i - 1) * (KDIM() - 1) + (k - 1)) * (JDIM() - 1) + j;
+        case 5:
+            if (j == 1)
+                return surface_face_index(5, k, i);
+            else
+                return m_faceOffset + nK + nI + ((j - 2) * (IDIM() - 1) + (i - 1)) * (KDIM() - 1) + k;
+        case 6:
+            if (j == JDIM() - 1)
+                return surface_face_index(6, k, i);
+            else
+                return m_faceOffset + nK + nI + ((j - 1) * (IDIM() - 1) + (i - 1)) * (KDIM() - 1) + k;
+        default:
+            throw not_a_surface(f);
         }
+    }
 
-        short s;
-        size_t s_pri, s_sec;
-        isSurfaceInternalNode(i, j, k, s, s_pri, s_sec);
-        if (s != -1)
-        {
-            surface_internal_node_occurance(s, s_pri, s_sec, c);
-            return *c[0];
-        }
+    size_t Block3D::node_offset() const
+    {
+        return m_nodeOffset;
+    }
 
-        interior_node_occurance(i, j, k, c);
-        return *c[0];
+    size_t &Block3D::node_offset()
+    {
+        return m_nodeOffset;
     }
 
-    short Block3D::isVertexNode(size_t i, size_t j, size_t k) const
+    size_t Block3D::face_offset() const
     {
-        if (i == 1 && j == 1 && k == 1)
-            return 1;
-        else if (i == 1 && j == 1 && k == KDIM())
-            return 2;
-        else if (i == IDIM() && j == 1 && k == KDIM())
-            return 3;
-        else if (i == IDIM() && j == 1 && k == 1)
-            return 4;
-        else if (i == 1 && j == JDIM() && k == 1)
-            return 5;
-        else if (i == 1 && j == JDIM() && k == KDIM())
-            return 6;
-        else if (i == IDIM() && j == JDIM() && k == KDIM())
-            return 7;
-        else if (i == IDIM() && j == JDIM() && k == 1)
-            return 8;
-        else
-            return -1;
+        return m_faceOffset;
     }
 
-    void Block3D::isFrameInternalNode(size_t i, size_t j, size_t k, short &f, size_t &idx) const
+    size_t &Block3D::face_offset()
     {
-        if (i == 1 && j == 1)
-        {
-            f = 1;
-            idx = k;
-        }
-        else if (i == IDIM() && j == 1)
-        {
-            f = 2;
-            idx = k;
-        }
-        else if (i == IDIM() && j == JDIM())
-        {
-            f = 3;
-            idx = k;
-        }
-        else if (i == 1 && j == JDIM())
-        {
-            f = 4;
-            idx = k;
-        }
-        else if (j == 1 && k == 1)
-        {
-            f = 5;
-            idx = i;
-        }
-        else if (j == 1 && k == KDIM())
-        {
-            f = 6;
-            idx = i;
-        }
-        else if (j == JDIM() && k == KDIM())
-        {
-            f = 7;
-            idx = i;
-        }
-        else if (j == JDIM() && k == 1)
-        {
-            f = 8;
-            idx = i;
-        }
-        else if (k == 1 && i == 1)
-        {
-            f = 9;
-            idx = j;
-        }
-        else if (k == KDIM() && i == 1)
-        {
-            f = 10;
-            idx = j;
-        }
-        else if (k == KDIM() && i == IDIM())
-        {
-            f = 11;
-            idx = j;
-        }
-        else if (k == 1 && i == IDIM())
-        {
-            f = 12;
-            idx = j;
-        }
-        else
-        {
-            f = -1;
-            idx = 0;
-        }
+        return m_faceOffset;
     }
 
-    void Block3D::isSurfaceInternalNode(size_t i, size_t j, size_t k, short &s, size_t &pri, size_t &sec) const
+    size_t Block3D::cell_offset() const
     {
-        if (k == 1 && (1 < j && j < JDIM()) && (1 < i && i < IDIM()))
-        {
-            s = 1;
-            pri = i;
-            sec = j;
-        }
-        else if (k == KDIM() && (1 < j && j < JDIM()) && (1 < i && i < IDIM()))
-        {
-            s = 2;
-            pri = i;
-            sec = j;
-        }
-        else if (i == 1 && (1 < j && j < JDIM()) && (1 < k && k < KDIM()))
-        {
-            s = 3;
-            pri = j;
-            sec = k;
-        }
-        else if (i == IDIM() && (1 < j && j < JDIM()) && (1 < k && k < KDIM()))
-        {
-            s = 4;
-            pri = j;
-            sec = k;
-        }
-        else if (j == 1 && (1 < k && k < KDIM()) && (1 < i && i < IDIM()))
-        {
-            s = 5;
-            pri = k;
-            sec = i;
-        }
-        else if (j == JDIM() && (1 < k && k < KDIM()) && (1 < i && i < IDIM()))
-        {
-            s = 6;
-            pri = k;
-            sec = i;
-        }
-        else
-        {
-            s = -1;
-            pri = 0;
-            sec = 0;
-        }
+        return m_cellOffset;
+    }
+
+    size_t &Block3D::cell_offset()
+    {
+        return m_cellOffset;
     }
 
     Mapping3D::ENTRY::ENTRY(const std::string &t, size_t B, short F, size_t S1, size_t E1, size_t S2, size_t E2) :
@@ -1201,58 +1245,69 @@ namespace GridTool::NMF
 
     void Mapping3D::readFromFile(const std::string &path)
     {
-        std::string s;
-        std::stringstream ss;
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::readFromFile");
 
         // Open file
-        std::ifstream mfp(path);
-        if (mfp.fail())
-            throw std::runtime_error("Can not open target input file: \"" + path + "\".");
+        {
+            std::ifstream mfp(path);
+            if (mfp.fail())
+                throw std::runtime_error("Can not open target input file: \"" + path + "\".");
+        }
+        const COMMON::MAPPED_FILE content(path);
+        TYDF_PROFILE_COUNT("nmf.bytes_read", content.size());
+        const char *pos = content.begin();
+        const char *const end = content.end();
+        const char *first = nullptr, *last = nullptr;
+        std::string res[4];
 
         // Skip header
-        do {
-            std::getline(mfp, s);
-        } while (isBlankLine(s) || checkStarting(s, '#'));
+        bool found = false;
+        while (getLine(pos, end, first, last))
+        {
+            if (!isBlankLine(first, last) && !checkStarting(first, last, '#'))
+            {
+                found = true;
+                break;
+            }
+        }
 
         // Read block nums
-        static const std::regex pattern1(R"(\s*(\d+)\s*)");
-        std::smatch res1;
-        if (std::regex_match(s, res1, pattern1))
+        if (found && matchIntegers(first, last, 1, res))
         {
-            int NumOfBlk = std::stoi(res1[1].str());
+            int NumOfBlk = std::stoi(res[0]);
             if (NumOfBlk > 0)
             {
                 release_all(); // NOT release all existing resources until it is ensured that this input file is valid.
                 m_blk.resize(NumOfBlk, nullptr); // Re-Allocate storage for new recordings.
             }
             else
-                throw std::runtime_error("Invalid num of blocks: \"" + res1[1].str() + "\".");
+                throw std::runtime_error("Invalid num of blocks: \"" + res[0] + "\".");
         }
         else
             throw std::runtime_error("Failed to match the single line, where only the num of blocks is specified.");
 
         // Read dimension info of each block
-        static const std::regex pattern2(R"(\s*(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s*)");
         const auto NumOfBlk = nBlock();
+        TYDF_PROFILE_COUNT("nmf.tokens_parsed", 1 + 4 * NumOfBlk);
         for (size_t i = 0; i < NumOfBlk; i++)
         {
-            std::getline(mfp, s);
-            std::smatch res2;
-            if (std::regex_match(s, res2, pattern2))
+            if (!getLine(pos, end, first, last))
+                first = last = end;
+            if (matchIntegers(first, last, 4, res))
             {
-                const size_t idx = std::stoi(res2[1].str());
+                const size_t idx = std::stoi(res[0]);
                 if (idx < 1 || idx > NumOfBlk)
                     throw std::runtime_error("Invalid order of block: " + std::to_string(idx));
 
-                const int i_max = std::stoi(res2[2].str());
+                const int i_max = std::stoi(res[1]);
                 if (i_max < 1)
                     throw std::runtime_error("Invalid I dimension: " + std::to_string(i_max));
 
-                const int j_max = std::stoi(res2[3].str());
+                const int j_max = std::stoi(res[2]);
                 if (j_max < 1)
                     throw std::runtime_error("Invalid J dimension: " + std::to_string(j_max));
 
-                const int k_max = std::stoi(res2[4].str());
+                const int k_max = std::stoi(res[3]);
                 if (k_max < 1)
                     throw std::runtime_error("Invalid K dimension: " + std::to_string(k_max));
 
@@ -1265,50 +1320,66 @@ namespace GridTool::NMF
         }
 
         // Skip separators
-        while (std::getline(mfp, s))
+        found = false;
+        while (getLine(pos, end, first, last))
         {
-            if (!isBlankLine(s) && !checkStarting(s, '#'))
+            if (!isBlankLine(first, last) && !checkStarting(first, last, '#'))
+            {
+                found = true;
                 break;
+            }
         }
 
         // Read connections
-        if (!mfp.eof())
+        /// Each line starts with the B.C. name, followed by 6 integers for each side.
+        if (found)
         {
             do {
-                formalize(s);
-                ss.clear();
-                ss << s;
-                std::string bc_str;
-                ss >> bc_str;
+                const char *p = first;
+                std::string bc_str = nextToken(p, last);
+                formalize(bc_str);
                 if (BC::str2idx(bc_str) == BC::ONE_TO_ONE)
                 {
                     size_t cB[2];
                     short cF[2];
                     size_t cS1[2], cE1[2], cS2[2], cE2[2];
-                    std::string swp;
                     for (int i = 0; i < 2; i++)
-                        ss >> cB[i] >> cF[i] >> cS1[i] >> cE1[i] >> cS2[i] >> cE2[i];
-                    ss >> swp;
+                    {
+                        cB[i] = nextInteger<size_t>(p, last);
+                        cF[i] = nextInteger<short>(p, last);
+                        cS1[i] = nextInteger<size_t>(p, last);
+                        cE1[i] = nextInteger<size_t>(p, last);
+                        cS2[i] = nextInteger<size_t>(p, last);
+                        cE2[i] = nextInteger<size_t>(p, last);
+                    }
+                    std::string swp = nextToken(p, last);
+                    formalize(swp);
                     add_entry(bc_str, cB[0], cF[0], cS1[0], cE1[0], cS2[0], cE2[0], cB[1], cF[1], cS1[1], cE1[1], cS2[1], cE2[1], swp == "TRUE");
+                    TYDF_PROFILE_COUNT("nmf.tokens_parsed", 14);
                 }
                 else
                 {
-                    size_t cB;
-                    short cF;
-                    size_t cS1, cE1, cS2, cE2;
-                    ss >> cB >> cF >> cS1 >> cE1 >> cS2 >> cE2;
+                    const size_t cB = nextInteger<size_t>(p, last);
+                    const short cF = nextInteger<short>(p, last);
+                    const size_t cS1 = nextInteger<size_t>(p, last);
+                    const size_t cE1 = nextInteger<size_t>(p, last);
+                    const size_t cS2 = nextInteger<size_t>(p, last);
+                    const size_t cE2 = nextInteger<size_t>(p, last);
                     add_entry(bc_str, cB, cF, cS1, cE1, cS2, cE2);
+                    TYDF_PROFILE_COUNT("nmf.tokens_parsed", 7);
                 }
-            } while (std::getline(mfp, s));
+            } while (getLine(pos, end, first, last));
         }
-
-        // Close input file
-        mfp.close();
     }
 
     void Mapping3D::compute_topology()
     {
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::compute_topology");
+
         connecting();
+        index_entries();
+        if (m_partial)
+            merge_shell_node();
 
         const int nsf = coloring_surface();
         if (nsf < Block3D::NumOfSurf)
@@ -1438,22 +1509,93 @@ namespace GridTool::NMF
         out << "========================================== END =========================================" << std::endl;
     }
 
-    void Mapping3D::numbering()
+    void Mapping3D::numbering(bool cell_storage, const std::vector<bool> &subset)
     {
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::numbering");
+
+        if (!subset.empty() && subset.size() != nBlock())
+            throw std::invalid_argument("Inconsistent num of blocks in the subset to be numbered.");
+
+        /// Blocks without shell storage are skipped when assigning indices.
         for (auto b : m_blk)
-            b->allocate_cell_storage();
+        {
+            b->release_cell_storage();
+            if (subset.empty() || subset[b->index() - 1])
+                b->allocate_shell_storage();
+            else
+                b->release_shell_storage();
+        }
 
         numbering_cell();
         numbering_face();
         numbering_node();
-    }
 
-    void Mapping3D::writeToFile(const std::string &path)
-    {
-        // Open target file
-        std::ofstream f_out(path);
-        if (f_out.fail())
-            throw std::runtime_error("Can not open target output file: \"" + path + "\".");
+        for (auto b : m_blk)
+            for (short f = 1; f <= Block3D::NumOfSurf && b->has_shell_storage(); ++f)
+            {
+                size_t n_pri = 0, n_sec = 0;
+                b->surface_size(f, n_pri, n_sec);
+                for (size_t sec = 1; sec <= n_sec; ++sec)
+                    for (size_t pri = 1; pri <= n_pri; ++pri)
+                        if (b->surface_node_index(f, pri, sec) == 0 || (pri < n_pri && sec < n_sec && b->surface_face_index(f, pri, sec) == 0))
+                            throw std::runtime_error("Surface " + std::to_string(f) + " of Block " + std::to_string(b->index()) + " is not fully numbered.");
+            }
+
+        if (!cell_storage)
+            return;
+
+        /// Local node offsets of each vertex of a HEX cell, see "HEX_CELL::NodeSeq".
+        static const short di[8] = { 0, 0, 1, 1, 0, 0, 1, 1 };
+        static const short dj[8] = { 0, 0, 0, 0, 1, 1, 1, 1 };
+        static const short dk[8] = { 0, 1, 1, 0, 0, 1, 1, 0 };
+
+        /// Cells are independent of each other, filled concurrently.
+        for (auto b : m_blk)
+        {
+            if (!b->has_shell_storage())
+                continue;
+
+            b->allocate_cell_storage();
+
+            const size_t nI = b->IDIM() - 1;
+            const size_t nJ = b->JDIM() - 1;
+            COMMON::parallel_for(b->cell_num(), [b, nI, nJ](size_t first, size_t last)
+            {
+                size_t i = first % nI + 1;
+                size_t j = first / nI % nJ + 1;
+                size_t k = first / nI / nJ + 1;
+                for (size_t n = first; n < last; ++n)
+                {
+                    auto &c = b->cell(i, j, k);
+                    c.CellSeq() = b->cell_index(i, j, k);
+                    for (short r = 0; r < 8; ++r)
+                        c.NodeSeq(r + 1) = b->node_index(i + di[r], j + dj[r], k + dk[r]);
+                    for (short f = 1; f <= Block3D::NumOfSurf; ++f)
+                        c.FaceSeq(f) = b->face_index(i, j, k, f);
+
+                    /// Next cell in (k, j, i) order.
+                    if (++i > nI)
+                    {
+                        i = 1;
+                        if (++j > nJ)
+                        {
+                            j = 1;
+                            ++k;
+                        }
+                    }
+                }
+            }, 4096);
+        }
+    }
+
+    void Mapping3D::writeToFile(const std::string &path)
+    {
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::writeToFile");
+
+        // Open target file
+        std::ofstream f_out(path);
+        if (f_out.fail())
+            throw std::runtime_error("Can not open target output file: \"" + path + "\".");
 
         // Header
         f_out << "# ============================= Neutral Map File generated by the Grid-Glue software =========================" << std::endl;
@@ -1547,6 +1689,14 @@ namespace GridTool::NMF
 
     size_t Mapping3D::nNode() const
     {
+        if (m_partial)
+        {
+            size_t ret = m_shellNodeNum;
+            for (auto b : m_blk)
+                ret += b->block_internal_node_num();
+            return ret;
+        }
+
         size_t ret = nVertex();
         for (auto b : m_blk)
         {
@@ -1573,6 +1723,463 @@ namespace GridTool::NMF
         return ret;
     }
 
+    void Mapping3D::index_entries()
+    {
+        m_surfIndex.assign(Block3D::NumOfSurf * nBlock(), SURFACE_INDEX());
+
+        /// Ranges go to the surface they lie on, in order of entries.
+        struct PATCH
+        {
+            size_t entry;
+            short side;
+            size_t s1, e1, s2, e2;
+        };
+        std::vector<std::vector<PATCH>> patch(m_surfIndex.size());
+        for (size_t n = 1; n <= m_entry.size(); ++n)
+        {
+            const auto e = m_entry(n);
+            const auto p = dynamic_cast<const DoubleSideEntry*>(e);
+            for (short side = 1; side <= (p ? 2 : 1); ++side)
+            {
+                const auto &rg = side == 1 ? e->Range1() : p->Range2();
+                if (rg.B() > nBlock() || rg.F() > Block3D::NumOfSurf)
+                    throw std::invalid_argument("Range of entry " + std::to_string(n) + " is not on any block surface.");
+                patch[Block3D::NumOfSurf * (rg.B() - 1) + (rg.F() - 1)].push_back({ n, side, rg.S1(), rg.E1(), rg.S2(), rg.E2() });
+            }
+        }
+
+        auto distinct = [](std::vector<size_t> &x)
+        {
+            std::sort(x.begin(), x.end());
+            x.erase(std::unique(x.begin(), x.end()), x.end());
+        };
+        auto position = [](const std::vector<size_t> &x, size_t val)
+        {
+            return std::lower_bound(x.begin(), x.end(), val) - x.begin();
+        };
+
+        for (size_t s = 0; s < m_surfIndex.size(); ++s)
+        {
+            auto &dst = m_surfIndex[s];
+            for (const auto &e : patch[s])
+            {
+                dst.pri.push_back(e.s1);
+                dst.pri.push_back(e.e1);
+                dst.sec.push_back(e.s2);
+                dst.sec.push_back(e.e2);
+            }
+            for (const auto &e : patch[s])
+                if (m_entry(e.entry)->Type() == BC::ONE_TO_ONE)
+                    dst.interface_face_num += (std::max(e.s1, e.e1) - std::min(e.s1, e.e1)) * (std::max(e.s2, e.e2) - std::min(e.s2, e.e2));
+            distinct(dst.pri);
+            distinct(dst.sec);
+            if (dst.pri.size() < 2 || dst.sec.size() < 2)
+                continue;
+
+            /// Overlapping parts are taken by the first entry.
+            const size_t nPri = dst.pri.size() - 1;
+            dst.entry.assign(nPri * (dst.sec.size() - 1), 0);
+            dst.side.assign(dst.entry.size(), 0);
+            for (const auto &e : patch[s])
+            {
+                const size_t i0 = position(dst.pri, std::min(e.s1, e.e1)), i1 = position(dst.pri, std::max(e.s1, e.e1));
+                const size_t j0 = position(dst.sec, std::min(e.s2, e.e2)), j1 = position(dst.sec, std::max(e.s2, e.e2));
+                for (size_t j = j0; j < j1; ++j)
+                    for (size_t i = i0; i < i1; ++i)
+                    {
+                        const size_t loc = i + nPri * j;
+                        if (dst.entry[loc] == 0)
+                        {
+                            dst.entry[loc] = e.entry;
+                            dst.side[loc] = e.side;
+                        }
+                    }
+            }
+        }
+    }
+
+    size_t Mapping3D::covering_entry(size_t b, short f, size_t pri, size_t sec, short &side) const
+    {
+        side = 0;
+        if (b < 1 || b > nBlock())
+            throw not_a_block(b);
+        if (f < 1 || f > Block3D::NumOfSurf)
+            throw std::invalid_argument("\"" + std::to_string(f) + "\" is not a valid surface index of a 3D block.");
+
+        const auto &idx = m_surfIndex.at(Block3D::NumOfSurf * (b - 1) + (f - 1));
+        const auto i = std::upper_bound(idx.pri.begin(), idx.pri.end(), pri) - idx.pri.begin();
+        const auto j = std::upper_bound(idx.sec.begin(), idx.sec.end(), sec) - idx.sec.begin();
+        if (i == 0 || j == 0 || static_cast<size_t>(i) >= idx.pri.size() || static_cast<size_t>(j) >= idx.sec.size())
+            return 0;
+
+        const size_t loc = (i - 1) + (idx.pri.size() - 1) * (j - 1);
+        side = idx.side[loc];
+        return idx.entry[loc];
+    }
+
+    size_t Mapping3D::surface_interface_face_num(size_t b, short f) const
+    {
+        if (f < 1 || f > Block3D::NumOfSurf)
+            throw std::invalid_argument("\"" + std::to_string(f) + "\" is not a valid surface index of a 3D block.");
+        return m_surfIndex.at(Block3D::NumOfSurf * (b - 1) + (f - 1)).interface_face_num;
+    }
+
+    size_t Mapping3D::surface_boundary_face_num(size_t b, short f) const
+    {
+        return block(b).surface_face_num(f) - surface_interface_face_num(b, f);
+    }
+
+    std::vector<int> Mapping3D::partition(size_t nPart) const
+    {
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::partition");
+
+        const size_t NC = nCell();
+        if (nPart == 0 || nPart > NC)
+            throw std::invalid_argument("Invalid num of parts: " + std::to_string(nPart) + ".");
+
+        /// Box of cells within a block, 1-based inclusive ranges in (i, j, k).
+        struct PIECE
+        {
+            size_t blk;
+            std::array<size_t, 3> lo, hi;
+            int part;
+
+            size_t extent(int d) const { return hi[d] - lo[d] + 1; }
+
+            size_t cell_num() const { return extent(0) * extent(1) * extent(2); }
+        };
+
+        /// 1-to-1 entries touching each block.
+        std::vector<std::vector<const DoubleSideEntry*>> link(nBlock());
+        for (auto e : m_entry)
+            if (e->Type() == BC::ONE_TO_ONE)
+            {
+                auto p = static_cast<const DoubleSideEntry*>(e);
+                link[p->Range1().B() - 1].push_back(p);
+                if (p->Range2().B() != p->Range1().B())
+                    link[p->Range2().B() - 1].push_back(p);
+            }
+
+        /// Faces of piece "x" on range "rg", as offsets from the starting node of each direction
+        /// of the range, half-open. Returns "false" if there is no such face.
+        auto on_range = [this](const PIECE &x, const auto &rg, size_t t[2][2])
+        {
+            static const int axis[3][3] = { { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 } }; /// pri, sec, normal
+            const auto &a = axis[(rg.F() - 1) / 2];
+            const auto &b = block(rg.B());
+            const size_t N = (a[2] == 0 ? b.IDIM() : a[2] == 1 ? b.JDIM() : b.KDIM()) - 1;
+            if (rg.F() % 2 == 1 ? x.lo[a[2]] != 1 : x.hi[a[2]] != N)
+                return false;
+
+            const size_t S[2] = { rg.S1(), rg.S2() }, E[2] = { rg.E1(), rg.E2() };
+            for (int r = 0; r < 2; ++r)
+            {
+                const size_t lo = x.lo[a[r]], hi = x.hi[a[r]];
+                const size_t f0 = std::max(lo, std::min(S[r], E[r])), f1 = std::min(hi, std::max(S[r], E[r]) - 1);
+                if (f0 > f1)
+                    return false;
+                if (E[r] > S[r])
+                {
+                    t[r][0] = f0 - S[r];
+                    t[r][1] = f1 - S[r] + 1;
+                }
+                else
+                {
+                    t[r][0] = S[r] - 1 - f1;
+                    t[r][1] = S[r] - f0;
+                }
+            }
+            return true;
+        };
+
+        /// Num of faces shared by 2 pieces.
+        auto weight = [&](const PIECE &x, const PIECE &y)
+        {
+            auto overlap = [](size_t a0, size_t a1, size_t b0, size_t b1)
+            {
+                return std::max(a0, b0) < std::min(a1, b1) ? std::min(a1, b1) - std::max(a0, b0) : size_t(0);
+            };
+
+            size_t w = 0;
+            if (x.blk == y.blk)
+                for (int d = 0; d < 3; ++d)
+                    if (x.hi[d] + 1 == y.lo[d] || y.hi[d] + 1 == x.lo[d])
+                    {
+                        const int d1 = (d + 1) % 3, d2 = (d + 2) % 3;
+                        w += overlap(x.lo[d1], x.hi[d1] + 1, y.lo[d1], y.hi[d1] + 1) * overlap(x.lo[d2], x.hi[d2] + 1, y.lo[d2], y.hi[d2] + 1);
+                    }
+
+            for (auto p : link[x.blk - 1])
+                for (int s = 0; s < 2; ++s)
+                {
+                    const auto &rx = s == 0 ? p->Range1() : p->Range2();
+                    const auto &ry = s == 0 ? p->Range2() : p->Range1();
+                    size_t tx[2][2], ty[2][2];
+                    if (rx.B() != x.blk || ry.B() != y.blk || !on_range(x, rx, tx) || !on_range(y, ry, ty))
+                        continue;
+                    if (p->Swap())
+                        std::swap(ty[0], ty[1]);
+                    w += overlap(tx[0][0], tx[0][1], ty[0][0], ty[0][1]) * overlap(tx[1][0], tx[1][1], ty[1][0], ty[1][1]);
+                }
+            return w;
+        };
+
+        std::vector<PIECE> piece;
+        for (size_t n = 1; n <= nBlock(); ++n)
+        {
+            const auto &b = block(n);
+            piece.push_back({ n, { 1, 1, 1 }, { b.IDIM() - 1, b.JDIM() - 1, b.KDIM() - 1 }, -1 });
+        }
+
+        /// Faces shared with the current part, and with all assigned pieces.
+        std::vector<size_t> connPart(piece.size(), 0), connAll(piece.size(), 0);
+        auto assign = [&](size_t x, int p)
+        {
+            piece[x].part = p;
+            for (size_t y = 0; y < piece.size(); ++y)
+                if (piece[y].part < 0)
+                {
+                    const size_t w = weight(piece[y], piece[x]);
+                    connPart[y] += w;
+                    connAll[y] += w;
+                }
+        };
+
+        size_t remain = NC;
+        for (size_t p = 0; p < nPart; ++p)
+        {
+            const bool isLast = p + 1 == nPart;
+            const size_t cap = (remain + (nPart - p) / 2) / (nPart - p);
+            std::fill(connPart.begin(), connPart.end(), 0);
+
+            size_t load = 0;
+            while (isLast || load < cap)
+            {
+                /// Most connected to the current part, then to the assigned ones,
+                /// so that parts are grown next to each other.
+                size_t x = piece.size();
+                for (size_t y = 0; y < piece.size(); ++y)
+                    if (piece[y].part < 0 && (x == piece.size() || std::make_pair(connPart[y], connAll[y]) > std::make_pair(connPart[x], connAll[x])))
+                        x = y;
+                if (x == piece.size())
+                    break;
+
+                const size_t n = piece[x].cell_num();
+                if (isLast || load + n <= cap)
+                {
+                    assign(x, static_cast<int>(p));
+                    load += n;
+                    continue;
+                }
+
+                /// Cut a slab across the longest direction, on the side closer to the current part,
+                /// and the layer next to it is cut again across its longest direction, until the part is full.
+                size_t need = cap - load;
+                auto cur = piece[x];
+                std::vector<PIECE> rest;
+                for (int level = 0; level < 3 && need > 0; ++level)
+                {
+                    int d = 0;
+                    for (int r = 1; r < 3; ++r)
+                        if (cur.extent(r) > cur.extent(d))
+                            d = r;
+                    const size_t cross = cur.cell_num() / cur.extent(d);
+                    const size_t m = need / cross;
+
+                    /// "m" layers to be taken, and the next one to be refined.
+                    PIECE lower = cur, upper = cur;
+                    lower.hi[d] = cur.lo[d] + m;
+                    upper.lo[d] = cur.hi[d] - m;
+                    size_t wLower = 0, wUpper = 0;
+                    for (const auto &y : piece)
+                        if (y.part == static_cast<int>(p) || (load == 0 && y.part >= 0))
+                        {
+                            wLower += weight(lower, y);
+                            wUpper += weight(upper, y);
+                        }
+                    const bool atUpper = wUpper > wLower;
+
+                    PIECE slab = atUpper ? upper : lower, remainder = cur;
+                    if (atUpper)
+                        remainder.hi[d] = upper.lo[d] - 1;
+                    else
+                        remainder.lo[d] = lower.hi[d] + 1;
+                    if (m + 1 < cur.extent(d))
+                        rest.push_back(remainder);
+
+                    cur = slab;
+                    if (atUpper)
+                    {
+                        cur.hi[d] = cur.lo[d];
+                        ++slab.lo[d];
+                    }
+                    else
+                    {
+                        cur.lo[d] = cur.hi[d];
+                        --slab.hi[d];
+                    }
+                    if (m > 0)
+                    {
+                        piece.push_back(slab);
+                        connPart.push_back(0);
+                        connAll.push_back(0);
+                        assign(piece.size() - 1, static_cast<int>(p));
+                        load += slab.cell_num();
+                        need -= slab.cell_num();
+                    }
+                }
+                rest.push_back(cur);
+
+                /// Connections of the remainders are counted afresh.
+                for (size_t r = 0; r < rest.size(); ++r)
+                {
+                    const size_t y = r == 0 ? x : piece.size();
+                    if (r == 0)
+                        piece[x] = rest[r];
+                    else
+                    {
+                        piece.push_back(rest[r]);
+                        connPart.push_back(0);
+                        connAll.push_back(0);
+                    }
+                    connPart[y] = connAll[y] = 0;
+                    for (const auto &z : piece)
+                        if (z.part >= 0)
+                        {
+                            const size_t w = weight(rest[r], z);
+                            connAll[y] += w;
+                            if (z.part == static_cast<int>(p))
+                                connPart[y] += w;
+                        }
+                }
+                break;
+            }
+            remain -= load;
+        }
+
+        /// Cells are numbered block by block in (k, j, i) order, see "numbering_cell".
+        std::vector<size_t> offset(nBlock() + 1, 0);
+        for (size_t n = 1; n <= nBlock(); ++n)
+            offset[n] = offset[n - 1] + block(n).cell_num();
+
+        std::vector<int> ret(NC, -1);
+        for (const auto &x : piece)
+        {
+            const auto &b = block(x.blk);
+            for (size_t k = x.lo[2]; k <= x.hi[2]; ++k)
+                for (size_t j = x.lo[1]; j <= x.hi[1]; ++j)
+                    for (size_t i = x.lo[0]; i <= x.hi[0]; ++i)
+                        ret[offset[x.blk - 1] + ((k - 1) * (b.JDIM() - 1) + (j - 1)) * (b.IDIM() - 1) + (i - 1)] = x.part;
+        }
+        return ret;
+    }
+
+    void Mapping3D::locate_cell(size_t c, size_t &b, size_t &i, size_t &j, size_t &k) const
+    {
+        /// Cells are numbered block by block, thus offsets are ascending.
+        auto it = std::upper_bound(m_blk.begin(), m_blk.end(), c, [](size_t val, const Block3D *e) { return val <= e->cell_offset(); });
+        if (c == 0 || it == m_blk.begin())
+            throw std::out_of_range("Cell " + std::to_string(c) + " is not numbered.");
+        --it;
+
+        const auto blk = *it;
+        size_t loc = c - blk->cell_offset();
+        if (loc > blk->cell_num())
+            throw std::out_of_range("Cell " + std::to_string(c) + " is not numbered.");
+
+        b = it - m_blk.begin() + 1;
+        --loc;
+        i = loc % (blk->IDIM() - 1) + 1;
+        loc /= blk->IDIM() - 1;
+        j = loc % (blk->JDIM() - 1) + 1;
+        k = loc / (blk->JDIM() - 1) + 1;
+    }
+
+    void Mapping3D::merge_shell_node()
+    {
+        m_shellOffset.assign(Block3D::NumOfSurf * nBlock() + 1, 0);
+        for (size_t n = 1; n <= nBlock(); ++n)
+            for (short f = 1; f <= Block3D::NumOfSurf; ++f)
+            {
+                const size_t s = Block3D::NumOfSurf * (n - 1) + (f - 1);
+                m_shellOffset[s + 1] = m_shellOffset[s] + block(n).surface_node_num(f);
+            }
+        m_shellNodeSet.reset(m_shellOffset.back());
+
+        auto node_id = [this](size_t b, short f, size_t pri, size_t sec)
+        {
+            size_t n_pri = 0, n_sec = 0;
+            block(b).surface_size(f, n_pri, n_sec);
+            return m_shellOffset[Block3D::NumOfSurf * (b - 1) + (f - 1)] + (pri - 1) + (sec - 1) * n_pri;
+        };
+
+        // Nodes on frames appear on 2 or 3 surfaces of a block.
+        for (size_t n = 1; n <= nBlock(); ++n)
+        {
+            const auto &b = block(n);
+            for (short f = 1; f <= Block3D::NumOfSurf; ++f)
+            {
+                size_t n_pri = 0, n_sec = 0, i = 0, j = 0, k = 0;
+                b.surface_size(f, n_pri, n_sec);
+                for (size_t sec = 1; sec <= n_sec; ++sec)
+                    for (size_t pri = 1; pri <= n_pri; pri += (sec == 1 || sec == n_sec || pri == n_pri) ? 1 : std::max<size_t>(1, n_pri - 1))
+                    {
+                        b.surface_node_coordinate(f, pri, sec, i, j, k);
+                        const size_t cur = node_id(n, f, pri, sec);
+
+                        /// Local (pri, sec) on each surface, see "Block3D::surface_node_coordinate".
+                        if (k == 1)
+                            m_shellNodeSet.unite(cur, node_id(n, 1, i, j));
+                        if (k == b.KDIM())
+                            m_shellNodeSet.unite(cur, node_id(n, 2, i, j));
+                        if (i == 1)
+                            m_shellNodeSet.unite(cur, node_id(n, 3, j, k));
+                        if (i == b.IDIM())
+                            m_shellNodeSet.unite(cur, node_id(n, 4, j, k));
+                        if (j == 1)
+                            m_shellNodeSet.unite(cur, node_id(n, 5, k, i));
+                        if (j == b.JDIM())
+                            m_shellNodeSet.unite(cur, node_id(n, 6, k, i));
+                    }
+            }
+        }
+
+        // Nodes on each 1-to-1 patch, in the same correspondence as "numbering_node".
+        for (auto e : m_entry)
+        {
+            if (e->Type() != BC::ONE_TO_ONE)
+                continue;
+
+            auto p = static_cast<DoubleSideEntry*>(e);
+            const auto &rg1 = p->Range1();
+            const auto &rg2 = p->Range2();
+
+            std::vector<size_t> b1_dim_pri, b1_dim_sec, b2_dim_pri, b2_dim_sec;
+            distribute_index(rg1.S1(), rg1.E1(), b1_dim_pri);
+            distribute_index(rg1.S2(), rg1.E2(), b1_dim_sec);
+            distribute_index(rg2.S1(), rg2.E1(), b2_dim_pri);
+            distribute_index(rg2.S2(), rg2.E2(), b2_dim_sec);
+            if (p->Swap())
+                std::swap(b2_dim_pri, b2_dim_sec);
+
+            if (b1_dim_pri.size() != b2_dim_pri.size() || b1_dim_sec.size() != b2_dim_sec.size())
+                throw std::runtime_error("Inconsistent num of nodes.");
+
+            for (size_t l2 = 0; l2 < b1_dim_sec.size(); ++l2)
+                for (size_t l1 = 0; l1 < b1_dim_pri.size(); ++l1)
+                {
+                    const size_t n1 = node_id(rg1.B(), rg1.F(), b1_dim_pri[l1], b1_dim_sec[l2]);
+                    const size_t n2 = p->Swap() ? node_id(rg2.B(), rg2.F(), b2_dim_sec[l2], b2_dim_pri[l1]) : node_id(rg2.B(), rg2.F(), b2_dim_pri[l1], b2_dim_sec[l2]);
+                    m_shellNodeSet.unite(n1, n2);
+                }
+        }
+
+        m_shellNodeNum = 0;
+        for (size_t id = 0; id < m_shellNodeSet.size(); ++id)
+            if (m_shellNodeSet.find(id) == id)
+                ++m_shellNodeNum;
+    }
+
     void Mapping3D::release_all()
     {
         // Release memory used for blocks.
@@ -1591,6 +2198,17 @@ namespace GridTool::NMF
 
     void Mapping3D::connecting()
     {
+        /// Whether "rg" spans the whole surface it lies on.
+        auto is_whole = [this](const auto &rg)
+        {
+            size_t n_pri = 0, n_sec = 0;
+            block(rg.B()).surface_size(rg.F(), n_pri, n_sec);
+            const bool t1 = std::min(rg.S1(), rg.E1()) == 1 && std::max(rg.S1(), rg.E1()) == n_pri;
+            const bool t2 = std::min(rg.S2(), rg.E2()) == 1 && std::max(rg.S2(), rg.E2()) == n_sec;
+            return t1 && t2;
+        };
+
+        m_partial = false;
         for (auto e : m_entry)
         {
             if (e->Type() == BC::ONE_TO_ONE)
@@ -1601,6 +2219,13 @@ namespace GridTool::NMF
                 auto F1 = &B1->surf(p->Range1().F());
                 auto F2 = &B2->surf(p->Range2().F());
 
+                // Patches of surfaces are handled by "merge_shell_node".
+                if (!is_whole(p->Range1()) || !is_whole(p->Range2()))
+                {
+                    m_partial = true;
+                    continue;
+                }
+
                 // Surface connectivity
                 F1->neighbourSurf = F2;
                 F2->neighbourSurf = F1;
@@ -1766,133 +2391,112 @@ namespace GridTool::NMF
         }
     }
 
-    int Mapping3D::coloring_surface()
+    size_t Mapping3D::surface_id(const Block3D::SURF *s)
+    {
+        return Block3D::NumOfSurf * (s->dependentBlock->index() - 1) + (s->local_index - 1);
+    }
+
+    size_t Mapping3D::frame_id(const Block3D::FRAME *e)
+    {
+        return Block3D::NumOfFrame * (e->dependentBlock->index() - 1) + (e->local_index - 1);
+    }
+
+    size_t Mapping3D::vertex_id(const Block3D::VERTEX *v)
+    {
+        return Block3D::NumOfVertex * (v->dependentBlock->index() - 1) + (v->local_index - 1);
+    }
+
+    template<typename F>
+    int Mapping3D::assign_color(COMMON::DISJOINT_SET &eqv, const F &global_index)
     {
+        /// Classes are numbered in order of their first member,
+        /// i.e. block by block and then by local index.
+        std::vector<int> color(eqv.size(), 0);
         int global_cnt = 0;
-        for (auto b : m_blk)
+        for (size_t id = 0; id < eqv.size(); ++id)
         {
+            auto &c = color[eqv.find(id)];
+            if (c == 0)
+                c = ++global_cnt;
+            global_index(id) = c;
+        }
+        return global_cnt;
+    }
+
+    int Mapping3D::coloring_surface()
+    {
+        m_surfSet.reset(Block3D::NumOfSurf * nBlock());
+        for (auto b : m_blk)
             for (short j = 1; j <= Block3D::NumOfSurf; ++j)
             {
-                auto s = &b->surf(j);
-                if (s->global_index != 0)
-                    continue;
-
-                s->global_index = ++global_cnt;
+                const auto s = &b->surf(j);
                 if (s->neighbourSurf)
-                    s->neighbourSurf->global_index = s->global_index;
+                    m_surfSet.unite(surface_id(s), surface_id(s->neighbourSurf));
             }
-        }
-        return global_cnt;
+
+        return assign_color(m_surfSet, [this](size_t id) -> int& { return block(id / Block3D::NumOfSurf + 1).surf(id % Block3D::NumOfSurf + 1).global_index; });
     }
 
     int Mapping3D::coloring_frame()
     {
-        int global_cnt = 0;
+        /// Counterparts of a frame on its 2 dependent surfaces are equivalent to it,
+        /// and the parity records whether they run in opposite directions.
+        m_frameSet.reset(Block3D::NumOfFrame * nBlock());
         for (auto b : m_blk)
-        {
-            for (short j = 1; j <= Block3D::NumOfFrame; ++j)
+            for (short j = 1; j <= Block3D::NumOfSurf; ++j)
             {
-                auto e = &b->frame(j);
-                if (e->global_index != 0)
+                const auto &sf = b->surf(j);
+                if (!sf.neighbourSurf)
                     continue;
 
-                ++global_cnt;
-                std::queue<Block3D::FRAME*> q;
-                q.push(e);
-
-                // BFS
-                while (!q.empty())
+                for (int ii = 0; ii < 4; ++ii)
                 {
-                    auto ce = q.front();
-                    q.pop();
-                    ce->global_index = global_cnt;
-
-                    for (auto sf : ce->dependentSurf)
-                    {
-                        if (!sf)
-                            throw std::runtime_error("Dependent surface of a frame should NOT be empty.");
-
-                        if (sf->neighbourSurf)
-                        {
-                            Block3D::FRAME *t = nullptr;
-                            for (int ii = 0; ii < 4; ++ii)
-                                if (sf->includedFrame[ii] == ce)
-                                {
-                                    t = sf->counterpartFrame[ii];
-                                    break;
-                                }
-                            if (!t)
-                                throw std::runtime_error("Internal error.");
-
-                            if (t->global_index == 0)
-                                q.push(t);
-                        }
-                    }
+                    const auto t = sf.counterpartFrame[ii];
+                    if (!t)
+                        throw std::runtime_error("Internal error.");
+                    if (!m_frameSet.unite(frame_id(sf.includedFrame[ii]), frame_id(t), sf.counterpartFrameIsOpposite[ii]))
+                        throw std::runtime_error("Inconsistent orientation of connected frames.");
                 }
             }
-        }
-        return global_cnt; // The total num of block frames.
+
+        return assign_color(m_frameSet, [this](size_t id) -> int& { return block(id / Block3D::NumOfFrame + 1).frame(id % Block3D::NumOfFrame + 1).global_index; }); // The total num of block frames.
     }
 
     int Mapping3D::coloring_vertex()
     {
-        int global_cnt = 0;
+        m_vertexSet.reset(Block3D::NumOfVertex * nBlock());
         for (auto b : m_blk)
-        {
-            for (short j = 1; j <= Block3D::NumOfVertex; ++j)
+            for (short j = 1; j <= Block3D::NumOfSurf; ++j)
             {
-                auto v = &b->vertex(j);
-                if (v->global_index != 0)
+                const auto &sf = b->surf(j);
+                if (!sf.neighbourSurf)
                     continue;
 
-                ++global_cnt;
-                std::stack<Block3D::VERTEX*> s;
-                s.push(v);
-
-                // DFS
-                while (!s.empty())
+                for (int ii = 0; ii < 4; ++ii)
                 {
-                    auto cv = s.top();
-                    s.pop();
-                    cv->global_index = global_cnt;
-
-                    for (auto sf : cv->dependentSurf)
-                    {
-                        if (!sf)
-                            throw std::runtime_error("Dependent surface of a vertex should NOT be empty.");
-
-                        if (sf->neighbourSurf)
-                        {
-                            Block3D::VERTEX *t = nullptr;
-                            for (int ii = 0; ii < 4; ++ii)
-                                if (sf->includedVertex[ii] == cv)
-                                {
-                                    t = sf->counterpartVertex[ii];
-                                    break;
-                                }
-                            if (!t)
-                                throw std::runtime_error("Counterpart vertex should exist.");
-
-                            if (t->global_index == 0)
-                                s.push(t);
-                        }
-                    }
+                    const auto t = sf.counterpartVertex[ii];
+                    if (!t)
+                        throw std::runtime_error("Counterpart vertex should exist.");
+                    m_vertexSet.unite(vertex_id(sf.includedVertex[ii]), vertex_id(t));
                 }
             }
-        }
-        return global_cnt;
+
+        return assign_color(m_vertexSet, [this](size_t id) -> int& { return block(id / Block3D::NumOfVertex + 1).vertex(id % Block3D::NumOfVertex + 1).global_index; });
     }
 
     void Mapping3D::numbering_cell()
     {
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::numbering_cell");
+
         const auto totalCellNum = nCell();
 
+        /// Cells are numbered block by block in (k, j, i) order.
         size_t cnt = 0;
         for (auto b : m_blk)
-            for (size_t k = 1; k < b->KDIM(); ++k)
-                for (size_t j = 1; j < b->JDIM(); ++j)
-                    for (size_t i = 1; i < b->IDIM(); ++i)
-                        b->cell(i, j, k).CellSeq() = ++cnt;
+        {
+            b->cell_offset() = cnt;
+            cnt += b->cell_num();
+        }
 
         if (cnt != totalCellNum)
             throw std::length_error("Inconsistent num of cells.");
@@ -1900,92 +2504,58 @@ namespace GridTool::NMF
 
     void Mapping3D::numbering_face()
     {
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::numbering_face");
+
         size_t totalFaceNum = 0, innerFaceNum = 0, bdryFaceNum = 0;
         nFace(totalFaceNum, innerFaceNum, bdryFaceNum);
 
+        /* Internal faces */
+        /// Numbered in K, I, J direction successively, see "Block3D::face_index".
         size_t cnt = 0;
         for (auto b : m_blk)
         {
-            /* Internal faces */
-            // K - direction
-            for (size_t k = 1; k <= b->KDIM() - 2; ++k)
-                for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                    for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                        b->cell(i, j, k + 1).FaceSeq(1) = b->cell(i, j, k).FaceSeq(2) = ++cnt;
-
-            // I - direction
-            for (size_t i = 1; i <= b->IDIM() - 2; ++i)
-                for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                    for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                        b->cell(i + 1, j, k).FaceSeq(3) = b->cell(i, j, k).FaceSeq(4) = ++cnt;
-
-            // J - direction
-            for (size_t j = 1; j <= b->JDIM() - 2; ++j)
-                for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                    for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                        b->cell(i, j + 1, k).FaceSeq(5) = b->cell(i, j, k).FaceSeq(6) = ++cnt;
-
-            /* External faces */
-            // Single-Sided
-            for (short f = 1; f <= Block3D::NumOfSurf; ++f)
-            {
-                auto &sf = b->surf(f);
-                if (!sf.neighbourSurf)
-                {
-                    if (sf.local_index == 1)
-                    {
-                        for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                            for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                                b->cell(i, j, 1).FaceSeq(1) = ++cnt;
-                    }
-                    else if (sf.local_index == 2)
-                    {
-                        for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                            for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                                b->cell(i, j, b->KDIM() - 1).FaceSeq(2) = ++cnt;
-                    }
-                    else if (sf.local_index == 3)
-                    {
-                        for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                            for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                                b->cell(1, j, k).FaceSeq(3) = ++cnt;
-                    }
-                    else if (sf.local_index == 4)
-                    {
-                        for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                            for (size_t j = 1; j <= b->JDIM() - 1; ++j)
-                                b->cell(b->IDIM() - 1, j, k).FaceSeq(4) = ++cnt;
-                    }
-                    else if (sf.local_index == 5)
-                    {
-                        for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                            for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                                b->cell(i, 1, k).FaceSeq(5) = ++cnt;
-                    }
-                    else if (sf.local_index == 6)
-                    {
-                        for (size_t i = 1; i <= b->IDIM() - 1; ++i)
-                            for (size_t k = 1; k <= b->KDIM() - 1; ++k)
-                                b->cell(i, b->JDIM() - 1, k).FaceSeq(6) = ++cnt;
-                    }
-                    else
-                        throw std::invalid_argument("Internal error: Wrong local index of block surface.");
-                }
-            }
+            b->face_offset() = cnt;
+            cnt += (b->KDIM() - 2) * (b->JDIM() - 1) * (b->IDIM() - 1);
+            cnt += (b->IDIM() - 2) * (b->KDIM() - 1) * (b->JDIM() - 1);
+            cnt += (b->JDIM() - 2) * (b->IDIM() - 1) * (b->KDIM() - 1);
         }
 
-        // Double-Sided
+        /// A face is represented by its lower-left node on the surface,
+        /// which is NOT the leading one along a descending range.
+        auto face_seq = [](const std::vector<size_t> &node_seq, size_t l)
+        {
+            return std::min(node_seq[l - 1], node_seq[l]);
+        };
+
+        /// Faces on different surfaces are independent of each other,
+        /// so each surface is numbered concurrently once its offset is known.
+        std::vector<DoubleSideEntry*> interface;
+        std::vector<size_t> interfaceOffset;
         for (auto e : m_entry)
         {
             if (e->Type() == BC::ONE_TO_ONE)
             {
                 auto p = static_cast<DoubleSideEntry*>(e);
+                interface.push_back(p);
+                interfaceOffset.push_back(cnt);
+                cnt += p->Range1().face_num();
+            }
+        }
+
+        // Double-Sided
+        COMMON::parallel_for(interface.size(), [&](size_t first, size_t last)
+        {
+            for (size_t n = first; n < last; ++n)
+            {
+                auto p = interface[n];
                 const auto &rg1 = p->Range1();
                 const auto &rg2 = p->Range2();
                 auto b1 = &block(rg1.B());
                 const auto f1 = rg1.F();
                 auto b2 = &block(rg2.B());
                 const auto f2 = rg2.F();
+                if (!b1->has_shell_storage() && !b2->has_shell_storage())
+                    continue;
 
                 std::vector<size_t> b1_dim_pri, b1_dim_sec, b2_dim_pri, b2_dim_sec;
                 distribute_index(rg1.S1(), rg1.E1(), b1_dim_pri);
@@ -1998,78 +2568,162 @@ namespace GridTool::NMF
                 if (b1_dim_pri.size() != b2_dim_pri.size() || b1_dim_sec.size() != b2_dim_sec.size())
                     throw std::runtime_error("Inconsistent num of nodes.");
 
+                size_t loc_cnt = interfaceOffset[n];
                 const auto n1 = rg1.pri_node_num();
                 const auto n2 = rg1.sec_node_num();
-                if (p->Swap())
-                {
-                    for (size_t l1 = 1; l1 <= n1 - 1; ++l1)
-                        for (size_t l2 = 1; l2 <= n2 - 1; ++l2)
-                        {
-                            const auto b1i1 = b1_dim_pri[l1 - 1];
-                            const auto b1i2 = b1_dim_sec[l2 - 1];
-                            const auto b2i1 = b2_dim_pri[l1 - 1];
-                            const auto b2i2 = b2_dim_sec[l2 - 1];
-                            b1->surface_face_index(f1, b1i1, b1i2) = b2->surface_face_index(f2, b2i2, b2i1) = ++cnt;
-                        }
-                }
-                else
+                for (size_t l1 = 1; l1 <= n1 - 1; ++l1)
+                    for (size_t l2 = 1; l2 <= n2 - 1; ++l2)
+                    {
+                        const auto b1i1 = face_seq(b1_dim_pri, l1);
+                        const auto b1i2 = face_seq(b1_dim_sec, l2);
+                        const auto b2i1 = face_seq(b2_dim_pri, l1);
+                        const auto b2i2 = face_seq(b2_dim_sec, l2);
+                        ++loc_cnt;
+                        if (b1->has_shell_storage())
+                            b1->surface_face_index(f1, b1i1, b1i2) = loc_cnt;
+                        if (!b2->has_shell_storage())
+                            continue;
+                        if (p->Swap())
+                            b2->surface_face_index(f2, b2i2, b2i1) = loc_cnt;
+                        else
+                            b2->surface_face_index(f2, b2i1, b2i2) = loc_cnt;
+                    }
+            }
+        });
+
+        // Single-Sided faces come last, so that all internal faces
+        // are numbered continuously, and so do faces on each boundary surface.
+        /// Surfaces split into patches may have both kinds.
+        std::vector<std::pair<Block3D*, short>> boundary;
+        std::vector<size_t> boundaryOffset;
+        for (auto b : m_blk)
+        {
+            for (short f = 1; f <= Block3D::NumOfSurf; ++f)
+            {
+                const auto nBF = surface_boundary_face_num(b->index(), f);
+                if (nBF == 0)
+                    continue;
+
+                if (b->has_shell_storage())
                 {
-                    for (size_t l1 = 1; l1 <= n1 - 1; ++l1)
-                        for (size_t l2 = 1; l2 <= n2 - 1; ++l2)
-                        {
-                            const auto b1i1 = b1_dim_pri[l1 - 1];
-                            const auto b1i2 = b1_dim_sec[l2 - 1];
-                            const auto b2i1 = b2_dim_pri[l1 - 1];
-                            const auto b2i2 = b2_dim_sec[l2 - 1];
-                            b1->surface_face_index(f1, b1i1, b1i2) = b2->surface_face_index(f2, b2i1, b2i2) = ++cnt;
-                        }
+                    boundary.emplace_back(b, f);
+                    boundaryOffset.push_back(cnt);
                 }
+                cnt += nBF;
             }
         }
 
+        /// Numbered along the primary direction first, see "Block3D::surface_face_index".
+        COMMON::parallel_for(boundary.size(), [&](size_t first, size_t last)
+        {
+            for (size_t n = first; n < last; ++n)
+            {
+                auto b = boundary[n].first;
+                const auto f = boundary[n].second;
+
+                size_t n_pri = 0, n_sec = 0, loc_cnt = boundaryOffset[n];
+                b->surface_size(f, n_pri, n_sec);
+                for (size_t sec = 1; sec < n_sec; ++sec)
+                    for (size_t pri = 1; pri < n_pri; ++pri)
+                    {
+                        auto &idx = b->surface_face_index(f, pri, sec);
+                        if (idx == 0)
+                            idx = ++loc_cnt;
+                    }
+            }
+        });
+
         if (cnt != totalFaceNum)
             throw std::length_error("Inconsistent num of faces detected.");
     }
 
     void Mapping3D::numbering_node()
     {
+        TYDF_PROFILE_SCOPE("NMF::Mapping3D::numbering_node");
+
         const auto totalNodeNum = nNode();
 
         size_t cnt = 0;
 
         // Block interior
+        /// Numbered block by block in (k, j, i) order, see "Block3D::node_index".
         for (auto b : m_blk)
         {
-            std::vector<size_t*> boc(8, nullptr);
-            for (size_t k = 2; k <= b->KDIM() - 1; ++k)
-                for (size_t j = 2; j <= b->JDIM() - 1; ++j)
-                    for (size_t i = 2; i <= b->IDIM() - 1; ++i)
-                    {
-                        ++cnt;
-                        b->interior_node_occurance(i, j, k, boc);
-                        for (auto r : boc)
-                            *r = cnt;
-                    }
+            b->node_offset() = cnt;
+            cnt += b->block_internal_node_num();
+        }
+
+        // Nodes on block surfaces split into patches
+        /// Classes of "m_shellNodeSet" are numbered in order of their first member.
+        if (m_partial)
+        {
+            std::vector<size_t> color(m_shellNodeSet.size(), 0);
+            size_t id = 0;
+            for (auto b : m_blk)
+                for (short f = 1; f <= Block3D::NumOfSurf; ++f)
+                {
+                    size_t n_pri = 0, n_sec = 0;
+                    b->surface_size(f, n_pri, n_sec);
+                    for (size_t sec = 1; sec <= n_sec; ++sec)
+                        for (size_t pri = 1; pri <= n_pri; ++pri, ++id)
+                        {
+                            auto &c = color[m_shellNodeSet.find(id)];
+                            if (c == 0)
+                                c = ++cnt;
+                            if (b->has_shell_storage())
+                                b->surface_node_index(f, pri, sec) = c;
+                        }
+                }
+
+            if (cnt != totalNodeNum)
+                throw std::length_error("Inconsistent num of nodes detected.");
+            return;
         }
 
+        size_t ni = 0, nj = 0, nk = 0;
+
         // Vertex
         for (const auto &e : m_vertex)
         {
             ++cnt;
             for (auto r : e)
-                r->dependentBlock->vertex_node_index(r->local_index) = cnt;
+            {
+                auto b = r->dependentBlock;
+                if (!b->has_shell_storage())
+                    continue;
+                b->vertex_node_coordinate(r->local_index, ni, nj, nk);
+                b->assign_node_index(ni, nj, nk, cnt);
+            }
         }
 
-        // Interior of double-sided surface
+        /// Nodes inside different surfaces are independent of each other,
+        /// so each surface is numbered concurrently once its offset is known.
+        std::vector<DoubleSideEntry*> interface;
+        std::vector<size_t> interfaceOffset;
         for (auto e : m_entry)
         {
             if (e->Type() == BC::ONE_TO_ONE)
             {
                 auto p = static_cast<DoubleSideEntry*>(e);
+                interface.push_back(p);
+                interfaceOffset.push_back(cnt);
+                cnt += (p->Range1().pri_node_num() - 2) * (p->Range1().sec_node_num() - 2);
+            }
+        }
+
+        // Interior of double-sided surface
+        COMMON::parallel_for(interface.size(), [&](size_t first, size_t last)
+        {
+            size_t ni = 0, nj = 0, nk = 0;
+            for (size_t n = first; n < last; ++n)
+            {
+                auto p = interface[n];
                 const auto &rg1 = p->Range1();
                 const auto &rg2 = p->Range2();
                 auto b1 = &block(rg1.B());
                 auto b2 = &block(rg2.B());
+                if (!b1->has_shell_storage() && !b2->has_shell_storage())
+                    continue;
                 const auto f1 = rg1.F();
                 const auto f2 = rg2.F();
                 const auto n1 = rg1.pri_node_num();
@@ -2086,136 +2740,82 @@ namespace GridTool::NMF
                 if (b1_dim_pri.size() != b2_dim_pri.size() || b1_dim_sec.size() != b2_dim_sec.size())
                     throw std::runtime_error("Inconsistent num of nodes.");
 
-                std::vector<size_t*> sioc(4, nullptr);
-                if (p->Swap())
-                {
-                    for (size_t l1 = 2; l1 <= n1 - 1; ++l1)
-                        for (size_t l2 = 2; l2 <= n2 - 1; ++l2)
-                        {
-                            ++cnt;
-
-                            const auto b1i1 = b1_dim_pri[l1 - 1];
-                            const auto b1i2 = b1_dim_sec[l2 - 1];
-                            const auto b2i1 = b2_dim_pri[l1 - 1];
-                            const auto b2i2 = b2_dim_sec[l2 - 1];
+                size_t loc_cnt = interfaceOffset[n];
+                for (size_t l1 = 2; l1 <= n1 - 1; ++l1)
+                    for (size_t l2 = 2; l2 <= n2 - 1; ++l2)
+                    {
+                        ++loc_cnt;
 
-                            b1->surface_internal_node_occurance(f1, b1i1, b1i2, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
+                        const auto b1i1 = b1_dim_pri[l1 - 1];
+                        const auto b1i2 = b1_dim_sec[l2 - 1];
+                        const auto b2i1 = b2_dim_pri[l1 - 1];
+                        const auto b2i2 = b2_dim_sec[l2 - 1];
 
-                            b2->surface_internal_node_occurance(f2, b2i2, b2i1, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
-                        }
-                }
-                else
-                {
-                    for (size_t l1 = 2; l1 <= n1 - 1; ++l1)
-                        for (size_t l2 = 2; l2 <= n2 - 1; ++l2)
+                        if (b1->has_shell_storage())
                         {
-                            ++cnt;
-
-                            const auto b1i1 = b1_dim_pri[l1 - 1];
-                            const auto b1i2 = b1_dim_sec[l2 - 1];
-                            const auto b2i1 = b2_dim_pri[l1 - 1];
-                            const auto b2i2 = b2_dim_sec[l2 - 1];
-
-                            b1->surface_internal_node_occurance(f1, b1i1, b1i2, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
-
-                            b2->surface_internal_node_occurance(f2, b2i1, b2i2, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
+                            b1->surface_node_coordinate(f1, b1i1, b1i2, ni, nj, nk);
+                            b1->assign_node_index(ni, nj, nk, loc_cnt);
                         }
-                }
+                        if (!b2->has_shell_storage())
+                            continue;
+
+                        if (p->Swap())
+                            b2->surface_node_coordinate(f2, b2i2, b2i1, ni, nj, nk);
+                        else
+                            b2->surface_node_coordinate(f2, b2i1, b2i2, ni, nj, nk);
+                        b2->assign_node_index(ni, nj, nk, loc_cnt);
+                    }
             }
-        }
+        });
 
         // Interior of single-sided surface
+        std::vector<std::pair<Block3D*, short>> boundary;
+        std::vector<size_t> boundaryOffset;
         for (auto b : m_blk)
         {
-            std::vector<size_t*> sioc(4, nullptr);
-            for (short i = 1; i <= Block3D::NumOfSurf; ++i)
+            for (short f = 1; f <= Block3D::NumOfSurf; ++f)
             {
-                auto &f = b->surf(i);
-                if (!f.neighbourSurf)
+                if (b->surf(f).neighbourSurf)
+                    continue;
+
+                if (b->has_shell_storage())
                 {
-                    size_t pri_end = 0, sec_end = 0;
-                    switch (i)
-                    {
-                    case 1:
-                    case 2:
-                        pri_end = b->IDIM() - 1;
-                        sec_end = b->JDIM() - 1;
-                        break;
-                    case 3:
-                    case 4:
-                        pri_end = b->JDIM() - 1;
-                        sec_end = b->KDIM() - 1;
-                        break;
-                    case 5:
-                    case 6:
-                        pri_end = b->KDIM() - 1;
-                        sec_end = b->IDIM() - 1;
-                        break;
-                    default:
-                        break;
-                    }
-                    for (size_t sec = 2; sec <= sec_end; ++sec)
-                        for (size_t pri = 2; pri <= pri_end; ++pri)
-                        {
-                            ++cnt;
-                            b->surface_internal_node_occurance(i, pri, sec, sioc);
-                            for (auto r : sioc)
-                                *r = cnt;
-                        }
+                    boundary.emplace_back(b, f);
+                    boundaryOffset.push_back(cnt);
                 }
+                cnt += b->surface_internal_node_num(f);
             }
         }
 
-        // Frame
-        for (const auto &e : m_frame)
+        COMMON::parallel_for(boundary.size(), [&](size_t first, size_t last)
         {
-            // Identify directions
-            std::map<Block3D::FRAME*, size_t> ptr2idx;
-            for (size_t i = 0; i < e.size(); ++i)
-                ptr2idx[e[i]] = i;
-            if (ptr2idx.size() != e.size())
-                throw std::runtime_error("Something wired happens...");
-            std::vector<bool> swap_flag(e.size(), false);
-            std::vector<bool> visited(e.size(), false);
-            visited[0] = true;
-            std::queue<Block3D::FRAME*> q;
-            q.push(e[0]);
-
-            while (!q.empty())
+            size_t ni = 0, nj = 0, nk = 0;
+            for (size_t n = first; n < last; ++n)
             {
-                auto r = q.front();
-                q.pop();
-                auto par_idx = ptr2idx[r];
+                auto b = boundary[n].first;
+                const auto f = boundary[n].second;
 
-                for (auto s : r->dependentSurf)
-                {
-                    if (s->neighbourSurf)
+                size_t n_pri = 0, n_sec = 0, loc_cnt = boundaryOffset[n];
+                b->surface_size(f, n_pri, n_sec);
+                for (size_t sec = 2; sec < n_sec; ++sec)
+                    for (size_t pri = 2; pri < n_pri; ++pri)
                     {
-                        size_t i = 0;
-                        while (i < s->includedFrame.size() && s->includedFrame[i] != r)
-                            ++i;
-                        if (i >= s->includedFrame.size())
-                            throw std::runtime_error("Internal error detected.");
-
-                        auto rr = s->counterpartFrame[i];
-                        auto loc_idx = ptr2idx[rr];
-                        if (!visited[loc_idx])
-                        {
-                            visited[loc_idx] = true;
-                            swap_flag[loc_idx] = s->counterpartFrameIsOpposite[i] ? !swap_flag[par_idx] : swap_flag[par_idx];
-                            q.push(rr);
-                        }
+                        ++loc_cnt;
+                        b->surface_node_coordinate(f, pri, sec, ni, nj, nk);
+                        b->assign_node_index(ni, nj, nk, loc_cnt);
                     }
-                }
             }
+        });
+
+        // Frame
+        for (const auto &e : m_frame)
+        {
+            // Identify directions
+            /// Frames running opposite to the first one are traversed reversely.
+            const bool p0 = m_frameSet.parity(frame_id(e[0]));
+            std::vector<bool> swap_flag(e.size(), false);
+            for (size_t i = 0; i < e.size(); ++i)
+                swap_flag[i] = m_frameSet.parity(frame_id(e[i])) != p0;
 
             // Assign index
             auto r0 = e[0];
@@ -2224,14 +2824,15 @@ namespace GridTool::NMF
             for (size_t lidx = 0; lidx < itn; ++lidx)
             {
                 auto cur_cnt = ++cnt;
-                for (size_t i = 0; i < e.size(); ++i)
+                for (size_t n = 0; n < e.size(); ++n)
                 {
-                    std::vector<size_t*> fnoc(2, nullptr);
-                    auto r = e[i];
+                    auto r = e[n];
                     auto b = r->dependentBlock;
-                    const size_t loc_pos = swap_flag[i] ? (itn + 1 - lidx) : (lidx + 2);
-                    b->frame_internal_node_occurace(r->local_index, loc_pos, fnoc);
-                    *fnoc[0] = *fnoc[1] = cur_cnt;
+                    if (!b->has_shell_storage())
+                        continue;
+                    const size_t loc_pos = swap_flag[n] ? (itn + 1 - lidx) : (lidx + 2);
+                    b->frame_node_coordinate(r->local_index, loc_pos, ni, nj, nk);
+                    b->assign_node_index(ni, nj, nk, cur_cnt);
                 }
             }
         }
@@ -2,18 +2,255 @@
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cctype>
+#include <limits>
+#include <algorithm>
+#include <charconv>
 #include "../inc/plot3d.h"
 
-static void formatted_writer(std::ostream &fout, double val, size_t &counter)
+/// Num of coordinates on each line of formatted files.
+static const size_t NumPerLine = 6;
+
+/// Upper bound of the length of a formatted coordinate, including the separators.
+static const size_t MaxLenOfValue = 32;
+
+/// Write "val" with global index "cnt" into "dst", and return the end of what was written.
+/// Same as "std::ostream::operator<<" with the default precision.
+static char *formatted_writer(char *dst, double val, size_t cnt)
+{
+    *dst++ = '\t';
+    dst = std::to_chars(dst, dst + MaxLenOfValue - 2, val, std::chars_format::general, 6).ptr;
+    if ((cnt + 1) % NumPerLine == 0)
+        *dst++ = '\n';
+    return dst;
+}
+
+/// Convert a single token in [first, last) by "std::from_chars".
+static double formatted_reader(const char *first, const char *last)
+{
+    if (first != last && *first == '+')
+        ++first;
+
+    double ret = 0.0;
+    const auto res = std::from_chars(first, last, ret);
+    if (res.ec == std::errc::result_out_of_range && res.ptr == last)
+        return std::strtod(std::string(first, last).c_str(), nullptr);
+    if (res.ec != std::errc() || res.ptr != last)
+        throw std::runtime_error("Invalid coordinate: \"" + std::string(first, last) + "\".");
+    return ret;
+}
+
+static bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/// Coordinates of all blocks, viewed as consecutive segments (1 for each plane) in file order.
+template<typename T>
+class VALUE_SEQ
+{
+private:
+    std::vector<T*> m_ptr;
+
+    /// Global index of the first value of each segment, followed by the total num.
+    std::vector<size_t> m_offset;
+
+public:
+    VALUE_SEQ() : m_offset(1, 0) {}
+
+    void append(T *p, size_t n)
+    {
+        m_ptr.push_back(p);
+        m_offset.push_back(m_offset.back() + n);
+    }
+
+    size_t size() const
+    {
+        return m_offset.back();
+    }
+
+    /// Invoke "f(g, v)" on each value "v" whose global index "g" is in [first, last).
+    template<typename F>
+    void visit(size_t first, size_t last, const F &f) const
+    {
+        if (first >= last)
+            return;
+
+        size_t s = std::upper_bound(m_offset.begin(), m_offset.end(), first) - m_offset.begin() - 1;
+        for (size_t g = first; g < last; ++s)
+        {
+            T *p = m_ptr[s] + (g - m_offset[s]);
+            for (const size_t stop = std::min(last, m_offset[s + 1]); g < stop; ++g, ++p)
+                f(g, *p);
+        }
+    }
+};
+
+/// Load a multi-byte value stored in [p, p + sizeof(T)), in reversed byte order if "swap".
+template<typename T>
+static T load_value(const char *p, bool swap)
+{
+    char buf[sizeof(T)];
+    std::memcpy(buf, p, sizeof(T));
+    if (swap)
+        std::reverse(buf, buf + sizeof(T));
+
+    T ret;
+    std::memcpy(&ret, buf, sizeof(T));
+    return ret;
+}
+
+template<typename T>
+static void write_value(std::ostream &fout, T val)
 {
-    static const size_t NumPerLine = 6;
-    static const std::string sep("\t");
+    fout.write(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+/// Formatted files start with the num of blocks in plain text,
+/// whereas binary ones carry non-printable bytes within the first few words.
+static bool is_formatted(std::istream &fin)
+{
+    static const size_t NumOfProbe = 64;
+
+    char buf[NumOfProbe];
+    fin.read(buf, NumOfProbe);
+    const auto n = fin.gcount();
+    fin.clear();
+    fin.seekg(0);
 
-    fout << sep << val;
-    if (++counter == NumPerLine)
+    for (std::streamsize i = 0; i < n; ++i)
     {
-        fout << std::endl;
-        counter = 0;
+        const auto c = static_cast<unsigned char>(buf[i]);
+        if (!std::isprint(c) && !std::isspace(c))
+            return false;
+    }
+    return n > 0;
+}
+
+/// Parse whitespace-separated coordinates in [first, last) into "seq" concurrently.
+/// The content is split into chunks at blanks, tokens within each chunk are counted first,
+/// so that each chunk knows the global index of its first token before parsing.
+static void read_formatted(const char *first, const char *last, const VALUE_SEQ<double> &seq)
+{
+    static const size_t MinLenOfChunk = 1 << 20;
+
+    const size_t L = last - first;
+    const size_t nChunk = std::max<size_t>(std::min(GridTool::COMMON::num_of_thread(), L / MinLenOfChunk), 1);
+    std::vector<const char*> bound(nChunk + 1, last);
+    bound[0] = first;
+    for (size_t t = 1; t < nChunk; ++t)
+    {
+        const char *p = std::max(bound[t - 1], first + L * t / nChunk);
+        while (p < last && !is_blank(*p))
+            ++p;
+        bound[t] = p;
+    }
+
+    /// Tokens belong to the chunk where they start.
+    std::vector<size_t> cnt(nChunk + 1, 0);
+    GridTool::COMMON::parallel_for(nChunk, [&bound, &cnt](size_t lo, size_t hi)
+    {
+        for (size_t t = lo; t < hi; ++t)
+        {
+            size_t n = 0;
+            for (const char *p = bound[t]; p < bound[t + 1];)
+            {
+                while (p < bound[t + 1] && is_blank(*p))
+                    ++p;
+                if (p == bound[t + 1])
+                    break;
+                ++n;
+                while (p < bound[t + 1] && !is_blank(*p))
+                    ++p;
+            }
+            cnt[t + 1] = n;
+        }
+    });
+    for (size_t t = 0; t < nChunk; ++t)
+        cnt[t + 1] += cnt[t];
+    TYDF_PROFILE_COUNT("plot3d.tokens_parsed", cnt[nChunk]);
+    if (cnt[nChunk] < seq.size())
+        throw std::runtime_error("Insufficient num of coordinates: " + std::to_string(cnt[nChunk]) + " found, " + std::to_string(seq.size()) + " expected.");
+
+    /// Redundant tokens at the end are ignored.
+    GridTool::COMMON::parallel_for(nChunk, [&bound, &cnt, &seq](size_t lo, size_t hi)
+    {
+        for (size_t t = lo; t < hi; ++t)
+        {
+            const char *p = bound[t];
+            const char *const end = bound[t + 1];
+            seq.visit(cnt[t], std::min(cnt[t + 1], seq.size()), [&p, end](size_t, double &dst)
+            {
+                while (is_blank(*p))
+                    ++p;
+                const char *q = p;
+                while (q < end && !is_blank(*q))
+                    ++q;
+                dst = formatted_reader(p, q);
+                p = q;
+            });
+        }
+    });
+}
+
+/// Num of coordinate planes stored in file.
+static size_t plane_num(const GridTool::PLOT3D::BLK &b)
+{
+    return b.is3D() ? 3 : 2;
+}
+
+/// Block of given dimensions, "K" is 0 if absent.
+static GridTool::PLOT3D::BLK *allocate_block(const std::array<size_t, 3> &d)
+{
+    using GridTool::PLOT3D::BLK;
+
+    TYDF_PROFILE_COUNT("plot3d.alloc_bytes", d[0] * d[1] * std::max<size_t>(d[2], 1) * (d[2] == 0 ? 2 : 3) * sizeof(double));
+    if (d[2] == 0)
+        return new BLK(d[0], d[1], false);
+    else if (d[2] == 1)
+        return new BLK(d[0], d[1], true);
+    else
+        return new BLK(d[0], d[1], d[2]);
+}
+
+/// Num of blocks and dimensions of each block in formatted files.
+/// "K" is 0 if absent, "fin" is left at the beginning of coordinates.
+static void read_header(std::istream &fin, std::vector<std::array<size_t, 3>> &dim)
+{
+    std::string s;
+    std::stringstream ss;
+
+    // Read block num.
+    std::getline(fin, s);
+    ss << s;
+    int blk_num = 0;
+    ss >> blk_num;
+    if (blk_num <= 0)
+        throw std::invalid_argument("Invalid num of blocks.");
+
+    // Read dimensions of each block.
+    dim.resize(blk_num);
+    for (int n = 0; n < blk_num; ++n)
+    {
+        int IMAX = 0, JMAX = 0, KMAX = 0;
+        std::getline(fin, s);
+        ss.clear();
+        ss << s;
+        ss >> IMAX >> JMAX;
+        if (IMAX <= 0)
+            throw std::invalid_argument("Invalid I dimension of Block " + std::to_string(n + 1) + ".");
+        if (JMAX <= 0)
+            throw std::invalid_argument("Invalid J dimension of Block " + std::to_string(n + 1) + ".");
+
+        if (!(ss >> KMAX))
+            KMAX = 0;
+        else if (KMAX <= 0)
+            throw std::invalid_argument("Invalid K dimension of Block " + std::to_string(n + 1) + ".");
+
+        dim[n] = { (size_t)IMAX, (size_t)JMAX, (size_t)KMAX };
     }
 }
 
@@ -30,7 +267,7 @@ namespace GridTool::PLOT3D
 {
     BLK::BLK(size_t nI, size_t nJ, bool is3D) :
         DIM(2, is3D),
-        ArrayND<Vector>(nI, nJ, { 0.0, 0.0, 0.0 })
+        ArrayND<Vector, PLANAR>(nI, nJ, { 0.0, 0.0, 0.0 })
     {
         if (nI == 0)
             throw invalid_dimension_size('I', nI);
@@ -40,7 +277,7 @@ namespace GridTool::PLOT3D
 
     BLK::BLK(size_t nI, size_t nJ, size_t nK) :
         DIM(3),
-        ArrayND<Vector>(nI, nJ, nK, { 0.0, 0.0, 0.0 })
+        ArrayND<Vector, PLANAR>(nI, nJ, nK, { 0.0, 0.0, 0.0 })
     {
         if (nI == 0)
             throw invalid_dimension_size('I', nI);
@@ -106,6 +343,324 @@ namespace GridTool::PLOT3D
         return face_num() - boundary_face_num();
     }
 
+    MAPPED_GRID::VIEW::VIEW(const MAPPED_GRID *grid, const std::array<size_t, 3> &dim, const char *data) :
+        m_grid(grid),
+        m_dim(dim),
+        m_plane{ nullptr, nullptr, nullptr }
+    {
+        const size_t len = node_num() * (grid->single_precision() ? sizeof(float) : sizeof(double));
+        m_plane[0] = data;
+        m_plane[1] = data + len;
+        if (m_dim[2] != 0)
+            m_plane[2] = data + 2 * len;
+    }
+
+    const std::array<size_t, 3> &MAPPED_GRID::VIEW::dimension() const
+    {
+        return m_dim;
+    }
+
+    size_t MAPPED_GRID::VIEW::node_num() const
+    {
+        return m_dim[0] * m_dim[1] * std::max<size_t>(m_dim[2], 1);
+    }
+
+    Vector MAPPED_GRID::VIEW::at(size_t i, size_t j, size_t k) const
+    {
+        const size_t n = i + m_dim[0] * (j + m_dim[1] * k);
+        const size_t len = m_grid->single_precision() ? sizeof(float) : sizeof(double);
+
+        Vector ret(0.0, 0.0, 0.0);
+        for (int c = 0; c < 3; ++c)
+            if (m_plane[c])
+                ret[c] = m_grid->value(m_plane[c] + n * len);
+        return ret;
+    }
+
+    Vector MAPPED_GRID::VIEW::operator()(size_t i, size_t j, size_t k) const
+    {
+        return at(i - 1, j - 1, k - 1);
+    }
+
+    BLK *MAPPED_GRID::VIEW::load() const
+    {
+        BLK *b = allocate_block(m_dim);
+
+        /// Both are stored plane by plane.
+        const size_t N = b->size();
+        const size_t len = m_grid->single_precision() ? sizeof(float) : sizeof(double);
+        for (size_t c = 0; c < 3; ++c)
+        {
+            if (m_plane[c] == nullptr)
+                continue;
+
+            auto dst = b->plane(c);
+            if (!m_grid->single_precision() && !m_grid->byte_swapped())
+                std::memcpy(dst, m_plane[c], N * len);
+            else
+            {
+                for (size_t n = 0; n < N; ++n)
+                    dst[n] = m_grid->value(m_plane[c] + n * len);
+            }
+        }
+
+        return b;
+    }
+
+    MAPPED_GRID::MAPPED_GRID(const std::string &src) :
+        m_file(src),
+        m_format(BINARY),
+        m_single(false),
+        m_swap(false)
+    {
+        if (!detect(UNFORMATTED, false) && !detect(UNFORMATTED, true) && !detect(BINARY, false) && !detect(BINARY, true))
+            throw std::runtime_error("Unrecognized layout of binary PLOT3D grid file: \"" + src + "\".");
+
+        TYDF_PROFILE_COUNT("plot3d.bytes_read", m_file.size());
+    }
+
+    size_t MAPPED_GRID::numOfBlock() const
+    {
+        return m_blk.size();
+    }
+
+    const MAPPED_GRID::VIEW &MAPPED_GRID::block(size_t loc_idx) const
+    {
+        return m_blk.at(loc_idx);
+    }
+
+    int MAPPED_GRID::format() const
+    {
+        return m_format;
+    }
+
+    bool MAPPED_GRID::single_precision() const
+    {
+        return m_single;
+    }
+
+    bool MAPPED_GRID::byte_swapped() const
+    {
+        return m_swap;
+    }
+
+    bool MAPPED_GRID::detect(int format, bool swap)
+    {
+        const char *data = m_file.begin();
+        const size_t N = m_file.size();
+
+        /// Non-negative 4-byte integer at "pos".
+        auto integer = [data, N, swap](size_t pos, size_t &dst)
+        {
+            if (pos + sizeof(int32_t) > N)
+                return false;
+            const auto val = load_value<int32_t>(data + pos, swap);
+            if (val < 0)
+                return false;
+            dst = val;
+            return true;
+        };
+
+        /// Dimensions of each block, starting from "pos".
+        std::vector<std::array<size_t, 3>> dim;
+        auto read_dimension = [&](size_t pos, size_t nBlk, size_t nDim)
+        {
+            dim.assign(nBlk, { 0, 0, 0 });
+            for (size_t n = 0; n < nBlk; ++n)
+                for (size_t r = 0; r < nDim; ++r)
+                    if (!integer(pos + (n * nDim + r) * sizeof(int32_t), dim[n][r]) || dim[n][r] == 0)
+                        return false;
+            return true;
+        };
+        auto plane_num = [](const std::array<size_t, 3> &d)
+        {
+            return d[2] == 0 ? 2 : 3;
+        };
+        auto node_num = [](const std::array<size_t, 3> &d)
+        {
+            return d[0] * d[1] * std::max<size_t>(d[2], 1);
+        };
+
+        bool single = false;
+        std::vector<size_t> offset;
+        if (format == UNFORMATTED)
+        {
+            /// Record of the num of blocks.
+            size_t head = 0, tail = 0, nBlk = 0;
+            if (!integer(0, head) || head != sizeof(int32_t) || !integer(4, nBlk) || !integer(8, tail) || tail != head || nBlk == 0)
+                return false;
+
+            /// Record of dimensions, 2 or 3 values for each block.
+            size_t pos = 12;
+            if (!integer(pos, head) || head == 0 || head % (nBlk * sizeof(int32_t)) != 0)
+                return false;
+            const size_t nDim = head / (nBlk * sizeof(int32_t));
+            if (nDim != 2 && nDim != 3)
+                return false;
+            if (!read_dimension(pos + 4, nBlk, nDim) || !integer(pos + 4 + head, tail) || tail != head)
+                return false;
+            pos += 8 + head;
+
+            /// Record of coordinates of each block.
+            for (size_t n = 0; n < nBlk; ++n)
+            {
+                const size_t cnt = plane_num(dim[n]) * node_num(dim[n]);
+                if (!integer(pos, head))
+                    return false;
+                if (n == 0 && head == cnt * sizeof(float))
+                    single = true;
+                if (head != cnt * (single ? sizeof(float) : sizeof(double)))
+                    return false;
+                if (!integer(pos + 4 + head, tail) || tail != head)
+                    return false;
+                offset.push_back(pos + 4);
+                pos += 8 + head;
+            }
+            if (pos != N)
+                return false;
+        }
+        else
+        {
+            size_t nBlk = 0;
+            if (!integer(0, nBlk) || nBlk == 0 || nBlk > N)
+                return false;
+
+            /// 3D is tried first, and then 2D, the one consistent with the file size wins.
+            bool found = false;
+            for (size_t nDim = 3; nDim >= 2 && !found; --nDim)
+            {
+                const size_t pos = sizeof(int32_t) * (1 + nBlk * nDim);
+                if (pos > N || !read_dimension(sizeof(int32_t), nBlk, nDim))
+                    continue;
+
+                size_t cnt = 0;
+                for (const auto &d : dim)
+                    cnt += plane_num(d) * node_num(d);
+
+                for (size_t len : { sizeof(double), sizeof(float) })
+                {
+                    if (pos + cnt * len == N)
+                    {
+                        single = len == sizeof(float);
+                        found = true;
+
+                        size_t cur = pos;
+                        for (const auto &d : dim)
+                        {
+                            offset.push_back(cur);
+                            cur += plane_num(d) * node_num(d) * len;
+                        }
+                        break;
+                    }
+                }
+            }
+            if (!found)
+                return false;
+        }
+
+        m_format = format;
+        m_single = single;
+        m_swap = swap;
+        m_blk.clear();
+        for (size_t n = 0; n < dim.size(); ++n)
+            m_blk.emplace_back(this, dim[n], data + offset[n]);
+        return true;
+    }
+
+    double MAPPED_GRID::value(const char *p) const
+    {
+        if (m_single)
+            return load_value<float>(p, m_swap);
+        else
+            return load_value<double>(p, m_swap);
+    }
+
+    READER::READER(const std::string &src) :
+        m_fin(src),
+        m_bin(nullptr),
+        m_cnt(0)
+    {
+        // Open input grid file.
+        if (!m_fin)
+            throw std::runtime_error("Failed to read the input grid.");
+
+        // Binary files are mapped as a whole.
+        if (!is_formatted(m_fin))
+        {
+            m_fin.close();
+            m_bin = new MAPPED_GRID(src);
+            for (size_t n = 0; n < m_bin->numOfBlock(); ++n)
+                m_dim.push_back(m_bin->block(n).dimension());
+            return;
+        }
+
+        read_header(m_fin, m_dim);
+    }
+
+    READER::~READER()
+    {
+        delete m_bin;
+    }
+
+    size_t READER::numOfBlock() const
+    {
+        return m_dim.size();
+    }
+
+    const std::array<size_t, 3> &READER::block_dimension(size_t loc_idx) const
+    {
+        return m_dim.at(loc_idx);
+    }
+
+    BLK *READER::next()
+    {
+        if (m_cnt >= m_dim.size())
+            return nullptr;
+
+        TYDF_PROFILE_SCOPE("PLOT3D::READER::next");
+        if (m_bin)
+            return m_bin->block(m_cnt++).load();
+
+        // Allocate new storage.
+        BLK *b = allocate_block(m_dim[m_cnt++]);
+
+        // Read coordinates.
+        /// X, Y and Z (if any) come one plane after another, with "i" varying fastest.
+        const size_t N = b->size();
+        for (size_t c = 0; c < plane_num(*b); ++c)
+        {
+            auto dst = b->plane(c);
+            for (size_t n = 0; n < N; ++n)
+                m_fin >> dst[n];
+        }
+        if (m_fin.fail())
+        {
+            delete b;
+            throw std::runtime_error("Failed to read block " + std::to_string(m_cnt) + " of the input grid.");
+        }
+        TYDF_PROFILE_COUNT("plot3d.tokens_parsed", plane_num(*b) * N);
+
+        return b;
+    }
+
+    bool READER::skip()
+    {
+        if (m_cnt >= m_dim.size())
+            return false;
+
+        const auto &d = m_dim[m_cnt++];
+        if (m_bin)
+            return true;
+
+        const size_t N = d[0] * d[1] * std::max<size_t>(d[2], 1) * (d[2] == 0 ? 2 : 3);
+        double val = 0.0;
+        for (size_t n = 0; n < N; ++n)
+            m_fin >> val;
+        if (m_fin.fail())
+            throw std::runtime_error("Failed to skip block " + std::to_string(m_cnt) + " of the input grid.");
+        return true;
+    }
+
     GRID::GRID() :
         DIM(3),
         m_blk(0)
@@ -127,11 +682,30 @@ namespace GridTool::PLOT3D
             m_blk[i] = new BLK(*rhs.m_blk[i]);
     }
 
+    GRID::GRID(GRID &&rhs) noexcept :
+        DIM(rhs),
+        m_blk(std::move(rhs.m_blk))
+    {
+        rhs.m_blk.clear();
+    }
+
     GRID::~GRID()
     {
         release_all();
     }
 
+    GRID &GRID::operator=(GRID &&rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            release_all();
+            DIM::operator=(rhs);
+            m_blk = std::move(rhs.m_blk);
+            rhs.m_blk.clear();
+        }
+        return *this;
+    }
+
     size_t GRID::numOfBlock() const
     {
         return m_blk.size();
@@ -139,94 +713,52 @@ namespace GridTool::PLOT3D
 
     void GRID::readFromFile(const std::string &src)
     {
-        std::string s;
-        std::stringstream ss;
+        TYDF_PROFILE_SCOPE("PLOT3D::GRID::readFromFile");
 
-        // Open input grid file.
         std::ifstream fin(src);
         if (!fin)
             throw std::runtime_error("Failed to read the input grid.");
 
-        // Read block num.
-        std::getline(fin, s);
-        ss << s;
-        int blk_num = 0;
-        ss >> blk_num;
-        if (blk_num <= 0)
-            throw std::invalid_argument("Invalid num of blocks.");
-
         // Drop previous contents.
         release_all();
 
-        // Read dimensions of each block,and allocate new storage.
-        m_blk.resize(blk_num, nullptr);
-        for (int n = 0; n < blk_num; ++n)
-        {
-            int IMAX = 0, JMAX = 0, KMAX = 0;
-            std::getline(fin, s);
-            ss.clear();
-            ss << s;
-            ss >> IMAX >> JMAX;
-            if (IMAX <= 0)
-                throw std::invalid_argument("Invalid I dimension of Block " + std::to_string(n + 1) + ".");
-            if (JMAX <= 0)
-                throw std::invalid_argument("Invalid J dimension of Block " + std::to_string(n + 1) + ".");
-
-            if (!(ss >> KMAX))
-                m_blk[n] = new BLK((size_t)IMAX, (size_t)JMAX, false);
-            else if (KMAX == 1)
-                m_blk[n] = new BLK((size_t)IMAX, (size_t)JMAX, true);
-            else
-            {
-                if (JMAX <= 0)
-                    throw std::invalid_argument("Invalid K dimension of Block " + std::to_string(n + 1) + ".");
-                else
-                    m_blk[n] = new BLK((size_t)IMAX, (size_t)JMAX, (size_t)KMAX);
-            }
-        }
-
         // Read coordinates of each block.
-        for (auto b : m_blk)
+        /// Blocks are loaded concurrently, binary ones are located by the header,
+        /// while formatted ones are located by a pre-scan of tokens.
+        if (is_formatted(fin))
         {
-            const size_t NX = b->nI(), NY = b->nJ(), NZ = b->nK();
-            if (b->dimension() == 3)
+            std::vector<std::array<size_t, 3>> dim;
+            read_header(fin, dim);
+            const auto pos = static_cast<size_t>(fin.tellg());
+            fin.close();
+
+            VALUE_SEQ<double> seq;
+            m_blk.assign(dim.size(), nullptr);
+            for (size_t n = 0; n < dim.size(); ++n)
             {
-                for (size_t k = 0; k < NZ; ++k)
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            fin >> b->at(i, j, k).x();
-
-                for (size_t k = 0; k < NZ; ++k)
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            fin >> b->at(i, j, k).y();
-
-                for (size_t k = 0; k < NZ; ++k)
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            fin >> b->at(i, j, k).z();
+                m_blk[n] = allocate_block(dim[n]);
+                for (size_t c = 0; c < plane_num(*m_blk[n]); ++c)
+                    seq.append(m_blk[n]->plane(c), m_blk[n]->size());
             }
-            else
-            {
-                for (size_t j = 0; j < NY; ++j)
-                    for (size_t i = 0; i < NX; ++i)
-                        fin >> b->at(i, j).x();
-
-                for (size_t j = 0; j < NY; ++j)
-                    for (size_t i = 0; i < NX; ++i)
-                        fin >> b->at(i, j).y();
 
-                if (b->is3D())
-                {
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            fin >> b->at(i, j).z();
-                }
-            }
+            COMMON::MAPPED_FILE content(src);
+            if (pos > content.size())
+                throw std::runtime_error("Inconsistent size of the input grid.");
+            TYDF_PROFILE_COUNT("plot3d.bytes_read", content.size());
+            read_formatted(content.begin() + pos, content.end(), seq);
         }
+        else
+        {
+            fin.close();
 
-        // Close file.
-        fin.close();
+            MAPPED_GRID content(src);
+            m_blk.assign(content.numOfBlock(), nullptr);
+            COMMON::parallel_for(m_blk.size(), [this, &content](size_t first, size_t last)
+            {
+                for (size_t n = first; n < last; ++n)
+                    m_blk[n] = content.block(n).load();
+            });
+        }
 
         // Update grid global DIM attributes, and check dimension consistency.
         m_is3D = m_blk[0]->is3D();
@@ -239,8 +771,18 @@ namespace GridTool::PLOT3D
         }
     }
 
-    void GRID::writeToFile(const std::string &dst) const
+    void GRID::writeToFile(const std::string &dst, int format, bool single_precision) const
     {
+        TYDF_PROFILE_SCOPE("PLOT3D::GRID::writeToFile");
+
+        if (format == BINARY || format == UNFORMATTED)
+        {
+            write_binary(dst, format == UNFORMATTED, single_precision);
+            return;
+        }
+        else if (format != FORMATTED)
+            throw std::invalid_argument("Invalid PLOT3D file format: " + std::to_string(format) + ".");
+
         // Open output file.
         std::ofstream fout(dst);
         if (!fout)
@@ -260,44 +802,118 @@ namespace GridTool::PLOT3D
         }
 
         // Write coordinates of each block
-        size_t cnt = 0;
+        /// Values are formatted concurrently into per-thread buffers
+        /// in rounds of consecutive chunks, and each round is written in order.
+        static const size_t NumPerChunk = 1 << 16;
+
+        VALUE_SEQ<const double> seq;
         for (auto b : m_blk)
+            for (size_t c = 0; c < plane_num(*b); ++c)
+                seq.append(b->plane(c), b->size());
+
+        const size_t N = seq.size();
+        const size_t nWorker = std::max<size_t>(COMMON::num_of_thread(), 1);
+        std::vector<std::vector<char>> buf(nWorker, std::vector<char>(NumPerChunk * MaxLenOfValue));
+        std::vector<size_t> len(nWorker, 0);
+        for (size_t first = 0; first < N; first += nWorker * NumPerChunk)
         {
-            const size_t NX = b->nI(), NY = b->nJ(), NZ = b->nK();
-            if (b->dimension() == 3)
+            const size_t nChunk = std::min(nWorker, (N - first + NumPerChunk - 1) / NumPerChunk);
+            COMMON::parallel_for(nChunk, [&seq, &buf, &len, first, N](size_t lo, size_t hi)
             {
-                for (size_t k = 0; k < NZ; ++k)
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            formatted_writer(fout, b->at(i, j, k).x(), cnt);
-
-                for (size_t k = 0; k < NZ; ++k)
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            formatted_writer(fout, b->at(i, j, k).y(), cnt);
-
-                for (size_t k = 0; k < NZ; ++k)
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            formatted_writer(fout, b->at(i, j, k).z(), cnt);
-            }
-            else
+                for (size_t t = lo; t < hi; ++t)
+                {
+                    char *p = buf[t].data();
+                    const size_t s = first + t * NumPerChunk;
+                    seq.visit(s, std::min(N, s + NumPerChunk), [&p](size_t g, double val)
+                    {
+                        p = formatted_writer(p, val, g);
+                    });
+                    len[t] = p - buf[t].data();
+                }
+            });
+
+            for (size_t t = 0; t < nChunk; ++t)
             {
-                for (size_t j = 0; j < NY; ++j)
-                    for (size_t i = 0; i < NX; ++i)
-                        formatted_writer(fout, b->at(i, j).x(), cnt);
+                fout.write(buf[t].data(), len[t]);
+                TYDF_PROFILE_COUNT("plot3d.bytes_written", len[t]);
+            }
+        }
 
-                for (size_t j = 0; j < NY; ++j)
-                    for (size_t i = 0; i < NX; ++i)
-                        formatted_writer(fout, b->at(i, j).y(), cnt);
+        // Close file.
+        fout.close();
+    }
+
+    void GRID::write_binary(const std::string &dst, bool marker, bool single_precision) const
+    {
+        // Open output file.
+        std::ofstream fout(dst, std::ios::out | std::ios::binary);
+        if (!fout)
+            throw std::runtime_error("Failed to open the target output grid file.");
+
+        /// Fortran sequential records are enclosed by their length in bytes.
+        auto record_marker = [&fout, marker](size_t len)
+        {
+            if (!marker)
+                return;
+            if (len > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+                throw std::length_error("Record of " + std::to_string(len) + " bytes is too long for unformatted PLOT3D file.");
+            write_value<int32_t>(fout, static_cast<int32_t>(len));
+        };
+
+        // Write num of blocks.
+        record_marker(sizeof(int32_t));
+        write_value<int32_t>(fout, static_cast<int32_t>(numOfBlock()));
+        record_marker(sizeof(int32_t));
+
+        // Write dimensions of each block.
+        const size_t nDim = is3D() ? 3 : 2;
+        record_marker(numOfBlock() * nDim * sizeof(int32_t));
+        for (auto b : m_blk)
+        {
+            write_value<int32_t>(fout, static_cast<int32_t>(b->nI()));
+            write_value<int32_t>(fout, static_cast<int32_t>(b->nJ()));
+            if (nDim == 3)
+                write_value<int32_t>(fout, static_cast<int32_t>(b->nK()));
+        }
+        record_marker(numOfBlock() * nDim * sizeof(int32_t));
+
+        // Write coordinates of each block, X, Y and Z are in 1 record.
+        /// Each record is converted concurrently before being written.
+        static const size_t NumPerChunk = 1 << 16;
+
+        std::vector<char> buf;
+        const size_t len = single_precision ? sizeof(float) : sizeof(double);
+        for (auto b : m_blk)
+        {
+            const size_t N = b->size();
+            buf.resize(nDim * N * len);
 
-                if (b->is3D())
+            COMMON::parallel_for(nDim * N, [&buf, b, N, len, single_precision](size_t first, size_t last)
+            {
+                for (size_t g = first; g < last;)
                 {
-                    for (size_t j = 0; j < NY; ++j)
-                        for (size_t i = 0; i < NX; ++i)
-                            formatted_writer(fout, b->at(i, j).z(), cnt);
+                    const size_t c = g / N, n = g % N;
+                    const size_t cnt = std::min(last - g, N - n);
+                    const double *src = b->plane(c) + n;
+                    char *p = buf.data() + g * len;
+                    if (single_precision)
+                    {
+                        for (size_t m = 0; m < cnt; ++m, p += len)
+                        {
+                            const float v = static_cast<float>(src[m]);
+                            std::memcpy(p, &v, len);
+                        }
+                    }
+                    else
+                        std::memcpy(p, src, cnt * len);
+                    g += cnt;
                 }
-            }
+            }, NumPerChunk);
+
+            record_marker(buf.size());
+            fout.write(buf.data(), buf.size());
+            record_marker(buf.size());
+            TYDF_PROFILE_COUNT("plot3d.bytes_written", buf.size());
         }
 
         // Close file.
@@ -309,6 +925,23 @@ namespace GridTool::PLOT3D
         return m_blk[loc_idx];
     }
 
+    void GRID::append(BLK *blk)
+    {
+        if (blk == nullptr)
+            throw std::invalid_argument("Invalid block to be appended.");
+        if (m_blk.empty())
+        {
+            m_is3D = blk->is3D();
+            m_dim = blk->dimension();
+        }
+        else if (blk->is3D() != is3D())
+        {
+            delete blk;
+            throw std::invalid_argument("Inconsistent dimension of the appended block.");
+        }
+        m_blk.push_back(blk);
+    }
+
     void GRID::release_all()
     {
         for (auto e : m_blk)
@@ -0,0 +1,304 @@
+#include "../inc/nmf.h"
+#include "../inc/xf.h"
+#include <cstdio>
+#include <cmath>
+#include <limits>
+
+/// Num of elements within each chunk of reduction.
+static const size_t ChunkLen = 1 << 14;
+
+/// Loops shorter than this are not worth splitting.
+static const size_t Grain = 4096;
+
+static const double Degree = 180.0 / 3.14159265358979323846;
+
+/// Partial reduction of a chunk.
+struct PARTIAL
+{
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0.0;
+    size_t argmin = 0, argmax = 0; /// 0-based
+};
+
+static std::string format_real(double x)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6e", x);
+    return buf;
+}
+
+namespace GridTool::XF
+{
+    size_t QUALITY::METRIC::worst() const
+    {
+        return lowerIsWorse ? argmin : argmax;
+    }
+
+    QUALITY::QUALITY(const MESH &mesh, size_t nBin) :
+        m_renumbered(mesh.renumbered())
+    {
+        TYDF_PROFILE_SCOPE("XF::QUALITY::QUALITY");
+
+        using GridTool::COMMON::parallel_for;
+
+        if (mesh.numOfCell() == 0 || mesh.numOfFace() == 0)
+            throw std::invalid_argument("Quality of an empty mesh is meaningless.");
+        if (nBin == 0)
+            throw std::invalid_argument("Num of bins must be positive.");
+
+        mesh.derive(MESH::CELL_GEOMETRY);
+        const size_t NC = mesh.numOfCell(), NF = mesh.numOfFace();
+
+        /// Cell-wise
+        const auto &area = mesh.faceArea();
+        const auto &cellFace = mesh.cellIncludedFace();
+        m_value[VOLUME] = mesh.cellVolume();
+        m_value[ASPECT_RATIO].resize(NC);
+        parallel_for(NC, [&](size_t first, size_t last)
+        {
+            auto &dst = m_value[ASPECT_RATIO];
+            for (size_t i = first; i < last; ++i)
+            {
+                double lo = std::numeric_limits<double>::infinity(), hi = 0.0;
+                for (auto f : cellFace.row(i))
+                {
+                    lo = std::min(lo, area[f - 1]);
+                    hi = std::max(hi, area[f - 1]);
+                }
+                dst[i] = hi / lo;
+            }
+        }, Grain);
+
+        /// Face-wise.
+        /// Components are taken plane by plane, so that each face costs a few
+        /// independent multiply-adds besides the gathering of cell centers.
+        const auto &fc = mesh.faceCenter();
+        const auto &fn = mesh.faceNormal();
+        const auto &cc = mesh.cellCenter();
+        const auto &lc = mesh.faceLeftCell();
+        const auto &rc = mesh.faceRightCell();
+        const double *const pfc[3] = { fc.plane(0), fc.plane(1), fc.plane(2) };
+        const double *const pfn[3] = { fn.plane(0), fn.plane(1), fn.plane(2) };
+        const double *const pcc[3] = { cc.plane(0), cc.plane(1), cc.plane(2) };
+        m_value[SKEWNESS].resize(NF);
+        m_value[NON_ORTHOGONALITY].resize(NF);
+        parallel_for(NF, [&](size_t first, size_t last)
+        {
+            auto &skew = m_value[SKEWNESS];
+            auto &angle = m_value[NON_ORTHOGONALITY];
+            for (size_t i = first; i < last; ++i)
+            {
+                const size_t c0 = lc[i], c1 = rc[i];
+
+                double p0[3], d[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    p0[k] = c0 != 0 ? pcc[k][c0 - 1] : pfc[k][i];
+                    d[k] = (c1 != 0 ? pcc[k][c1 - 1] : pfc[k][i]) - p0[k];
+                }
+
+                double dd = 0.0, dn = 0.0, en = 0.0;
+                for (int k = 0; k < 3; ++k)
+                {
+                    dd += d[k] * d[k];
+                    dn += d[k] * pfn[k][i];
+                    en += (pfc[k][i] - p0[k]) * pfn[k][i];
+                }
+                dd = std::sqrt(dd);
+                if (dd == 0.0)
+                {
+                    skew[i] = 0.0;
+                    angle[i] = 90.0;
+                    continue;
+                }
+
+                /// "d" lies in the plane of the face, which is never crossed.
+                if (std::abs(dn) <= std::numeric_limits<double>::epsilon() * dd)
+                {
+                    skew[i] = 1.0;
+                    angle[i] = 90.0;
+                    continue;
+                }
+                angle[i] = std::acos(std::max(-1.0, std::min(1.0, dn / dd))) * Degree;
+
+                /// "p0 + t * d" is where "d" crosses the plane of the face.
+                const double t = en / dn;
+                double e = 0.0;
+                for (int k = 0; k < 3; ++k)
+                {
+                    const double r = pfc[k][i] - (p0[k] + t * d[k]);
+                    e += r * r;
+                }
+                skew[i] = std::sqrt(e) / dd;
+            }
+        }, Grain);
+
+        m_metric[VOLUME].name = "VOLUME";
+        m_metric[ASPECT_RATIO].name = "ASPECT_RATIO";
+        m_metric[SKEWNESS].name = "SKEWNESS";
+        m_metric[NON_ORTHOGONALITY].name = "NON_ORTHOGONALITY";
+        reduce(VOLUME, nBin, false, 0.0, 0.0);
+        reduce(ASPECT_RATIO, nBin, false, 0.0, 0.0);
+        reduce(SKEWNESS, nBin, true, 0.0, 1.0);
+        reduce(NON_ORTHOGONALITY, nBin, true, 0.0, 90.0);
+
+        for (int m = 0; m < NumOfMetric; ++m)
+        {
+            m_metric[m].cellwise = m == VOLUME || m == ASPECT_RATIO;
+            m_metric[m].lowerIsWorse = m == VOLUME;
+            const size_t w = m_metric[m].worst();
+            m_worstCell[m] = m_metric[m].cellwise ? w : (lc[w - 1] != 0 ? lc[w - 1] : rc[w - 1]);
+        }
+    }
+
+    const QUALITY::METRIC &QUALITY::metric(int m) const
+    {
+        return m_metric.at(m);
+    }
+
+    const std::vector<double> &QUALITY::value(int m) const
+    {
+        return m_value.at(m);
+    }
+
+    void QUALITY::reduce(int m, size_t nBin, bool fixed, double lo, double hi)
+    {
+        using GridTool::COMMON::parallel_for;
+
+        const auto &val = m_value[m];
+        const size_t n = val.size();
+        const size_t nChunk = (n + ChunkLen - 1) / ChunkLen;
+
+        /// Min, max and sum of each chunk.
+        std::vector<PARTIAL> part(nChunk);
+        parallel_for(nChunk, [&](size_t first, size_t last)
+        {
+            for (size_t c = first; c < last; ++c)
+            {
+                auto &dst = part[c];
+                for (size_t i = c * ChunkLen; i < std::min(n, (c + 1) * ChunkLen); ++i)
+                {
+                    const double x = val[i];
+                    if (x < dst.min)
+                    {
+                        dst.min = x;
+                        dst.argmin = i;
+                    }
+                    if (x > dst.max)
+                    {
+                        dst.max = x;
+                        dst.argmax = i;
+                    }
+                    dst.sum += x;
+                }
+            }
+        });
+
+        /// Chunks are merged in order, the first one is taken on ties.
+        PARTIAL all;
+        for (const auto &e : part)
+        {
+            if (e.min < all.min)
+            {
+                all.min = e.min;
+                all.argmin = e.argmin;
+            }
+            if (e.max > all.max)
+            {
+                all.max = e.max;
+                all.argmax = e.argmax;
+            }
+            all.sum += e.sum;
+        }
+
+        auto &dst = m_metric[m];
+        dst.min = all.min;
+        dst.max = all.max;
+        dst.mean = all.sum / n;
+        dst.argmin = all.argmin + 1;
+        dst.argmax = all.argmax + 1;
+        dst.lo = fixed ? lo : all.min;
+        dst.hi = fixed ? hi : all.max;
+
+        /// A single bin of all values if the range is degenerate, up to rounding errors.
+        if (dst.hi - dst.lo <= 16 * std::numeric_limits<double>::epsilon() * std::max(std::abs(dst.lo), std::abs(dst.hi)))
+        {
+            dst.hi = dst.lo;
+            dst.histogram.assign(1, n);
+            return;
+        }
+
+        /// Counts of each chunk, then summed up.
+        const double w = nBin / (dst.hi - dst.lo);
+        std::vector<size_t> cnt(nChunk * nBin, 0);
+        parallel_for(nChunk, [&](size_t first, size_t last)
+        {
+            for (size_t c = first; c < last; ++c)
+            {
+                size_t *const h = cnt.data() + c * nBin;
+                for (size_t i = c * ChunkLen; i < std::min(n, (c + 1) * ChunkLen); ++i)
+                {
+                    const double x = (val[i] - dst.lo) * w;
+                    const size_t b = x >= 0.0 ? static_cast<size_t>(std::min(x, static_cast<double>(nBin - 1))) : 0;
+                    ++h[b];
+                }
+            }
+        });
+        dst.histogram.assign(nBin, 0);
+        for (size_t c = 0; c < nChunk; ++c)
+            for (size_t b = 0; b < nBin; ++b)
+                dst.histogram[b] += cnt[c * nBin + b];
+    }
+
+    void QUALITY::report(std::ostream &out) const
+    {
+        out << "Quality of " << m_value[VOLUME].size() << " cells and " << m_value[SKEWNESS].size() << " faces:" << std::endl;
+        for (const auto &e : m_metric)
+        {
+            const std::string elem = e.cellwise ? "cell" : "face";
+            out << "  " << e.name << ": min " << format_real(e.min) << " at " << elem << " " << e.argmin;
+            out << ", max " << format_real(e.max) << " at " << elem << " " << e.argmax;
+            out << ", mean " << format_real(e.mean) << std::endl;
+
+            if (e.hi == e.lo)
+            {
+                out << "    [" << format_real(e.lo) << ", " << format_real(e.lo) << "]: " << e.histogram[0] << std::endl;
+                continue;
+            }
+            const double dx = (e.hi - e.lo) / e.histogram.size();
+            for (size_t b = 0; b < e.histogram.size(); ++b)
+                out << "    [" << format_real(e.lo + b * dx) << ", " << format_real(e.lo + (b + 1) * dx) << "): " << e.histogram[b] << std::endl;
+        }
+    }
+
+    void QUALITY::report(std::ostream &out, const NMF::Mapping3D &nmf) const
+    {
+        if (m_renumbered)
+            throw std::runtime_error("Cells of a renumbered mesh can not be located in blocks.");
+        if (nmf.nCell() != m_value[VOLUME].size())
+            throw std::invalid_argument("Inconsistent num of cells between NMF and MESH.");
+
+        report(out);
+
+        out << "Worst elements in blocks:" << std::endl;
+        for (int m = 0; m < NumOfMetric; ++m)
+        {
+            const auto &e = m_metric[m];
+            size_t b, i, j, k;
+            nmf.locate_cell(m_worstCell[m], b, i, j, k);
+            out << "  " << e.name << ": " << (e.cellwise ? "cell " : "face ") << e.worst() << " in block " << b;
+            if (e.cellwise)
+                out << " at (" << i << ", " << j << ", " << k << ")" << std::endl;
+            else
+            {
+                short f = 1;
+                while (f <= 6 && nmf.block(b).face_index(i, j, k, f) != e.worst())
+                    ++f;
+                if (f > 6)
+                    throw std::runtime_error("Face " + std::to_string(e.worst()) + " is not included by cell " + std::to_string(m_worstCell[m]) + ", the mesh may have been renumbered.");
+                out << " on face " << f << " of cell (" << i << ", " << j << ", " << k << ")" << std::endl;
+            }
+        }
+    }
+}
@@ -1,10 +1,17 @@
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <string>
 #include "../inc/common.h"
 #include "../inc/spacing.h"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define TYDF_HAS_X86_SIMD
+#endif
+
 struct invalid_node_num : public std::invalid_argument
 {
     explicit invalid_node_num(int n) :
@@ -100,10 +107,9 @@ namespace GridTool::SPACING
         }
     }
 
-    void double_exponential(int n, double a1, double a2, double a3, DIST_ARR &dst)
+    /// Exponent of the 2nd segment of "double_exponential".
+    static double double_exponential_a4(double a1, double a2, double a3)
     {
-        uniform(n, dst);
-
         if (std::abs(a2) < 1e-12)
             throw std::invalid_argument("\"a2\" shouldn't be 0.");
 
@@ -131,6 +137,14 @@ namespace GridTool::SPACING
         if (!ok)
             throw std::runtime_error("Newton-Raphson iteration failed to converge.");
 
+        return a4;
+    }
+
+    void double_exponential(int n, double a1, double a2, double a3, DIST_ARR &dst)
+    {
+        uniform(n, dst);
+
+        const double a4 = double_exponential_a4(a1, a2, a3);
         const double ea21 = std::exp(a2) - 1.0;
         const double ea41 = std::exp(a4) - 1.0;
         for (auto &e : dst)
@@ -160,3 +174,325 @@ namespace GridTool::SPACING
             e = 1.0 + std::sinh(c * (e - 1.0)) / sc;
     }
 }
+
+/// Batched "exp(x) - 1" shared by the exponential and hyperbolic distributions.
+/// With "x = k * ln2 + r" and "|r| <= ln2 / 2", "exp(r) - 1" is evaluated by its
+/// Taylor series up to the 13th order without the constant term, "2^k" is assembled
+/// from bits, and the result is "2^k * (exp(r) - 1) + (2^k - 1)", which does not
+/// cancel for small "x".
+/// Arguments are clamped into [-708, 709], where "2^k" is a normal number.
+/// Every instruction set carries out the same operations in the same order,
+/// and FMA is NOT enabled, so that results are bitwise identical.
+namespace GridTool::SPACING
+{
+    static const double ExpMin = -708.0;
+    static const double ExpMax = 709.0;
+    static const double Log2E = 1.44269504088896338700e+00;
+    static const double Ln2Hi = 6.93147180369123816490e-01; /// Low 21 bits are 0, "k * Ln2Hi" is exact.
+    static const double Ln2Lo = 1.90821492927058770002e-10;
+    static const double ExpBias = 1023.0 + 4503599627370496.0; /// Biased exponent in the low bits.
+    static const int ExpOrder = 13;
+    static const double ExpCoef[ExpOrder + 1] = {
+        1.0, 1.0, 1.0 / 2.0, 1.0 / 6.0, 1.0 / 24.0, 1.0 / 120.0, 1.0 / 720.0,
+        1.0 / 5040.0, 1.0 / 40320.0, 1.0 / 362880.0, 1.0 / 3628800.0,
+        1.0 / 39916800.0, 1.0 / 479001600.0, 1.0 / 6227020800.0
+    };
+}
+
+#ifdef TYDF_HAS_X86_SIMD
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#pragma GCC optimize("fp-contract=off")
+namespace GridTool::SPACING::AVX2
+{
+    typedef __m256d V;
+    static const size_t W = 4;
+
+    /// Num of leading values processed is returned.
+    static size_t expm1(size_t n, const double *x, double *y)
+    {
+        const V lo = _mm256_set1_pd(ExpMin), hi = _mm256_set1_pd(ExpMax);
+        const V log2e = _mm256_set1_pd(Log2E), half = _mm256_set1_pd(0.5);
+        const V ln2hi = _mm256_set1_pd(Ln2Hi), ln2lo = _mm256_set1_pd(Ln2Lo);
+        const V bias = _mm256_set1_pd(ExpBias);
+        const V one = _mm256_set1_pd(ExpCoef[0]);
+
+        size_t i = 0;
+        for (; i + W <= n; i += W)
+        {
+            const V a = _mm256_min_pd(_mm256_max_pd(_mm256_loadu_pd(x + i), lo), hi);
+            const V k = _mm256_floor_pd(_mm256_add_pd(_mm256_mul_pd(a, log2e), half));
+            const V r = _mm256_sub_pd(_mm256_sub_pd(a, _mm256_mul_pd(k, ln2hi)), _mm256_mul_pd(k, ln2lo));
+            V p = _mm256_set1_pd(ExpCoef[ExpOrder]);
+            for (int m = ExpOrder - 1; m >= 1; --m)
+                p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(ExpCoef[m]));
+            const __m256i e = _mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(k, bias)), 52);
+            const V t = _mm256_castsi256_pd(e);
+            _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(p, r), t), _mm256_sub_pd(t, one)));
+        }
+        return i;
+    }
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off")
+namespace GridTool::SPACING::AVX512
+{
+    typedef __m512d V;
+    static const size_t W = 8;
+
+    /// Masked forms with all lanes active and the rest zeroed, as the plain ones
+    /// pass an undefined vector through, which is flagged by "-Wmaybe-uninitialized".
+    static const __mmask8 All = 0xFF;
+
+    /// Num of leading values processed is returned.
+    static size_t expm1(size_t n, const double *x, double *y)
+    {
+        const V lo = _mm512_set1_pd(ExpMin), hi = _mm512_set1_pd(ExpMax);
+        const V log2e = _mm512_set1_pd(Log2E), half = _mm512_set1_pd(0.5);
+        const V ln2hi = _mm512_set1_pd(Ln2Hi), ln2lo = _mm512_set1_pd(Ln2Lo);
+        const V bias = _mm512_set1_pd(ExpBias);
+        const V one = _mm512_set1_pd(ExpCoef[0]);
+
+        size_t i = 0;
+        for (; i + W <= n; i += W)
+        {
+            const V a = _mm512_maskz_min_pd(All, _mm512_maskz_max_pd(All, _mm512_loadu_pd(x + i), lo), hi);
+            const V k = _mm512_maskz_roundscale_pd(All, _mm512_add_pd(_mm512_mul_pd(a, log2e), half), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+            const V r = _mm512_sub_pd(_mm512_sub_pd(a, _mm512_mul_pd(k, ln2hi)), _mm512_mul_pd(k, ln2lo));
+            V p = _mm512_set1_pd(ExpCoef[ExpOrder]);
+            for (int m = ExpOrder - 1; m >= 1; --m)
+                p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(ExpCoef[m]));
+            const __m512i e = _mm512_maskz_slli_epi64(All, _mm512_castpd_si512(_mm512_add_pd(k, bias)), 52);
+            const V t = _mm512_castsi512_pd(e);
+            _mm512_storeu_pd(y + i, _mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(p, r), t), _mm512_sub_pd(t, one)));
+        }
+        return i;
+    }
+}
+#pragma GCC pop_options
+#endif
+
+#ifdef __GNUC__
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+namespace GridTool::SPACING
+{
+    /// "y[i] = exp(x[i]) - 1", "x" and "y" may be the same.
+    static void expm1_batch(size_t n, const double *x, double *y)
+    {
+        size_t i = 0;
+#ifdef TYDF_HAS_X86_SIMD
+        const COMMON::SIMD_ISA isa = std::min(COMMON::simd_isa(), COMMON::simd_supported());
+        if (isa == COMMON::AVX512_ISA)
+            i = AVX512::expm1(n, x, y);
+        else if (isa == COMMON::AVX2_ISA)
+            i = AVX2::expm1(n, x, y);
+#endif
+
+        /// Remaining ones
+        for (; i < n; ++i)
+        {
+            const double a = std::min(std::max(x[i], ExpMin), ExpMax);
+            const double k = std::floor(a * Log2E + 0.5);
+            const double r = (a - k * Ln2Hi) - k * Ln2Lo;
+            double p = ExpCoef[ExpOrder];
+            for (int m = ExpOrder - 1; m >= 1; --m)
+                p = p * r + ExpCoef[m];
+
+            const double t = k + ExpBias;
+            uint64_t bits = 0;
+            std::memcpy(&bits, &t, sizeof(bits));
+            bits <<= 52;
+            double s = 0.0;
+            std::memcpy(&s, &bits, sizeof(s));
+            y[i] = p * r * s + (s - ExpCoef[0]);
+        }
+    }
+}
+#ifdef __GNUC__
+#pragma GCC pop_options
+#endif
+
+namespace GridTool::SPACING
+{
+    /// Num of parameters adopted by each kind, see "REQUEST".
+    static int param_num(KIND kind)
+    {
+        static const int cnt[] = { 0, 2, 1, 3, 1, 1 };
+
+        if (kind < UNIFORM || kind > HYPERBOLIC_SINE)
+            throw std::invalid_argument("Invalid kind of distribution: " + std::to_string(kind) + ".");
+        return cnt[kind];
+    }
+
+    /// Fill "req.n" values of "dst".
+    /// Arguments of "exp" are prepared in place, and transformed after a single batched pass.
+    static void evaluate(const REQUEST &req, double *dst)
+    {
+        const int n = req.n;
+        if (n < 2)
+            throw invalid_node_num(n);
+
+        const auto &p = req.param;
+        auto ratio = [n](int i)
+        {
+            return 1.0 * i / (n - 1);
+        };
+
+        switch (req.kind)
+        {
+        case UNIFORM:
+            for (int i = 0; i < n; ++i)
+                dst[i] = ratio(i);
+            return;
+        case CHEBSHEV:
+        {
+            static const double pi = std::acos(-1.0);
+
+            for (int i = 0; i < n; ++i)
+                dst[i] = relaxation(p[0], p[1], 0.5 * (1.0 + std::cos(relaxation(pi, 0.0, ratio(i)))));
+            return;
+        }
+        case SINGLE_EXPONENTIAL:
+        {
+            if (std::abs(p[0]) < 1e-12)
+                throw std::invalid_argument("\"a\" shouldn't be 0.");
+
+            for (int i = 0; i < n; ++i)
+                dst[i] = p[0] * ratio(i);
+            expm1_batch(n, dst, dst);
+            const double t = std::expm1(p[0]);
+            for (int i = 0; i < n; ++i)
+                dst[i] /= t;
+            break;
+        }
+        case DOUBLE_EXPONENTIAL:
+        {
+            const double a1 = p[0], a2 = p[1], a3 = p[2];
+            const double a4 = double_exponential_a4(a1, a2, a3);
+
+            for (int i = 0; i < n; ++i)
+            {
+                const double e = ratio(i);
+                dst[i] = e <= a3 ? a2 / a3 * e : a4 / (1.0 - a3) * (e - a3);
+            }
+            expm1_batch(n, dst, dst);
+            const double ea21 = std::expm1(a2);
+            const double ea41 = std::expm1(a4);
+            for (int i = 0; i < n; ++i)
+                dst[i] = ratio(i) <= a3 ? a1 * dst[i] / ea21 : a1 + (1.0 - a1) * dst[i] / ea41;
+            break;
+        }
+        case HYPERBOLIC_TANGENT:
+        {
+            /// tanh(x) = (exp(2x) - 1) / (exp(2x) - 1 + 2)
+            for (int i = 0; i < n; ++i)
+                dst[i] = 2.0 * (p[0] * (ratio(i) - 1.0));
+            expm1_batch(n, dst, dst);
+            const double tb = std::tanh(p[0]);
+            for (int i = 0; i < n; ++i)
+                dst[i] = 1.0 + dst[i] / (dst[i] + 2.0) / tb;
+            break;
+        }
+        case HYPERBOLIC_SINE:
+        {
+            /// sinh(x) = (exp(x) - 1) * (exp(x) - 1 + 2) / (2 * exp(x)),
+            /// evaluated on "|x|" where nothing cancels, as "x" takes the sign of "-c" throughout.
+            for (int i = 0; i < n; ++i)
+                dst[i] = std::abs(p[0] * (ratio(i) - 1.0));
+            expm1_batch(n, dst, dst);
+            const double sc = p[0] > 0.0 ? -std::sinh(p[0]) : std::sinh(p[0]);
+            for (int i = 0; i < n; ++i)
+                dst[i] = 1.0 + dst[i] * (dst[i] + 2.0) / (2.0 * (dst[i] + 1.0)) / sc;
+            break;
+        }
+        default:
+            throw std::invalid_argument("Invalid kind of distribution: " + std::to_string(req.kind) + ".");
+        }
+
+        /// Both ends are exact, as the non-batched version.
+        dst[0] = 0.0;
+        dst[n - 1] = 1.0;
+    }
+
+    size_t node_num(const REQUEST *req, size_t cnt)
+    {
+        size_t ret = 0;
+        for (size_t i = 0; i < cnt; ++i)
+        {
+            if (req[i].n < 2)
+                throw invalid_node_num(req[i].n);
+            ret += req[i].n;
+        }
+        return ret;
+    }
+
+    void distribute(const REQUEST *req, size_t cnt, double *dst)
+    {
+        for (size_t i = 0; i < cnt; ++i)
+        {
+            evaluate(req[i], dst);
+            dst += req[i].n;
+        }
+    }
+
+    CACHE::KEY CACHE::key(const REQUEST &req)
+    {
+        /// Unused parameters are not distinguished.
+        const int m = param_num(req.kind);
+        return KEY(req.kind, req.n, m > 0 ? req.param[0] : 0.0, m > 1 ? req.param[1] : 0.0, m > 2 ? req.param[2] : 0.0);
+    }
+
+    const DIST_ARR &CACHE::at(const REQUEST &req)
+    {
+        const auto k = key(req);
+        auto it = m_entry.find(k);
+        if (it != m_entry.end())
+        {
+            ++m_hit;
+            return it->second;
+        }
+
+        if (req.n < 2)
+            throw invalid_node_num(req.n);
+        DIST_ARR d(req.n);
+        evaluate(req, d.data());
+        ++m_miss;
+        return m_entry.emplace(k, std::move(d)).first->second;
+    }
+
+    void CACHE::distribute(const REQUEST *req, size_t cnt, double *dst)
+    {
+        for (size_t i = 0; i < cnt; ++i)
+        {
+            const auto &d = at(req[i]);
+            std::copy(d.begin(), d.end(), dst);
+            dst += d.size();
+        }
+    }
+
+    size_t CACHE::size() const
+    {
+        return m_entry.size();
+    }
+
+    size_t CACHE::hit() const
+    {
+        return m_hit;
+    }
+
+    size_t CACHE::miss() const
+    {
+        return m_miss;
+    }
+
+    void CACHE::clear()
+    {
+        m_entry.clear();
+        m_hit = m_miss = 0;
+    }
+}
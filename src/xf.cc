@@ -1,4 +1,9 @@
 #include "../inc/xf.h"
+#include <atomic>
+#include <cstring>
+#include <charconv>
+#include <iterator>
+#include <type_traits>
 
 /// Convert a boundary condition string literal to unified form within the scope of this code.
 /// Outcome will be composed of LOWER case letters and '-' only!
@@ -17,23 +22,424 @@ static std::string formalize(const std::string &s)
     return ret;
 }
 
-static void eat(std::istream &in, char c)
+/// Dump contiguous data of a binary section body in native byte order.
+template<typename T>
+static void write_binary_body(std::ostream &out, const std::vector<T> &buf)
 {
-    char tmp = 0;
-    do {
-        in >> tmp;
-    } while (tmp != c);
+    out.write(reinterpret_cast<const char*>(buf.data()), buf.size() * sizeof(T));
 }
 
-static void skip_white(std::istream &in)
+static void end_binary_section(std::ostream &out, int id)
 {
-    char tmp = 0;
-    do {
-        in >> tmp;
-    } while (tmp == ' ' || tmp == '\t' || tmp == '\n');
+    out << ")End of Binary Section " << std::dec << std::setw(5) << id << ")" << std::endl;
+}
+
+/// Append " v" at "p" in hex, as "std::hex" does.
+template<typename T>
+static char *put_hex(char *p, T v)
+{
+    *p++ = ' ';
+    return std::to_chars(p, p + 24, v, 16).ptr;
+}
+
+/// Append " v" at "p" with 12 significant digits, same as "%.12g".
+static char *put_real(char *p, double v)
+{
+    *p++ = ' ';
+    return std::to_chars(p, p + 32, v, std::chars_format::general, 12).ptr;
+}
+
+static bool is_white(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/// Convert a single token in [first, last) by "std::from_chars".
+template<typename T>
+static void convert(const char *first, const char *last, T &dst, int base)
+{
+    std::from_chars_result ret;
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        if (first != last && *first == '+')
+            ++first;
+        ret = std::from_chars(first, last, dst);
+        (void)base;
+    }
+    else
+        ret = std::from_chars(first, last, dst, base);
+
+    if (ret.ec != std::errc() || ret.ptr != last)
+        throw std::runtime_error("Invalid numerical token: \"" + std::string(first, last) + "\".");
+}
+
+/// Cursor over the content of a grid file.
+class SCANNER
+{
+private:
+    const char *m_cur, *m_end;
+
+public:
+    SCANNER() = delete;
+
+    SCANNER(const char *first, const char *last) :
+        m_cur(first),
+        m_end(last)
+    {
+        /// Empty body.
+    }
+
+    bool eof() const
+    {
+        return m_cur >= m_end;
+    }
+
+    const char *pos() const
+    {
+        return m_cur;
+    }
+
+    void skip_white()
+    {
+        while (m_cur < m_end && is_white(*m_cur))
+            ++m_cur;
+    }
+
+    /// Discard everything until "c" is consumed.
+    void eat(char c)
+    {
+        m_cur = find(c) + 1;
+    }
+
+    /// Location of the next "c", current position is NOT changed.
+    const char *find(char c) const
+    {
+        auto p = static_cast<const char*>(std::memchr(m_cur, c, m_end - m_cur));
+        if (p == nullptr)
+            throw std::runtime_error(std::string("Unexpected end of file when looking for \'") + c + "\'.");
+        return p;
+    }
+
+    /// Character right after current position, NO white-space is skipped.
+    char get()
+    {
+        if (eof())
+            throw std::runtime_error("Unexpected end of file.");
+        return *m_cur++;
+    }
+
+    void seek(const char *p)
+    {
+        m_cur = p;
+    }
+
+    /// Next white-space separated word.
+    std::string word()
+    {
+        skip_white();
+        const char *first = m_cur;
+        while (m_cur < m_end && !is_white(*m_cur))
+            ++m_cur;
+        return std::string(first, m_cur);
+    }
+
+    /// Everything until "c", which is consumed but not included.
+    std::string until(char c)
+    {
+        const char *p = find(c);
+        std::string ret(m_cur, p);
+        m_cur = p + 1;
+        return ret;
+    }
+
+    /// Next number, integers are hexadecimal by default.
+    template<typename T>
+    T number(int base = 16)
+    {
+        skip_white();
+        const char *first = m_cur;
+        while (m_cur < m_end && !is_white(*m_cur) && *m_cur != '(' && *m_cur != ')')
+            ++m_cur;
+        T ret{};
+        convert(first, m_cur, ret, base);
+        return ret;
+    }
+
+    /// Raw data of a binary section body in native byte order.
+    template<typename T>
+    void raw(std::vector<T> &buf)
+    {
+        const size_t nByte = buf.size() * sizeof(T);
+        if (static_cast<size_t>(m_end - m_cur) < nByte)
+            throw std::runtime_error("Unexpected end of file within binary section.");
+        std::memcpy(buf.data(), m_cur, nByte);
+        m_cur += nByte;
+    }
+};
+
+/// Parse exactly "n" white-space separated tokens within [first, last).
+/// "f(token_first, token_last, token_index)" is called for each token.
+/// Large bodies are split into line-aligned chunks processed concurrently,
+/// tokens of each chunk are counted beforehand to locate their global indices.
+template<typename F>
+static void parse_body(const char *first, const char *last, size_t n, const F &f)
+{
+    static const size_t MinChunkSize = 1 << 20; /// In bytes
+
+    const size_t len = last - first;
+    const size_t nChunk = std::max<size_t>(std::min(GridTool::COMMON::num_of_thread(), len / MinChunkSize), 1);
+
+    std::vector<const char*> bnd(nChunk + 1, last);
+    bnd[0] = first;
+    for (size_t k = 1; k < nChunk; ++k)
+    {
+        auto p = std::max(first + len * k / nChunk, bnd[k - 1]);
+        auto q = static_cast<const char*>(std::memchr(p, '\n', last - p));
+        bnd[k] = q ? q + 1 : last;
+    }
+
+    auto tokenize = [&bnd](size_t c, const auto &g)
+    {
+        size_t cnt = 0;
+        const char *p = bnd[c], *e = bnd[c + 1];
+        while (true)
+        {
+            while (p < e && is_white(*p))
+                ++p;
+            if (p == e)
+                break;
+            const char *q = p;
+            while (q < e && !is_white(*q))
+                ++q;
+            g(p, q, cnt++);
+            p = q;
+        }
+        return cnt;
+    };
+
+    std::vector<size_t> offset(nChunk + 1, 0);
+    if (nChunk > 1)
+    {
+        GridTool::COMMON::parallel_for(nChunk, [&](size_t b, size_t e)
+        {
+            for (size_t c = b; c < e; ++c)
+                offset[c + 1] = tokenize(c, [](const char*, const char*, size_t) {});
+        });
+        for (size_t c = 1; c <= nChunk; ++c)
+            offset[c] += offset[c - 1];
+        if (offset[nChunk] != n)
+            throw std::runtime_error("Inconsistent num of records within section body.");
+    }
+
+    std::vector<size_t> cnt(nChunk, 0);
+    GridTool::COMMON::parallel_for(nChunk, [&](size_t b, size_t e)
+    {
+        for (size_t c = b; c < e; ++c)
+        {
+            const size_t base = offset[c];
+            cnt[c] = tokenize(c, [&](const char *tb, const char *te, size_t idx)
+            {
+                idx += base;
+                if (idx >= n)
+                    throw std::runtime_error("Inconsistent num of records within section body.");
+                f(tb, te, idx);
+            });
+        }
+    });
+    if (nChunk == 1 && cnt[0] != n)
+        throw std::runtime_error("Inconsistent num of records within section body.");
+}
+
+/// Counters which may be increased concurrently.
+/// Atomic read-modify-write is avoided if NOT shared among threads.
+class COUNTER
+{
+private:
+    std::vector<std::atomic<size_t>> m_cnt;
+    bool m_shared;
+
+public:
+    COUNTER() = delete;
+
+    COUNTER(size_t n, bool shared) :
+        m_cnt(n),
+        m_shared(shared)
+    {
+        reset();
+    }
+
+    COUNTER(const COUNTER &rhs) = delete;
+
+    ~COUNTER() = default;
+
+    /// Value before increment is returned.
+    size_t increase(size_t i, size_t n = 1)
+    {
+        if (m_shared)
+            return m_cnt[i].fetch_add(n, std::memory_order_relaxed);
+
+        const size_t ret = m_cnt[i].load(std::memory_order_relaxed);
+        m_cnt[i].store(ret + n, std::memory_order_relaxed);
+        return ret;
+    }
+
+    void reset()
+    {
+        for (auto &e : m_cnt)
+            e.store(0, std::memory_order_relaxed);
+    }
+
+    std::vector<size_t> value() const
+    {
+        std::vector<size_t> ret(m_cnt.size());
+        for (size_t i = 0; i < ret.size(); ++i)
+            ret[i] = m_cnt[i].load(std::memory_order_relaxed);
+        return ret;
+    }
+};
+
+/// Loops of derivation shorter than this are not worth splitting.
+static const size_t DeriveGrain = 4096;
+
+/// FACE sections in the order of appearance.
+static std::vector<GridTool::XF::FACE*> face_sections(const std::vector<GridTool::XF::SECTION*> &content)
+{
+    std::vector<GridTool::XF::FACE*> ret;
+    for (auto curPtr : content)
+    {
+        if (curPtr->identity() == GridTool::XF::SECTION::FACE)
+        {
+            auto curObj = dynamic_cast<GridTool::XF::FACE*>(curPtr);
+            if (curObj == nullptr)
+                throw std::runtime_error("Internal error: FACE section can not be identified.");
+            ret.push_back(curObj);
+        }
+    }
+    return ret;
+}
+
+/// Apply "f(section, global_index)" on all faces concurrently.
+template<typename F>
+static void for_each_face(const std::vector<GridTool::XF::FACE*> &faceSect, const F &f)
+{
+    for (auto curObj : faceSect)
+    {
+        const size_t cur_first = curObj->first_index();
+        GridTool::COMMON::parallel_for(curObj->num(), [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+                f(curObj, cur_first + i);
+        }, DeriveGrain);
+    }
+}
+
+/// Rank of each face in the order of appearance, empty if "NF" is 0.
+/// Incidence rows are filled concurrently, and then sorted by this rank,
+/// so the outcome is identical to that of a serial sweep.
+static GridTool::COMMON::IndexArray face_rank(const std::vector<GridTool::XF::FACE*> &faceSect, size_t NF)
+{
+    GridTool::COMMON::IndexArray ret(NF, NF);
+    if (NF == 0)
+        return ret;
+
+    size_t cnt = 0;
+    for (auto curObj : faceSect)
+    {
+        for (size_t i = curObj->first_index(); i <= curObj->last_index(); ++i)
+            ret.set(i - 1, cnt++);
+    }
+    return ret;
+}
+
+static void sort_by_rank(const GridTool::COMMON::IndexArray &faceRank, GridTool::COMMON::CSR &tbl, size_t i, std::vector<size_t> &buf)
+{
+    const auto r = tbl.row(i);
+    buf.assign(r.begin(), r.end());
+    std::sort(buf.begin(), buf.end(), [&faceRank](size_t a, size_t b) { return faceRank[a - 1] < faceRank[b - 1]; });
+    for (size_t k = 0; k < buf.size(); ++k)
+        tbl.set(i, k, buf[k]);
+}
+
+/// Shape declared by all FACE sections if they agree on it and cover all "NF" faces,
+/// otherwise "FACE::MIXED". Records within such sections are all of that shape, as set when loading.
+static int mono_face_type(const std::vector<GridTool::XF::FACE*> &faceSect, size_t NF)
+{
+    using GridTool::XF::FACE;
 
-    if (!in.eof())
-        in.unget();
+    if (faceSect.empty())
+        return FACE::MIXED;
+
+    const int ret = faceSect.front()->face_type();
+    size_t cnt = 0;
+    for (auto curObj : faceSect)
+    {
+        if (curObj->face_type() != ret)
+            return FACE::MIXED;
+        cnt += curObj->num();
+    }
+    return cnt == NF ? ret : FACE::MIXED;
+}
+
+/// Element type declared by all CELL sections if they agree on it and cover all "NC" cells,
+/// otherwise "CELL::MIXED".
+static int mono_cell_type(const std::vector<GridTool::XF::CELL*> &cellSect, size_t NC)
+{
+    using GridTool::XF::CELL;
+
+    if (cellSect.empty())
+        return CELL::MIXED;
+
+    const int ret = cellSect.front()->element_type();
+    size_t cnt = 0;
+    for (auto curObj : cellSect)
+    {
+        if (curObj->element_type() != ret)
+            return CELL::MIXED;
+        cnt += curObj->num();
+    }
+    return cnt == NC ? ret : CELL::MIXED;
+}
+
+/// Position of a point along the 3D Hilbert curve, with "Bits" bits per axis.
+/// Coordinates are converted into the transposed form of the index
+/// (Skilling, 2004), whose bits are then interleaved.
+static uint64_t hilbert_index(uint32_t x[3])
+{
+    static const int Bits = 21;
+    static const uint32_t M = 1u << (Bits - 1);
+
+    /// Inverse undo
+    for (uint32_t q = M; q > 1; q >>= 1)
+    {
+        const uint32_t p = q - 1;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (x[i] & q)
+                x[0] ^= p;
+            else
+            {
+                const uint32_t t = (x[0] ^ x[i]) & p;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+
+    /// Gray encode
+    for (int i = 1; i < 3; ++i)
+        x[i] ^= x[i - 1];
+    uint32_t t = 0;
+    for (uint32_t q = M; q > 1; q >>= 1)
+        if (x[2] & q)
+            t ^= q - 1;
+    for (int i = 0; i < 3; ++i)
+        x[i] ^= t;
+
+    uint64_t ret = 0;
+    for (int b = Bits - 1; b >= 0; --b)
+        for (int i = 0; i < 3; ++i)
+            ret = (ret << 1) | ((x[i] >> b) & 1u);
+    return ret;
 }
 
 namespace GridTool::XF
@@ -49,6 +455,11 @@ namespace GridTool::XF
         return m_identity;
     }
 
+    void SECTION::repr_binary(std::ostream &out)
+    {
+        repr(out);
+    }
+
     bool BC::isValidIdx(int x)
     {
         static const std::set<int> candidate_set{
@@ -319,6 +730,14 @@ namespace GridTool::XF
             return it->second;
     }
 
+    char *NODE::put_record(char *p, const Vector &x, int nd)
+    {
+        for (int k = 0; k < nd; ++k)
+            p = put_real(p, x[k]);
+        *p++ = '\n';
+        return p;
+    }
+
     NODE::NODE(size_t zone, size_t first, size_t last, int tp, int ND) :
         RANGE(SECTION::NODE, zone, first, last),
         DIM(ND, ND == 3),
@@ -329,6 +748,27 @@ namespace GridTool::XF
             throw std::invalid_argument("Invalid description of node type in constructor.");
     }
 
+    NODE::NODE(size_t zone, size_t first, size_t last, int tp, int ND, std::vector<Vector> &&coord) :
+        RANGE(SECTION::NODE, zone, first, last),
+        DIM(ND, ND == 3),
+        std::vector<Vector>(std::move(coord)),
+        m_type(tp)
+    {
+        if (!isValidTypeIdx(type()))
+            throw std::invalid_argument("Invalid description of node type in constructor.");
+        if (size() != num())
+            throw std::invalid_argument("Inconsistent num of nodes in constructor.");
+    }
+
+    NODE::NODE(NODE &&rhs) noexcept :
+        RANGE(rhs),
+        DIM(rhs),
+        std::vector<Vector>(std::move(rhs)),
+        m_type(rhs.m_type)
+    {
+        /// Empty body.
+    }
+
     NODE::NODE(const NODE &rhs) :
         RANGE(SECTION::NODE, rhs.zone(), rhs.first_index(), rhs.last_index()),
         DIM(rhs.ND(), rhs.is3D()),
@@ -375,16 +815,32 @@ namespace GridTool::XF
         out << " (" << std::hex << zone() << " " << first_index() << " " << last_index() << " ";
         out << std::dec << type() << " " << ND() << ")(" << std::endl;
 
-        out.precision(12);
+        COMMON::write_records(out, num(), [this](size_t first, size_t last, std::string &buf)
+        {
+            COMMON::append_records(buf, first, last, RecordWidth, [this](size_t i, char *p)
+            {
+                return put_record(p, at(i), m_dim);
+            });
+        });
+        out << "))" << std::endl;
+    }
+
+    void NODE::repr_binary(std::ostream &out)
+    {
+        out << "(" << std::dec << SECTION::NODE_BIN_DP;
+        out << " (" << std::hex << zone() << " " << first_index() << " " << last_index() << " ";
+        out << std::dec << type() << " " << ND() << ")(";
+
         const size_t N = num();
+        std::vector<double> buf(N * m_dim);
         for (size_t i = 0; i < N; ++i)
         {
             const auto &node = at(i);
             for (int k = 0; k < m_dim; ++k)
-                out << " " << node.at(k);
-            out << std::endl;
+                buf[i * m_dim + k] = node.at(k);
         }
-        out << "))" << std::endl;
+        write_binary_body(out, buf);
+        end_binary_section(out, SECTION::NODE_BIN_DP);
     }
 
     bool CELL::isValidTypeIdx(int x)
@@ -530,6 +986,31 @@ namespace GridTool::XF
             throw invalid_elem_type_idx(elem_type);
     }
 
+    CELL::CELL(size_t zone, size_t first, size_t last, int type, int elem_type, std::vector<int> &&elem) :
+        RANGE(SECTION::CELL, zone, first, last),
+        std::vector<int>(std::move(elem)),
+        m_type(type),
+        m_elem(elem_type)
+    {
+        if (!isValidTypeIdx(type))
+            throw invalid_cell_type_idx(type);
+
+        if (!isValidElemIdx(elem_type))
+            throw invalid_elem_type_idx(elem_type);
+
+        if (size() != num())
+            throw std::invalid_argument("Inconsistent num of cells in constructor.");
+    }
+
+    CELL::CELL(CELL &&rhs) noexcept :
+        RANGE(rhs),
+        std::vector<int>(std::move(rhs)),
+        m_type(rhs.m_type),
+        m_elem(rhs.m_elem)
+    {
+        /// Empty body.
+    }
+
     CELL::CELL(const CELL &rhs) :
         RANGE(SECTION::CELL, rhs.zone(), rhs.first_index(), rhs.last_index()),
         std::vector<int>(rhs.begin(), rhs.end()),
@@ -574,17 +1055,38 @@ namespace GridTool::XF
         else
         {
             out << "(";
-            const size_t N = num();
-            for (size_t i = 0; i < N; ++i)
+            COMMON::write_records(out, num(), [this](size_t first, size_t last, std::string &buf)
             {
-                if (i % NumPerLine == 0)
-                    out << std::endl;
-                out << " " << at(i);
-            }
+                COMMON::append_records(buf, first, last, 1 + 24, [this](size_t i, char *p)
+                {
+                    if (i % NumPerLine == 0)
+                        *p++ = '\n';
+                    return put_hex(p, at(i));
+                });
+            });
             out << std::endl << "))" << std::endl;
         }
     }
 
+    void CELL::repr_binary(std::ostream &out)
+    {
+        /// Nothing to be packed if the shape of cells is not mixed.
+        if (m_elem != CELL::MIXED)
+        {
+            repr(out);
+            return;
+        }
+
+        out << "(" << std::dec << SECTION::CELL_BIN << " (";
+        out << std::hex;
+        out << zone() << " " << first_index() << " " << last_index() << " ";
+        out << m_type << " " << m_elem << ")(";
+
+        const std::vector<int32_t> buf(begin(), end());
+        write_binary_body(out, buf);
+        end_binary_section(out, SECTION::CELL_BIN);
+    }
+
     CONNECTIVITY::CONNECTIVITY() : x(1), n{ 0, 0, 0, 0 }, c{ 0, 0 } {}
 
     size_t CONNECTIVITY::cl() const
@@ -705,6 +1207,18 @@ namespace GridTool::XF
             return it->second;
     }
 
+    char *FACE::put_record(char *p, int x, const size_t *n, size_t c0, size_t c1, bool mixed)
+    {
+        if (mixed)
+            p = put_hex(p, x);
+        for (int j = 0; j < x; ++j)
+            p = put_hex(p, n[j]);
+        p = put_hex(p, c0);
+        p = put_hex(p, c1);
+        *p++ = '\n';
+        return p;
+    }
+
     FACE::FACE(size_t zone, size_t first, size_t last, int bc, int face) :
         RANGE(SECTION::FACE, zone, first, last),
         std::vector<CONNECTIVITY>(num()),
@@ -720,6 +1234,33 @@ namespace GridTool::XF
             throw FACE::polygon_not_supported();
     }
 
+    FACE::FACE(size_t zone, size_t first, size_t last, int bc, int face, std::vector<CONNECTIVITY> &&cnect) :
+        RANGE(SECTION::FACE, zone, first, last),
+        std::vector<CONNECTIVITY>(std::move(cnect)),
+        m_bc(bc),
+        m_face(face)
+    {
+        if (!BC::isValidIdx(bc))
+            throw BC::invalid_bc_idx(bc);
+
+        if (!isValidIdx(face))
+            throw invalid_face_type_idx(face);
+        if (face == POLYGONAL)
+            throw FACE::polygon_not_supported();
+
+        if (size() != num())
+            throw std::invalid_argument("Inconsistent num of faces in constructor.");
+    }
+
+    FACE::FACE(FACE &&rhs) noexcept :
+        RANGE(rhs),
+        std::vector<CONNECTIVITY>(std::move(rhs)),
+        m_bc(rhs.m_bc),
+        m_face(rhs.m_face)
+    {
+        /// Empty body.
+    }
+
     FACE::FACE(const FACE &rhs) :
         RANGE(SECTION::FACE, rhs.zone(), rhs.first_index(), rhs.last_index()),
         std::vector<CONNECTIVITY>(rhs.begin(), rhs.end()),
@@ -762,30 +1303,39 @@ namespace GridTool::XF
         out << zone() << " " << first_index() << " " << last_index() << " ";
         out << bc_type() << " " << face_type() << ")(" << std::endl;
 
-        const size_t N = num();
-        if (m_face == MIXED)
+        /// Num of nodes is given at the beginning of each record for mixed faces.
+        const bool mixed = m_face == MIXED;
+        COMMON::write_records(out, num(), [this, mixed](size_t first, size_t last, std::string &buf)
         {
-            for (size_t i = 0; i < N; ++i)
+            COMMON::append_records(buf, first, last, RecordWidth, [this, mixed](size_t i, char *p)
             {
                 const auto &loc_cnect = at(i);
-                out << " " << loc_cnect.x;
-                for (int j = 0; j < loc_cnect.x; ++j)
-                    out << " " << loc_cnect.n[j];
-                out << " " << loc_cnect.c[0] << " " << loc_cnect.c[1] << std::endl;
-            }
-        }
-        else
+                return put_record(p, loc_cnect.x, loc_cnect.n, loc_cnect.c[0], loc_cnect.c[1], mixed);
+            });
+        });
+        out << "))" << std::endl;
+    }
+
+    void FACE::repr_binary(std::ostream &out)
+    {
+        out << "(" << std::dec << SECTION::FACE_BIN << " (";
+        out << std::hex;
+        out << zone() << " " << first_index() << " " << last_index() << " ";
+        out << bc_type() << " " << face_type() << ")(";
+
+        std::vector<int32_t> buf;
+        buf.reserve(num() * (m_face == MIXED ? 7 : m_face + 2));
+        for (const auto &loc_cnect : *this)
         {
-            for (size_t i = 0; i < N; ++i)
-            {
-                const auto &loc_cnect = at(i);
-                for (int j = 0; j < loc_cnect.x; ++j)
-                    out << " " << loc_cnect.n[j];
-                out << " " << loc_cnect.c[0] << " " << loc_cnect.c[1] << std::endl;
-            }
+            if (m_face == MIXED)
+                buf.push_back(loc_cnect.x);
+            for (int j = 0; j < loc_cnect.x; ++j)
+                buf.push_back(static_cast<int32_t>(loc_cnect.n[j]));
+            buf.push_back(static_cast<int32_t>(loc_cnect.c[0]));
+            buf.push_back(static_cast<int32_t>(loc_cnect.c[1]));
         }
-
-        out << "))" << std::endl;
+        write_binary_body(out, buf);
+        end_binary_section(out, SECTION::FACE_BIN);
     }
 
     bool ZONE::isValidIdx(int x)
@@ -959,19 +1509,35 @@ namespace GridTool::XF
         m_totalNodeNum(0),
         m_totalCellNum(0),
         m_totalFaceNum(0),
-        m_totalZoneNum(0)
+        m_totalZoneNum(0),
+        m_derived(0),
+        m_renumbered(false)
     {
         /// Empty body.
     }
 
-    MESH::MESH(const std::string &inp, std::ostream &fout) :
+    MESH::MESH(const std::string &inp, std::ostream &fout, int derived) :
         DIM(3), /// 3D by default, may be modified when input mesh is loaded.
         m_totalNodeNum(0),
         m_totalCellNum(0),
         m_totalFaceNum(0),
-        m_totalZoneNum(0)
+        m_totalZoneNum(0),
+        m_derived(0),
+        m_renumbered(false)
+    {
+        readFromFile(inp, fout, derived);
+    }
+
+    MESH::MESH(MESH &&rhs) noexcept :
+        DIM(rhs),
+        m_totalNodeNum(0),
+        m_totalCellNum(0),
+        m_totalFaceNum(0),
+        m_totalZoneNum(0),
+        m_derived(0),
+        m_renumbered(false)
     {
-        readFromFile(inp, fout);
+        steal(rhs);
     }
 
     MESH::~MESH()
@@ -979,6 +1545,17 @@ namespace GridTool::XF
         clear_entry();
     }
 
+    MESH &MESH::operator=(MESH &&rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            clear_entry();
+            DIM::operator=(rhs);
+            steal(rhs);
+        }
+        return *this;
+    }
+
     size_t MESH::numOfNode() const
     {
         return m_totalNodeNum;
@@ -999,34 +1576,208 @@ namespace GridTool::XF
         return m_totalZoneNum;
     }
 
-    const MESH::NODE_ELEM &MESH::node(size_t id) const
+    MESH::NODE_ELEM MESH::node(size_t id) const
     {
-        return m_node((int)id);
+        if (id == 0 || id > numOfNode())
+            throw wrong_index(id, "is not a valid node index");
+
+        derive(NODE_ADJACENCY);
+        const size_t i = id - 1;
+        return NODE_ELEM{ m_nodeCoordinate.at(i), m_nodeAtBdry[i] != 0, m_nodeAdjacentNode.row(i), m_nodeDependentFace.row(i), m_nodeDependentCell.row(i) };
     }
 
-    MESH::NODE_ELEM &MESH::node(size_t id)
+    MESH::FACE_ELEM MESH::face(size_t id) const
     {
-        return m_node((int)id);
+        if (id == 0 || id > numOfFace())
+            throw wrong_index(id, "is not a valid face index");
+
+        derive(FACE_GEOMETRY);
+        const size_t i = id - 1;
+        Vector n_RL = m_faceNormal.at(i);
+        n_RL *= -1.0;
+        return FACE_ELEM{ m_faceType[i], m_faceCenter.at(i), m_faceArea[i], m_faceAtBdry[i] != 0, m_faceIncludedNode.row(i), m_faceLeftCell[i], m_faceRightCell[i], m_faceNormal.at(i), n_RL };
     }
 
-    const MESH::FACE_ELEM &MESH::face(size_t id) const
+    MESH::FACE_SHAPE MESH::face_shape(size_t id) const
     {
-        return m_face((int)id);
+        if (id == 0 || id > numOfFace())
+            throw wrong_index(id, "is not a valid face index");
+
+        const size_t i = id - 1;
+        return FACE_SHAPE{ m_faceType[i], m_faceIncludedNode.row(i) };
     }
 
-    MESH::FACE_ELEM &MESH::face(size_t id)
+    MESH::CELL_ELEM MESH::cell(size_t id) const
     {
-        return m_face((int)id);
+        if (id == 0 || id > numOfCell())
+            throw wrong_index(id, "is not a valid cell index");
+
+        derive(CELL_GEOMETRY);
+        const size_t i = id - 1;
+        const CSR::ROW adj(m_cellAdjacentCell, m_cellIncludedFace.offset(i), m_cellIncludedFace.offset(i + 1));
+        return CELL_ELEM{ m_cellType[i], m_cellCenter.at(i), m_cellVolume[i], m_cellIncludedNode.row(i), m_cellIncludedFace.row(i), adj, NORMAL_ROW(this, id, false), NORMAL_ROW(this, id, true) };
+    }
+
+    MESH::NORMAL_ROW::NORMAL_ROW(const MESH *mesh, size_t cell, bool weighted) :
+        m_mesh(mesh),
+        m_cell(cell),
+        m_weighted(weighted)
+    {
+        /// Empty body.
+    }
+
+    size_t MESH::NORMAL_ROW::size() const
+    {
+        return m_mesh->m_cellIncludedFace.length(m_cell - 1);
+    }
+
+    Vector MESH::NORMAL_ROW::at(size_t j) const
+    {
+        if (j >= size())
+            throw std::out_of_range("Index " + std::to_string(j) + " is out of range of the row.");
+        return (*this)[j];
+    }
+
+    Vector MESH::NORMAL_ROW::operator[](size_t j) const
+    {
+        const size_t f_idx = m_mesh->m_cellIncludedFace.at(m_cell - 1, j) - 1;
+        const double a = m_weighted ? m_mesh->m_faceArea[f_idx] : 1.0;
+
+        Vector ret(0.0, 0.0, 0.0);
+        const auto n = m_mesh->m_faceNormal.at(f_idx);
+        const double sgn = m_mesh->m_faceLeftCell[f_idx] == m_cell ? 1.0 : -1.0;
+        for (int k = 1; k <= m_mesh->dimension(); ++k)
+            ret(k) = m_weighted ? a * (sgn * n(k)) : sgn * n(k);
+        return ret;
+    }
+
+    Vector MESH::NORMAL_ROW::operator()(int j) const
+    {
+        if (j >= 1)
+            return at(j - 1);
+        else if (j <= -1)
+            return at(size() + j);
+        else
+            throw wrong_index(0, "is invalid when using 1-based index");
+    }
+
+    const COMMON::VectorArray &MESH::nodeCoordinate() const
+    {
+        derive(0);
+        return m_nodeCoordinate;
+    }
+
+    const CSR &MESH::nodeAdjacentNode() const
+    {
+        derive(NODE_ADJACENCY);
+        return m_nodeAdjacentNode;
+    }
+
+    const CSR &MESH::nodeDependentFace() const
+    {
+        derive(NODE_ADJACENCY);
+        return m_nodeDependentFace;
     }
 
-    const MESH::CELL_ELEM &MESH::cell(size_t id) const
+    const CSR &MESH::nodeDependentCell() const
     {
-        return m_cell((int)id);
+        derive(NODE_ADJACENCY);
+        return m_nodeDependentCell;
     }
 
-    MESH::CELL_ELEM &MESH::cell(size_t id)
+    const COMMON::VectorArray &MESH::faceCenter() const
     {
-        return m_cell((int)id);
+        derive(FACE_GEOMETRY);
+        return m_faceCenter;
+    }
+
+    const std::vector<double> &MESH::faceArea() const
+    {
+        derive(FACE_GEOMETRY);
+        return m_faceArea;
+    }
+
+    const COMMON::VectorArray &MESH::faceNormal() const
+    {
+        derive(FACE_GEOMETRY);
+        return m_faceNormal;
+    }
+
+    const CSR &MESH::faceIncludedNode() const
+    {
+        derive(0);
+        return m_faceIncludedNode;
+    }
+
+    const IndexArray &MESH::faceLeftCell() const
+    {
+        derive(0);
+        return m_faceLeftCell;
+    }
+
+    const IndexArray &MESH::faceRightCell() const
+    {
+        derive(0);
+        return m_faceRightCell;
+    }
+
+    const COMMON::VectorArray &MESH::cellCenter() const
+    {
+        derive(CELL_GEOMETRY);
+        return m_cellCenter;
+    }
+
+    const std::vector<double> &MESH::cellVolume() const
+    {
+        derive(CELL_GEOMETRY);
+        return m_cellVolume;
+    }
+
+    const CSR &MESH::cellIncludedNode() const
+    {
+        derive(CELL_ADJACENCY);
+        return m_cellIncludedNode;
+    }
+
+    const CSR &MESH::cellIncludedFace() const
+    {
+        derive(CELL_ADJACENCY);
+        return m_cellIncludedFace;
+    }
+
+    const IndexArray &MESH::cellAdjacentCell() const
+    {
+        derive(CELL_ADJACENCY);
+        return m_cellAdjacentCell;
+    }
+
+    size_t MESH::derived_bytes() const
+    {
+        size_t ret = 0;
+
+        ret += m_nodeCoordinate.bytes();
+        ret += m_nodeAtBdry.size() * sizeof(char);
+        ret += m_nodeAdjacentNode.bytes();
+        ret += m_nodeDependentFace.bytes();
+        ret += m_nodeDependentCell.bytes();
+
+        ret += m_faceType.size() * sizeof(int);
+        ret += m_faceCenter.bytes();
+        ret += m_faceArea.size() * sizeof(double);
+        ret += m_faceAtBdry.size() * sizeof(char);
+        ret += m_faceIncludedNode.bytes();
+        ret += m_faceLeftCell.bytes();
+        ret += m_faceRightCell.bytes();
+        ret += m_faceNormal.bytes();
+
+        ret += m_cellType.size() * sizeof(int);
+        ret += m_cellCenter.bytes();
+        ret += m_cellVolume.size() * sizeof(double);
+        ret += m_cellIncludedNode.bytes();
+        ret += m_cellIncludedFace.bytes();
+        ret += m_cellAdjacentCell.bytes();
+
+        return ret;
     }
 
     const MESH::ZONE_ELEM &MESH::zone(size_t id, bool isRealZoneID) const
@@ -1051,43 +1802,105 @@ namespace GridTool::XF
             return m_zone((int)id);
     }
 
-    void MESH::raw2derived()
+    void MESH::derive(int features) const
     {
-        /************************* Allocate storage ***************************/
-        m_node.resize(numOfNode());
-        m_face.resize(numOfFace());
-        m_cell.resize(numOfCell());
+        if (features & CELL_GEOMETRY)
+            features |= FACE_GEOMETRY | CELL_ADJACENCY;
+        features |= PRIMARY;
+        if ((m_derived.load(std::memory_order_acquire) & features) == features)
+            return;
+
+        TYDF_PROFILE_SCOPE("XF::MESH::derive");
 
-        /************************ Set initial values **************************/
-        for (auto &e : m_node)
+        std::lock_guard<std::mutex> guard(m_deriveLock);
+        const int todo = features & ~m_derived.load(std::memory_order_relaxed);
+
+        /// Stages in the order of dependency.
+        /// Each is marked once done, so that earlier ones are kept on failure.
+        auto stage = [this, todo](int flag, void (MESH::*f)() const)
         {
-            e.coordinate.z() = 0.0;
-            e.atBdry = false;
-            e.adjacentNode.clear();
-            e.dependentFace.clear();
-            e.dependentCell.clear();
-        }
+            if (todo & flag)
+            {
+                (this->*f)();
+                m_derived.fetch_or(flag, std::memory_order_release);
+            }
+        };
+        stage(PRIMARY, &MESH::derive_primary);
+        stage(NODE_ADJACENCY, &MESH::derive_node_adjacency);
+        stage(CELL_ADJACENCY, &MESH::derive_cell_adjacency);
+        stage(FACE_GEOMETRY, &MESH::derive_face_geometry);
+        stage(CELL_GEOMETRY, &MESH::derive_cell_geometry);
+        TYDF_PROFILE_COUNT("xf.alloc_bytes", derived_bytes());
+    }
+
+    int MESH::derived() const
+    {
+        return m_derived.load(std::memory_order_acquire) & ALL_DERIVED;
+    }
+
+    void MESH::clear_derived()
+    {
+        std::lock_guard<std::mutex> guard(m_deriveLock);
+        m_derived.store(0, std::memory_order_release);
+
+        m_nodeCoordinate.clear();
+        std::vector<char>().swap(m_nodeAtBdry);
+        m_nodeAdjacentNode.clear();
+        m_nodeDependentFace.clear();
+        m_nodeDependentCell.clear();
+
+        std::vector<int>().swap(m_faceType);
+        m_faceCenter.clear();
+        std::vector<double>().swap(m_faceArea);
+        std::vector<char>().swap(m_faceAtBdry);
+        m_faceIncludedNode.clear();
+        m_faceLeftCell.clear();
+        m_faceRightCell.clear();
+        m_faceNormal.clear();
+
+        std::vector<int>().swap(m_cellType);
+        m_cellCenter.clear();
+        std::vector<double>().swap(m_cellVolume);
+        m_cellIncludedNode.clear();
+        m_cellIncludedFace.clear();
+        m_cellAdjacentCell.clear();
+    }
+
+    void MESH::derive_primary() const
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::derive_primary");
 
-        for (auto &e : m_face)
+        using GridTool::COMMON::parallel_for;
+
+        const size_t NN = numOfNode(), NF = numOfFace(), NC = numOfCell();
+
+        /************************* Allocate storage ***************************/
+        m_nodeCoordinate.assign(NN);
+        m_nodeAtBdry.assign(NN, false);
+
+        m_faceType.assign(NF, 0);
+        m_faceAtBdry.assign(NF, false);
+        m_faceLeftCell.allocate(NF, NC);
+        m_faceRightCell.allocate(NF, NC);
+
+        m_cellType.assign(NC, 0);
+
+        auto check_node = [NN](size_t n)
         {
-            e.center.z() = 0.0;
-            e.includedNode.clear();
-            e.n_LR.z() = 0.0;
-            e.n_RL.z() = 0.0;
-        }
+            if (n == 0 || n > NN)
+                throw std::out_of_range("Node index " + std::to_string(n) + " is out of range.");
+        };
 
-        for (auto &e : m_cell)
+        auto check_cell = [NC](size_t c)
         {
-            e.center.z() = 0.0;
-            e.includedFace.clear();
-            e.includedNode.clear();
-            e.adjacentCell.clear();
-            e.n.clear();
-            e.S.clear();
-        }
+            if (c > NC)
+                throw std::out_of_range("Cell index " + std::to_string(c) + " is out of range.");
+        };
 
-        /************************* Parse node and face ************************/
-        /// Basic records
+        /// Sections in the order of appearance.
+        std::vector<NODE*> nodeSect;
+        std::vector<FACE*> faceSect;
+        std::vector<CELL*> cellSect;
         for (auto curPtr : m_content)
         {
             if (curPtr->identity() == SECTION::NODE)
@@ -1095,168 +1908,323 @@ namespace GridTool::XF
                 auto curObj = dynamic_cast<NODE*>(curPtr);
                 if (curObj == nullptr)
                     throw internal_error(-1);
+                check_node(curObj->first_index());
+                check_node(curObj->last_index());
+                nodeSect.push_back(curObj);
+            }
+            else if (curPtr->identity() == SECTION::FACE)
+            {
+                auto curObj = dynamic_cast<FACE*>(curPtr);
+                if (curObj == nullptr)
+                    throw internal_error(-2);
+                if (curObj->first_index() == 0 || curObj->last_index() > NF)
+                    throw std::out_of_range("Face index out of range in zone " + std::to_string(curObj->zone()) + ".");
+                faceSect.push_back(curObj);
+            }
+            else if (curPtr->identity() == SECTION::CELL)
+            {
+                auto curObj = dynamic_cast<CELL*>(curPtr);
+                if (curObj == nullptr)
+                    throw internal_error(-4);
+                if (curObj->first_index() == 0 || curObj->last_index() > NC)
+                    throw std::out_of_range("Cell index out of range in zone " + std::to_string(curObj->zone()) + ".");
+                cellSect.push_back(curObj);
+            }
+        }
 
-                /// Node type within this zone
-                const bool flag = curObj->is_boundary_node();
+        /************************* Parse node and face ************************/
+        /// Basic records
+        for (auto curObj : nodeSect)
+        {
+            /// Node type within this zone
+            const bool flag = curObj->is_boundary_node();
 
-                /// 1-based global node index
-                const size_t cur_first = curObj->first_index();
-                const size_t cur_last = curObj->last_index();
-                for (size_t i = cur_first; i <= cur_last; ++i)
+            /// 1-based global node index
+            const size_t cur_first = curObj->first_index();
+            parallel_for(curObj->num(), [&](size_t first, size_t last)
+            {
+                for (size_t i = first; i < last; ++i)
                 {
                     /// Node Coordinates
-                    node(i).coordinate = curObj->at(i - cur_first);
+                    m_nodeCoordinate.set(cur_first + i - 1, curObj->at(i));
 
                     /// Node on boundary or not
-                    node(i).atBdry = flag;
+                    m_nodeAtBdry[cur_first + i - 1] = flag;
                 }
-            }
+            }, DeriveGrain);
+        }
 
-            if (curPtr->identity() == SECTION::FACE)
+        /// Num of nodes within each face.
+        /// Faces of a single declared shape are of fixed length, nothing to be counted or checked.
+        const int mono = mono_face_type(faceSect, NF);
+        if (mono != FACE::MIXED)
+            m_faceIncludedNode.allocate(NF, mono, NN);
+        else
+        {
+            std::vector<size_t> faceNodeCnt(NF, 0);
+            for_each_face(faceSect, [&](const FACE *curObj, size_t i)
             {
-                auto curObj = dynamic_cast<FACE*>(curPtr);
-                if (curObj == nullptr)
-                    throw internal_error(-2);
+                const auto &cnct = curObj->at(i - curObj->first_index());
+                faceNodeCnt[i - 1] = cnct.x;
+            });
+            m_faceIncludedNode.allocate(faceNodeCnt, NN);
+        }
 
-                /// 1-based global face index
-                const size_t cur_first = curObj->first_index();
-                const size_t cur_last = curObj->last_index();
+        for_each_face(faceSect, [&](const FACE *curObj, size_t i)
+        {
+            const auto &cnct = curObj->at(i - curObj->first_index());
+            const size_t loc_idx = i - 1;
+
+            /// Face type of this zone
+            const int ft = curObj->face_type();
+
+            /// Check consistency of face-type
+            if (mono != FACE::MIXED)
+                m_faceType[loc_idx] = mono;
+            else if (ft == 0)
+                m_faceType[loc_idx] = cnct.x;
+            else if (cnct.x != ft)
+                throw internal_error("local face shape is inconsistent with global specification");
+            else
+                m_faceType[loc_idx] = ft;
 
-                /// Face type of this zone
-                const int ft = curObj->face_type();
+            /// Nodes within this face.
+            /// 1-based node index are stored.
+            /// Right-hand convention is preserved.
+            for (int j = 0; j < cnct.x; ++j)
+            {
+                check_node(cnct.n[j]);
+                m_faceIncludedNode.set(loc_idx, j, cnct.n[j]);
+            }
 
-                for (size_t i = cur_first; i <= cur_last; ++i)
-                {
-                    const auto &cnct = curObj->at(i - cur_first);
+            /// Adjacent cells.
+            /// 1-based cell index are stored, 0 stands for boundary.
+            /// Right-hand convention is preserved.
+            const size_t lc = cnct.cl(), rc = cnct.cr();
+            check_cell(lc);
+            check_cell(rc);
+            m_faceLeftCell.set(loc_idx, lc);
+            m_faceRightCell.set(loc_idx, rc);
 
-                    /// Check consistency of face-type
-                    if (ft == 0)
-                        face(i).type = cnct.x;
-                    else if (cnct.x != ft)
-                        throw internal_error("local face shape is inconsistent with global specification");
-                    else
-                        face(i).type = ft;
+            /// Face on boundary or not
+            m_faceAtBdry[loc_idx] = (cnct.c0() == 0 || cnct.c1() == 0);
+        });
+
+        /*********************** Parse records of cell ************************/
+        for (auto curObj : cellSect)
+        {
+            const size_t cur_first = curObj->first_index();
+            const size_t cur_last = curObj->last_index();
+            for (size_t i = cur_first; i <= cur_last; ++i)
+                m_cellType[i - 1] = curObj->at(i - cur_first);
+        }
+    }
 
-                    /// Nodes within this face.
-                    /// 1-based node index are stored.
-                    /// Right-hand convention is preserved.
-                    face(i).includedNode.assign(cnct.n, cnct.n + cnct.x);
+    void MESH::derive_node_adjacency() const
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::derive_node_adjacency");
 
-                    /// Adjacent cells.
-                    /// 1-based cell index are stored, 0 stands for boundary.
-                    /// Right-hand convention is preserved.
-                    const size_t lc = cnct.cl(), rc = cnct.cr();
-                    face(i).leftCell = lc;
-                    face(i).rightCell = rc;
-                    if (lc != 0)
-                        cell(lc).includedFace.push_back(i);
-                    if (rc != 0)
-                        cell(rc).includedFace.push_back(i);
-
-                    /// Face on boundary or not
-                    face(i).atBdry = (cnct.c0() == 0 || cnct.c1() == 0);
-
-                    /// Face area, center and unit normal vectors
-                    if (cnct.x == FACE::LINEAR)
-                    {
-                        const size_t na = cnct.n[0], nb = cnct.n[1];
-                        const auto &p1 = node(na).coordinate;
-                        const auto &p2 = node(nb).coordinate;
+        using GridTool::COMMON::parallel_for;
 
-                        face(i).area = GridTool::COMMON::line_length(p1, p2);
-                        GridTool::COMMON::line_center(p1, p2, face(i).center);
-                        GridTool::COMMON::line_normal(p1, p2, face(i).n_LR, face(i).n_RL);
-                    }
-                    else if (cnct.x == FACE::TRIANGULAR)
-                    {
-                        const size_t na = cnct.n[0], nb = cnct.n[1], nc = cnct.n[2];
-                        const auto &p1 = node(na).coordinate;
-                        const auto &p2 = node(nb).coordinate;
-                        const auto &p3 = node(nc).coordinate;
-
-                        face(i).area = GridTool::COMMON::triangle_area(p1, p2, p3);
-                        GridTool::COMMON::triangle_center(p1, p2, p3, face(i).center);
-                        GridTool::COMMON::triangle_normal(p1, p2, p3, face(i).n_LR, face(i).n_RL);
-                    }
-                    else if (cnct.x == FACE::QUADRILATERAL)
-                    {
-                        const size_t na = cnct.n[0], nb = cnct.n[1], nc = cnct.n[2], nd = cnct.n[3];
-                        const auto &p1 = node(na).coordinate;
-                        const auto &p2 = node(nb).coordinate;
-                        const auto &p3 = node(nc).coordinate;
-                        const auto &p4 = node(nd).coordinate;
-
-                        face(i).area = GridTool::COMMON::quadrilateral_area(p1, p2, p3, p4);
-                        GridTool::COMMON::quadrilateral_center(p1, p2, p3, p4, face(i).center);
-                        GridTool::COMMON::quadrilateral_normal(p1, p2, p3, p4, face(i).n_LR, face(i).n_RL);
-                    }
-                    else if (cnct.x == FACE::POLYGONAL)
-                        throw FACE::polygon_not_supported();
-                    else
-                        throw internal_error("face shape not recognized");
-                }
-            }
-        }
+        const size_t NN = numOfNode(), NF = numOfFace(), NC = numOfCell();
+        const auto faceSect = face_sections(m_content);
+
+        /// Nothing to be sorted if running serially.
+        const bool concurrent = GridTool::COMMON::num_of_thread() > 1;
+        const auto faceRank = face_rank(faceSect, concurrent ? NF : 0);
 
         /// Adjacent nodes, dependent faces, and dependent cells of each node.
         /// Step1: Count all occurance
-        for (auto curPtr : m_content)
+        COUNTER adjNodeCnt(NN, concurrent), depFaceCnt(NN, concurrent), depCellCnt(NN, concurrent);
+        for_each_face(faceSect, [&](const FACE *curObj, size_t i)
         {
-            if (curPtr->identity() == SECTION::FACE)
+            const auto &cnct = curObj->at(i - curObj->first_index());
+            const size_t nc = (cnct.cl() != 0) + (cnct.cr() != 0);
+            for (int j = 0; j < cnct.x; ++j)
             {
-                auto curObj = dynamic_cast<FACE*>(curPtr);
-                if (curObj == nullptr)
-                    throw internal_error(-3);
+                const size_t loc_idx = cnct.n[j] - 1;
+                adjNodeCnt.increase(loc_idx, cnct.x > 2 ? 2 : 1);
+                depFaceCnt.increase(loc_idx);
+                depCellCnt.increase(loc_idx, nc);
+            }
+        });
+
+        /// Step2: Record all occurance
+        CSR adjNode, depCell;
+        adjNode.allocate(adjNodeCnt.value(), NN);
+        m_nodeDependentFace.allocate(depFaceCnt.value(), NF);
+        depCell.allocate(depCellCnt.value(), NC);
+        adjNodeCnt.reset();
+        depFaceCnt.reset();
+        depCellCnt.reset();
+        for_each_face(faceSect, [&](const FACE *curObj, size_t i)
+        {
+            const auto &cnct = curObj->at(i - curObj->first_index());
+            const size_t loc_leftCell = cnct.cl();
+            const size_t loc_rightCell = cnct.cr();
 
-                /// 1-based index
-                const size_t cur_first = curObj->first_index();
-                const size_t cur_last = curObj->last_index();
+            for (int j = 0; j < cnct.x; ++j)
+            {
+                const size_t loc_idx = cnct.n[j] - 1;
 
-                for (size_t i = cur_first; i <= cur_last; ++i)
-                {
-                    const auto &cnct = curObj->at(i - cur_first);
-                    const size_t loc_leftCell = cnct.cl();
-                    const size_t loc_rightCell = cnct.cr();
+                /// Adjacent nodes
+                adjNode.set(loc_idx, adjNodeCnt.increase(loc_idx), cnct.leftAdj(j));
+                if (cnct.x > 2)
+                    adjNode.set(loc_idx, adjNodeCnt.increase(loc_idx), cnct.rightAdj(j));
 
-                    for (int j = 0; j < cnct.x; ++j)
-                    {
-                        const size_t idx_ = cnct.n[j];
-                        auto &curNode = node(idx_);
+                /// Dependent faces
+                m_nodeDependentFace.set(loc_idx, depFaceCnt.increase(loc_idx), i);
 
-                        const size_t loc_leftNode = cnct.leftAdj(j);
-                        const size_t loc_rightNode = cnct.rightAdj(j);
+                /// Dependent cells
+                if (loc_leftCell != 0)
+                    depCell.set(loc_idx, depCellCnt.increase(loc_idx), loc_leftCell);
+                if (loc_rightCell != 0)
+                    depCell.set(loc_idx, depCellCnt.increase(loc_idx), loc_rightCell);
+            }
+        });
+        if (concurrent)
+        {
+            parallel_for(NN, [&](size_t first, size_t last)
+            {
+                std::vector<size_t> buf;
+                for (size_t i = first; i < last; ++i)
+                    sort_by_rank(faceRank, m_nodeDependentFace, i, buf);
+            }, DeriveGrain);
+        }
 
-                        /// Adjacent nodes
-                        curNode.adjacentNode.push_back(loc_leftNode);
-                        if (cnct.x > 2)
-                            curNode.adjacentNode.push_back(loc_rightNode);
+        /// Step3: Remove duplication
+        auto deduplicate = [NN](const CSR &src, size_t maxVal, CSR &dst)
+        {
+            std::vector<size_t> cnt(NN, 0);
+            parallel_for(NN, [&](size_t first, size_t last)
+            {
+                std::vector<size_t> buf;
+                for (size_t i = first; i < last; ++i)
+                {
+                    const auto r = src.row(i);
+                    buf.assign(r.begin(), r.end());
+                    std::sort(buf.begin(), buf.end());
+                    cnt[i] = std::unique(buf.begin(), buf.end()) - buf.begin();
+                }
+            }, DeriveGrain);
+            dst.allocate(cnt, maxVal);
+            parallel_for(NN, [&](size_t first, size_t last)
+            {
+                std::vector<size_t> buf;
+                for (size_t i = first; i < last; ++i)
+                {
+                    const auto r = src.row(i);
+                    buf.assign(r.begin(), r.end());
+                    std::sort(buf.begin(), buf.end());
+                    std::unique(buf.begin(), buf.end());
+                    for (size_t k = 0; k < cnt[i]; ++k)
+                        dst.set(i, k, buf[k]);
+                }
+            }, DeriveGrain);
+        };
+        deduplicate(adjNode, NN, m_nodeAdjacentNode);
+        adjNode.clear();
+        deduplicate(depCell, NC, m_nodeDependentCell);
+        depCell.clear();
+    }
+
+    template<int T>
+    void MESH::derive_cell_adjacency() const
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::derive_cell_adjacency<T>");
 
-                        /// Dependent faces
-                        curNode.dependentFace.push_back(i);
+        using GridTool::COMMON::parallel_for;
 
-                        /// Dependent cells
-                        if (loc_leftCell != 0)
-                            curNode.dependentCell.push_back(loc_leftCell);
-                        if (loc_rightCell != 0)
-                            curNode.dependentCell.push_back(loc_rightCell);
-                    }
+        const size_t NN = numOfNode(), NC = numOfCell();
+        m_cellIncludedNode.allocate(NC, CELL_SHAPE<T>::NumOfNode, NN);
+        m_cellAdjacentCell.allocate(m_cellIncludedFace.nnz(), NC);
+
+        parallel_for(NC, [&](size_t first, size_t last)
+        {
+            SHAPE_RECORD<T> curCell;
+            for (size_t loc_idx = first; loc_idx < last; ++loc_idx)
+            {
+                const size_t i = loc_idx + 1;
+                const size_t pos = m_cellIncludedFace.offset(loc_idx);
+                const size_t nf = m_cellIncludedFace.length(loc_idx);
+                if (nf != CELL_SHAPE<T>::NumOfFace)
+                    throw std::runtime_error(R"(Mismatch between cell type ")" + CELL::idx2str_elem(T) + R"(" and num of faces: )" + std::to_string(nf));
+                for (size_t j = 0; j < CELL_SHAPE<T>::NumOfFace; ++j)
+                    curCell.includedFace[j] = m_cellIncludedFace.at(loc_idx, j);
+
+                /// Organize order of included nodes and faces
+                if constexpr (T == CELL::HEXAHEDRAL)
+                    hex_standardization(curCell);
+                else
+                    quad_standardization(curCell);
+                for (size_t j = 0; j < CELL_SHAPE<T>::NumOfFace; ++j)
+                    m_cellIncludedFace.set(loc_idx, j, curCell.includedFace[j]);
+                for (size_t j = 0; j < CELL_SHAPE<T>::NumOfNode; ++j)
+                    m_cellIncludedNode.set(loc_idx, j, curCell.includedNode[j]);
+
+                /// Adjacent cells.
+                for (size_t j = 0; j < CELL_SHAPE<T>::NumOfFace; ++j)
+                {
+                    const size_t f_idx = curCell.includedFace[j] - 1;
+                    const auto c0 = m_faceLeftCell[f_idx], c1 = m_faceRightCell[f_idx];
+                    if (c0 == i)
+                        m_cellAdjacentCell.set(pos + j, c1);
+                    else if (c1 == i)
+                        m_cellAdjacentCell.set(pos + j, c0);
+                    else
+                        throw internal_error(-5);
                 }
             }
-        }
+        }, DeriveGrain);
+    }
 
-        /// Step2: Remove duplication
-        for (size_t i = 1; i <= numOfNode(); ++i)
-        {
-            auto &curNode = node(i);
+    void MESH::derive_cell_adjacency() const
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::derive_cell_adjacency");
+
+        using GridTool::COMMON::parallel_for;
+
+        const size_t NN = numOfNode(), NF = numOfFace(), NC = numOfCell();
+        const auto faceSect = face_sections(m_content);
 
-            const std::set<size_t> st1(curNode.adjacentNode.begin(), curNode.adjacentNode.end());
-            curNode.adjacentNode.assign(st1.begin(), st1.end());
+        /// Nothing to be sorted if running serially.
+        const bool concurrent = GridTool::COMMON::num_of_thread() > 1;
+        const auto faceRank = face_rank(faceSect, concurrent ? NF : 0);
 
-            const std::set<size_t> st2(curNode.dependentCell.begin(), curNode.dependentCell.end());
-            curNode.dependentCell.assign(st2.begin(), st2.end());
+        /// Faces of each cell, in the order of appearance.
+        COUNTER cellFaceCnt(NC, concurrent);
+        parallel_for(NF, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                const size_t lc = m_faceLeftCell[i], rc = m_faceRightCell[i];
+                if (lc != 0)
+                    cellFaceCnt.increase(lc - 1);
+                if (rc != 0)
+                    cellFaceCnt.increase(rc - 1);
+            }
+        }, DeriveGrain);
+        m_cellIncludedFace.allocate(cellFaceCnt.value(), NF);
+        cellFaceCnt.reset();
+        for_each_face(faceSect, [&](const FACE *, size_t i)
+        {
+            const size_t lc = m_faceLeftCell[i - 1], rc = m_faceRightCell[i - 1];
+            if (lc != 0)
+                m_cellIncludedFace.set(lc - 1, cellFaceCnt.increase(lc - 1), i);
+            if (rc != 0)
+                m_cellIncludedFace.set(rc - 1, cellFaceCnt.increase(rc - 1), i);
+        });
+        if (concurrent)
+        {
+            parallel_for(NC, [&](size_t first, size_t last)
+            {
+                std::vector<size_t> buf;
+                for (size_t i = first; i < last; ++i)
+                    sort_by_rank(faceRank, m_cellIncludedFace, i, buf);
+            }, DeriveGrain);
         }
 
-        /*********************** Parse records of cell ************************/
+        std::vector<CELL*> cellSect;
         for (auto curPtr : m_content)
         {
             if (curPtr->identity() == SECTION::CELL)
@@ -1264,73 +2232,80 @@ namespace GridTool::XF
                 auto curObj = dynamic_cast<CELL*>(curPtr);
                 if (curObj == nullptr)
                     throw internal_error(-4);
+                cellSect.push_back(curObj);
+            }
+        }
+
+        /// Cells of a single declared shape, whose faces are of the corresponding one.
+        const int mono = mono_cell_type(cellSect, NC);
+        const int faceMono = mono_face_type(faceSect, NF);
+        if (mono == CELL::HEXAHEDRAL && faceMono == CELL_SHAPE<CELL::HEXAHEDRAL>::FaceType)
+        {
+            derive_cell_adjacency<CELL::HEXAHEDRAL>();
+            return;
+        }
+        if (mono == CELL::QUADRILATERAL && faceMono == CELL_SHAPE<CELL::QUADRILATERAL>::FaceType)
+        {
+            derive_cell_adjacency<CELL::QUADRILATERAL>();
+            return;
+        }
+
+        /// Num of nodes within each cell.
+        std::vector<size_t> cellNodeCnt(NC, 0);
+        for (auto curObj : cellSect)
+        {
+            for (size_t i = curObj->first_index(); i <= curObj->last_index(); ++i)
+                cellNodeCnt[i - 1] = cell_node_num(m_cellType[i - 1]);
+        }
+        m_cellIncludedNode.allocate(cellNodeCnt, NN);
+        m_cellAdjacentCell.allocate(m_cellIncludedFace.nnz(), NC);
+        std::vector<size_t>().swap(cellNodeCnt);
 
-                /// 1-based global face index
-                const size_t cur_first = curObj->first_index();
-                const size_t cur_last = curObj->last_index();
+        for (auto curObj : cellSect)
+        {
+            /// 1-based global cell index
+            const size_t cur_first = curObj->first_index();
 
-                for (size_t i = cur_first; i <= cur_last; ++i)
+            parallel_for(curObj->num(), [&](size_t first, size_t last)
+            {
+                CELL_RECORD curCell;
+                for (size_t i = cur_first + first; i < cur_first + last; ++i)
                 {
-                    auto &curCell = cell(i);
+                    const size_t loc_idx = i - 1;
 
                     /// Element type of cells in this zone
-                    curCell.type = curObj->at(i - cur_first);
+                    curCell.type = m_cellType[loc_idx];
+                    const auto cf = m_cellIncludedFace.row(loc_idx);
+                    curCell.includedFace.assign(cf.begin(), cf.end());
+                    curCell.includedNode.clear();
 
                     /// Organize order of included nodes and faces
                     cell_standardization(curCell);
+                    for (size_t j = 0; j < curCell.includedFace.size(); ++j)
+                        m_cellIncludedFace.set(loc_idx, j, curCell.includedFace[j]);
+                    for (size_t j = 0; j < curCell.includedNode.size(); ++j)
+                        m_cellIncludedNode.set(loc_idx, j, curCell.includedNode[j]);
 
-                    /// Adjacent cells and normal
-                    /// Allocate storage.
-                    curCell.adjacentCell.resize(curCell.includedFace.size());
-                    curCell.n.resize(curCell.includedFace.size());
-                    curCell.S.resize(curCell.includedFace.size());
-
+                    /// Adjacent cells.
+                    const size_t pos = m_cellIncludedFace.offset(loc_idx);
                     for (size_t j = 0; j < curCell.includedFace.size(); ++j)
                     {
-                        const size_t f_idx = curCell.includedFace[j];
-                        const auto &f = face(f_idx);
-                        const auto c0 = f.leftCell, c1 = f.rightCell;
+                        const size_t f_idx = curCell.includedFace[j] - 1;
+                        const auto c0 = m_faceLeftCell[f_idx], c1 = m_faceRightCell[f_idx];
                         if (c0 == i)
-                        {
-                            curCell.adjacentCell[j] = c1;
-                            curCell.n[j] = f.n_LR;
-                        }
+                            m_cellAdjacentCell.set(pos + j, c1);
                         else if (c1 == i)
-                        {
-                            curCell.adjacentCell[j] = c0;
-                            curCell.n[j] = f.n_RL;
-                        }
+                            m_cellAdjacentCell.set(pos + j, c0);
                         else
                             throw internal_error(-5);
-
-                        for (int k = 1; k <= dimension(); ++k)
-                            curCell.S[j](k) = f.area * curCell.n[j](k);
-                    }
-
-                    /// Volume and Centroid.
-                    /// Based on the divergence theorem. See (5.15) and (5.17) of Jiri Blazek's CFD book.
-                    curCell.volume = 0.0;
-                    curCell.center.x() = 0.0; curCell.center.y() = 0.0; curCell.center.z() = 0.0;
-                    for (size_t j = 0; j < curCell.includedFace.size(); ++j)
-                    {
-                        const auto cfi = curCell.includedFace.at(j);
-                        const auto &cf = face(cfi);
-                        const auto &cf_c = cf.center;
-                        const auto &cf_S = curCell.S.at(j);
-                        const auto w = cf_c.dot(cf_S);
-                        curCell.volume += w;
-                        for (int k = 1; k <= dimension(); ++k)
-                            curCell.center(k) += w * cf_c(k);
                     }
-                    curCell.volume /= dimension();
-                    const double cde = (1.0 + dimension()) * curCell.volume;
-                    for (int k = 1; k <= dimension(); ++k)
-                        curCell.center(k) /= cde;
                 }
-            }
+            }, DeriveGrain);
         }
+    }
 
-        /*********************** Parse records of zone ************************/
+    void MESH::derive_zone()
+    {
         m_totalZoneNum = 0;
         m_zoneMapping.clear();
         for (auto curPtr : m_content) // Determine the total num of zones.
@@ -1371,6 +2346,681 @@ namespace GridTool::XF
         }
     }
 
+    void MESH::derive_face_geometry() const
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::derive_face_geometry");
+
+        using GridTool::COMMON::parallel_for;
+
+        /// Num of faces handled by each call of batched geometry kernels.
+        static const size_t Batch = 512;
+
+        const size_t NF = numOfFace();
+        m_faceCenter.assign(NF);
+        m_faceArea.assign(NF, 0.0);
+        m_faceNormal.assign(NF);
+
+        /// Face area, center and unit normal vectors.
+        /// Zones of triangles or quadrilaterals are handled in batch.
+        const double *const nodeCoord[3] = { m_nodeCoordinate.plane(0), m_nodeCoordinate.plane(1), m_nodeCoordinate.plane(2) };
+        for (auto curObj : face_sections(m_content))
+        {
+            const size_t cur_first = curObj->first_index();
+            const int ft = curObj->face_type();
+            parallel_for(curObj->num(), [&](size_t first, size_t last)
+            {
+                if (ft == FACE::TRIANGULAR || ft == FACE::QUADRILATERAL)
+                {
+                    std::vector<size_t> node;
+                    for (size_t i = first; i < last; i += Batch)
+                    {
+                        const size_t loc_first = cur_first + i - 1;
+                        const size_t n = std::min(Batch, last - i);
+
+                        node.resize(n * ft);
+                        for (size_t j = 0; j < n; ++j)
+                            for (int r = 0; r < ft; ++r)
+                                node[j * ft + r] = m_faceIncludedNode.at(loc_first + j, r) - 1;
+
+                        double *const rc[3] = { m_faceCenter.plane(0) + loc_first, m_faceCenter.plane(1) + loc_first, m_faceCenter.plane(2) + loc_first };
+                        double *const n_LR[3] = { m_faceNormal.plane(0) + loc_first, m_faceNormal.plane(1) + loc_first, m_faceNormal.plane(2) + loc_first };
+                        if (ft == FACE::TRIANGULAR)
+                            GridTool::COMMON::triangle_geometry(n, nodeCoord, node.data(), m_faceArea.data() + loc_first, rc, n_LR);
+                        else
+                            GridTool::COMMON::quadrilateral_geometry(n, nodeCoord, node.data(), m_faceArea.data() + loc_first, rc, n_LR);
+                    }
+                    return;
+                }
+
+                for (size_t i = first; i < last; ++i)
+                {
+                    const size_t loc_idx = cur_first + i - 1;
+                    const auto &cnct = curObj->at(i);
+
+                    Vector center, n_LR, n_RL;
+                    if (cnct.x == FACE::LINEAR)
+                    {
+                        const auto p1 = m_nodeCoordinate.at(cnct.n[0] - 1);
+                        const auto p2 = m_nodeCoordinate.at(cnct.n[1] - 1);
+
+                        m_faceArea[loc_idx] = GridTool::COMMON::line_length(p1, p2);
+                        GridTool::COMMON::line_center(p1, p2, center);
+                        GridTool::COMMON::line_normal(p1, p2, n_LR, n_RL);
+                    }
+                    else if (cnct.x == FACE::TRIANGULAR)
+                    {
+                        const auto p1 = m_nodeCoordinate.at(cnct.n[0] - 1);
+                        const auto p2 = m_nodeCoordinate.at(cnct.n[1] - 1);
+                        const auto p3 = m_nodeCoordinate.at(cnct.n[2] - 1);
+
+                        m_faceArea[loc_idx] = GridTool::COMMON::triangle_area(p1, p2, p3);
+                        GridTool::COMMON::triangle_center(p1, p2, p3, center);
+                        GridTool::COMMON::triangle_normal(p1, p2, p3, n_LR, n_RL);
+                    }
+                    else if (cnct.x == FACE::QUADRILATERAL)
+                    {
+                        const auto p1 = m_nodeCoordinate.at(cnct.n[0] - 1);
+                        const auto p2 = m_nodeCoordinate.at(cnct.n[1] - 1);
+                        const auto p3 = m_nodeCoordinate.at(cnct.n[2] - 1);
+                        const auto p4 = m_nodeCoordinate.at(cnct.n[3] - 1);
+
+                        m_faceArea[loc_idx] = GridTool::COMMON::quadrilateral_area(p1, p2, p3, p4);
+                        GridTool::COMMON::quadrilateral_center(p1, p2, p3, p4, center);
+                        GridTool::COMMON::quadrilateral_normal(p1, p2, p3, p4, n_LR, n_RL);
+                    }
+                    else if (cnct.x == FACE::POLYGONAL)
+                        throw FACE::polygon_not_supported();
+                    else
+                        throw internal_error("face shape not recognized");
+
+                    m_faceCenter.set(loc_idx, center);
+                    m_faceNormal.set(loc_idx, n_LR);
+                }
+            }, DeriveGrain);
+        }
+    }
+
+    void MESH::derive_cell_geometry() const
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::derive_cell_geometry");
+
+        using GridTool::COMMON::parallel_for;
+
+        const size_t NC = numOfCell();
+        m_cellCenter.assign(NC);
+        m_cellVolume.assign(NC, 0.0);
+
+        /// Volume and centroid of each cell, based on the divergence theorem.
+        /// See (5.15) and (5.17) of Jiri Blazek's CFD book.
+        parallel_for(NC, [&](size_t first, size_t last)
+        {
+            for (size_t loc_idx = first; loc_idx < last; ++loc_idx)
+            {
+                const size_t i = loc_idx + 1;
+                const auto cf = m_cellIncludedFace.row(loc_idx);
+
+                double volume = 0.0;
+                Vector center(0.0, 0.0, 0.0);
+                for (auto f : cf)
+                {
+                    const size_t f_idx = f - 1;
+                    Vector n = m_faceNormal.at(f_idx);
+                    if (m_faceLeftCell[f_idx] != i)
+                        n *= -1.0;
+
+                    Vector cf_S(0.0, 0.0, 0.0);
+                    for (int k = 1; k <= dimension(); ++k)
+                        cf_S(k) = m_faceArea[f_idx] * n(k);
+
+                    const auto cf_c = m_faceCenter.at(f_idx);
+                    const auto w = cf_c.dot(cf_S);
+                    volume += w;
+                    for (int k = 1; k <= dimension(); ++k)
+                        center(k) += w * cf_c(k);
+                }
+                volume /= dimension();
+                const double cde = (1.0 + dimension()) * volume;
+                for (int k = 1; k <= dimension(); ++k)
+                    center(k) /= cde;
+
+                m_cellVolume[loc_idx] = volume;
+                m_cellCenter.set(loc_idx, center);
+            }
+        }, DeriveGrain);
+    }
+
+    size_t MESH::bandwidth() const
+    {
+        derive(0);
+        size_t ret = 0;
+        for (size_t i = 0; i < numOfFace(); ++i)
+        {
+            const size_t lc = m_faceLeftCell[i], rc = m_faceRightCell[i];
+            if (lc != 0 && rc != 0)
+                ret = std::max(ret, lc > rc ? lc - rc : rc - lc);
+        }
+        return ret;
+    }
+
+    bool MESH::renumbered() const
+    {
+        return m_renumbered;
+    }
+
+    size_t MESH::renumber(int ordering, std::ostream &fout)
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::renumber");
+
+        const size_t NN = numOfNode(), NC = numOfCell();
+        if (NC == 0)
+            throw std::runtime_error("Invalid num of cells.");
+
+        /// Features available beforehand are re-computed afterwards, others are left on demand.
+        const int features = derived();
+        derive(ordering == HILBERT ? CELL_GEOMETRY : CELL_ADJACENCY);
+
+        /// Neighbours of cell "c" through interior faces, all 0-based.
+        auto for_each_neighbour = [this](size_t c, const auto &f)
+        {
+            for (auto e : m_cellIncludedFace.row(c))
+            {
+                const size_t lc = m_faceLeftCell[e - 1], rc = m_faceRightCell[e - 1];
+                const size_t adj = lc == c + 1 ? rc : lc;
+                if (adj != 0 && adj != c + 1)
+                    f(adj - 1);
+            }
+        };
+
+        /// Rank of each cell in the target order.
+        std::vector<size_t> rank(NC, 0);
+        if (ordering == RCM)
+        {
+            std::vector<size_t> deg(NC, 0);
+            for (size_t c = 0; c < NC; ++c)
+                for_each_neighbour(c, [&deg, c](size_t) { ++deg[c]; });
+
+            /// Breadth-first search from "s" within its component, which is not visited yet.
+            /// Returns the num of levels, "last" is the deepest level.
+            std::vector<size_t> mark(NC, 0);
+            size_t stamp = 0;
+            std::vector<size_t> cur, nxt, last;
+            auto level_structure = [&](size_t s)
+            {
+                ++stamp;
+                cur.assign(1, s);
+                mark[s] = stamp;
+                size_t nLevel = 0;
+                while (!cur.empty())
+                {
+                    ++nLevel;
+                    last.swap(cur);
+                    cur.clear();
+                    for (auto c : last)
+                        for_each_neighbour(c, [&](size_t adj)
+                        {
+                            if (mark[adj] != stamp)
+                            {
+                                mark[adj] = stamp;
+                                cur.push_back(adj);
+                            }
+                        });
+                }
+                return nLevel;
+            };
+
+            /// Each component starts from a pseudo-peripheral cell (George and Liu, 1979),
+            /// neighbours are appended in ascending order of degree.
+            std::vector<char> visited(NC, false);
+            std::vector<size_t> order, buf;
+            order.reserve(NC);
+            for (size_t c0 = 0; c0 < NC; ++c0)
+            {
+                if (visited[c0])
+                    continue;
+
+                size_t s = c0;
+                size_t ecc = level_structure(s);
+                for (int iter = 0; iter < 8; ++iter)
+                {
+                    const size_t x = *std::min_element(last.begin(), last.end(), [&deg](size_t a, size_t b) { return deg[a] < deg[b] || (deg[a] == deg[b] && a < b); });
+                    const size_t e = level_structure(x);
+                    if (e <= ecc)
+                        break;
+                    s = x;
+                    ecc = e;
+                }
+
+                size_t head = order.size();
+                order.push_back(s);
+                visited[s] = true;
+                for (; head < order.size(); ++head)
+                {
+                    buf.clear();
+                    for_each_neighbour(order[head], [&](size_t adj)
+                    {
+                        if (!visited[adj])
+                        {
+                            visited[adj] = true;
+                            buf.push_back(adj);
+                        }
+                    });
+                    std::sort(buf.begin(), buf.end(), [&deg](size_t a, size_t b) { return deg[a] < deg[b] || (deg[a] == deg[b] && a < b); });
+                    order.insert(order.end(), buf.begin(), buf.end());
+                }
+            }
+            for (size_t k = 0; k < NC; ++k)
+                rank[order[k]] = NC - 1 - k;
+        }
+        else if (ordering == HILBERT)
+        {
+            /// Cell centers are quantized within their bounding box.
+            Vector lo = m_cellCenter.at(0), hi = lo;
+            for (size_t c = 1; c < NC; ++c)
+            {
+                const auto p = m_cellCenter.at(c);
+                for (int k = 0; k < 3; ++k)
+                {
+                    lo[k] = std::min(lo[k], p[k]);
+                    hi[k] = std::max(hi[k], p[k]);
+                }
+            }
+            const double L = std::max({ hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2], std::numeric_limits<double>::min() });
+            const double scale = ((1u << 21) - 1) / L;
+
+            std::vector<uint64_t> key(NC);
+            COMMON::parallel_for(NC, [&](size_t first, size_t last)
+            {
+                for (size_t c = first; c < last; ++c)
+                {
+                    const auto p = m_cellCenter.at(c);
+                    uint32_t x[3];
+                    for (int k = 0; k < 3; ++k)
+                        x[k] = static_cast<uint32_t>((p[k] - lo[k]) * scale);
+                    key[c] = hilbert_index(x);
+                }
+            }, 4096);
+
+            std::vector<size_t> order(NC);
+            for (size_t c = 0; c < NC; ++c)
+                order[c] = c;
+            std::stable_sort(order.begin(), order.end(), [&key](size_t a, size_t b) { return key[a] < key[b]; });
+            for (size_t k = 0; k < NC; ++k)
+                rank[order[k]] = k;
+        }
+        else
+            throw std::invalid_argument("Invalid ordering of renumbering: " + std::to_string(ordering) + ".");
+
+        const size_t bw0 = bandwidth();
+
+        /// Elements are reordered within their own sections.
+        /// "seq" holds 1-based indices of a section sorted by "less", and
+        /// "dst[old - 1]" is the new index.
+        auto reorder = [](const RANGE *sect, const auto &less, std::vector<size_t> &dst)
+        {
+            std::vector<size_t> seq(sect->num());
+            for (size_t i = 0; i < seq.size(); ++i)
+                seq[i] = sect->first_index() + i;
+            std::stable_sort(seq.begin(), seq.end(), less);
+            for (size_t i = 0; i < seq.size(); ++i)
+                dst[seq[i] - 1] = sect->first_index() + i;
+            return seq;
+        };
+
+        std::vector<NODE*> nodeSect;
+        std::vector<FACE*> faceSect;
+        std::vector<CELL*> cellSect;
+        for (auto e : m_content)
+        {
+            if (e->identity() == SECTION::NODE)
+                nodeSect.push_back(dynamic_cast<NODE*>(e));
+            else if (e->identity() == SECTION::FACE)
+                faceSect.push_back(dynamic_cast<FACE*>(e));
+            else if (e->identity() == SECTION::CELL)
+                cellSect.push_back(dynamic_cast<CELL*>(e));
+        }
+
+        /// Cells
+        std::vector<size_t> newCell(NC, 0), oldCell(NC, 0);
+        for (auto sect : cellSect)
+        {
+            const auto seq = reorder(sect, [&rank](size_t a, size_t b) { return rank[a - 1] < rank[b - 1]; }, newCell);
+            std::vector<int> elem(seq.size());
+            for (size_t i = 0; i < seq.size(); ++i)
+            {
+                elem[i] = sect->at(seq[i] - sect->first_index());
+                oldCell[sect->first_index() + i - 1] = seq[i];
+            }
+            sect->swap(elem);
+        }
+
+        /// Nodes, in the order of first visit by cells.
+        static const size_t NotVisited = std::numeric_limits<size_t>::max();
+        std::vector<size_t> visit(NN, NotVisited), newNode(NN, 0);
+        size_t cnt = 0;
+        for (auto c : oldCell)
+            if (c != 0)
+                for (auto n : m_cellIncludedNode.row(c - 1))
+                    if (visit[n - 1] == NotVisited)
+                        visit[n - 1] = cnt++;
+        for (auto sect : nodeSect)
+        {
+            const auto seq = reorder(sect, [&visit](size_t a, size_t b) { return visit[a - 1] < visit[b - 1]; }, newNode);
+            std::vector<Vector> coord(seq.size());
+            for (size_t i = 0; i < seq.size(); ++i)
+                coord[i] = sect->at(seq[i] - sect->first_index());
+            sect->swap(coord);
+        }
+
+        /// Faces, in the order of their adjacent cells.
+        auto map_cell = [&newCell](size_t c)
+        {
+            return c == 0 ? size_t(0) : newCell.at(c - 1);
+        };
+        std::vector<size_t> newFace(numOfFace(), 0);
+        for (auto sect : faceSect)
+        {
+            std::vector<std::pair<size_t, size_t>> adj(sect->num());
+            for (size_t i = 0; i < adj.size(); ++i)
+            {
+                const auto &cnct = sect->at(i);
+                const size_t c0 = map_cell(cnct.c[0]), c1 = map_cell(cnct.c[1]);
+                adj[i] = c0 == 0 || c1 == 0 ? std::make_pair(c0 + c1, size_t(0)) : std::make_pair(std::min(c0, c1), std::max(c0, c1));
+            }
+            const auto seq = reorder(sect, [&adj, sect](size_t a, size_t b) { return adj[a - sect->first_index()] < adj[b - sect->first_index()]; }, newFace);
+
+            std::vector<CONNECTIVITY> cnct(seq.size());
+            for (size_t i = 0; i < seq.size(); ++i)
+            {
+                auto &dst = cnct[i];
+                dst = sect->at(seq[i] - sect->first_index());
+                for (int j = 0; j < dst.x; ++j)
+                    dst.n[j] = newNode.at(dst.n[j] - 1);
+                dst.c[0] = map_cell(dst.c[0]);
+                dst.c[1] = map_cell(dst.c[1]);
+            }
+            sect->swap(cnct);
+        }
+
+        clear_derived();
+        derive(features);
+        m_renumbered = true;
+
+        const size_t bw1 = bandwidth();
+        fout << "Bandwidth of cell adjacency: " << bw0 << " -> " << bw1 << std::endl;
+        return bw1;
+    }
+
+    size_t MESH::writePartition(const std::vector<int> &part, const std::string &prefix, bool binary, std::ostream &fout) const
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::writePartition");
+
+        const size_t NC = numOfCell(), NF = numOfFace();
+        if (part.size() != NC)
+            throw std::invalid_argument("Inconsistent num of cells in partition.");
+        if (m_renumbered)
+            throw std::runtime_error("Cells of a renumbered mesh are not in the order of partition.");
+
+        size_t nPart = 0;
+        for (auto p : part)
+        {
+            if (p < 0)
+                throw std::invalid_argument("Invalid part index: " + std::to_string(p) + ".");
+            nPart = std::max(nPart, static_cast<size_t>(p) + 1);
+        }
+
+        /// Cells keep their relative order within each part.
+        std::vector<size_t> localCell(NC, 0), cellNum(nPart, 0);
+        for (size_t c = 0; c < NC; ++c)
+            localCell[c] = ++cellNum[part[c]];
+        for (size_t p = 0; p < nPart; ++p)
+            if (cellNum[p] == 0)
+                throw std::runtime_error("Part " + std::to_string(p) + " is empty.");
+
+        std::vector<const NODE*> nodeSect;
+        std::vector<const FACE*> faceSect;
+        std::vector<const CELL*> cellSect;
+        std::vector<const ZONE*> zoneSect;
+        size_t maxZone = 0;
+        for (auto e : m_content)
+        {
+            if (e->identity() == SECTION::NODE)
+                nodeSect.push_back(dynamic_cast<const NODE*>(e));
+            else if (e->identity() == SECTION::FACE)
+                faceSect.push_back(dynamic_cast<const FACE*>(e));
+            else if (e->identity() == SECTION::CELL)
+                cellSect.push_back(dynamic_cast<const CELL*>(e));
+            else if (e->identity() == SECTION::ZONE)
+            {
+                zoneSect.push_back(dynamic_cast<const ZONE*>(e));
+                maxZone = std::max(maxZone, zoneSect.back()->zone());
+            }
+            if (auto r = dynamic_cast<const RANGE*>(e))
+                maxZone = std::max(maxZone, r->zone());
+        }
+
+        /// Faces visited by cells of each part, in the order of sections.
+        auto part_of = [&part](size_t c)
+        {
+            return c == 0 ? -1 : part[c - 1];
+        };
+        std::vector<const CONNECTIVITY*> slot(NF, nullptr);
+        std::vector<size_t> faceSectOf(NF, 0);
+        std::vector<std::vector<size_t>> faceOfPart(nPart);
+        for (size_t s = 0; s < faceSect.size(); ++s)
+        {
+            const auto sect = faceSect[s];
+            for (size_t i = 0; i < sect->num(); ++i)
+            {
+                const size_t g = sect->first_index() + i;
+                const auto &cnct = sect->at(i);
+                slot[g - 1] = &cnct;
+                faceSectOf[g - 1] = s;
+                const int p0 = part_of(cnct.c[0]), p1 = part_of(cnct.c[1]);
+                if (p0 >= 0)
+                    faceOfPart[p0].push_back(g);
+                if (p1 >= 0 && p1 != p0)
+                    faceOfPart[p1].push_back(g);
+            }
+        }
+
+        struct SUMMARY
+        {
+            size_t node, face, interface_face, neighbour;
+        };
+        std::vector<SUMMARY> smry(nPart);
+
+        COMMON::parallel_for(nPart, [&](size_t first, size_t last)
+        {
+            for (size_t p = first; p < last; ++p)
+            {
+                const int P = static_cast<int>(p);
+                const auto &face = faceOfPart[p];
+
+                /// Nodes keep their relative order as well.
+                std::vector<size_t> node;
+                for (auto g : face)
+                    for (int j = 0; j < slot[g - 1]->x; ++j)
+                        node.push_back(slot[g - 1]->n[j]);
+                std::sort(node.begin(), node.end());
+                node.erase(std::unique(node.begin(), node.end()), node.end());
+                auto local_node = [&node](size_t n)
+                {
+                    return static_cast<size_t>(std::lower_bound(node.begin(), node.end(), n) - node.begin()) + 1;
+                };
+
+                MESH sub;
+                sub.m_is3D = m_is3D;
+                sub.m_dim = m_dim;
+                sub.add_entry(new HEADER("Partition " + std::to_string(p) + " of " + std::to_string(nPart)));
+                sub.add_entry(new DIMENSION(m_dim, m_is3D));
+                std::set<size_t> zoneKept;
+
+                for (auto sect : nodeSect)
+                {
+                    const size_t lo = local_node(sect->first_index()), hi = local_node(sect->last_index() + 1) - 1;
+                    if (lo > hi)
+                        continue;
+                    std::vector<Vector> coord(hi - lo + 1);
+                    for (size_t i = lo; i <= hi; ++i)
+                        coord[i - lo] = sect->at(node[i - 1] - sect->first_index());
+                    sub.add_entry(new NODE(sect->zone(), lo, hi, sect->type(), sect->ND(), std::move(coord)));
+                    zoneKept.insert(sect->zone());
+                }
+
+                for (auto sect : cellSect)
+                {
+                    std::vector<int> elem;
+                    size_t lo = 0;
+                    for (size_t c = sect->first_index(); c <= sect->last_index(); ++c)
+                        if (part[c - 1] == P)
+                        {
+                            if (elem.empty())
+                                lo = localCell[c - 1];
+                            elem.push_back(sect->at(c - sect->first_index()));
+                        }
+                    if (elem.empty())
+                        continue;
+                    const size_t hi = lo + elem.size() - 1;
+                    sub.add_entry(new CELL(sect->zone(), lo, hi, sect->type(), sect->element_type(), std::move(elem)));
+                    zoneKept.insert(sect->zone());
+                }
+
+                /// Faces shared with other parts are grouped by the neighbour,
+                /// and oriented such that the local cell is "c0". Polygons are flipped
+                /// around the first node, so that geometric quantities are kept bitwise.
+                std::map<int, std::vector<size_t>> shared;
+                auto localize = [&](const CONNECTIVITY &src, CONNECTIVITY &dst)
+                {
+                    dst = src;
+                    if (part_of(src.c[0]) != P)
+                    {
+                        std::reverse(dst.n + (dst.x > 2 ? 1 : 0), dst.n + dst.x);
+                        std::swap(dst.c[0], dst.c[1]);
+                    }
+                    for (int j = 0; j < dst.x; ++j)
+                        dst.n[j] = local_node(dst.n[j]);
+                    dst.c[0] = localCell[dst.c[0] - 1];
+                    dst.c[1] = part_of(dst.c[1]) == P ? localCell[dst.c[1] - 1] : 0;
+                };
+
+                size_t cnt = 0;
+                for (size_t k = 0; k < face.size();)
+                {
+                    const size_t s = faceSectOf[face[k] - 1];
+                    std::vector<size_t> kept;
+                    for (; k < face.size() && faceSectOf[face[k] - 1] == s; ++k)
+                    {
+                        const auto &cnct = *slot[face[k] - 1];
+                        const int p0 = part_of(cnct.c[0]), p1 = part_of(cnct.c[1]);
+                        if (p0 >= 0 && p1 >= 0 && p0 != p1)
+                            shared[p0 == P ? p1 : p0].push_back(face[k]);
+                        else
+                            kept.push_back(face[k]);
+                    }
+                    if (kept.empty())
+                        continue;
+
+                    const auto sect = faceSect[s];
+                    auto dst = new FACE(sect->zone(), cnt + 1, cnt + kept.size(), sect->bc_type(), sect->face_type());
+                    for (size_t i = 0; i < kept.size(); ++i)
+                        localize(*slot[kept[i] - 1], dst->at(i));
+                    cnt += kept.size();
+                    sub.add_entry(dst);
+                    zoneKept.insert(sect->zone());
+                }
+
+                std::vector<size_t> interfaceStart;
+                for (const auto &e : shared)
+                {
+                    int x = slot[e.second.front() - 1]->x;
+                    for (auto g : e.second)
+                        if (slot[g - 1]->x != x)
+                            x = FACE::MIXED;
+                    interfaceStart.push_back(cnt + 1);
+                    auto dst = new FACE(maxZone + 1 + e.first, cnt + 1, cnt + e.second.size(), BC::INTERFACE, x);
+                    for (size_t i = 0; i < e.second.size(); ++i)
+                        localize(*slot[e.second[i] - 1], dst->at(i));
+                    cnt += e.second.size();
+                    sub.add_entry(dst);
+                }
+
+                sub.add_entry(new COMMENT("Zone Sections"));
+                for (auto z : zoneSect)
+                    if (zoneKept.count(z->zone()))
+                        sub.add_entry(new ZONE(*z));
+                for (const auto &e : shared)
+                    sub.add_entry(new ZONE(static_cast<int>(maxZone + 1 + e.first), "interface", "interface_" + std::to_string(e.first)));
+
+                sub.m_totalNodeNum = node.size();
+                sub.m_totalCellNum = cellNum[p];
+                sub.m_totalFaceNum = cnt;
+                sub.writeToFile(prefix + "_" + std::to_string(p) + ".msh", binary);
+
+                /// Map of part "p", in plain text:
+                ///   PART <p> <num of parts>
+                ///   NODE <num>, followed by global index of each local node
+                ///   CELL <num>, followed by global index of each local cell
+                ///   FACE <num>, followed by global index of each local face
+                ///   INTERFACE <q> <num>, followed by "<local face> <local cell> <global halo cell> <halo cell local to q>"
+                ///     of each face shared with part "q", in the same order as that written by part "q".
+                /// All indices are 1-based.
+                const std::string f_map = prefix + "_" + std::to_string(p) + ".map";
+                std::ofstream fmap(f_map);
+                if (fmap.fail())
+                    throw std::runtime_error("Failed to open partition map file: " + f_map);
+                fmap << "PART " << p << " " << nPart << "\n";
+                fmap << "NODE " << node.size() << "\n";
+                for (auto n : node)
+                    fmap << n << "\n";
+                fmap << "CELL " << cellNum[p] << "\n";
+                for (size_t c = 0; c < NC; ++c)
+                    if (part[c] == P)
+                        fmap << c + 1 << "\n";
+                fmap << "FACE " << cnt << "\n";
+                for (auto g : face)
+                {
+                    const int p0 = part_of(slot[g - 1]->c[0]), p1 = part_of(slot[g - 1]->c[1]);
+                    if (p0 < 0 || p1 < 0 || p0 == p1)
+                        fmap << g << "\n";
+                }
+                for (const auto &e : shared)
+                    for (auto g : e.second)
+                        fmap << g << "\n";
+                size_t nShared = 0;
+                for (const auto &e : shared)
+                {
+                    fmap << "INTERFACE " << e.first << " " << e.second.size() << "\n";
+                    for (size_t i = 0; i < e.second.size(); ++i)
+                    {
+                        const auto &cnct = *slot[e.second[i] - 1];
+                        const size_t own = part_of(cnct.c[0]) == P ? cnct.c[0] : cnct.c[1];
+                        const size_t halo = cnct.c[0] + cnct.c[1] - own;
+                        fmap << interfaceStart[nShared] + i << " " << localCell[own - 1] << " " << halo << " " << localCell[halo - 1] << "\n";
+                    }
+                    ++nShared;
+                }
+                fmap.close();
+
+                size_t nIF = 0;
+                for (const auto &e : shared)
+                    nIF += e.second.size();
+                smry[p] = { node.size(), cnt, nIF, shared.size() };
+            }
+        }, 1);
+
+        size_t nIF = 0, maxCell = 0;
+        for (size_t p = 0; p < nPart; ++p)
+        {
+            fout << "Part " << p << ": " << cellNum[p] << " cells, " << smry[p].node << " nodes, " << smry[p].face << " faces";
+            fout << ", " << smry[p].interface_face << " shared with " << smry[p].neighbour << " parts." << std::endl;
+            nIF += smry[p].interface_face;
+            maxCell = std::max(maxCell, cellNum[p]);
+        }
+        nIF /= 2;
+        fout << "Interface faces: " << nIF << ", load imbalance: " << static_cast<double>(maxCell) * nPart / NC << std::endl;
+        return nIF;
+    }
+
     void MESH::add_entry(SECTION *e)
     {
         m_content.push_back(e);
@@ -1384,291 +3034,402 @@ namespace GridTool::XF
 
         /// Clear container.
         m_content.clear();
+        m_renumbered = false;
     }
 
-    void MESH::readFromFile(const std::string &src, std::ostream &fout)
+    void MESH::steal(MESH &rhs)
     {
-        // Open grid file
-        std::ifstream fin(src);
-        if (fin.fail())
-            throw std::runtime_error("Failed to open input grid file: \"" + src + "\".");
+        /// Sections are held by pointers, thus zones referring to them are still valid.
+        m_content = std::move(rhs.m_content);
+        rhs.m_content.clear();
+        m_totalNodeNum = std::exchange(rhs.m_totalNodeNum, 0);
+        m_totalCellNum = std::exchange(rhs.m_totalCellNum, 0);
+        m_totalFaceNum = std::exchange(rhs.m_totalFaceNum, 0);
+
+        m_nodeCoordinate = std::move(rhs.m_nodeCoordinate);
+        m_nodeAtBdry = std::move(rhs.m_nodeAtBdry);
+        m_nodeAdjacentNode = std::move(rhs.m_nodeAdjacentNode);
+        m_nodeDependentFace = std::move(rhs.m_nodeDependentFace);
+        m_nodeDependentCell = std::move(rhs.m_nodeDependentCell);
+
+        m_faceType = std::move(rhs.m_faceType);
+        m_faceCenter = std::move(rhs.m_faceCenter);
+        m_faceArea = std::move(rhs.m_faceArea);
+        m_faceAtBdry = std::move(rhs.m_faceAtBdry);
+        m_faceIncludedNode = std::move(rhs.m_faceIncludedNode);
+        m_faceLeftCell = std::move(rhs.m_faceLeftCell);
+        m_faceRightCell = std::move(rhs.m_faceRightCell);
+        m_faceNormal = std::move(rhs.m_faceNormal);
+
+        m_cellType = std::move(rhs.m_cellType);
+        m_cellCenter = std::move(rhs.m_cellCenter);
+        m_cellVolume = std::move(rhs.m_cellVolume);
+        m_cellIncludedNode = std::move(rhs.m_cellIncludedNode);
+        m_cellIncludedFace = std::move(rhs.m_cellIncludedFace);
+        m_cellAdjacentCell = std::move(rhs.m_cellAdjacentCell);
+
+        m_totalZoneNum = std::exchange(rhs.m_totalZoneNum, 0);
+        m_derived.store(rhs.m_derived.exchange(0));
+        m_renumbered = std::exchange(rhs.m_renumbered, false);
+        m_zoneMapping = std::move(rhs.m_zoneMapping);
+        m_zone = std::move(rhs.m_zone);
+    }
+
+    void MESH::readFromFile(const std::string &src, std::ostream &fout, int derived)
+    {
+        TYDF_PROFILE_SCOPE("XF::MESH::readFromFile");
+
+        // Map grid file into memory
+        const GridTool::COMMON::MAPPED_FILE fin(src);
+        TYDF_PROFILE_COUNT("xf.bytes_read", fin.size());
+        SCANNER sc(fin.begin(), fin.end());
 
         // Clear existing records if any.
         clear_entry();
+        clear_derived();
+
+        // Declaration of total num of nodes, cells or faces,
+        // whose "first-index" must be 1.
+        auto read_declaration = [&sc](const std::string &tag, bool checkType, size_t &dst)
+        {
+            if (sc.number<int>() != 1)
+                throw std::runtime_error("Invalid \"first-index\" in " + tag + " declaration!");
+            dst = sc.number<size_t>();
+            const int tp = sc.number<int>();
+            if (checkType && tp != 0)
+                throw std::runtime_error("Invalid \"type\" in " + tag + " declaration!");
+            sc.skip_white();
+            if (!sc.eof() && *sc.pos() != ')')
+                sc.number<int>(); /// Optional "element-type"
+            sc.eat(')');
+            sc.eat(')');
+        };
 
         // Read contents
-        while (!fin.eof())
+        sc.skip_white();
+        while (!sc.eof())
         {
-            skip_white(fin);
-            eat(fin, '(');
-            int ti = -1;
-            fin >> std::dec >> ti;
+            sc.eat('(');
+            const int ti = sc.number<int>(10);
             if (ti == SECTION::COMMENT)
             {
-                eat(fin, '\"');
-                std::string ts;
-                char tc;
-                while ((tc = fin.get()) != '\"')
-                    ts.push_back(tc);
-                eat(fin, ')');
+                sc.eat('\"');
+                const std::string ts = sc.until('\"');
+                sc.eat(')');
                 add_entry(new COMMENT(ts));
-                skip_white(fin);
             }
             else if (ti == SECTION::HEADER)
             {
-                eat(fin, '\"');
-                std::string ts;
-                char tc;
-                while ((tc = fin.get()) != '\"')
-                    ts.push_back(tc);
-                eat(fin, ')');
+                sc.eat('\"');
+                const std::string ts = sc.until('\"');
+                sc.eat(')');
                 add_entry(new HEADER(ts));
-                skip_white(fin);
             }
             else if (ti == SECTION::DIMENSION)
             {
-                int nd = 0;
-                fin >> std::dec >> nd;
-                eat(fin, ')');
+                const int nd = sc.number<int>(10);
+                sc.eat(')');
                 add_entry(new DIMENSION(nd));
-                skip_white(fin);
                 m_dim = nd;
                 m_is3D = (nd == 3);
             }
             else if (ti == SECTION::NODE)
             {
-                eat(fin, '(');
-                int zone;
-                fin >> std::hex >> zone;
+                sc.eat('(');
+                const size_t zone = sc.number<size_t>();
                 if (zone == 0)
                 {
                     // If zone-id is 0, indicating total number of nodes in the mesh.
-                    int tmp;
-                    fin >> std::hex;
-                    fin >> tmp;
-                    if (tmp != 1)
-                        throw std::runtime_error("Invalid \"first-index\" in NODE declaration!");
-                    fin >> m_totalNodeNum;
+                    read_declaration("NODE", true, m_totalNodeNum);
                     fout << "Total number of nodes: " << m_totalNodeNum << std::endl;
-                    fin >> tmp;
-                    if (tmp != 0)
-                        throw std::runtime_error("Invalid \"type\" in NODE declaration!");
-                    char ndc = fin.get();
-                    if (ndc != ')')
-                    {
-                        fin >> tmp;
-                        eat(fin, ')');
-                    }
-                    eat(fin, ')');
                 }
                 else
                 {
                     // If zone-id is positive, it indicates the zone to which the nodes belong.
-                    int first, last, tp, nd;
-                    fin >> std::hex;
-                    fin >> first >> last;
-                    fin >> tp >> nd;
+                    const auto first = sc.number<size_t>();
+                    const auto last = sc.number<size_t>();
+                    const auto tp = sc.number<int>();
+                    const auto nd = sc.number<int>();
                     auto e = new NODE(zone, first, last, tp, nd);
-                    eat(fin, ')');
-                    eat(fin, '(');
+                    sc.eat(')');
+                    sc.eat('(');
                     fout << "Reading " << e->num() << " nodes in zone " << zone << " (from " << first << " to " << last << "), whose type is \"" << NODE::idx2str(tp) << "\"  ... ";
 
                     if (nd != dimension())
                         throw std::runtime_error("Inconsistent with previous DIMENSION declaration!");
 
-                    if (nd == 3)
-                    {
-                        for (int i = first; i <= last; ++i)
-                        {
-                            auto &ce = e->at(i - first);
-                            fin >> ce.x() >> ce.y() >> ce.z();
-                        }
-                    }
-                    else
+                    const char *body_end = sc.find(')');
+                    auto &dst = *e;
+                    parse_body(sc.pos(), body_end, e->num() * nd, [&dst, nd](const char *tb, const char *te, size_t idx)
                     {
-                        for (int i = first; i <= last; ++i)
-                        {
-                            auto &ce = e->at(i - first);
-                            fin >> ce.x() >> ce.y();
-                        }
-                    }
-                    eat(fin, ')');
-                    eat(fin, ')');
+                        convert(tb, te, dst[idx / nd][idx % nd], 10);
+                    });
+                    sc.seek(body_end + 1);
+                    sc.eat(')');
                     fout << "Done!" << std::endl;
                     add_entry(e);
                 }
-                skip_white(fin);
             }
             else if (ti == SECTION::CELL)
             {
-                eat(fin, '(');
-                int zone;
-                fin >> std::hex >> zone;
+                sc.eat('(');
+                const size_t zone = sc.number<size_t>();
                 if (zone == 0)
                 {
                     // If zone-id is 0, indicating total number of cells in the mesh.
-                    int tmp;
-                    fin >> std::hex;
-                    fin >> tmp;
-                    if (tmp != 1)
-                        throw std::runtime_error("Invalid \"first-index\" in CELL declaration!");
-                    fin >> m_totalCellNum;
+                    read_declaration("CELL", true, m_totalCellNum);
                     fout << "Total number of cells: " << m_totalCellNum << std::endl;
-                    fin >> tmp;
-                    if (tmp != 0)
-                        throw std::runtime_error("Invalid \"type\" in CELL declaration!");
-                    char ndc = fin.get();
-                    if (ndc != ')')
-                    {
-                        fin >> tmp;
-                        eat(fin, ')');
-                    }
-                    eat(fin, ')');
                 }
                 else
                 {
                     // If zone-id is positive, it indicates the zone to which the cells belong.
-                    int first, last, tp, elem;
-                    fin >> std::hex;
-                    fin >> first >> last;
-                    fin >> tp >> elem;
+                    const auto first = sc.number<size_t>();
+                    const auto last = sc.number<size_t>();
+                    const auto tp = sc.number<int>();
+                    auto elem = sc.number<int>();
                     auto e = new CELL(zone, first, last, tp, elem);
-                    eat(fin, ')');
+                    sc.eat(')');
 
                     if (elem == 0)
                     {
                         fout << "Reading " << e->num() << " mixed cells in zone " << zone << " (from " << first << " to " << last << ") ... ";
-                        eat(fin, '(');
-                        for (int i = first; i <= last; ++i)
+                        sc.eat('(');
+                        for (size_t i = first; i <= last; ++i)
                         {
-                            fin >> elem;
+                            elem = sc.number<int>();
                             if (CELL::isValidElemIdx(elem))
                                 e->at(i - first) = elem;
                             else
                                 throw std::runtime_error("Invalid CELL-ELEM-TYPE: \"" + std::to_string(elem) + "\"");
                         }
-                        eat(fin, ')');
+                        sc.eat(')');
                         fout << "Done!" << std::endl;
                     }
                     else
                         fout << e->num() << " " << CELL::idx2str_elem(elem) << " in zone " << zone << " (from " << first << " to " << last << ")" << std::endl;
 
-                    eat(fin, ')');
+                    sc.eat(')');
                     add_entry(e);
                 }
-                skip_white(fin);
             }
             else if (ti == SECTION::FACE)
             {
-                eat(fin, '(');
-                int zone;
-                fin >> std::hex >> zone;
+                sc.eat('(');
+                const size_t zone = sc.number<size_t>();
                 if (zone == 0)
                 {
                     // If zone-id is 0, indicating total number of faces in the mesh.
-                    int tmp;
-                    fin >> tmp;
-                    if (tmp != 1)
-                        throw std::runtime_error("Invalid \"first-index\" in FACE declaration!");
-                    fin >> m_totalFaceNum;
+                    read_declaration("FACE", false, m_totalFaceNum);
                     fout << "Total number of faces: " << m_totalFaceNum << std::endl;
-                    fin >> tmp;
-                    char ndc = fin.get();
-                    if (ndc != ')')
-                    {
-                        fin >> tmp;
-                        eat(fin, ')');
-                    }
-                    eat(fin, ')');
                 }
                 else
                 {
                     // If zone-id is positive, it indicates a regular face section and will be
                     // followed by a body containing information about the grid connectivity.
-                    size_t first, last;
-                    int bc, face;
-                    fin >> first >> last;
-                    fin >> bc >> face;
+                    const auto first = sc.number<size_t>();
+                    const auto last = sc.number<size_t>();
+                    const auto bc = sc.number<int>();
+                    const auto face = sc.number<int>();
                     auto e = new FACE(zone, first, last, bc, face);
-                    eat(fin, ')');
-                    eat(fin, '(');
+                    sc.eat(')');
+                    sc.eat('(');
                     fout << "Reading " << e->num() << " " << FACE::idx2str(face) << " faces in zone " << zone << " (from " << first << " to " << last << "), whose B.C. is \"" << BC::idx2str(bc) << "\" ... ";
 
-                    size_t tmp_n[4];
-                    size_t tmp_c[2];
                     if (face == FACE::MIXED)
                     {
-                        int x = -1;
+                        size_t tmp_n[4];
+                        size_t tmp_c[2];
                         for (size_t i = first; i <= last; ++i)
                         {
                             // Read connectivity record
-                            fin >> x;
+                            const int x = sc.number<int>();
                             if (x <= 1 || x >= 5)
                                 throw std::invalid_argument("Invalid node num in the mixed face.");
                             for (int j = 0; j < x; ++j)
-                                fin >> tmp_n[j];
-                            fin >> tmp_c[0] >> tmp_c[1];
+                                tmp_n[j] = sc.number<size_t>();
+                            tmp_c[0] = sc.number<size_t>();
+                            tmp_c[1] = sc.number<size_t>();
 
                             // Store current connectivity info
                             e->at(i - first).set(x, tmp_n, tmp_c);
                         }
+                        sc.eat(')');
                     }
                     else
                     {
-                        for (size_t i = first; i <= last; ++i)
+                        // Records are of fixed length, thus can be located directly.
+                        const size_t L = face + 2;
+                        const char *body_end = sc.find(')');
+                        auto &dst = *e;
+                        parse_body(sc.pos(), body_end, e->num() * L, [&dst, face, L](const char *tb, const char *te, size_t idx)
                         {
-                            // Read connectivity record
-                            for (int j = 0; j < face; ++j)
-                                fin >> tmp_n[j];
-                            fin >> tmp_c[0] >> tmp_c[1];
-
-                            // Store current connectivity info
-                            e->at(i - first).set(face, tmp_n, tmp_c);
-                        }
+                            auto &loc_cnect = dst[idx / L];
+                            const size_t loc_idx = idx % L;
+                            if (loc_idx == 0)
+                                loc_cnect.x = face;
+                            if (loc_idx < size_t(face))
+                                convert(tb, te, loc_cnect.n[loc_idx], 16);
+                            else
+                                convert(tb, te, loc_cnect.c[loc_idx - face], 16);
+                        });
+                        sc.seek(body_end + 1);
                     }
-                    eat(fin, ')');
-                    eat(fin, ')');
+                    sc.eat(')');
                     fout << "Done!" << std::endl;
                     add_entry(e);
                 }
-                skip_white(fin);
+            }
+            else if (ti == SECTION::NODE_BIN_SP || ti == SECTION::NODE_BIN_DP)
+            {
+                sc.eat('(');
+                const auto zone = sc.number<size_t>();
+                const auto first = sc.number<size_t>();
+                const auto last = sc.number<size_t>();
+                const auto tp = sc.number<int>();
+                const auto nd = sc.number<int>();
+                auto e = new NODE(zone, first, last, tp, nd);
+                sc.eat(')');
+                sc.eat('(');
+                fout << "Reading " << e->num() << " nodes in zone " << zone << " (from " << first << " to " << last << ") in binary form, whose type is \"" << NODE::idx2str(tp) << "\"  ... ";
+
+                if (nd != dimension())
+                    throw std::runtime_error("Inconsistent with previous DIMENSION declaration!");
+
+                const size_t N = e->num() * nd;
+                if (ti == SECTION::NODE_BIN_SP)
+                {
+                    std::vector<float> buf(N);
+                    sc.raw(buf);
+                    for (size_t i = 0; i < e->num(); ++i)
+                        for (int k = 0; k < nd; ++k)
+                            e->at(i).at(k) = buf[i * nd + k];
+                }
+                else
+                {
+                    std::vector<double> buf(N);
+                    sc.raw(buf);
+                    for (size_t i = 0; i < e->num(); ++i)
+                        for (int k = 0; k < nd; ++k)
+                            e->at(i).at(k) = buf[i * nd + k];
+                }
+                sc.eat(')');
+                sc.eat(')');
+                fout << "Done!" << std::endl;
+                add_entry(e);
+            }
+            else if (ti == SECTION::CELL_BIN || ti == SECTION::CELL_BIN_DP)
+            {
+                sc.eat('(');
+                const auto zone = sc.number<size_t>();
+                const auto first = sc.number<size_t>();
+                const auto last = sc.number<size_t>();
+                const auto tp = sc.number<int>();
+                const auto elem = sc.number<int>();
+                auto e = new CELL(zone, first, last, tp, elem);
+                sc.eat(')');
+
+                if (elem == CELL::MIXED)
+                {
+                    fout << "Reading " << e->num() << " mixed cells in zone " << zone << " (from " << first << " to " << last << ") in binary form ... ";
+                    sc.eat('(');
+                    std::vector<int32_t> buf(e->num());
+                    sc.raw(buf);
+                    for (size_t i = 0; i < e->num(); ++i)
+                    {
+                        if (CELL::isValidElemIdx(buf[i]))
+                            e->at(i) = buf[i];
+                        else
+                            throw std::runtime_error("Invalid CELL-ELEM-TYPE: \"" + std::to_string(buf[i]) + "\"");
+                    }
+                    sc.eat(')');
+                    fout << "Done!" << std::endl;
+                }
+                else
+                    fout << e->num() << " " << CELL::idx2str_elem(elem) << " in zone " << zone << " (from " << first << " to " << last << ")" << std::endl;
+
+                sc.eat(')');
+                add_entry(e);
+            }
+            else if (ti == SECTION::FACE_BIN || ti == SECTION::FACE_BIN_DP)
+            {
+                sc.eat('(');
+                const auto zone = sc.number<size_t>();
+                const auto first = sc.number<size_t>();
+                const auto last = sc.number<size_t>();
+                const auto bc = sc.number<int>();
+                const auto face = sc.number<int>();
+                auto e = new FACE(zone, first, last, bc, face);
+                sc.eat(')');
+                sc.eat('(');
+                fout << "Reading " << e->num() << " " << FACE::idx2str(face) << " faces in zone " << zone << " (from " << first << " to " << last << ") in binary form, whose B.C. is \"" << BC::idx2str(bc) << "\" ... ";
+
+                size_t tmp_n[4];
+                size_t tmp_c[2];
+                std::vector<int32_t> rec(face == FACE::MIXED ? 1 : face + 2);
+                for (size_t i = first; i <= last; ++i)
+                {
+                    // Read connectivity record
+                    int x = face;
+                    if (face == FACE::MIXED)
+                    {
+                        sc.raw(rec);
+                        x = rec[0];
+                        if (x <= 1 || x >= 5)
+                            throw std::invalid_argument("Invalid node num in the mixed face.");
+                        rec.resize(x + 2);
+                    }
+                    sc.raw(rec);
+                    for (int j = 0; j < x; ++j)
+                        tmp_n[j] = rec[j];
+                    tmp_c[0] = rec[x];
+                    tmp_c[1] = rec[x + 1];
+                    if (face == FACE::MIXED)
+                        rec.resize(1);
+
+                    // Store current connectivity info
+                    e->at(i - first).set(x, tmp_n, tmp_c);
+                }
+                sc.eat(')');
+                sc.eat(')');
+                fout << "Done!" << std::endl;
+                add_entry(e);
             }
             else if (ti == SECTION::ZONE || ti == SECTION::ZONE_MESHING)
             {
-                eat(fin, '(');
-                int zone;
-                fin >> std::dec >> zone;
-                std::string ztp;
-                fin >> ztp;
-                skip_white(fin);
-                std::string zname;
-                char t0;
-                while ((t0 = fin.get()) != ')')
-                    zname.push_back(t0);
-                eat(fin, '(');
-                eat(fin, ')');
-                eat(fin, ')');
+                sc.eat('(');
+                const int zone = sc.number<int>(10);
+                const std::string ztp = sc.word();
+                sc.skip_white();
+                const std::string zname = sc.until(')');
+                sc.eat('(');
+                sc.eat(')');
+                sc.eat(')');
                 auto e = new ZONE(zone, ztp, zname);
                 add_entry(e);
-                skip_white(fin);
                 fout << "ZONE " << e->zone() << ", named " << R"(")" << e->name() << R"(", )" << "is " << R"(")" << e->type() << R"(")" << std::endl;
             }
             else
                 throw std::runtime_error("Unsupported section index: " + std::to_string(ti));
+
+            sc.skip_white();
         }
 
-        // Close grid file
-        fin.close();
+        derive_zone();
 
         // Re-orginize grid connectivities in a much easier way,
         // and compute some derived quantities.
-        fout << "Converting into high-level representation ... ";
-        raw2derived();
-        fout << "Done!" << std::endl;
+        if (derived != 0)
+        {
+            fout << "Converting into high-level representation ... ";
+            derive(derived);
+            fout << "Done!" << std::endl;
+        }
     }
 
-    void MESH::writeToFile(const std::string &dst) const
+    void MESH::writeToFile(const std::string &dst, bool binary) const
     {
+        TYDF_PROFILE_SCOPE("XF::MESH::writeToFile");
+
         if (numOfCell() == 0)
             throw std::runtime_error("Invalid num of cells.");
         if (numOfFace() == 0)
@@ -1679,7 +3440,7 @@ namespace GridTool::XF
             throw std::runtime_error("Invalid num of contents.");
 
         /// Open grid file
-        std::ofstream fout(dst);
+        std::ofstream fout(dst, binary ? std::ios::out | std::ios::binary : std::ios::out);
         if (fout.fail())
             throw std::runtime_error("Failed to open output grid file: " + dst);
 
@@ -1695,25 +3456,57 @@ namespace GridTool::XF
         }
 
         /// Declaration of NODE, FACE, CELL
-        fout << "(" << std::dec << SECTION::NODE << " (";
-        fout << std::hex << 0 << " " << 1 << " " << m_totalNodeNum << " ";
-        fout << std::dec << 0 << " " << (m_is3D ? 3 : 2) << "))" << std::endl;
-        fout << "(" << std::dec << SECTION::CELL << " (";
-        fout << std::hex << 0 << " " << 1 << " " << m_totalCellNum << " ";
-        fout << std::dec << 0 << " " << 0 << "))" << std::endl;
-        fout << "(" << std::dec << SECTION::FACE << " (";
-        fout << std::hex << 0 << " " << 1 << " " << m_totalFaceNum << " ";
-        fout << std::dec << 0 << " " << 0 << "))" << std::endl;
+        write_declaration(fout, m_totalNodeNum, m_totalCellNum, m_totalFaceNum, m_is3D);
 
         /// Contents
         for (; i < m_content.size(); ++i)
-            m_content[i]->repr(fout);
+        {
+            if (binary)
+                m_content[i]->repr_binary(fout);
+            else
+                m_content[i]->repr(fout);
+        }
+        TYDF_PROFILE_COUNT("xf.bytes_written", static_cast<long long>(fout.tellp()));
 
         /// Close grid file
         fout.close();
     }
 
-    void MESH::cell_standardization(CELL_ELEM &c)
+    void MESH::write_declaration(std::ostream &out, size_t nNode, size_t nCell, size_t nFace, bool is3D)
+    {
+        out << "(" << std::dec << SECTION::NODE << " (";
+        out << std::hex << 0 << " " << 1 << " " << nNode << " ";
+        out << std::dec << 0 << " " << (is3D ? 3 : 2) << "))" << std::endl;
+        out << "(" << std::dec << SECTION::CELL << " (";
+        out << std::hex << 0 << " " << 1 << " " << nCell << " ";
+        out << std::dec << 0 << " " << 0 << "))" << std::endl;
+        out << "(" << std::dec << SECTION::FACE << " (";
+        out << std::hex << 0 << " " << 1 << " " << nFace << " ";
+        out << std::dec << 0 << " " << 0 << "))" << std::endl;
+    }
+
+    size_t MESH::cell_node_num(int type)
+    {
+        switch (type)
+        {
+        case CELL::TETRAHEDRAL:
+            return 4;
+        case CELL::HEXAHEDRAL:
+            return 8;
+        case CELL::PYRAMID:
+            return 5;
+        case CELL::WEDGE:
+            return 6;
+        case CELL::TRIANGULAR:
+            return 3;
+        case CELL::QUADRILATERAL:
+            return 4;
+        default:
+            throw CELL::invalid_cell_type_idx(type);
+        }
+    }
+
+    void MESH::cell_standardization(CELL_RECORD &c) const
     {
         switch (c.type)
         {
@@ -1740,26 +3533,26 @@ namespace GridTool::XF
         }
     }
 
-    void MESH::tet_standardization(CELL_ELEM &tet)
+    void MESH::tet_standardization(CELL_RECORD &tet) const
     {
         // Check num of total faces
         if (tet.includedFace.size() != 4)
             throw std::runtime_error(R"(Mismatch between cell type ")" + CELL::idx2str_elem(tet.type) + R"(" and num of faces: )" + std::to_string(tet.includedFace.size()));
 
         // Ensure all faces are triangular
-        const auto &f0 = face(tet.includedFace.at(0));
+        const auto &f0 = face_shape(tet.includedFace.at(0));
         if (f0.type != FACE::TRIANGULAR)
             throw std::runtime_error("Internal error.");
 
-        const auto &f1 = face(tet.includedFace.at(1));
+        const auto &f1 = face_shape(tet.includedFace.at(1));
         if (f1.type != FACE::TRIANGULAR)
             throw std::runtime_error("Internal error.");
 
-        const auto &f2 = face(tet.includedFace.at(2));
+        const auto &f2 = face_shape(tet.includedFace.at(2));
         if (f2.type != FACE::TRIANGULAR)
             throw std::runtime_error("Internal error.");
 
-        const auto &f3 = face(tet.includedFace.at(3));
+        const auto &f3 = face_shape(tet.includedFace.at(3));
         if (f3.type != FACE::TRIANGULAR)
             throw std::runtime_error("Internal error.");
 
@@ -1794,7 +3587,7 @@ namespace GridTool::XF
         tet.includedNode.at(3) = n3;
     }
 
-    void MESH::pyramid_standardization(CELL_ELEM &pyramid)
+    void MESH::pyramid_standardization(CELL_RECORD &pyramid) const
     {
         // Check num of total faces
         if (pyramid.includedFace.size() != 5)
@@ -1804,7 +3597,7 @@ namespace GridTool::XF
         size_t f0_idx = 0;
         for (auto e : pyramid.includedFace)
         {
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (f.type == FACE::QUADRILATERAL)
             {
                 if (f0_idx == 0)
@@ -1821,7 +3614,7 @@ namespace GridTool::XF
             throw std::runtime_error("Internal error.");
 
         // Nodes at bottom
-        const auto &f0 = face(f0_idx);
+        const auto &f0 = face_shape(f0_idx);
 
         const size_t n0 = f0.includedNode.at(0);
         if (n0 == 0)
@@ -1846,7 +3639,7 @@ namespace GridTool::XF
             if (e == f0_idx)
                 continue;
 
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (f.includedNode.contains(n0, n3))
             {
                 f1_idx = e;
@@ -1862,7 +3655,7 @@ namespace GridTool::XF
             if (e == f0_idx || e == f1_idx)
                 continue;
 
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (f.includedNode.contains(n3, n2))
             {
                 f2_idx = e;
@@ -1878,7 +3671,7 @@ namespace GridTool::XF
             if (e == f0_idx || e == f1_idx || e == f2_idx)
                 continue;
 
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (f.includedNode.contains(n2, n1))
             {
                 f3_idx = e;
@@ -1894,7 +3687,7 @@ namespace GridTool::XF
             if (e != f0_idx && e != f1_idx && e != f2_idx && e != f3_idx)
             {
                 f4_idx = e;
-                const auto &f = face(e);
+                const auto &f = face_shape(e);
                 if (!f.includedNode.contains(n1, n0))
                     throw std::runtime_error("Internal error.");
 
@@ -1913,7 +3706,7 @@ namespace GridTool::XF
 
         // The last node
         size_t n4 = 0;
-        const auto &f1 = face(f1_idx);
+        const auto &f1 = face_shape(f1_idx);
         for (auto e : f1.includedNode)
             if (e != n0 && e != n3)
             {
@@ -1932,7 +3725,7 @@ namespace GridTool::XF
         pyramid.includedNode.at(4) = n4;
     }
 
-    void MESH::prism_standardization(CELL_ELEM &prism)
+    void MESH::prism_standardization(CELL_RECORD &prism) const
     {
         // Check num of total faces
         if (prism.includedFace.size() != 5)
@@ -1942,7 +3735,7 @@ namespace GridTool::XF
         size_t f0_idx = 0, f1_idx = 0;
         for (auto e : prism.includedFace)
         {
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (f.type == FACE::TRIANGULAR)
             {
                 if (f0_idx == 0)
@@ -1961,8 +3754,8 @@ namespace GridTool::XF
             throw std::runtime_error("Missing triangular faces in a prism cell.");
 
         // 2 triangular faces
-        const auto &f0 = face(f0_idx);
-        const auto &f1 = face(f1_idx);
+        const auto &f0 = face_shape(f0_idx);
+        const auto &f1 = face_shape(f1_idx);
 
         // 3 nodes on the bottom triangular face
         const size_t n0 = f0.includedNode.at(0);
@@ -1973,7 +3766,7 @@ namespace GridTool::XF
         size_t f4_idx = 0;
         for (auto e : prism.includedFace)
         {
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (f.type == FACE::QUADRILATERAL && f.includedNode.contains(n0, n1))
             {
                 if (f4_idx == 0)
@@ -1985,13 +3778,13 @@ namespace GridTool::XF
         if (f4_idx == 0)
             throw std::runtime_error("Missing face 4.");
 
-        const auto &f4 = face(f4_idx);
+        const auto &f4 = face_shape(f4_idx);
 
         // Find face 3
         size_t f3_idx = 0;
         for (auto e : prism.includedFace)
         {
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (f.type == FACE::QUADRILATERAL && f.includedNode.contains(n1, n2))
             {
                 if (f3_idx == 0)
@@ -2003,13 +3796,13 @@ namespace GridTool::XF
         if (f3_idx == 0 || f3_idx == f4_idx)
             throw std::runtime_error("Missing face 3.");
 
-        const auto &f3 = face(f3_idx);
+        const auto &f3 = face_shape(f3_idx);
 
         // Find face 2
         size_t f2_idx = 0;
         for (auto e : prism.includedFace)
         {
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (f.type == FACE::QUADRILATERAL)
             {
                 if (e != f4_idx && e != f3_idx)
@@ -2022,7 +3815,7 @@ namespace GridTool::XF
         if (f2_idx == 0)
             throw std::runtime_error("Missing face 2.");
 
-        const auto &f2 = face(f2_idx);
+        const auto &f2 = face_shape(f2_idx);
         if (!f2.includedNode.contains(n2, n0))
             throw std::runtime_error("Inconsistent face composition.");
 
@@ -2082,7 +3875,7 @@ namespace GridTool::XF
         prism.includedNode.at(5) = n5;
     }
 
-    void MESH::hex_standardization(CELL_ELEM &hex)
+    void MESH::hex_standardization(CELL_RECORD &hex) const
     {
         // Check num of total faces
         if (hex.includedFace.size() != 6)
@@ -2093,18 +3886,29 @@ namespace GridTool::XF
         {
             if (e == 0)
                 throw std::runtime_error("Internal error.");
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (f.type != FACE::QUADRILATERAL)
                 throw std::runtime_error(R"(Inconsistent face type ")" + FACE::idx2str(f.type) + R"(" in a hex cell.)");
         }
 
+        SHAPE_RECORD<CELL::HEXAHEDRAL> rec;
+        std::copy(hex.includedFace.begin(), hex.includedFace.end(), rec.includedFace.begin());
+        hex_standardization(rec);
+        hex.includedFace.assign(rec.includedFace.begin(), rec.includedFace.end());
+        hex.includedNode.assign(rec.includedNode.begin(), rec.includedNode.end());
+    }
+
+    void MESH::hex_standardization(SHAPE_RECORD<CELL::HEXAHEDRAL> &hex) const
+    {
+        auto nodes = [this](size_t f) { return m_faceIncludedNode.row(f - 1); };
+
         // Face 4 at bottom
-        const size_t f4_idx = hex.includedFace.at(0);
-        const auto &f4 = face(f4_idx);
-        const size_t n0 = f4.includedNode.at(0);
-        const size_t n1 = f4.includedNode.at(1);
-        const size_t n2 = f4.includedNode.at(2);
-        const size_t n3 = f4.includedNode.at(3);
+        const size_t f4_idx = hex.includedFace[0];
+        const auto f4 = nodes(f4_idx);
+        const size_t n0 = f4[0];
+        const size_t n1 = f4[1];
+        const size_t n2 = f4[2];
+        const size_t n3 = f4[3];
         if (n0 == 0 || n1 == 0 || n2 == 0 || n3 == 0)
             throw std::runtime_error("Internal error.");
 
@@ -2115,8 +3919,7 @@ namespace GridTool::XF
             if (e == f4_idx)
                 continue;
 
-            const auto &f = face(e);
-            if (f.includedNode.contains(n3, n0))
+            if (nodes(e).contains(n3, n0))
             {
                 if (f0_idx == 0)
                     f0_idx = e;
@@ -2127,9 +3930,7 @@ namespace GridTool::XF
         if (f0_idx == 0)
             throw std::runtime_error("Missing face 0");
 
-        const auto &f0 = face(f0_idx);
-        if (f0.includedNode.size() != 4)
-            throw std::runtime_error("Internal error.");
+        const auto f0 = nodes(f0_idx);
 
         // Face 2
         size_t f2_idx = 0;
@@ -2138,8 +3939,7 @@ namespace GridTool::XF
             if (e == f4_idx || e == f0_idx)
                 continue;
 
-            const auto &f = face(e);
-            if (f.includedNode.contains(n0, n1))
+            if (nodes(e).contains(n0, n1))
             {
                 if (f2_idx == 0)
                     f2_idx = e;
@@ -2150,9 +3950,7 @@ namespace GridTool::XF
         if (f2_idx == 0)
             throw std::runtime_error("Missing face 2");
 
-        const auto &f2 = face(f2_idx);
-        if (f2.includedNode.size() != 4)
-            throw std::runtime_error("Internal error.");
+        const auto f2 = nodes(f2_idx);
 
         // Face 1
         size_t f1_idx = 0;
@@ -2161,8 +3959,7 @@ namespace GridTool::XF
             if (e == f4_idx || e == f0_idx || e == f2_idx)
                 continue;
 
-            const auto &f = face(e);
-            if (f.includedNode.contains(n1, n2))
+            if (nodes(e).contains(n1, n2))
             {
                 if (f1_idx == 0)
                     f1_idx = e;
@@ -2173,9 +3970,7 @@ namespace GridTool::XF
         if (f1_idx == 0)
             throw std::runtime_error("Missing face 1");
 
-        const auto &f1 = face(f1_idx);
-        if (f1.includedNode.size() != 4)
-            throw std::runtime_error("Internal error.");
+        const auto f1 = nodes(f1_idx);
 
         // Face 3
         size_t f3_idx = 0;
@@ -2184,8 +3979,7 @@ namespace GridTool::XF
             if (e == f4_idx || e == f0_idx || e == f2_idx || e == f1_idx)
                 continue;
 
-            const auto &f = face(e);
-            if (f.includedNode.contains(n2, n3))
+            if (nodes(e).contains(n2, n3))
             {
                 if (f3_idx == 0)
                     f3_idx = e;
@@ -2196,9 +3990,7 @@ namespace GridTool::XF
         if (f3_idx == 0)
             throw std::runtime_error("Missing face 3");
 
-        const auto &f3 = face(f3_idx);
-        if (f3.includedNode.size() != 4)
-            throw std::runtime_error("Internal error.");
+        const auto f3 = nodes(f3_idx);
 
         // Face 5
         size_t f5_idx = 0;
@@ -2213,25 +4005,23 @@ namespace GridTool::XF
         if (f5_idx == 0)
             throw std::runtime_error("Missing face 5");
 
-        const auto &f5 = face(f5_idx);
-        if (f5.includedNode.size() != 4)
-            throw std::runtime_error("Internal error.");
+        const auto f5 = nodes(f5_idx);
 
         // Assign face index
-        hex.includedFace.at(0) = f0_idx;
-        hex.includedFace.at(1) = f1_idx;
-        hex.includedFace.at(2) = f2_idx;
-        hex.includedFace.at(3) = f3_idx;
-        hex.includedFace.at(4) = f4_idx;
-        hex.includedFace.at(5) = f5_idx;
+        hex.includedFace[0] = f0_idx;
+        hex.includedFace[1] = f1_idx;
+        hex.includedFace[2] = f2_idx;
+        hex.includedFace[3] = f3_idx;
+        hex.includedFace[4] = f4_idx;
+        hex.includedFace[5] = f5_idx;
 
         // 4 nodes at top to be defined
         size_t n4 = 0, n5 = 0, n6 = 0, n7 = 0;
 
         // Node 4
-        for (auto e : f5.includedNode)
+        for (auto e : f5)
         {
-            if (f0.includedNode.contains(e) && f2.includedNode.contains(e))
+            if (f0.contains(e) && f2.contains(e))
             {
                 n4 = e;
                 break;
@@ -2241,7 +4031,7 @@ namespace GridTool::XF
             throw std::runtime_error("Missing node 4");
 
         // Node 5
-        for (auto e : f2.includedNode)
+        for (auto e : f2)
         {
             if (e == n0 || e == n1 || e == n4)
                 continue;
@@ -2253,7 +4043,7 @@ namespace GridTool::XF
             throw std::runtime_error("Missing node 5");
 
         // Node 6
-        for (auto e : f1.includedNode)
+        for (auto e : f1)
         {
             if (e == n1 || e == n2 || e == n5)
                 continue;
@@ -2265,7 +4055,7 @@ namespace GridTool::XF
             throw std::runtime_error("Missing node 6");
 
         // Node 7
-        for (auto e : f0.includedNode)
+        for (auto e : f0)
         {
             if (e == n0 || e == n3 || e == n4)
                 continue;
@@ -2276,22 +4066,14 @@ namespace GridTool::XF
         if (n7 == 0)
             throw std::runtime_error("Missing node 7");
 
-        if (!f3.includedNode.contains(n6, n7))
+        if (!f3.contains(n6, n7))
             throw std::runtime_error("Inconsistent node composition.");
 
         // Assign node index
-        hex.includedNode.resize(8);
-        hex.includedNode.at(0) = n0;
-        hex.includedNode.at(1) = n1;
-        hex.includedNode.at(2) = n2;
-        hex.includedNode.at(3) = n3;
-        hex.includedNode.at(4) = n4;
-        hex.includedNode.at(5) = n5;
-        hex.includedNode.at(6) = n6;
-        hex.includedNode.at(7) = n7;
+        hex.includedNode = { n0, n1, n2, n3, n4, n5, n6, n7 };
     }
 
-    void MESH::triangle_standardization(CELL_ELEM &tri)
+    void MESH::triangle_standardization(CELL_RECORD &tri) const
     {
         // Check num of total faces
         if (tri.includedFace.size() != 3)
@@ -2300,7 +4082,7 @@ namespace GridTool::XF
         // Ensure all faces are lines
         for (auto e : tri.includedFace)
         {
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (e == 0 || f.type != FACE::LINEAR || f.includedNode.size() != 2)
                 throw std::runtime_error("Invalid face detected.");
         }
@@ -2312,9 +4094,9 @@ namespace GridTool::XF
         const auto f1_idx = tri.includedFace.at(1);
         const auto f2_idx = tri.includedFace.at(2);
 
-        const auto &f0 = face(f0_idx);
-        const auto &f1 = face(f1_idx);
-        const auto &f2 = face(f2_idx);
+        const auto &f0 = face_shape(f0_idx);
+        const auto &f1 = face_shape(f1_idx);
+        const auto &f2 = face_shape(f2_idx);
 
         // Nodes
         const size_t n0 = f0.includedNode.at(0);
@@ -2341,7 +4123,7 @@ namespace GridTool::XF
         tri.includedNode.at(2) = n2;
     }
 
-    void MESH::quad_standardization(CELL_ELEM &quad)
+    void MESH::quad_standardization(CELL_RECORD &quad) const
     {
         // Check num of total faces
         if (quad.includedFace.size() != 4)
@@ -2350,18 +4132,29 @@ namespace GridTool::XF
         // Ensure all faces are lines
         for (auto e : quad.includedFace)
         {
-            const auto &f = face(e);
+            const auto &f = face_shape(e);
             if (e == 0 || f.type != FACE::LINEAR || f.includedNode.size() != 2)
                 throw std::runtime_error("Invalid face detected.");
         }
 
+        SHAPE_RECORD<CELL::QUADRILATERAL> rec;
+        std::copy(quad.includedFace.begin(), quad.includedFace.end(), rec.includedFace.begin());
+        quad_standardization(rec);
+        quad.includedFace.assign(rec.includedFace.begin(), rec.includedFace.end());
+        quad.includedNode.assign(rec.includedNode.begin(), rec.includedNode.end());
+    }
+
+    void MESH::quad_standardization(SHAPE_RECORD<CELL::QUADRILATERAL> &quad) const
+    {
+        auto nodes = [this](size_t f) { return m_faceIncludedNode.row(f - 1); };
+
         // Face 0
-        const auto f0_idx = quad.includedFace.at(0);
-        const auto &f0 = face(f0_idx);
+        const auto f0_idx = quad.includedFace[0];
+        const auto f0 = nodes(f0_idx);
 
         // Node 0 and 1
-        const auto n0 = f0.includedNode.at(0);
-        const auto n1 = f0.includedNode.at(1);
+        const auto n0 = f0[0];
+        const auto n1 = f0[1];
 
         // Face 1
         size_t f1_idx = 0;
@@ -2370,8 +4163,7 @@ namespace GridTool::XF
             if (e == f0_idx)
                 continue;
 
-            const auto &f = face(e);
-            if (f.includedNode.contains(n1))
+            if (nodes(e).contains(n1))
             {
                 f1_idx = e;
                 break;
@@ -2380,10 +4172,10 @@ namespace GridTool::XF
         if (f1_idx == 0)
             throw std::runtime_error("Missing face 1");
 
-        const auto &f1 = face(f1_idx);
+        const auto f1 = nodes(f1_idx);
 
         // Node 2
-        const size_t n2 = f1.includedNode.at(0) == n1 ? f1.includedNode.at(1) : f1.includedNode.at(0);
+        const size_t n2 = f1[0] == n1 ? f1[1] : f1[0];
 
         // Face 3
         size_t f3_idx = 0;
@@ -2392,8 +4184,7 @@ namespace GridTool::XF
             if (e == f0_idx || e == f1_idx)
                 continue;
 
-            const auto &f = face(e);
-            if (f.includedNode.contains(n0))
+            if (nodes(e).contains(n0))
             {
                 f3_idx = e;
                 break;
@@ -2402,10 +4193,10 @@ namespace GridTool::XF
         if (f3_idx == 0)
             throw std::runtime_error("Missing face 3");
 
-        const auto &f3 = face(f3_idx);
+        const auto f3 = nodes(f3_idx);
 
         // Node 3
-        const size_t n3 = f3.includedNode.at(0) == n0 ? f3.includedNode.at(1) : f3.includedNode.at(0);
+        const size_t n3 = f3[0] == n0 ? f3[1] : f3[0];
 
         // Check face 2
         size_t f2_idx = 0;
@@ -2420,20 +4211,15 @@ namespace GridTool::XF
         if (f2_idx == 0)
             throw std::runtime_error("Missing face 2");
 
-        const auto &f2 = face(f2_idx);
-        if (!f2.includedNode.contains(n2, n3))
+        if (!nodes(f2_idx).contains(n2, n3))
             throw std::runtime_error("Inconsistent node and face includance on face 2");
 
         // Assign face index
-        quad.includedFace.at(1) = f1_idx;
-        quad.includedFace.at(2) = f2_idx;
-        quad.includedFace.at(3) = f3_idx;
+        quad.includedFace[1] = f1_idx;
+        quad.includedFace[2] = f2_idx;
+        quad.includedFace[3] = f3_idx;
 
         // Assign node index
-        quad.includedNode.resize(4);
-        quad.includedNode.at(0) = n0;
-        quad.includedNode.at(1) = n1;
-        quad.includedNode.at(2) = n2;
-        quad.includedNode.at(3) = n3;
+        quad.includedNode = { n0, n1, n2, n3 };
     }
 }
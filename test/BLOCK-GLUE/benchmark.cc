@@ -0,0 +1,513 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include "../../inc/plot3d.h"
+#include "../../inc/nmf.h"
+#include "../../inc/xf.h"
+
+using namespace GridTool;
+
+static const std::string CASTE_SEP = "  ";
+
+typedef std::chrono::steady_clock CLOCK;
+
+/// Synthetic case: unit cube with "n" cells along each direction,
+/// split evenly into "bx * by * bz" blocks.
+struct CAVITY
+{
+    size_t n;
+    size_t bx, by, bz;
+
+    std::string name() const
+    {
+        return "Cavity" + std::to_string(n) + "_" + std::to_string(bx) + "x" + std::to_string(by) + "x" + std::to_string(bz);
+    }
+
+    size_t nBlock() const
+    {
+        return bx * by * bz;
+    }
+
+    size_t nCell() const
+    {
+        return n * n * n;
+    }
+
+    size_t nNode() const
+    {
+        return (n + 1) * (n + 1) * (n + 1);
+    }
+
+    size_t nFace() const
+    {
+        return 3 * n * n * (n + 1);
+    }
+
+    /// 1-based index of block at (ib, jb, kb), I varies fastest.
+    size_t index(size_t ib, size_t jb, size_t kb) const
+    {
+        return 1 + ib + bx * (jb + by * kb);
+    }
+};
+
+struct STAGE
+{
+    std::string name;
+    double seconds;
+    size_t bytes; /// Amount of data read or written, 0 if not an IO stage.
+    size_t peak_rss;
+};
+
+/// Discards the report of gluing.
+class NULL_BUF : public std::streambuf
+{
+protected:
+    int overflow(int c) override
+    {
+        return c == traits_type::eof() ? 0 : c;
+    }
+};
+
+/// Total duration in seconds of events named "name" which started after "since",
+/// in microseconds of "COMMON::profiler".
+static double event_seconds(const std::string &name, double since)
+{
+    double ret = 0.0;
+    bool found = false;
+    for (const auto &e : COMMON::profiler().events())
+        if (e.name == name && e.start >= since)
+        {
+            ret += e.duration;
+            found = true;
+        }
+    if (!found)
+        throw std::runtime_error("Event \"" + name + "\" is not recorded, see \"TYDF_ENABLE_PROFILE\".");
+    return ret * 1e-6;
+}
+
+static double elapsed(const CLOCK::time_point &t0, const CLOCK::time_point &t1)
+{
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+static size_t file_size(const std::string &path)
+{
+    std::error_code ec;
+    const auto sz = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<size_t>(sz);
+}
+
+/// Binary PLOT3D grid, without record markers, in the byte order of the host.
+/// Written plane by plane, since large cases can not be held in memory twice.
+static void write_grid(const CAVITY &c, const std::string &dst)
+{
+    std::ofstream fout(dst, std::ios::out | std::ios::binary);
+    if (!fout)
+        throw std::runtime_error("Failed to open \"" + dst + "\".");
+
+    auto put = [&fout](int32_t val)
+    {
+        fout.write(reinterpret_cast<const char *>(&val), sizeof(val));
+    };
+
+    const size_t mI = c.n / c.bx, mJ = c.n / c.by, mK = c.n / c.bz;
+    put(static_cast<int32_t>(c.nBlock()));
+    for (size_t b = 0; b < c.nBlock(); ++b)
+    {
+        put(static_cast<int32_t>(mI + 1));
+        put(static_cast<int32_t>(mJ + 1));
+        put(static_cast<int32_t>(mK + 1));
+    }
+
+    std::vector<double> buf((mI + 1) * (mJ + 1));
+    for (size_t kb = 0; kb < c.bz; ++kb)
+        for (size_t jb = 0; jb < c.by; ++jb)
+            for (size_t ib = 0; ib < c.bx; ++ib)
+                for (short d = 0; d < 3; ++d)
+                    for (size_t k = 0; k <= mK; ++k)
+                    {
+                        double *p = buf.data();
+                        for (size_t j = 0; j <= mJ; ++j)
+                            for (size_t i = 0; i <= mI; ++i)
+                            {
+                                const size_t g[3] = { ib * mI + i, jb * mJ + j, kb * mK + k };
+                                *p++ = static_cast<double>(g[d]) / c.n;
+                            }
+                        fout.write(reinterpret_cast<const char *>(buf.data()), buf.size() * sizeof(double));
+                    }
+
+    if (!fout)
+        throw std::runtime_error("Failed to write \"" + dst + "\".");
+}
+
+/// Neighbouring blocks are connected through full surfaces without
+/// swapping, remaining surfaces are walls.
+static void write_map(const CAVITY &c, const std::string &dst)
+{
+    std::ofstream fout(dst);
+    if (!fout)
+        throw std::runtime_error("Failed to open \"" + dst + "\".");
+
+    const size_t nI = c.n / c.bx + 1, nJ = c.n / c.by + 1, nK = c.n / c.bz + 1;
+
+    /// Ranges of surfaces, in the order of their primary and secondary directions.
+    const std::string rg[3] = {
+        "1 " + std::to_string(nI) + " 1 " + std::to_string(nJ),
+        "1 " + std::to_string(nJ) + " 1 " + std::to_string(nK),
+        "1 " + std::to_string(nK) + " 1 " + std::to_string(nI)
+    };
+
+    fout << "# " << c.name() << std::endl;
+    fout << c.nBlock() << std::endl;
+    for (size_t b = 1; b <= c.nBlock(); ++b)
+        fout << b << " " << nI << " " << nJ << " " << nK << std::endl;
+    fout << "# Connectivity" << std::endl;
+
+    for (size_t kb = 0; kb < c.bz; ++kb)
+        for (size_t jb = 0; jb < c.by; ++jb)
+            for (size_t ib = 0; ib < c.bx; ++ib)
+            {
+                const size_t b = c.index(ib, jb, kb);
+
+                if (ib + 1 < c.bx)
+                    fout << "ONE_TO_ONE " << b << " 4 " << rg[1] << " " << c.index(ib + 1, jb, kb) << " 3 " << rg[1] << " FALSE" << std::endl;
+                if (jb + 1 < c.by)
+                    fout << "ONE_TO_ONE " << b << " 6 " << rg[2] << " " << c.index(ib, jb + 1, kb) << " 5 " << rg[2] << " FALSE" << std::endl;
+                if (kb + 1 < c.bz)
+                    fout << "ONE_TO_ONE " << b << " 2 " << rg[0] << " " << c.index(ib, jb, kb + 1) << " 1 " << rg[0] << " FALSE" << std::endl;
+
+                if (kb == 0)
+                    fout << "WALL " << b << " 1 " << rg[0] << std::endl;
+                if (kb + 1 == c.bz)
+                    fout << "WALL " << b << " 2 " << rg[0] << std::endl;
+                if (ib == 0)
+                    fout << "WALL " << b << " 3 " << rg[1] << std::endl;
+                if (ib + 1 == c.bx)
+                    fout << "WALL " << b << " 4 " << rg[1] << std::endl;
+                if (jb == 0)
+                    fout << "WALL " << b << " 5 " << rg[2] << std::endl;
+                if (jb + 1 == c.by)
+                    fout << "WALL " << b << " 6 " << rg[2] << std::endl;
+            }
+}
+
+/// Run each stage of the pipeline once, in the same order as
+/// "PLOT3D::GRID" reading and "XF::MESH(f_nmf, f_p3d)" gluing.
+static std::vector<STAGE> run(const CAVITY &c, const std::string &dir, bool formatted, bool keep, bool quality, int ordering, size_t nPart)
+{
+    const std::string MAP_PATH = dir + c.name() + ".nmf";
+    const std::string GRID_PATH = dir + c.name() + (formatted ? ".fmt" : ".xyz");
+    const std::string MESH_PATH = dir + c.name() + ".msh";
+
+    std::cout << CASTE_SEP << "Generating ..." << std::endl;
+    write_map(c, MAP_PATH);
+    if (formatted)
+    {
+        const std::string BIN_PATH = dir + c.name() + ".xyz";
+        write_grid(c, BIN_PATH);
+        PLOT3D::GRID(BIN_PATH).writeToFile(GRID_PATH, PLOT3D::FORMATTED);
+        std::filesystem::remove(BIN_PATH);
+    }
+    else
+        write_grid(c, GRID_PATH);
+
+    std::vector<STAGE> ret;
+    auto cleanup = [&]()
+    {
+        if (keep)
+            return;
+        std::filesystem::remove(MAP_PATH);
+        std::filesystem::remove(GRID_PATH);
+        std::filesystem::remove(MESH_PATH);
+    };
+
+    /// Generated files are removed even if a stage fails, e.g. "nPart" does not suit the case.
+    try
+    {
+        COMMON::reset_peak_rss();
+        auto t0 = CLOCK::now();
+        auto record = [&](const std::string &name, size_t bytes)
+        {
+            const auto t1 = CLOCK::now();
+            ret.push_back({ name, elapsed(t0, t1), bytes, COMMON::peak_rss() });
+            t0 = CLOCK::now();
+        };
+
+        std::cout << CASTE_SEP << "Reading grid ..." << std::endl;
+        {
+            PLOT3D::GRID grid;
+            grid.readFromFile(GRID_PATH);
+            record("plot3d_read", file_size(GRID_PATH));
+        }
+
+        std::cout << CASTE_SEP << "Reading map ..." << std::endl;
+        NMF::Mapping3D nmf;
+        nmf.readFromFile(MAP_PATH);
+        record("nmf_read", file_size(MAP_PATH));
+
+        nmf.compute_topology();
+        record("compute_topology", 0);
+
+        std::cout << CASTE_SEP << "Numbering ..." << std::endl;
+        nmf.numbering(false);
+        record("numbering", 0);
+
+        std::cout << CASTE_SEP << "Combining ..." << std::endl;
+        NULL_BUF nbuf;
+        std::ostream frpt(&nbuf);
+        {
+            /// Derivation is done within the constructor, and timed by its own scope.
+            const double since = COMMON::profiler().now();
+            XF::MESH mesh(nmf, GRID_PATH, frpt);
+            const double total = elapsed(t0, CLOCK::now());
+            const double derived = std::min(event_seconds("XF::MESH::derive", since), total);
+            ret.push_back({ "glue", total - derived, 0, COMMON::peak_rss() });
+            ret.push_back({ "raw2derived", derived, 0, COMMON::peak_rss() });
+            t0 = CLOCK::now();
+
+            if (quality)
+            {
+                std::cout << CASTE_SEP << "Checking quality ..." << std::endl;
+                XF::QUALITY(mesh).report(frpt, nmf);
+                record("quality", 0);
+            }
+
+            /// Parts refer to cells in the order of gluing, thus written before renumbering.
+            if (nPart != 0)
+            {
+                std::cout << CASTE_SEP << "Partitioning ..." << std::endl;
+                const auto part = nmf.partition(nPart);
+                record("partition", 0);
+
+                const std::string PART_PREFIX = dir + c.name() + "_part";
+                mesh.writePartition(part, PART_PREFIX, false, std::cout);
+                size_t bytes = 0;
+                for (size_t p = 0; p < nPart; ++p)
+                    for (const std::string ext : { ".msh", ".map" })
+                    {
+                        const std::string f = PART_PREFIX + "_" + std::to_string(p) + ext;
+                        bytes += file_size(f);
+                        if (!keep)
+                            std::filesystem::remove(f);
+                    }
+                record("partition_write", bytes);
+            }
+
+            if (ordering != 0)
+            {
+                std::cout << CASTE_SEP << "Renumbering ..." << std::endl;
+                mesh.renumber(ordering, std::cout);
+                record("renumber", 0);
+            }
+
+            std::cout << CASTE_SEP << "Writing ..." << std::endl;
+            mesh.writeToFile(MESH_PATH);
+            record("msh_write", file_size(MESH_PATH));
+        }
+
+        std::cout << CASTE_SEP << "Streaming ..." << std::endl;
+        XF::MESH::glue(nmf, GRID_PATH, MESH_PATH, frpt);
+        record("stream_glue", file_size(MESH_PATH));
+    }
+    catch (...)
+    {
+        cleanup();
+        throw;
+    }
+
+    cleanup();
+
+    return ret;
+}
+
+static std::vector<std::string> split(const std::string &s, char sep)
+{
+    std::vector<std::string> ret;
+    std::istringstream ss(s);
+    std::string t;
+    while (std::getline(ss, t, sep))
+        if (!t.empty())
+            ret.push_back(t);
+    return ret;
+}
+
+static void usage(const char *exe)
+{
+    std::cout << "Usage: " << exe << " [options]" << std::endl;
+    std::cout << CASTE_SEP << "-n 32,64,...     Num of cells along each direction." << std::endl;
+    std::cout << CASTE_SEP << "-b 1x1x1,2x2x2   Block splits, \"n\" must be divisible." << std::endl;
+    std::cout << CASTE_SEP << "-t 4             Num of threads, see \"COMMON::num_of_thread\"." << std::endl;
+    std::cout << CASTE_SEP << "-f               Use formatted PLOT3D grid instead of binary." << std::endl;
+    std::cout << CASTE_SEP << "-q               Check quality of the glued mesh, see \"XF::QUALITY\"." << std::endl;
+    std::cout << CASTE_SEP << "-r rcm|hilbert   Renumber the glued mesh before writing." << std::endl;
+    std::cout << CASTE_SEP << "-P 4             Write the glued mesh in parts, see \"NMF::Mapping3D::partition\"." << std::endl;
+    std::cout << CASTE_SEP << "-k               Keep the generated files." << std::endl;
+    std::cout << CASTE_SEP << "-d DIR           Directory of the generated files." << std::endl;
+    std::cout << CASTE_SEP << "-o FILE          Path of the JSON report." << std::endl;
+    std::cout << CASTE_SEP << "-p FILE          Path of the Chrome trace of all stages." << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> size_list = { 32 };
+    std::vector<std::array<size_t, 3>> split_list = { { 1, 1, 1 }, { 2, 2, 2 } };
+    std::string dir = "./", dst = "benchmark.json", trace;
+    bool formatted = false, keep = false, quality = false;
+    int ordering = 0;
+    size_t nPart = 0;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string opt = argv[i];
+            auto value = [&]() -> std::string
+            {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument("Missing value of \"" + opt + "\".");
+                return argv[++i];
+            };
+
+            if (opt == "-n")
+            {
+                size_list.clear();
+                for (const auto &s : split(value(), ','))
+                    size_list.push_back(std::stoul(s));
+            }
+            else if (opt == "-b")
+            {
+                split_list.clear();
+                for (const auto &s : split(value(), ','))
+                {
+                    const auto d = split(s, 'x');
+                    if (d.size() != 3)
+                        throw std::invalid_argument("Invalid block split \"" + s + "\".");
+                    split_list.push_back({ std::stoul(d[0]), std::stoul(d[1]), std::stoul(d[2]) });
+                }
+            }
+            else if (opt == "-t")
+                COMMON::num_of_thread() = std::stoul(value());
+            else if (opt == "-f")
+                formatted = true;
+            else if (opt == "-q")
+                quality = true;
+            else if (opt == "-r")
+            {
+                const auto s = value();
+                if (s == "rcm")
+                    ordering = XF::MESH::RCM;
+                else if (s == "hilbert")
+                    ordering = XF::MESH::HILBERT;
+                else
+                    throw std::invalid_argument("Unknown ordering \"" + s + "\".");
+            }
+            else if (opt == "-P")
+                nPart = std::stoul(value());
+            else if (opt == "-k")
+                keep = true;
+            else if (opt == "-d")
+            {
+                dir = value();
+                if (dir.back() != '/')
+                    dir.push_back('/');
+            }
+            else if (opt == "-o")
+                dst = value();
+            else if (opt == "-p")
+                trace = value();
+            else
+            {
+                usage(argv[0]);
+                return opt == "-h" ? 0 : 1;
+            }
+        }
+
+        std::filesystem::create_directories(dir);
+
+        std::ofstream fout(dst);
+        if (!fout)
+            throw std::runtime_error("Failed to open \"" + dst + "\".");
+        fout.precision(6);
+
+        std::cout << "Benchmark the \"Block-Glue\" pipeline with " << COMMON::num_of_thread() << " thread(s)." << std::endl;
+        fout << "{" << std::endl;
+        fout << "  \"threads\": " << COMMON::num_of_thread() << "," << std::endl;
+        fout << "  \"grid_format\": \"" << (formatted ? "formatted" : "binary") << "\"," << std::endl;
+        fout << "  \"cases\": [";
+
+        bool first_case = true;
+        for (auto n : size_list)
+            for (const auto &s : split_list)
+            {
+                const CAVITY c{ n, s[0], s[1], s[2] };
+                std::cout << "Case \"" << c.name() << "\", " << c.nCell() << " cells in " << c.nBlock() << " block(s) ..." << std::endl;
+                if (n == 0 || s[0] == 0 || s[1] == 0 || s[2] == 0 || n % s[0] || n % s[1] || n % s[2])
+                {
+                    std::cout << CASTE_SEP << "Skipped: Can not split " << n << " cells evenly." << std::endl;
+                    continue;
+                }
+
+                std::vector<STAGE> stage;
+                try
+                {
+                    stage = run(c, dir, formatted, keep, quality, ordering, nPart);
+                }
+                catch (std::exception &e)
+                {
+                    /// Remaining cases are still run.
+                    std::cout << CASTE_SEP << "Skipped: " << e.what() << std::endl;
+                    continue;
+                }
+
+                fout << (first_case ? "" : ",") << std::endl;
+                first_case = false;
+                fout << "    {" << std::endl;
+                fout << "      \"name\": \"" << c.name() << "\"," << std::endl;
+                fout << "      \"blocks\": " << c.nBlock() << "," << std::endl;
+                fout << "      \"nodes\": " << c.nNode() << "," << std::endl;
+                fout << "      \"faces\": " << c.nFace() << "," << std::endl;
+                fout << "      \"cells\": " << c.nCell() << "," << std::endl;
+                fout << "      \"stages\": [" << std::endl;
+                double total = 0.0;
+                for (size_t i = 0; i < stage.size(); ++i)
+                {
+                    const auto &e = stage[i];
+                    total += e.seconds;
+                    std::cout << CASTE_SEP << CASTE_SEP << e.name << ": " << e.seconds << " s, peak RSS " << e.peak_rss << " KB" << std::endl;
+
+                    /// Throughput in cells and megabytes processed per second.
+                    const double t = std::max(e.seconds, 1e-9);
+                    fout << "        { \"name\": \"" << e.name << "\", \"seconds\": " << e.seconds;
+                    fout << ", \"cells_per_second\": " << c.nCell() / t;
+                    if (e.bytes > 0)
+                        fout << ", \"bytes\": " << e.bytes << ", \"mb_per_second\": " << e.bytes / t / (1 << 20);
+                    fout << ", \"peak_rss_kb\": " << e.peak_rss << " }" << (i + 1 < stage.size() ? "," : "") << std::endl;
+                }
+                fout << "      ]," << std::endl;
+                fout << "      \"total_seconds\": " << total << "," << std::endl;
+                fout << "      \"peak_rss_kb\": " << (stage.empty() ? 0 : stage.back().peak_rss) << std::endl;
+                fout << "    }";
+            }
+
+        fout << std::endl << "  ]" << std::endl << "}" << std::endl;
+        std::cout << "Results are written to \"" << dst << "\"." << std::endl;
+
+        if (!trace.empty())
+        {
+            std::ofstream ftrace(trace);
+            if (!ftrace)
+                throw std::runtime_error("Failed to open \"" + trace + "\".");
+            COMMON::profiler().dump_trace(ftrace);
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
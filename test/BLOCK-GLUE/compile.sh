@@ -1 +1 @@
-g++ main.cc ../../src/nmf.cc ../../src/plot3d.cc ../../src/xf.cc ../../src/glue.cc ../../src/common.cc -std=c++17 -O3
\ No newline at end of file
+g++ main.cc ../../src/nmf.cc ../../src/plot3d.cc ../../src/xf.cc ../../src/checkpoint.cc ../../src/quality.cc ../../src/glue.cc ../../src/export.cc ../../src/common.cc -std=c++17 -O3 -pthread
\ No newline at end of file
@@ -1,4 +1,11 @@
 #include <iostream>
+#include <fstream>
+#include <cmath>
+#include <map>
+#include <array>
+#include <iterator>
+#include "../../inc/plot3d.h"
+#include "../../inc/nmf.h"
 #include "../../inc/xf.h"
 
 using namespace GridTool;
@@ -18,12 +25,26 @@ void test(const std::string &case_name, const std::string &case_desc, const std:
             throw std::runtime_error("Failed to open target report file.");
 
         std::cout << CASTE_SEP << "Combining ..." << std::endl;
-        const XF::MESH mesh(MAP_PATH, GRID_PATH, frpt);
+        NMF::Mapping3D nmf(MAP_PATH);
+        nmf.numbering(false);
+        const XF::MESH mesh(nmf, GRID_PATH, frpt);
+
+        std::cout << CASTE_SEP << "Checking quality ..." << std::endl;
+        XF::QUALITY(mesh).report(frpt, nmf);
         frpt.close();
 
         std::cout << CASTE_SEP << "Writing ..." << std::endl;
         mesh.writeToFile(MESH_PATH);
 
+        std::cout << CASTE_SEP << "Streaming ..." << std::endl;
+        XF::MESH::glue(MAP_PATH, GRID_PATH, MESH_DIR + MESH_NAME + "_stream.msh", std::cout);
+
+        std::cout << CASTE_SEP << "Exporting ..." << std::endl;
+        nmf.writeVTK(GRID_PATH, MESH_DIR + MESH_NAME);
+#ifdef TYDF_USE_CGNS
+        nmf.writeCGNS(GRID_PATH, MESH_DIR + MESH_NAME + ".cgns");
+#endif
+
         std::cout << CASTE_SEP << "Done!" << std::endl;
     }
     catch (std::exception &e)
@@ -32,9 +53,228 @@ void test(const std::string &case_name, const std::string &case_desc, const std:
     }
 };
 
+/// Sum of cell volumes and that of boundary face areas.
+static void measure(const XF::MESH &mesh, double &volume, double &area)
+{
+    volume = 0.0;
+    for (auto v : mesh.cellVolume())
+        volume += v;
+
+    area = 0.0;
+    for (size_t i = 1; i <= mesh.numOfFace(); ++i)
+    {
+        const auto f = mesh.face(i);
+        if (f.atBdry)
+            area += f.area;
+    }
+}
+
+static bool close_to(double a, double b)
+{
+    return std::abs(a - b) <= 1e-12 * std::max(std::abs(a), std::abs(b));
+}
+
+void test_renumber(const std::string &case_name, const std::string &MAP_PATH, const std::string &GRID_PATH)
+{
+    try
+    {
+        std::cout << "Case \"" << case_name << "\", renumbering ..." << std::endl;
+        NMF::Mapping3D nmf(MAP_PATH);
+        nmf.numbering(false);
+
+        double volume, area;
+        measure(XF::MESH(nmf, GRID_PATH, std::cout), volume, area);
+
+        for (int ordering : {XF::MESH::RCM, XF::MESH::HILBERT})
+        {
+            std::cout << CASTE_SEP << (ordering == XF::MESH::RCM ? "RCM" : "Hilbert") << " ..." << std::endl;
+            XF::MESH mesh(nmf, GRID_PATH, std::cout);
+            mesh.renumber(ordering, std::cout);
+
+            double v, a;
+            measure(mesh, v, a);
+            if (!close_to(v, volume) || !close_to(a, area))
+                throw std::runtime_error("Total volume or boundary area is changed by renumbering.");
+        }
+
+        std::cout << CASTE_SEP << "Done!" << std::endl;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+    }
+}
+
+/// Contents of "<prefix>_<p>.map" written by "XF::MESH::writePartition".
+struct PART_MAP
+{
+    std::vector<size_t> node, cell, face;
+    std::map<int, std::vector<std::array<size_t, 4>>> interface;
+};
+
+static PART_MAP read_map(const std::string &src)
+{
+    std::ifstream fin(src);
+    if (fin.fail())
+        throw std::runtime_error("Failed to open partition map file: " + src);
+
+    PART_MAP ret;
+    std::string tag;
+    size_t p, nPart, num;
+    fin >> tag >> p >> nPart;
+    for (auto dst : {&ret.node, &ret.cell, &ret.face})
+    {
+        fin >> tag >> num;
+        dst->resize(num);
+        for (auto &e : *dst)
+            fin >> e;
+    }
+    int q;
+    while (fin >> tag >> q >> num)
+    {
+        auto &dst = ret.interface[q];
+        dst.resize(num);
+        for (auto &e : dst)
+            fin >> e[0] >> e[1] >> e[2] >> e[3];
+    }
+    if (!fin.eof())
+        throw std::runtime_error("Invalid partition map file: " + src);
+    return ret;
+}
+
+void test_partition(const std::string &case_name, const std::string &MAP_PATH, const std::string &GRID_PATH, const std::string &PART_PREFIX, size_t nPart)
+{
+    try
+    {
+        std::cout << "Case \"" << case_name << "\", " << nPart << " parts ..." << std::endl;
+        std::ofstream frpt(PART_PREFIX + "_report.txt");
+        if (frpt.fail())
+            throw std::runtime_error("Failed to open target report file.");
+
+        NMF::Mapping3D nmf(MAP_PATH);
+        nmf.numbering(false);
+        const XF::MESH mesh(nmf, GRID_PATH, frpt);
+
+        std::cout << CASTE_SEP << "Writing ..." << std::endl;
+        mesh.writePartition(nmf.partition(nPart), PART_PREFIX, false, frpt);
+
+        std::cout << CASTE_SEP << "Re-loading ..." << std::endl;
+        std::vector<PART_MAP> part;
+        size_t nCell = 0;
+        for (size_t p = 0; p < nPart; ++p)
+        {
+            const std::string name = PART_PREFIX + "_" + std::to_string(p);
+            const XF::MESH sub(name + ".msh", frpt, 0);
+            part.push_back(read_map(name + ".map"));
+            if (sub.numOfCell() != part.back().cell.size() || sub.numOfFace() != part.back().face.size())
+                throw std::runtime_error("Inconsistent num of elements between part " + std::to_string(p) + " and its map.");
+            nCell += sub.numOfCell();
+        }
+        if (nCell != mesh.numOfCell())
+            throw std::runtime_error("Cells of parts do not sum up to the original.");
+
+        /// Each shared face is listed by both sides in the same order.
+        for (size_t p = 0; p < nPart; ++p)
+            for (const auto &e : part[p].interface)
+            {
+                const auto &lhs = e.second;
+                const auto &rhs = part.at(e.first).interface.at(static_cast<int>(p));
+                if (lhs.size() != rhs.size())
+                    throw std::runtime_error("Unpaired interface between part " + std::to_string(p) + " and " + std::to_string(e.first) + ".");
+                for (size_t i = 0; i < lhs.size(); ++i)
+                {
+                    const auto &r = part[e.first];
+                    if (part[p].face.at(lhs[i][0] - 1) != r.face.at(rhs[i][0] - 1) || lhs[i][2] != r.cell.at(rhs[i][1] - 1) || lhs[i][3] != rhs[i][1])
+                        throw std::runtime_error("Mismatched interface face between part " + std::to_string(p) + " and " + std::to_string(e.first) + ".");
+                }
+            }
+
+        std::cout << CASTE_SEP << "Done!" << std::endl;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+    }
+}
+
+static std::string read_all(const std::string &src)
+{
+    std::ifstream fin(src, std::ios::binary);
+    if (fin.fail())
+        throw std::runtime_error("Failed to open \"" + src + "\".");
+    return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+}
+
+void test_update(const std::string &case_name, const std::string &MAP_PATH, const std::string &GRID_PATH, const std::string &MESH_DIR, const std::string &MESH_NAME)
+{
+    const std::string MOVED_GRID_PATH = MESH_DIR + MESH_NAME + "_moved.fmt";
+    const std::string UPDATED_PATH = MESH_DIR + MESH_NAME + "_updated.msh";
+    const std::string FRESH_PATH = MESH_DIR + MESH_NAME + "_moved.msh";
+
+    try
+    {
+        std::cout << "Case \"" << case_name << "\", updating nodes ..." << std::endl;
+        std::ofstream frpt(MESH_DIR + MESH_NAME + "_update_report.txt");
+        if (frpt.fail())
+            throw std::runtime_error("Failed to open target report file.");
+
+        /// Sheared and stretched, without changing the topology.
+        PLOT3D::GRID grid(GRID_PATH);
+        for (size_t n = 0; n < grid.numOfBlock(); ++n)
+        {
+            auto b = grid.block(n);
+            auto x = b->plane(0), y = b->plane(1), z = b->plane(2);
+            for (size_t i = 0; i < b->size(); ++i)
+            {
+                x[i] += 0.25 * y[i];
+                z[i] *= 1.5;
+            }
+        }
+        grid.writeToFile(MOVED_GRID_PATH);
+
+        NMF::Mapping3D nmf(MAP_PATH);
+        nmf.numbering(false);
+
+        std::cout << CASTE_SEP << "Updating ..." << std::endl;
+        XF::MESH mesh(nmf, GRID_PATH, frpt);
+        mesh.update_node(nmf, MOVED_GRID_PATH);
+        mesh.writeToFile(UPDATED_PATH);
+
+        std::cout << CASTE_SEP << "Combining ..." << std::endl;
+        XF::MESH(nmf, MOVED_GRID_PATH, frpt).writeToFile(FRESH_PATH);
+        if (read_all(UPDATED_PATH) != read_all(FRESH_PATH))
+            throw std::runtime_error("Updated mesh differs from that combined from the moved grid.");
+
+        std::cout << CASTE_SEP << "Renumbering ..." << std::endl;
+        mesh.renumber(XF::MESH::RCM, frpt);
+        bool rejected = false;
+        try
+        {
+            mesh.update_node(nmf, GRID_PATH);
+        }
+        catch (std::runtime_error &)
+        {
+            rejected = true;
+        }
+        if (!rejected)
+            throw std::runtime_error("Nodes of a renumbered mesh are updated.");
+
+        std::cout << CASTE_SEP << "Done!" << std::endl;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+    }
+}
+
 int main(int argc, char *argv[])
 {
     std::cout << "Test the \"Block-Glue\" utilities." << std::endl;
 
+    test("Split", "3 blocks, 1 surface split into 2 patches", "../../case/Split/NMF/map.nmf", "../../case/Split/PLOT3D/xyz.fmt", "../../case/Split/", "mesh");
+    test_renumber("Split", "../../case/Split/NMF/map.nmf", "../../case/Split/PLOT3D/xyz.fmt");
+    test_partition("Split", "../../case/Split/NMF/map.nmf", "../../case/Split/PLOT3D/xyz.fmt", "../../case/Split/part", 3);
+    test_update("Split", "../../case/Split/NMF/map.nmf", "../../case/Split/PLOT3D/xyz.fmt", "../../case/Split/", "mesh");
+
     return 0;
 }
@@ -0,0 +1,36 @@
+#include <iostream>
+#include <sstream>
+#include "../../inc/xf.h"
+
+using namespace GridTool;
+
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc, &argv);
+
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (argc != 4)
+    {
+        if (rank == 0)
+            std::cout << "Usage: " << argv[0] << " <NMF> <PLOT3D> <MSH>" << std::endl;
+        MPI_Finalize();
+        return 1;
+    }
+
+    /// Only the first rank reports progress.
+    std::ostringstream silent;
+    try
+    {
+        XF::MESH::glue(MPI_COMM_WORLD, argv[1], argv[2], argv[3], rank == 0 ? std::cout : silent);
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Rank " << rank << ": " << e.what() << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -1 +1 @@
-g++ main.cc ../../src/xf.cc ../../src/common.cc -std=c++17 -O3
\ No newline at end of file
+g++ main.cc ../../src/xf.cc ../../src/checkpoint.cc ../../src/quality.cc ../../src/nmf.cc ../../src/common.cc -std=c++17 -O3 -pthread
\ No newline at end of file
@@ -10,6 +10,8 @@ void test(const std::string &case_name, const std::string &case_desc, const std:
     const std::string REPORT_PATH = file_dir + file_name + "_report.txt";
     const std::string MESH_PATH = file_dir + file_name + ".msh";
     const std::string TRANSCRIPT_PATH = file_dir + file_name + "_blessed.msh";
+    const std::string BINARY_TRANSCRIPT_PATH = file_dir + file_name + "_blessed_bin.msh";
+    const std::string CHECKPOINT_PATH = file_dir + file_name + ".ckp";
 
     std::cout << "Case \"" << case_name << "\"," << case_desc << " ..." << std::endl;
     std::ofstream fout(REPORT_PATH);
@@ -18,11 +20,29 @@ void test(const std::string &case_name, const std::string &case_desc, const std:
 
     std::cout << CASTE_SEP << "Reading ..." << std::endl;
     XF::MESH msh(MESH_PATH, fout);
-    fout.close();
+
+    std::cout << CASTE_SEP << "Checking quality ..." << std::endl;
+    XF::QUALITY(msh).report(fout);
 
     std::cout << CASTE_SEP << "Transcribing ..." << std::endl;
     msh.writeToFile(TRANSCRIPT_PATH);
 
+    std::cout << CASTE_SEP << "Transcribing in binary form ..." << std::endl;
+    msh.writeToFile(BINARY_TRANSCRIPT_PATH, true);
+
+    std::cout << CASTE_SEP << "Re-loading binary transcript ..." << std::endl;
+    XF::MESH msh_bin(BINARY_TRANSCRIPT_PATH, fout, 0);
+    if (msh_bin.numOfNode() != msh.numOfNode() || msh_bin.numOfFace() != msh.numOfFace() || msh_bin.numOfCell() != msh.numOfCell())
+        throw std::runtime_error("Inconsistent binary transcript.");
+
+    std::cout << CASTE_SEP << "Checkpointing ..." << std::endl;
+    msh.writeCheckpoint(CHECKPOINT_PATH);
+    XF::MESH msh_ckp;
+    msh_ckp.readCheckpoint(CHECKPOINT_PATH, fout);
+    fout.close();
+    if (msh_ckp.numOfNode() != msh.numOfNode() || msh_ckp.numOfFace() != msh.numOfFace() || msh_ckp.numOfCell() != msh.numOfCell())
+        throw std::runtime_error("Inconsistent checkpoint.");
+
     std::cout << CASTE_SEP << "Done!" << std::endl;
 }
 
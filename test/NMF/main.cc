@@ -37,6 +37,7 @@ int main(int argc, char *argv[])
     test("Cavity", "a single block", "../../case/Cavity/NMF/", "map");
     test("Sky1", "2 blocks connected through 1 surface", "../../case/Sky1/NMF/", "map");
     test("Langley", "4 blocks in 2 x 2 form", "../../case/Langley/NMF/", "map");
+    test("Split", "3 blocks, 1 surface split into 2 patches", "../../case/Split/NMF/", "map");
 
     return 0;
 }
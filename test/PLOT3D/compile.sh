@@ -1 +1 @@
-g++ main.cc ../../src/plot3d.cc ../../src/common.cc -std=c++17 -O3
\ No newline at end of file
+g++ main.cc ../../src/plot3d.cc ../../src/common.cc -std=c++17 -O3 -pthread
\ No newline at end of file
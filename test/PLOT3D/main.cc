@@ -18,6 +18,11 @@ void test(const std::string &case_name, const std::string &case_desc, const std:
     std::cout << CASTE_SEP << "Transcribing ..." << std::endl;
     p3d.writeToFile(TRANSCRIPT_PATH);
 
+    std::cout << CASTE_SEP << "Transcribing in unformatted form ..." << std::endl;
+    const std::string BINARY_PATH = file_dir + file_name + "_blessed.x";
+    p3d.writeToFile(BINARY_PATH, PLOT3D::UNFORMATTED);
+    PLOT3D::GRID(BINARY_PATH).writeToFile(file_dir + file_name + "_blessed_x.fmt");
+
     std::cout << CASTE_SEP << "Done!" << std::endl;
 }
 
@@ -2,6 +2,8 @@
 #include <fstream>
 #include <string>
 #include <stdexcept>
+#include <cmath>
+#include <algorithm>
 #include "../../inc/spacing.h"
 
 using namespace GridTool;
@@ -26,5 +28,24 @@ int main(int argc, char *argv[])
     SPACING::uniform(100, c1);
     writeToFile(c1, "uniform100.txt");
 
+    SPACING::CACHE cache;
+    writeToFile(cache.at({ SPACING::HYPERBOLIC_TANGENT, 100, { 2.0 } }), "tanh100.txt");
+
+    /// Near-uniform parameters, batched results against the non-batched version.
+    DIST_ARR c2;
+    for (double b : { 1e-4, 1e-8 })
+    {
+        double err = 0.0;
+        SPACING::hyperbolic_tangent(100, b, c2);
+        const auto &c3 = cache.at({ SPACING::HYPERBOLIC_TANGENT, 100, { b } });
+        for (size_t i = 0; i < c2.size(); ++i)
+            err = std::max(err, std::abs(c2[i] - c3[i]));
+        SPACING::hyperbolic_sine(100, b, c2);
+        const auto &c4 = cache.at({ SPACING::HYPERBOLIC_SINE, 100, { b } });
+        for (size_t i = 0; i < c2.size(); ++i)
+            err = std::max(err, std::abs(c2[i] - c4[i]));
+        std::cout << "Max deviation of batched distributions with parameter " << b << ": " << err << std::endl;
+    }
+
     return 0;
 }